@@ -50,8 +50,12 @@
 #include <elevation_map_msgs/CheckSafety.h>
 #include <elevation_map_msgs/Initialize.h>
 #include <elevation_map_msgs/ChannelInfo.h>
+#include <elevation_map_msgs/GetMemoryUsage.h>
+#include <elevation_map_msgs/MemoryUsage.h>
 
 #include "elevation_mapping_cupy/elevation_mapping_wrapper.hpp"
+#include "elevation_mapping_cupy/point_cloud_writer.hpp"
+#include "elevation_mapping_cupy/shared_map.hpp"
 
 namespace py = pybind11;
 
@@ -97,21 +101,28 @@ class ElevationMappingNode {
   void imageChannelCallback(const sensor_msgs::ImageConstPtr& image_msg, const sensor_msgs::CameraInfoConstPtr& camera_info_msg, const elevation_map_msgs::ChannelInfoConstPtr& channel_info_msg);
   void pointCloudChannelCallback(const sensor_msgs::PointCloud2& cloud, const elevation_map_msgs::ChannelInfoConstPtr& channel_info_msg);
   // void multiLayerImageCallback(const elevation_map_msgs::MultiLayerImageConstPtr& image_msg, const sensor_msgs::CameraInfoConstPtr& camera_info_msg);
-  void publishAsPointCloud(const grid_map::GridMap& map) const;
+  void publishAsPointCloud(const grid_map::GridMap& map);
   bool getSubmap(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response);
   bool checkSafety(elevation_map_msgs::CheckSafety::Request& request, elevation_map_msgs::CheckSafety::Response& response);
   bool initializeMap(elevation_map_msgs::Initialize::Request& request, elevation_map_msgs::Initialize::Response& response);
   bool clearMap(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response);
   bool clearMapWithInitializer(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response);
   bool setPublishPoint(std_srvs::SetBool::Request& request, std_srvs::SetBool::Response& response);
+  bool getMemoryUsage(elevation_map_msgs::GetMemoryUsage::Request& request, elevation_map_msgs::GetMemoryUsage::Response& response);
   void updatePose(const ros::TimerEvent&);
   void updateVariance(const ros::TimerEvent&);
   void updateTime(const ros::TimerEvent&);
   void updateGridMap(const ros::TimerEvent&);
   void publishNormalAsArrow(const grid_map::GridMap& map) const;
+  void exportToSharedMemory(const grid_map::GridMap& map);
   void initializeWithTF();
   void publishMapToOdom(double error);
   void publishStatistics(const ros::TimerEvent&);
+  void publishMemoryUsage(const ros::TimerEvent&);
+  // Requires mapMutex_ to be locked.
+  elevation_map_msgs::MemoryUsage collectMemoryUsage();
+  // Requires mapMutex_ to be locked. Returns false if the layer must not be added to gridMap_.
+  bool checkMemoryBudget(const std::string& layer, size_t layerBytes);
   void publishMapOfIndex(int index);
 
   visualization_msgs::Marker vectorToArrowMarker(const Eigen::Vector3d& start, const Eigen::Vector3d& end, const int id) const;
@@ -131,17 +142,20 @@ class ElevationMappingNode {
   ros::Publisher pointPub_;
   ros::Publisher normalPub_;
   ros::Publisher statisticsPub_;
+  ros::Publisher memoryUsagePub_;
   ros::ServiceServer rawSubmapService_;
   ros::ServiceServer clearMapService_;
   ros::ServiceServer clearMapWithInitializerService_;
   ros::ServiceServer initializeMapService_;
   ros::ServiceServer setPublishPointService_;
   ros::ServiceServer checkSafetyService_;
+  ros::ServiceServer memoryUsageService_;
   ros::Timer updateVarianceTimer_;
   ros::Timer updateTimeTimer_;
   ros::Timer updatePoseTimer_;
   ros::Timer updateGridMapTimer_;
   ros::Timer publishStatisticsTimer_;
+  ros::Timer publishMemoryUsageTimer_;
   ros::Time lastStatisticsPublishedTime_;
   tf::TransformListener transformListener_;
   ElevationMappingWrapper map_;
@@ -186,6 +200,24 @@ class ElevationMappingNode {
   double initializeTfGridSize_;
   bool alwaysClearWithInitializer_;
   std::atomic_int pointCloudProcessCounter_;
+
+  // Memory accounting
+  size_t memoryBudgetBytes_;  // 0 disables the budget
+  bool memoryBudgetRefuseLayers_;
+  std::mutex memoryMutex_;  // protects mapMessageBytes_
+  std::vector<size_t> mapMessageBytes_;  // serialized size of the last message of each map publisher
+  std::atomic<size_t> pointCloudBufferBytes_;
+  std::atomic<size_t> imageBufferBytes_;
+
+  // Shared memory export, created with the size of the first map
+  bool enableSharedMemoryExport_;
+  std::string sharedMemoryName_;
+  int sharedMemoryMaxLayers_;
+  std::unique_ptr<SharedMapWriter> sharedMapWriter_;  // protected by mapMutex_
+
+  // Point cloud publishing, the message is reused while no subscriber in the same process holds it
+  std::unique_ptr<PointCloudWriter> pointCloudWriter_;
+  sensor_msgs::PointCloud2Ptr pointCloudMsg_;  // protected by mapMutex_
 };
 
 }  // namespace elevation_mapping_cupy
@@ -7,6 +7,7 @@
 
 // STL
 #include <iostream>
+#include <map>
 
 // Eigen
 #include <Eigen/Dense>
@@ -62,6 +63,8 @@ class ElevationMappingWrapper {
   double get_additive_mean_error();
   void initializeWithPoints(std::vector<Eigen::Vector3d>& points, std::string method);
   void addNormalColorLayer(grid_map::GridMap& map);
+  std::map<std::string, size_t> get_memory_usage();
+  size_t get_memory_pool_usage();
 
  private:
   void setParameters(ros::NodeHandle& nh);
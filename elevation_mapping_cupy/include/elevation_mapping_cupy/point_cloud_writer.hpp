@@ -0,0 +1,47 @@
+//
+// Writes a grid map into a sensor_msgs::PointCloud2. Positions and layers are packed in one pass over the layer matrices, instead of the
+// cell by cell lookups of grid_map::GridMapRosConverter::toPointCloud.
+//
+
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+// ROS
+#include <sensor_msgs/PointCloud2.h>
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+namespace elevation_mapping_cupy {
+
+class PointCloudWriter {
+ public:
+  /**
+   * @param heightLayer layer written as the z coordinate.
+   * @param layers layers written as float fields after x, y, z. All other layers of the map if empty. "color" is written as "rgb".
+   * @param skipInvalid skip cells without a finite height. Ignored by organized clouds.
+   * @param organized write one point per cell, with the map rows as cloud rows. Cells without a finite height have NaN coordinates.
+   */
+  explicit PointCloudWriter(std::string heightLayer = "elevation", std::vector<std::string> layers = {}, bool skipInvalid = true,
+                            bool organized = false);
+
+  /**
+   * Fills the cloud with the cells of the map, in the frame and with the timestamp of the map. The data buffer of the cloud is reused,
+   * it only reallocates if the map or the number of fields grows.
+   * @throw std::invalid_argument if the height layer or one of the layers is not in the map.
+   */
+  void write(const grid_map::GridMap& map, sensor_msgs::PointCloud2& cloud) const;
+
+  bool isOrganized() const { return organized_; }
+
+ private:
+  std::string heightLayer_;
+  std::vector<std::string> layers_;
+  bool skipInvalid_;
+  bool organized_;
+};
+
+}  // namespace elevation_mapping_cupy
@@ -0,0 +1,427 @@
+//
+// Export of the elevation map to POSIX shared memory, for consumers on the same machine. Header-only and without ROS dependencies, such
+// that planners and controllers can read the map without deserializing a grid_map_msgs::GridMap.
+//
+// The shared memory object holds a fixed header, followed by maxLayers x maxCells floats. The writer updates it with a seqlock: the
+// sequence number is odd while a map is written, and readers retry until they copied a map during which it did not change. Readers never
+// block the writer.
+//
+
+#pragma once
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// POSIX
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Eigen
+#include <Eigen/Core>
+
+namespace elevation_mapping_cupy {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The seqlock requires lock-free 64 bit atomics to work across processes.");
+
+/// Geometry of a grid_map::GridMap. Layers are stored column-major, with the circular buffer start index of the grid map.
+struct SharedMapGeometry {
+  std::string frameId;
+  double resolution = 0.0;
+  double lengthX = 0.0;
+  double lengthY = 0.0;
+  double positionX = 0.0;
+  double positionY = 0.0;
+  int rows = 0;
+  int cols = 0;
+  int startIndexRow = 0;
+  int startIndexCol = 0;
+};
+
+/// Copy of one map, as returned by SharedMapReader::read.
+struct SharedMapSnapshot {
+  SharedMapGeometry geometry;
+  uint64_t timestamp = 0;  // [ns]
+  uint64_t updateCount = 0;
+  std::vector<std::string> layerNames;
+  std::vector<Eigen::MatrixXf> layers;
+
+  /// Returns nullptr if the layer is not in the snapshot.
+  const Eigen::MatrixXf* get(const std::string& layerName) const {
+    const auto it = std::find(layerNames.begin(), layerNames.end(), layerName);
+    return it == layerNames.end() ? nullptr : &layers[it - layerNames.begin()];
+  }
+};
+
+namespace shared_map {
+
+constexpr uint32_t kMagic = 0x4d534d45;  // "EMSM"
+constexpr uint32_t kLayoutVersion = 2;
+constexpr size_t kMaxNameLength = 64;  // including the terminating zero
+
+struct LayerEntry {
+  char name[kMaxNameLength];
+};
+
+/// Fixed layout at the start of the shared memory object. Followed by the layer table and the layer data.
+struct Header {
+  uint32_t magic;
+  uint32_t layoutVersion;
+  uint64_t maxLayers;
+  uint64_t maxCells;
+  // Process that created the object.
+  int64_t writerPid;
+  // Odd while the writer updates the map. Incremented by two per map.
+  std::atomic<uint64_t> sequence;
+
+  // Written under the seqlock.
+  uint64_t timestamp;
+  char frameId[kMaxNameLength];
+  double resolution;
+  double lengthX;
+  double lengthY;
+  double positionX;
+  double positionY;
+  int32_t rows;
+  int32_t cols;
+  int32_t startIndexRow;
+  int32_t startIndexCol;
+  uint64_t numLayers;
+};
+
+inline size_t layerTableOffset() {
+  return (sizeof(Header) + 63) / 64 * 64;
+}
+
+inline size_t dataOffset(size_t maxLayers) {
+  return (layerTableOffset() + maxLayers * sizeof(LayerEntry) + 63) / 64 * 64;
+}
+
+inline size_t totalSize(size_t maxLayers, size_t maxCells) {
+  return dataOffset(maxLayers) + maxLayers * maxCells * sizeof(float);
+}
+
+inline void copyName(char (&destination)[kMaxNameLength], const std::string& name) {
+  if (name.size() >= kMaxNameLength) {
+    throw std::invalid_argument("SharedMap: name " + name + " is longer than " + std::to_string(kMaxNameLength - 1) + " characters.");
+  }
+  std::memset(destination, 0, kMaxNameLength);
+  std::memcpy(destination, name.data(), name.size());
+}
+
+inline std::string readName(const char (&source)[kMaxNameLength]) {
+  return std::string(source, strnlen(source, kMaxNameLength));
+}
+
+/**
+ * Pid of the writer of an existing object, read from its header. Returns 0 if the object is gone, and -1 if the header is not
+ * initialized yet (another writer is creating it) or has an unknown layout.
+ */
+inline int64_t existingWriterPid(const std::string& name) {
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return errno == ENOENT ? 0 : -1;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) {
+    close(fd);
+    return -1;
+  }
+  void* memory = mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return -1;
+  }
+  const auto* header = static_cast<const Header*>(memory);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const bool isValid = header->magic == kMagic && header->layoutVersion == kLayoutVersion;
+  const int64_t pid = isValid ? header->writerPid : -1;
+  munmap(memory, sizeof(Header));
+  return pid;
+}
+
+/// True if the process exists. A process of another user counts as alive.
+inline bool isProcessAlive(int64_t pid) {
+  return pid > 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+}  // namespace shared_map
+
+/**
+ * Creates the shared memory object and publishes maps to it. The object is removed when the writer is destroyed.
+ * Only one writer per name is supported: the constructor fails while the writer recorded in an existing object is alive, and takes over
+ * objects left behind by a writer that died.
+ */
+class SharedMapWriter {
+ public:
+  /**
+   * @param name : name of the shared memory object, e.g. "/elevation_map". Appears in /dev/shm on Linux.
+   * @param maxLayers : maximum number of layers per map.
+   * @param maxCells : maximum number of cells per layer.
+   * Throws std::runtime_error if another writer uses the name.
+   */
+  SharedMapWriter(const std::string& name, size_t maxLayers, size_t maxCells) : name_(name) {
+    if (maxLayers == 0 || maxCells == 0) {
+      throw std::invalid_argument("SharedMapWriter: maxLayers and maxCells must be positive.");
+    }
+    size_ = shared_map::totalSize(maxLayers, maxCells);
+    const int fd = createExclusive();
+    struct stat status {};
+    if (fstat(fd, &status) != 0) {
+      const std::string error = std::strerror(errno);
+      close(fd);
+      shm_unlink(name_.c_str());
+      throw std::runtime_error("SharedMapWriter: could not stat " + name_ + ": " + error);
+    }
+    inode_ = status.st_ino;
+    if (ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+      const std::string error = std::strerror(errno);
+      close(fd);
+      shm_unlink(name_.c_str());
+      throw std::runtime_error("SharedMapWriter: could not resize " + name_ + ": " + error);
+    }
+    void* memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+      shm_unlink(name_.c_str());
+      throw std::runtime_error("SharedMapWriter: could not map " + name_ + ": " + std::strerror(errno));
+    }
+    memory_ = static_cast<char*>(memory);
+
+    // Readers check the magic number last, such that they never see a partially initialized header.
+    header_ = reinterpret_cast<shared_map::Header*>(memory_);
+    header_->magic = 0;
+    header_->layoutVersion = shared_map::kLayoutVersion;
+    header_->maxLayers = maxLayers;
+    header_->maxCells = maxCells;
+    header_->writerPid = getpid();
+    new (&header_->sequence) std::atomic<uint64_t>(0);
+    header_->numLayers = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = shared_map::kMagic;
+  }
+
+  ~SharedMapWriter() {
+    munmap(memory_, size_);
+    if (isOwnObject()) {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  SharedMapWriter(const SharedMapWriter&) = delete;
+  SharedMapWriter& operator=(const SharedMapWriter&) = delete;
+
+  /**
+   * Publishes a map. Layers are column-major matrices of geometry.rows x geometry.cols, as in grid_map::GridMap.
+   * Throws std::invalid_argument if the map does not fit, in which case the previous map stays readable.
+   */
+  void write(const SharedMapGeometry& geometry, uint64_t timestamp, const std::vector<std::string>& layerNames,
+             const std::vector<const Eigen::MatrixXf*>& layers) {
+    const size_t numCells = static_cast<size_t>(geometry.rows) * static_cast<size_t>(geometry.cols);
+    if (layerNames.size() != layers.size() || layers.size() > header_->maxLayers || numCells > header_->maxCells) {
+      throw std::invalid_argument("SharedMapWriter: " + std::to_string(layers.size()) + " layers of " + std::to_string(numCells) +
+                                  " cells do not fit in " + name_ + ".");
+    }
+    for (const auto* layer : layers) {
+      if (layer->rows() != geometry.rows || layer->cols() != geometry.cols) {
+        throw std::invalid_argument("SharedMapWriter: the layer size does not match the geometry.");
+      }
+    }
+    for (const auto& layerName : layerNames) {
+      if (layerName.size() >= shared_map::kMaxNameLength) {
+        throw std::invalid_argument("SharedMapWriter: layer name " + layerName + " is too long.");
+      }
+    }
+    if (geometry.frameId.size() >= shared_map::kMaxNameLength) {
+      throw std::invalid_argument("SharedMapWriter: frame id " + geometry.frameId + " is too long.");
+    }
+
+    const uint64_t sequence = header_->sequence.load(std::memory_order_relaxed);
+    header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header_->timestamp = timestamp;
+    shared_map::copyName(header_->frameId, geometry.frameId);
+    header_->resolution = geometry.resolution;
+    header_->lengthX = geometry.lengthX;
+    header_->lengthY = geometry.lengthY;
+    header_->positionX = geometry.positionX;
+    header_->positionY = geometry.positionY;
+    header_->rows = geometry.rows;
+    header_->cols = geometry.cols;
+    header_->startIndexRow = geometry.startIndexRow;
+    header_->startIndexCol = geometry.startIndexCol;
+    header_->numLayers = layers.size();
+    auto* layerTable = reinterpret_cast<shared_map::LayerEntry*>(memory_ + shared_map::layerTableOffset());
+    auto* data = reinterpret_cast<float*>(memory_ + shared_map::dataOffset(header_->maxLayers));
+    for (size_t i = 0; i < layers.size(); ++i) {
+      shared_map::copyName(layerTable[i].name, layerNames[i]);
+      std::memcpy(data + i * header_->maxCells, layers[i]->data(), numCells * sizeof(float));
+    }
+
+    header_->sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  const std::string& name() const { return name_; }
+
+  /// Size of the shared memory object.
+  size_t sizeInBytes() const { return size_; }
+
+ private:
+  /// Creates the object, replacing one left behind by a dead writer. Returns the file descriptor.
+  int createExclusive() const {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+      if (fd >= 0) {
+        return fd;
+      }
+      if (errno != EEXIST) {
+        throw std::runtime_error("SharedMapWriter: could not create " + name_ + ": " + std::strerror(errno));
+      }
+      const int64_t pid = shared_map::existingWriterPid(name_);
+      if (pid < 0 || shared_map::isProcessAlive(pid)) {
+        const std::string writer = pid < 0 ? "another writer" : "process " + std::to_string(pid);
+        throw std::runtime_error("SharedMapWriter: " + name_ + " is already written by " + writer +
+                                 ". Use another name, or remove /dev/shm" + name_ + " if no writer is running.");
+      }
+      if (pid > 0) {
+        shm_unlink(name_.c_str());  // Stale object of a writer that died.
+      }
+    }
+    throw std::runtime_error("SharedMapWriter: could not create " + name_ + ": another writer created it concurrently.");
+  }
+
+  /// True if the name still refers to the object created by this writer.
+  bool isOwnObject() const {
+    const int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat status {};
+    const bool isOwn = fstat(fd, &status) == 0 && status.st_ino == inode_;
+    close(fd);
+    return isOwn;
+  }
+
+  std::string name_;
+  size_t size_ = 0;
+  ino_t inode_ = 0;
+  char* memory_ = nullptr;
+  shared_map::Header* header_ = nullptr;
+};
+
+/**
+ * Maps the shared memory object of a SharedMapWriter read-only and copies consistent snapshots out of it.
+ */
+class SharedMapReader {
+ public:
+  /// Throws std::runtime_error if the object does not exist or was written by another layout version.
+  explicit SharedMapReader(const std::string& name) : name_(name) {
+    const int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      throw std::runtime_error("SharedMapReader: could not open " + name_ + ": " + std::strerror(errno));
+    }
+    struct stat status {};
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(shared_map::Header)) {
+      close(fd);
+      throw std::runtime_error("SharedMapReader: " + name_ + " is not initialized.");
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    void* memory = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+      throw std::runtime_error("SharedMapReader: could not map " + name_ + ": " + std::strerror(errno));
+    }
+    memory_ = static_cast<const char*>(memory);
+    header_ = reinterpret_cast<const shared_map::Header*>(memory_);
+
+    const bool isValid = header_->magic == shared_map::kMagic && header_->layoutVersion == shared_map::kLayoutVersion &&
+                         shared_map::totalSize(header_->maxLayers, header_->maxCells) <= size_;
+    if (!isValid) {
+      munmap(const_cast<char*>(memory_), size_);
+      throw std::runtime_error("SharedMapReader: " + name_ + " has an unknown layout.");
+    }
+  }
+
+  ~SharedMapReader() { munmap(const_cast<char*>(memory_), size_); }
+
+  SharedMapReader(const SharedMapReader&) = delete;
+  SharedMapReader& operator=(const SharedMapReader&) = delete;
+
+  /// Number of maps written so far. Cheap, use it to poll for new maps.
+  uint64_t updateCount() const { return header_->sequence.load(std::memory_order_acquire) / 2; }
+
+  /**
+   * Copies the latest map into snapshot, reusing its memory.
+   * @param maxAttempts : number of tries while the writer updates the map.
+   * @return false if no map was written yet, or if every attempt overlapped with a write.
+   */
+  bool read(SharedMapSnapshot& snapshot, int maxAttempts = 100) const {
+    const auto* layerTable = reinterpret_cast<const shared_map::LayerEntry*>(memory_ + shared_map::layerTableOffset());
+    const auto* data = reinterpret_cast<const float*>(memory_ + shared_map::dataOffset(header_->maxLayers));
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+      const uint64_t sequence = header_->sequence.load(std::memory_order_acquire);
+      if (sequence == 0) {
+        return false;
+      }
+      if (sequence % 2 == 1) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Values can be torn while the writer is active. They are validated by the sequence check before they are used.
+      auto& geometry = snapshot.geometry;
+      snapshot.timestamp = header_->timestamp;
+      geometry.frameId = shared_map::readName(header_->frameId);
+      geometry.resolution = header_->resolution;
+      geometry.lengthX = header_->lengthX;
+      geometry.lengthY = header_->lengthY;
+      geometry.positionX = header_->positionX;
+      geometry.positionY = header_->positionY;
+      geometry.rows = header_->rows;
+      geometry.cols = header_->cols;
+      geometry.startIndexRow = header_->startIndexRow;
+      geometry.startIndexCol = header_->startIndexCol;
+      const size_t numLayers = std::min<uint64_t>(header_->numLayers, header_->maxLayers);
+      const size_t numCells = static_cast<size_t>(std::max(geometry.rows, 0)) * static_cast<size_t>(std::max(geometry.cols, 0));
+      if (numCells > header_->maxCells) {
+        continue;
+      }
+      snapshot.layerNames.resize(numLayers);
+      snapshot.layers.resize(numLayers);
+      for (size_t i = 0; i < numLayers; ++i) {
+        snapshot.layerNames[i] = shared_map::readName(layerTable[i].name);
+        snapshot.layers[i].resize(geometry.rows, geometry.cols);
+        std::memcpy(snapshot.layers[i].data(), data + i * header_->maxCells, numCells * sizeof(float));
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (header_->sequence.load(std::memory_order_relaxed) == sequence) {
+        snapshot.updateCount = sequence / 2;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const std::string& name() const { return name_; }
+
+ private:
+  std::string name_;
+  size_t size_ = 0;
+  const char* memory_ = nullptr;
+  const shared_map::Header* header_ = nullptr;
+};
+
+}  // namespace elevation_mapping_cupy
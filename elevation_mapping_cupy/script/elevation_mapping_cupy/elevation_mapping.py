@@ -116,6 +116,10 @@ class ElevationMap:
 
         self.map_initializer = MapInitializer(self.initial_variance, param.initialized_variance, xp=cp, method="points")
 
+        self.semantic_map.memory_budget_check = self.check_memory_budget
+        if self.exceeds_memory_budget():
+            print(f"[WARNING] The map already exceeds the memory budget of {self.param.memory_budget_mb} MB.")
+
     def clear(self):
         """Reset all the layers of the elevation & the semantic map."""
         with self.map_lock:
@@ -656,6 +660,64 @@ class ElevationMap:
             else:
                 data[...] = cp.asnumpy(array.astype(np.float32))
 
+    def get_memory_usage(self):
+        """Return the bytes held by the map, per component.
+
+        The components do not overlap. The cupy memory pool can hold more memory than their sum, see get_memory_pool_usage.
+
+        Returns:
+            Dict[str, int]: bytes of the elevation layers, buffers, semantic layers and plugin layers.
+        """
+        buffers = [self.traversability_buffer, self.normal_map]
+        if hasattr(self, "uv_correspondence"):
+            buffers += [self.uv_correspondence, self.valid_correspondence]
+        return {
+            "elevation_layers": int(self.elevation_map.nbytes),
+            "buffers": int(sum(buffer.nbytes for buffer in buffers)),
+            "semantic_layers": self.semantic_map.get_memory_usage(),
+            "plugin_layers": int(self.plugin_manager.layers.nbytes),
+        }
+
+    def get_memory_pool_usage(self):
+        """Return the bytes allocated by the cupy memory pool, including freed blocks that are kept for reuse.
+
+        Returns:
+            int: bytes
+        """
+        return int(pool.total_bytes())
+
+    def exceeds_memory_budget(self, additional_bytes=0):
+        """Check if the map exceeds memory_budget_mb after adding additional_bytes.
+
+        Args:
+            additional_bytes (int): bytes that are about to be allocated.
+
+        Returns:
+            bool: False if the budget is disabled.
+        """
+        if self.param.memory_budget_mb <= 0.0:
+            return False
+        used_bytes = sum(self.get_memory_usage().values())
+        return used_bytes + additional_bytes > self.param.memory_budget_mb * 1024 * 1024
+
+    def check_memory_budget(self, name, additional_bytes):
+        """Warn if adding a layer exceeds the memory budget.
+
+        Args:
+            name (str): name of the layer that is about to be added.
+            additional_bytes (int): bytes of the layer.
+
+        Returns:
+            bool: False if the layer must not be added, see memory_budget_refuse_layers.
+        """
+        if not self.exceeds_memory_budget(additional_bytes):
+            return True
+        if self.param.memory_budget_refuse_layers:
+            print(f"[WARNING] Layer {name} is not added, it would exceed the memory budget of {self.param.memory_budget_mb} MB.")
+            return False
+        print(f"[WARNING] Layer {name} exceeds the memory budget of {self.param.memory_budget_mb} MB.")
+        return True
+
     def exists_layer(self, name):
         """Check if the layer exists in elevation map or in the semantic map.
 
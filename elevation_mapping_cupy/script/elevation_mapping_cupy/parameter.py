@@ -110,6 +110,10 @@ class Parameter(Serializable):
                               (Default: ``0.1``)
         orientation_noise_thresh: If the orientation change is bigger than this value, the drift compensation happens.  
                                   (Default: ``0.1``)
+        memory_budget_mb: Memory budget [MB] of the map layers, buffers, semantic and plugin layers. 0 disables the budget.  
+                          (Default: ``0.0``)
+        memory_budget_refuse_layers: Refuse to add semantic layers that exceed the memory budget instead of only warning.  
+                                     (Default: ``False``)
         plugin_config_file: Configuration file for the plugin.  
                             (Default: ``"config/plugin_config.yaml"``)
         weight_file: Weight file for traversability filter.  
@@ -210,6 +214,9 @@ class Parameter(Serializable):
     position_noise_thresh: float = 0.1  # if the position change is bigger than this value, the drift compensation happens.
     orientation_noise_thresh: float = 0.1  # if the orientation change is bigger than this value, the drift compensation happens.
 
+    memory_budget_mb: float = 0.0  # memory budget of the map layers, buffers, semantic and plugin layers. 0 disables it.
+    memory_budget_refuse_layers: bool = False  # refuse to add semantic layers that exceed the budget instead of only warning.
+
     plugin_config_file: str = "config/plugin_config.yaml"  # configuration file for the plugin
     weight_file: str = "config/weights.dat"  # weight file for traversability filter
 
@@ -43,6 +43,8 @@ class SemanticMap:
         # if a layer should not be reset, it is defined in compile_kernels function
         self.delete_new_layers = cp.ones(self.new_map.shape[0], cp.bool8)
         self.fusion_manager = FusionManager(self.param)
+        # Called with the layer name and its size in bytes before a layer is added, returns False to refuse it.
+        self.memory_budget_check = None
 
     def clear(self):
         """Clear the semantic map."""
@@ -83,8 +85,14 @@ class SemanticMap:
 
         Args:
             name (str): The name of the new layer.
+
+        Returns:
+            bool: False if the layer was refused by the memory budget.
         """
         if name not in self.layer_names:
+            layer_bytes = 2 * self.param.cell_n * self.param.cell_n * np.dtype(self.param.data_type).itemsize
+            if self.memory_budget_check is not None and not self.memory_budget_check(name, layer_bytes):
+                return False
             self.layer_names.append(name)
             self.semantic_map = cp.append(
                 self.semantic_map,
@@ -95,6 +103,16 @@ class SemanticMap:
                 self.new_map, cp.zeros((1, self.param.cell_n, self.param.cell_n), dtype=self.param.data_type), axis=0,
             )
             self.delete_new_layers = cp.append(self.delete_new_layers, cp.array([1], dtype=cp.bool8))
+        return True
+
+    def get_memory_usage(self):
+        """Return the bytes held by the semantic layers, including the fusion buffers.
+
+        Returns:
+            int: bytes
+        """
+        arrays = [self.semantic_map, self.new_map, self.delete_new_layers] + list(self.elements_to_shift.values())
+        return int(sum(array.nbytes for array in arrays))
 
     def pad_value(self, x, shift_value, idx=None, value=0.0):
         """Create a padding of the map along x,y-axis according to amount that has shifted.
@@ -211,11 +229,15 @@ class SemanticMap:
         # this contains exactly the fusion alg type for each channel of the pcl
         pcl_val_list = [layer_specs[x] for x in pcl_channels]
         # this contains the indices of the point cloud where we have to perform a certain fusion
-        pcl_indices = cp.array([idp + 3 for idp, x in enumerate(pcl_val_list) if x == fusion_alg], dtype=cp.int32,)
+        # channels whose layer was refused by the memory budget are skipped
+        pcl_indices = cp.array(
+            [idp + 3 for idp, x in enumerate(pcl_val_list) if x == fusion_alg and pcl_channels[idp] in self.layer_names],
+            dtype=cp.int32,
+        )
         # create a list of indices of the layers that will be updated by the point cloud with specific fusion alg
         layer_indices = cp.array([], dtype=cp.int32)
         for it, (key, val) in enumerate(layer_specs.items()):
-            if key in pcl_channels and val == fusion_alg:
+            if key in pcl_channels and val == fusion_alg and key in self.layer_names:
                 layer_idx = self.layer_names.index(key)
                 layer_indices = cp.append(layer_indices, layer_idx).astype(cp.int32)
         return pcl_indices, layer_indices
@@ -287,7 +309,8 @@ class SemanticMap:
         for j, (fusion, channel) in enumerate(zip(fusion_methods, process_channels)):
             if channel not in self.layer_names:
                 print(f"Layer {channel} not found, adding it to the semantic map")
-                self.add_layer(channel)
+                if not self.add_layer(channel):
+                    continue
             sem_map_idx = self.get_index(channel)
 
             if sem_map_idx == -1:
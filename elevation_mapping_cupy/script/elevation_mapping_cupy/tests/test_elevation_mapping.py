@@ -116,3 +116,30 @@ class TestElevationMap:
         data = np.zeros((200, 200), dtype=np.float32)
         for layer in layers:
             elmap_ex.get_map_with_name_ref(layer, data)
+
+    def test_memory_usage(self, elmap_ex):
+        cell_bytes = elmap_ex.cell_n * elmap_ex.cell_n * np.dtype(elmap_ex.data_type).itemsize
+        usage = elmap_ex.get_memory_usage()
+        assert usage["elevation_layers"] == 7 * cell_bytes
+        assert usage["plugin_layers"] == len(elmap_ex.plugin_manager.layer_names) * elmap_ex.cell_n * elmap_ex.cell_n * 4
+        assert usage["buffers"] >= elmap_ex.traversability_buffer.nbytes + 3 * cell_bytes
+        assert elmap_ex.get_memory_pool_usage() >= sum(usage.values())
+
+        # A semantic layer is held twice, in the semantic map and in the buffer of new measurements.
+        semantic_bytes = usage["semantic_layers"]
+        assert elmap_ex.semantic_map.add_layer("memory_test")
+        assert elmap_ex.get_memory_usage()["semantic_layers"] == semantic_bytes + 2 * cell_bytes + 1
+
+    def test_memory_budget(self, elmap_ex):
+        used_mb = sum(elmap_ex.get_memory_usage().values()) / 1024 / 1024
+        elmap_ex.param.memory_budget_mb = used_mb + 0.001
+        assert not elmap_ex.exceeds_memory_budget()
+        assert elmap_ex.exceeds_memory_budget(2 * elmap_ex.cell_n * elmap_ex.cell_n * 4)
+
+        # Layers that exceed the budget are only refused if configured.
+        assert elmap_ex.semantic_map.add_layer("warned_layer")
+        elmap_ex.param.memory_budget_refuse_layers = True
+        assert not elmap_ex.semantic_map.add_layer("refused_layer")
+        assert not elmap_ex.exists_layer("refused_layer")
+        elmap_ex.param.memory_budget_mb = 0.0
+        assert elmap_ex.semantic_map.add_layer("refused_layer")
@@ -0,0 +1,56 @@
+//
+// Nodelet version of the elevation mapping node. Point clouds from a driver and the published maps are passed by shared pointer
+// between nodelets of the same manager, without serialization.
+//
+
+#include <dlfcn.h>
+
+#include <memory>
+
+// Pybind
+#include <pybind11/embed.h>
+
+// ROS
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+
+#include "elevation_mapping_cupy/elevation_mapping_ros.hpp"
+
+namespace elevation_mapping_cupy {
+
+class ElevationMappingNodelet : public nodelet::Nodelet {
+ public:
+  ~ElevationMappingNodelet() override {
+    if (mapNode_ != nullptr) {
+      // The python objects of the node are released with the GIL held.
+      py::gil_scoped_acquire acquire;
+      mapNode_.reset();
+    }
+  }
+
+ private:
+  void onInit() override {
+    // The interpreter is shared by all nodelets of the manager and is kept alive until the process exits.
+    if (!Py_IsInitialized()) {
+      // pluginlib loads this library with local symbols. The extension modules imported by the map (numpy, cupy) need the symbols of
+      // libpython, such that it is reopened globally before the interpreter starts.
+      if (dlopen(ELEVATION_MAPPING_PYTHON_LIBRARY, RTLD_NOW | RTLD_GLOBAL | RTLD_NOLOAD) == nullptr) {
+        NODELET_WARN_STREAM("Could not load " << ELEVATION_MAPPING_PYTHON_LIBRARY << " globally: " << dlerror());
+      }
+      py::initialize_interpreter();
+      // Release the GIL taken by the initialization, every call into python acquires it.
+      PyEval_SaveThread();
+    }
+
+    // The private node handle has a single threaded queue, same as the spinner of the standalone node.
+    py::gil_scoped_acquire acquire;
+    mapNode_.reset(new ElevationMappingNode(getPrivateNodeHandle()));
+  }
+
+  std::unique_ptr<ElevationMappingNode> mapNode_;
+};
+
+}  // namespace elevation_mapping_cupy
+
+PLUGINLIB_EXPORT_CLASS(elevation_mapping_cupy::ElevationMappingNodelet, nodelet::Nodelet)
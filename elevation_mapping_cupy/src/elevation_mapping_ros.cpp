@@ -8,6 +8,9 @@
 // Pybind
 #include <pybind11/eigen.h>
 
+// Boost
+#include <boost/make_shared.hpp>
+
 // ROS
 #include <geometry_msgs/Point32.h>
 #include <ros/package.h>
@@ -29,7 +32,11 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
       positionAlpha_(0.1),
       orientationAlpha_(0.1),
       enablePointCloudPublishing_(false),
-      isGridmapUpdated_(false) {
+      isGridmapUpdated_(false),
+      memoryBudgetBytes_(0),
+      memoryBudgetRefuseLayers_(false),
+      pointCloudBufferBytes_(0),
+      imageBufferBytes_(0) {
   nh_ = nh;
 
   std::string pose_topic, map_frame;
@@ -37,6 +44,7 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
   XmlRpc::XmlRpcValue subscribers;
   std::vector<std::string> map_topics;
   double recordableFps, updateVarianceFps, timeInterval, updatePoseFps, updateGridMapFps, publishStatisticsFps;
+  double publishMemoryUsageFps, memoryBudgetMb;
   bool enablePointCloudPublishing(false);
 
   // Read parameters
@@ -64,13 +72,26 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
   nh.param<double>("initialize_tf_grid_size", initializeTfGridSize_, 0.5);
   nh.param<double>("map_acquire_fps", updateGridMapFps, 5.0);
   nh.param<double>("publish_statistics_fps", publishStatisticsFps, 1.0);
+  nh.param<double>("publish_memory_usage_fps", publishMemoryUsageFps, 1.0);
+  nh.param<double>("memory_budget_mb", memoryBudgetMb, 0.0);
+  nh.param<bool>("memory_budget_refuse_layers", memoryBudgetRefuseLayers_, false);
+  nh.param<bool>("enable_shared_memory_export", enableSharedMemoryExport_, false);
+  nh.param<std::string>("shared_memory_name", sharedMemoryName_, "/elevation_map");
+  nh.param<int>("shared_memory_max_layers", sharedMemoryMaxLayers_, 16);
   nh.param<bool>("enable_pointcloud_publishing", enablePointCloudPublishing, false);
+  std::vector<std::string> pointCloudLayers;
+  bool pointCloudSkipInvalid, pointCloudOrganized;
+  nh.param<std::vector<std::string>>("pointcloud_layers", pointCloudLayers, {});
+  nh.param<bool>("pointcloud_skip_invalid", pointCloudSkipInvalid, true);
+  nh.param<bool>("pointcloud_organized", pointCloudOrganized, false);
   nh.param<bool>("enable_normal_arrow_publishing", enableNormalArrowPublishing_, false);
   nh.param<bool>("enable_drift_corrected_TF_publishing", enableDriftCorrectedTFPublishing_, false);
   nh.param<bool>("use_initializer_at_start", useInitializerAtStart_, false);
   nh.param<bool>("always_clear_with_initializer", alwaysClearWithInitializer_, false);
 
   enablePointCloudPublishing_ = enablePointCloudPublishing;
+  pointCloudWriter_.reset(new PointCloudWriter("elevation", pointCloudLayers, pointCloudSkipInvalid, pointCloudOrganized));
+  memoryBudgetBytes_ = static_cast<size_t>(std::max(memoryBudgetMb, 0.0) * 1024.0 * 1024.0);
 
   // Iterate all the subscribers
   // here we have to remove all the stuff
@@ -84,7 +105,10 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
       channels_[key].push_back("x");
       channels_[key].push_back("y");
       channels_[key].push_back("z");
-      boost::function<void(const sensor_msgs::PointCloud2&)> f = boost::bind(&ElevationMappingNode::pointcloudCallback, this, _1, key);
+      // Subscribe with a shared pointer, clouds of a driver nodelet in the same manager are not copied.
+      boost::function<void(const sensor_msgs::PointCloud2ConstPtr&)> f = [this, key](const sensor_msgs::PointCloud2ConstPtr& cloud) {
+        pointcloudCallback(*cloud, key);
+      };
       ros::Subscriber sub = nh_.subscribe<sensor_msgs::PointCloud2>(pointcloud_topic, 1, f);
       pointcloudSubs_.push_back(sub);
       ROS_INFO_STREAM("Subscribed to PointCloud2 topic: " << pointcloud_topic);
@@ -190,12 +214,14 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
     map_fps_.push_back(fps);
     map_fps_unique_.insert(fps);
   }
+  mapMessageBytes_.resize(mapPubs_.size(), 0);
   setupMapPublishers();
 
   pointPub_ = nh_.advertise<sensor_msgs::PointCloud2>("elevation_map_points", 1);
   alivePub_ = nh_.advertise<std_msgs::Empty>("alive", 1);
   normalPub_ = nh_.advertise<visualization_msgs::MarkerArray>("normal", 1);
   statisticsPub_ = nh_.advertise<elevation_map_msgs::Statistics>("statistics", 1);
+  memoryUsagePub_ = nh_.advertise<elevation_map_msgs::MemoryUsage>("memory_usage", 1);
 
   gridMap_.setFrameId(mapFrameId_);
   rawSubmapService_ = nh_.advertiseService("get_raw_submap", &ElevationMappingNode::getSubmap, this);
@@ -205,6 +231,7 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
       nh_.advertiseService("clear_map_with_initializer", &ElevationMappingNode::clearMapWithInitializer, this);
   setPublishPointService_ = nh_.advertiseService("set_publish_points", &ElevationMappingNode::setPublishPoint, this);
   checkSafetyService_ = nh_.advertiseService("check_safety", &ElevationMappingNode::checkSafety, this);
+  memoryUsageService_ = nh_.advertiseService("get_memory_usage", &ElevationMappingNode::getMemoryUsage, this);
 
   if (updateVarianceFps > 0) {
     double duration = 1.0 / (updateVarianceFps + 0.00001);
@@ -226,6 +253,10 @@ ElevationMappingNode::ElevationMappingNode(ros::NodeHandle& nh)
     double duration = 1.0 / (publishStatisticsFps + 0.00001);
     publishStatisticsTimer_ = nh_.createTimer(ros::Duration(duration), &ElevationMappingNode::publishStatistics, this, false, true);
   }
+  if (publishMemoryUsageFps > 0) {
+    double duration = 1.0 / (publishMemoryUsageFps + 0.00001);
+    publishMemoryUsageTimer_ = nh_.createTimer(ros::Duration(duration), &ElevationMappingNode::publishMemoryUsage, this, false, true);
+  }
   lastStatisticsPublishedTime_ = ros::Time::now();
   ROS_INFO("[ElevationMappingCupy] finish initialization");
 }
@@ -271,7 +302,8 @@ void ElevationMappingNode::publishMapOfIndex(int index) {
   if (!isGridmapUpdated_) {
     return;
   }
-  grid_map_msgs::GridMap msg;
+  // Published as a shared pointer, such that nodelets in the same manager receive the map without serialization.
+  grid_map_msgs::GridMapPtr msg = boost::make_shared<grid_map_msgs::GridMap>();
   std::vector<std::string> layers;
 
   {  // need continuous lock between adding layers and converting to message. Otherwise updateGridmap can reset the data not in
@@ -285,6 +317,9 @@ void ElevationMappingNode::publishMapOfIndex(int index) {
         // if there are layers which is not in the syncing layer.
         ElevationMappingWrapper::RowMatrixXf map_data;
         map_.get_layer_data(layer, map_data);
+        if (!gridMap_.exists(layer) && !checkMemoryBudget(layer, map_data.size() * sizeof(float))) {
+          continue;
+        }
         gridMap_.add(layer, map_data);
         layers.push_back(layer);
       }
@@ -293,10 +328,14 @@ void ElevationMappingNode::publishMapOfIndex(int index) {
       return;
     }
 
-    grid_map::GridMapRosConverter::toMessage(gridMap_, layers, msg);
+    grid_map::GridMapRosConverter::toMessage(gridMap_, layers, *msg);
   }
 
-  msg.basic_layers = map_basic_layers_[index];
+  msg->basic_layers = map_basic_layers_[index];
+  {
+    std::lock_guard<std::mutex> lock(memoryMutex_);
+    mapMessageBytes_[index] = ros::serialization::serializationLength(*msg);
+  }
   mapPubs_[index].publish(msg);
 }
 
@@ -337,6 +376,7 @@ void ElevationMappingNode::inputPointCloud(const sensor_msgs::PointCloud2& cloud
       points(i, j) = static_cast<double>(temp);
     }
   }
+  pointCloudBufferBytes_ = pcl_pc->data.size() + points.size() * sizeof(double);
   //  get pose of sensor in map frame
   tf::StampedTransform transformTf;
   std::string sensorFrameId = cloud.header.frame_id;
@@ -411,6 +451,11 @@ void ElevationMappingNode::inputImage(const sensor_msgs::ImageConstPtr& image_ms
     cv::cv2eigen(img, eigen_img);
     multichannel_image.push_back(eigen_img);
   }
+  size_t imageBytes = image.total() * image.elemSize();
+  for (const auto& channel_image : multichannel_image) {
+    imageBytes += channel_image.size() * sizeof(float);
+  }
+  imageBufferBytes_ = imageBytes;
 
   // Check if the size of multichannel_image and channels and channel_methods matches. "rgb" counts for 3 layers.
   int total_channels = 0;
@@ -485,10 +530,21 @@ void ElevationMappingNode::updatePose(const ros::TimerEvent&) {
   }
 }
 
-void ElevationMappingNode::publishAsPointCloud(const grid_map::GridMap& map) const {
-  sensor_msgs::PointCloud2 msg;
-  grid_map::GridMapRosConverter::toPointCloud(map, "elevation", msg);
-  pointPub_.publish(msg);
+void ElevationMappingNode::publishAsPointCloud(const grid_map::GridMap& map) {
+  if (pointPub_.getNumSubscribers() == 0) {
+    return;
+  }
+  // Published by shared pointer, reuse its buffer unless a subscriber or the publisher queue still holds it.
+  if (!pointCloudMsg_ || !pointCloudMsg_.unique()) {
+    pointCloudMsg_ = boost::make_shared<sensor_msgs::PointCloud2>();
+  }
+  try {
+    pointCloudWriter_->write(map, *pointCloudMsg_);
+  } catch (const std::invalid_argument& exception) {
+    ROS_WARN_THROTTLE(10.0, "[ElevationMappingCupy] Could not publish the point cloud: %s", exception.what());
+    return;
+  }
+  pointPub_.publish(pointCloudMsg_);
 }
 
 bool ElevationMappingNode::getSubmap(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response) {
@@ -555,6 +611,34 @@ bool ElevationMappingNode::clearMapWithInitializer(std_srvs::Empty::Request& req
   return true;
 }
 
+void ElevationMappingNode::exportToSharedMemory(const grid_map::GridMap& map) {
+  try {
+    if (!sharedMapWriter_) {
+      sharedMapWriter_.reset(new SharedMapWriter(sharedMemoryName_, sharedMemoryMaxLayers_, map.getSize().prod()));
+      ROS_INFO("[ElevationMappingCupy] Exporting the map to shared memory %s (%zu bytes).", sharedMemoryName_.c_str(),
+               sharedMapWriter_->sizeInBytes());
+    }
+    SharedMapGeometry geometry;
+    geometry.frameId = map.getFrameId();
+    geometry.resolution = map.getResolution();
+    geometry.lengthX = map.getLength().x();
+    geometry.lengthY = map.getLength().y();
+    geometry.positionX = map.getPosition().x();
+    geometry.positionY = map.getPosition().y();
+    geometry.rows = map.getSize()(0);
+    geometry.cols = map.getSize()(1);
+    geometry.startIndexRow = map.getStartIndex()(0);
+    geometry.startIndexCol = map.getStartIndex()(1);
+    std::vector<const Eigen::MatrixXf*> layers;
+    for (const auto& layer : map.getLayers()) {
+      layers.push_back(&map[layer]);
+    }
+    sharedMapWriter_->write(geometry, map.getTimestamp(), map.getLayers(), layers);
+  } catch (const std::exception& exception) {
+    ROS_WARN_THROTTLE(10.0, "[ElevationMappingCupy] Could not export the map to shared memory: %s", exception.what());
+  }
+}
+
 void ElevationMappingNode::initializeWithTF() {
   std::vector<Eigen::Vector3d> points;
   const auto& timeStamp = ros::Time::now();
@@ -671,12 +755,91 @@ void ElevationMappingNode::publishStatistics(const ros::TimerEvent&) {
   statisticsPub_.publish(msg);
 }
 
+void ElevationMappingNode::publishMemoryUsage(const ros::TimerEvent&) {
+  elevation_map_msgs::MemoryUsage msg;
+  {
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    msg = collectMemoryUsage();
+  }
+  if (memoryBudgetBytes_ > 0 && msg.total_bytes > memoryBudgetBytes_) {
+    ROS_WARN_THROTTLE(10.0, "[ElevationMappingCupy] Memory usage exceeds the budget (%zu > %zu bytes).",
+                      static_cast<size_t>(msg.total_bytes), static_cast<size_t>(msg.budget_bytes));
+  }
+  memoryUsagePub_.publish(msg);
+}
+
+bool ElevationMappingNode::getMemoryUsage(elevation_map_msgs::GetMemoryUsage::Request& request,
+                                          elevation_map_msgs::GetMemoryUsage::Response& response) {
+  std::lock_guard<std::mutex> lock(mapMutex_);
+  response.usage = collectMemoryUsage();
+  return true;
+}
+
+elevation_map_msgs::MemoryUsage ElevationMappingNode::collectMemoryUsage() {
+  elevation_map_msgs::MemoryUsage usage;
+  usage.header.stamp = ros::Time::now();
+  auto addComponent = [&usage](const std::string& name, size_t bytes) {
+    elevation_map_msgs::MemoryComponent component;
+    component.name = name;
+    component.bytes = bytes;
+    usage.components.push_back(component);
+    usage.total_bytes += bytes;
+  };
+
+  // Arrays of the python map: elevation layers, buffers, semantic layers and plugin layers.
+  for (const auto& component : map_.get_memory_usage()) {
+    addComponent("map/" + component.first, component.second);
+  }
+  size_t gridMapBytes = 0;
+  for (const auto& layer : gridMap_.getLayers()) {
+    gridMapBytes += gridMap_[layer].size() * sizeof(float);
+  }
+  addComponent("node/grid_map", gridMapBytes);
+  size_t messageBytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(memoryMutex_);
+    for (size_t bytes : mapMessageBytes_) {
+      messageBytes += bytes;
+    }
+  }
+  addComponent("node/map_messages", messageBytes);
+  addComponent("node/pointcloud_buffer", pointCloudBufferBytes_);
+  addComponent("node/image_buffer", imageBufferBytes_);
+  addComponent("node/shared_memory", sharedMapWriter_ ? sharedMapWriter_->sizeInBytes() : 0);
+  addComponent("node/point_cloud", pointCloudMsg_ ? pointCloudMsg_->data.capacity() : 0);
+
+  usage.gpu_pool_bytes = map_.get_memory_pool_usage();
+  usage.budget_bytes = memoryBudgetBytes_;
+  return usage;
+}
+
+bool ElevationMappingNode::checkMemoryBudget(const std::string& layer, size_t layerBytes) {
+  if (memoryBudgetBytes_ == 0) {
+    return true;
+  }
+  const size_t usedBytes = collectMemoryUsage().total_bytes;
+  if (usedBytes + layerBytes <= memoryBudgetBytes_) {
+    return true;
+  }
+  if (memoryBudgetRefuseLayers_) {
+    ROS_WARN_THROTTLE(10.0, "[ElevationMappingCupy] Layer %s is not published, it would exceed the memory budget (%zu + %zu > %zu bytes).",
+                      layer.c_str(), usedBytes, layerBytes, memoryBudgetBytes_);
+    return false;
+  }
+  ROS_WARN_THROTTLE(10.0, "[ElevationMappingCupy] Layer %s exceeds the memory budget (%zu + %zu > %zu bytes).", layer.c_str(), usedBytes,
+                    layerBytes, memoryBudgetBytes_);
+  return true;
+}
+
 void ElevationMappingNode::updateGridMap(const ros::TimerEvent&) {
   std::vector<std::string> layers(map_layers_all_.begin(), map_layers_all_.end());
   std::lock_guard<std::mutex> lock(mapMutex_);
   map_.get_grid_map(gridMap_, layers);
   gridMap_.setTimestamp(ros::Time::now().toNSec());
   alivePub_.publish(std_msgs::Empty());
+  if (enableSharedMemoryExport_) {
+    exportToSharedMemory(gridMap_);
+  }
 
   // Mostly debug purpose
   if (enablePointCloudPublishing_) {
@@ -313,6 +313,16 @@ void ElevationMappingWrapper::addNormalColorLayer(grid_map::GridMap& map) {
   }
 }
 
+std::map<std::string, size_t> ElevationMappingWrapper::get_memory_usage() {
+  py::gil_scoped_acquire acquire;
+  return map_.attr("get_memory_usage")().cast<std::map<std::string, size_t>>();
+}
+
+size_t ElevationMappingWrapper::get_memory_pool_usage() {
+  py::gil_scoped_acquire acquire;
+  return map_.attr("get_memory_pool_usage")().cast<size_t>();
+}
+
 void ElevationMappingWrapper::update_variance() {
   py::gil_scoped_acquire acquire;
   map_.attr("update_variance")();
@@ -0,0 +1,123 @@
+//
+// Writes a grid map into a sensor_msgs::PointCloud2, see point_cloud_writer.hpp.
+//
+
+#include "elevation_mapping_cupy/point_cloud_writer.hpp"
+
+// STL
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace elevation_mapping_cupy {
+
+namespace {
+
+inline void writeFloat(uint8_t* destination, float value) {
+  std::memcpy(destination, &value, sizeof(float));
+}
+
+}  // namespace
+
+PointCloudWriter::PointCloudWriter(std::string heightLayer, std::vector<std::string> layers, bool skipInvalid, bool organized)
+    : heightLayer_(std::move(heightLayer)), layers_(std::move(layers)), skipInvalid_(skipInvalid), organized_(organized) {}
+
+void PointCloudWriter::write(const grid_map::GridMap& map, sensor_msgs::PointCloud2& cloud) const {
+  if (!map.exists(heightLayer_)) {
+    throw std::invalid_argument("PointCloudWriter: the map has no height layer '" + heightLayer_ + "'.");
+  }
+  std::vector<std::string> layers = layers_;
+  if (layers.empty()) {
+    for (const auto& layer : map.getLayers()) {
+      if (layer != heightLayer_) {
+        layers.push_back(layer);
+      }
+    }
+  }
+  std::vector<const float*> layerData;
+  layerData.reserve(layers.size());
+  for (const auto& layer : layers) {
+    if (!map.exists(layer)) {
+      throw std::invalid_argument("PointCloudWriter: the map has no layer '" + layer + "'.");
+    }
+    layerData.push_back(map.get(layer).data());
+  }
+
+  // Fields: x, y, z and one float per layer.
+  const uint32_t numFields = 3 + layers.size();
+  cloud.fields.resize(numFields);
+  for (uint32_t i = 0; i < numFields; ++i) {
+    auto& field = cloud.fields[i];
+    if (i < 3) {
+      field.name = std::string(1, "xyz"[i]);
+    } else {
+      field.name = layers[i - 3] == "color" ? "rgb" : layers[i - 3];
+    }
+    field.offset = i * sizeof(float);
+    field.datatype = sensor_msgs::PointField::FLOAT32;
+    field.count = 1;
+  }
+  cloud.header.frame_id = map.getFrameId();
+  cloud.header.stamp.fromNSec(map.getTimestamp());
+  cloud.is_bigendian = false;
+  cloud.point_step = numFields * sizeof(float);
+
+  const grid_map::Size size = map.getSize();
+  const grid_map::Index startIndex = map.getStartIndex();
+  const size_t numCells = size.prod();
+  cloud.data.resize(numCells * cloud.point_step);
+
+  // Cells are visited in column-major order of the unwrapped circular buffer. The cell at the start index is the corner with the largest
+  // x and y, the others are offset by multiples of the resolution.
+  grid_map::Position cornerPosition;
+  map.getPosition(startIndex, cornerPosition);
+  const double resolution = map.getResolution();
+  const float* heightData = map.get(heightLayer_).data();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const bool skipInvalid = skipInvalid_ && !organized_;
+
+  uint8_t* const data = cloud.data.data();
+  size_t numPoints = 0;
+  bool isDense = true;
+  for (int col = 0; col < size(1); ++col) {
+    const int bufferCol = startIndex(1) + col < size(1) ? startIndex(1) + col : startIndex(1) + col - size(1);
+    const float y = static_cast<float>(cornerPosition.y() - col * resolution);
+    for (int row = 0; row < size(0); ++row) {
+      const int bufferRow = startIndex(0) + row < size(0) ? startIndex(0) + row : startIndex(0) + row - size(0);
+      const size_t cellIndex = static_cast<size_t>(bufferCol) * size(0) + bufferRow;
+      const float z = heightData[cellIndex];
+      const bool isValid = std::isfinite(z);
+      if (!isValid && skipInvalid) {
+        continue;
+      }
+      isDense = isDense && isValid;
+
+      const size_t pointIndex = organized_ ? static_cast<size_t>(row) * size(1) + col : numPoints;
+      uint8_t* point = data + pointIndex * cloud.point_step;
+      if (isValid || !organized_) {
+        writeFloat(point, static_cast<float>(cornerPosition.x() - row * resolution));
+        writeFloat(point + sizeof(float), y);
+      } else {
+        writeFloat(point, nan);
+        writeFloat(point + sizeof(float), nan);
+      }
+      writeFloat(point + 2 * sizeof(float), z);
+      point += 3 * sizeof(float);
+      for (const float* layer : layerData) {
+        writeFloat(point, layer[cellIndex]);
+        point += sizeof(float);
+      }
+      ++numPoints;
+    }
+  }
+
+  cloud.height = organized_ ? size(0) : 1;
+  cloud.width = organized_ ? size(1) : numPoints;
+  cloud.row_step = cloud.width * cloud.point_step;
+  cloud.is_dense = isDense;
+  cloud.data.resize(static_cast<size_t>(cloud.height) * cloud.row_step);
+}
+
+}  // namespace elevation_mapping_cupy
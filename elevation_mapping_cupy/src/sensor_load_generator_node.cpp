@@ -0,0 +1,378 @@
+//
+// Load generator for the elevation mapping node: publishes synthetic point clouds and images of N virtual sensors, together with their
+// TF, and reports the end-to-end latency until the points show up in the published map, the throughput and the drop rate.
+//
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <utility>
+
+// ROS
+#include <elevation_map_msgs/Statistics.h>
+#include <grid_map_msgs/GridMap.h>
+#include <ros/ros.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <tf/transform_broadcaster.h>
+
+namespace {
+
+/**
+ * Latency samples of one report period. The end-to-end latency of a cloud is the time from its stamp until the first map is received
+ * that was acquired after the cloud was sent, i.e. the delay a consumer of the map observes.
+ * At most maxPendingStamps clouds wait for a map. If the mapping node falls behind, the oldest ones are dropped and counted.
+ */
+class LatencyRecorder {
+ public:
+  void setMaxPendingStamps(size_t maxPendingStamps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxPendingStamps_ = std::max<size_t>(1, maxPendingStamps);
+  }
+
+  void addSent(const ros::Time& stamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (pendingStamps_.size() >= maxPendingStamps_) {
+      pendingStamps_.erase(pendingStamps_.begin());
+      ++numberOfDroppedStamps_;
+    }
+    pendingStamps_.insert(stamp);
+  }
+
+  void addMap(const ros::Time& mapStamp, const ros::Time& receiveTime) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto end = pendingStamps_.upper_bound(mapStamp);
+    for (auto it = pendingStamps_.begin(); it != end; ++it) {
+      latencies_.push_back((receiveTime - *it).toSec());
+    }
+    pendingStamps_.erase(pendingStamps_.begin(), end);
+  }
+
+  /// Returns the latencies since the last call, sorted.
+  std::vector<double> takeLatencies() {
+    std::vector<double> latencies;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      latencies.swap(latencies_);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+  }
+
+  /// Returns the number of clouds dropped without a map since the last call.
+  size_t takeNumberOfDroppedStamps() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::exchange(numberOfDroppedStamps_, 0);
+  }
+
+ private:
+  std::mutex mutex_;
+  size_t maxPendingStamps_ = 1000;
+  std::multiset<ros::Time> pendingStamps_;
+  std::vector<double> latencies_;
+  size_t numberOfDroppedStamps_ = 0;
+};
+
+double percentile(const std::vector<double>& sortedValues, double p) {
+  if (sortedValues.empty()) {
+    return 0.0;
+  }
+  const auto index = static_cast<size_t>(std::ceil(p / 100.0 * sortedValues.size()));
+  return sortedValues[std::min(sortedValues.size() - 1, std::max<size_t>(index, 1) - 1)];
+}
+
+class SensorLoadGenerator {
+ public:
+  explicit SensorLoadGenerator(ros::NodeHandle& nh) : nh_(nh) {
+    std::string mapTopic, statisticsTopic, topicPrefix;
+    nh.param<std::string>("map_frame", mapFrameId_, "odom");
+    nh.param<std::string>("base_frame", baseFrameId_, "base_footprint");
+    nh.param<std::string>("map_topic", mapTopic, "/elevation_mapping/elevation_map_raw");
+    nh.param<std::string>("statistics_topic", statisticsTopic, "/elevation_mapping/statistics");
+    nh.param<std::string>("topic_prefix", topicPrefix, "/synthetic_sensor_");
+    nh.param<int>("number_of_pointcloud_sensors", numberOfPointCloudSensors_, 1);
+    nh.param<int>("number_of_image_sensors", numberOfImageSensors_, 0);
+    nh.param<int>("points_per_cloud", pointsPerCloud_, 20000);
+    nh.param<std::vector<std::string>>("pointcloud_fields", pointCloudFields_, {"x", "y", "z"});
+    nh.param<double>("pointcloud_rate", pointCloudRate_, 10.0);
+    nh.param<int>("image_width", imageWidth_, 640);
+    nh.param<int>("image_height", imageHeight_, 480);
+    nh.param<double>("image_rate", imageRate_, 10.0);
+    nh.param<double>("sensor_height", sensorHeight_, 0.5);
+    nh.param<double>("base_velocity", baseVelocity_, 0.0);
+    nh.param<double>("report_period", reportPeriod_, 5.0);
+    int maxPendingStamps;
+    nh.param<int>("max_pending_stamps", maxPendingStamps, 1000);
+    latencyRecorder_.setMaxPendingStamps(static_cast<size_t>(std::max(1, maxPendingStamps)));
+
+    if (pointCloudFields_.size() < 3 || pointCloudFields_[0] != "x" || pointCloudFields_[1] != "y" || pointCloudFields_[2] != "z") {
+      ROS_FATAL("[SensorLoadGenerator] pointcloud_fields must start with x, y, z.");
+      ros::shutdown();
+      return;
+    }
+
+    for (int i = 0; i < numberOfPointCloudSensors_; ++i) {
+      const std::string name = topicPrefix + std::to_string(i);
+      pointCloudPubs_.push_back(nh_.advertise<sensor_msgs::PointCloud2>(name + "/points", 1));
+      clouds_.push_back(createPointCloud(sensorFrameId(i), static_cast<unsigned int>(i)));
+    }
+    for (int i = 0; i < numberOfImageSensors_; ++i) {
+      const std::string name = topicPrefix + std::to_string(numberOfPointCloudSensors_ + i);
+      imagePubs_.push_back(nh_.advertise<sensor_msgs::Image>(name + "/image", 1));
+      cameraInfoPubs_.push_back(nh_.advertise<sensor_msgs::CameraInfo>(name + "/camera_info", 1));
+    }
+    image_ = createImage();
+    cameraInfo_ = createCameraInfo();
+
+    mapSub_ = nh_.subscribe<grid_map_msgs::GridMap>(mapTopic, 10, &SensorLoadGenerator::mapCallback, this);
+    statisticsSub_ = nh_.subscribe<elevation_map_msgs::Statistics>(statisticsTopic, 10, &SensorLoadGenerator::statisticsCallback, this);
+
+    // One timer per stream type. All sensors of a type publish in the same callback with the same stamp, as synchronized sensors would.
+    startTime_ = ros::Time::now();
+    lastReportTime_ = startTime_;
+    if (numberOfPointCloudSensors_ > 0 && pointCloudRate_ > 0.0) {
+      pointCloudTimer_ = nh_.createTimer(ros::Duration(1.0 / pointCloudRate_), &SensorLoadGenerator::publishPointClouds, this);
+    }
+    if (numberOfImageSensors_ > 0 && imageRate_ > 0.0) {
+      imageTimer_ = nh_.createTimer(ros::Duration(1.0 / imageRate_), &SensorLoadGenerator::publishImages, this);
+    }
+    reportTimer_ = nh_.createTimer(ros::Duration(reportPeriod_), &SensorLoadGenerator::report, this);
+  }
+
+ private:
+  std::string sensorFrameId(int index) const { return "synthetic_sensor_" + std::to_string(index); }
+
+  /// Sensors are mounted at sensor_height above the base and distributed evenly in yaw.
+  tf::Transform baseToSensor(int index) const {
+    const int numberOfSensors = numberOfPointCloudSensors_ + numberOfImageSensors_;
+    tf::Quaternion orientation;
+    orientation.setRPY(0.0, 0.0, 2.0 * M_PI * index / numberOfSensors);
+    return tf::Transform(orientation, tf::Vector3(0.0, 0.0, sensorHeight_));
+  }
+
+  /**
+   * Random points on a wavy ground surface in front of the sensor, within the default range filters of the mapping. Fields after x, y, z
+   * are filled with random values.
+   */
+  sensor_msgs::PointCloud2 createPointCloud(const std::string& frameId, unsigned int seed) const {
+    sensor_msgs::PointCloud2 cloud;
+    cloud.header.frame_id = frameId;
+    cloud.height = 1;
+    cloud.width = pointsPerCloud_;
+    cloud.is_bigendian = false;
+    cloud.is_dense = true;
+    for (size_t i = 0; i < pointCloudFields_.size(); ++i) {
+      sensor_msgs::PointField field;
+      field.name = pointCloudFields_[i];
+      field.offset = static_cast<uint32_t>(i * sizeof(float));
+      field.datatype = sensor_msgs::PointField::FLOAT32;
+      field.count = 1;
+      cloud.fields.push_back(field);
+    }
+    cloud.point_step = static_cast<uint32_t>(pointCloudFields_.size() * sizeof(float));
+    cloud.row_step = cloud.point_step * cloud.width;
+    cloud.data.resize(static_cast<size_t>(cloud.row_step) * cloud.height);
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> forward(0.6f, 3.0f);
+    std::uniform_real_distribution<float> lateral(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto* values = reinterpret_cast<float*>(cloud.data.data());
+    for (int i = 0; i < pointsPerCloud_; ++i) {
+      float* point = values + i * pointCloudFields_.size();
+      point[0] = forward(generator);
+      point[1] = lateral(generator);
+      point[2] = static_cast<float>(-sensorHeight_ + 0.1 * std::sin(2.0 * point[0]) * std::cos(3.0 * point[1]));
+      for (size_t j = 3; j < pointCloudFields_.size(); ++j) {
+        point[j] = unit(generator);
+      }
+    }
+    return cloud;
+  }
+
+  sensor_msgs::Image createImage() const {
+    sensor_msgs::Image image;
+    image.height = imageHeight_;
+    image.width = imageWidth_;
+    image.encoding = "rgb8";
+    image.is_bigendian = false;
+    image.step = 3 * imageWidth_;
+    image.data.resize(static_cast<size_t>(image.step) * image.height);
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (auto& value : image.data) {
+      value = static_cast<uint8_t>(byte(generator));
+    }
+    return image;
+  }
+
+  /// Pinhole camera looking forward and 45 degrees down, expressed in the optical frame convention.
+  sensor_msgs::CameraInfo createCameraInfo() const {
+    sensor_msgs::CameraInfo cameraInfo;
+    cameraInfo.height = imageHeight_;
+    cameraInfo.width = imageWidth_;
+    cameraInfo.distortion_model = "plumb_bob";
+    cameraInfo.D.assign(5, 0.0);
+    const double focalLength = 0.5 * imageWidth_;
+    cameraInfo.K = {focalLength, 0.0, 0.5 * imageWidth_, 0.0, focalLength, 0.5 * imageHeight_, 0.0, 0.0, 1.0};
+    cameraInfo.R = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+    cameraInfo.P = {focalLength, 0.0, 0.5 * imageWidth_, 0.0, 0.0, focalLength, 0.5 * imageHeight_, 0.0, 0.0, 0.0, 1.0, 0.0};
+    return cameraInfo;
+  }
+
+  void publishTransforms(const ros::Time& stamp) {
+    std::lock_guard<std::mutex> lock(tfMutex_);
+    // The base drives on a circle with radius 1m if base_velocity is set.
+    const double angle = baseVelocity_ * (stamp - startTime_).toSec();
+    tf::Quaternion baseOrientation;
+    baseOrientation.setRPY(0.0, 0.0, angle);
+    const tf::Transform mapToBase(baseOrientation, tf::Vector3(std::sin(angle), 1.0 - std::cos(angle), 0.0));
+
+    std::vector<tf::StampedTransform> transforms;
+    transforms.emplace_back(mapToBase, stamp, mapFrameId_, baseFrameId_);
+    for (int i = 0; i < numberOfPointCloudSensors_; ++i) {
+      transforms.emplace_back(baseToSensor(i), stamp, baseFrameId_, sensorFrameId(i));
+    }
+    for (int i = 0; i < numberOfImageSensors_; ++i) {
+      const int index = numberOfPointCloudSensors_ + i;
+      tf::Quaternion cameraOrientation;
+      cameraOrientation.setRPY(-M_PI_2 - M_PI_4, 0.0, -M_PI_2);  // z forward and 45 degrees down, x right
+      transforms.emplace_back(baseToSensor(index) * tf::Transform(cameraOrientation), stamp, baseFrameId_, sensorFrameId(index));
+    }
+    tfBroadcaster_.sendTransform(transforms);
+  }
+
+  void publishPointClouds(const ros::TimerEvent& event) {
+    const ros::Time stamp = ros::Time::now();
+    publishTransforms(stamp);
+    countLateEvent(event, pointCloudRate_);
+    for (size_t i = 0; i < clouds_.size(); ++i) {
+      clouds_[i].header.stamp = stamp;
+      pointCloudPubs_[i].publish(clouds_[i]);
+      latencyRecorder_.addSent(stamp);
+    }
+    numberOfSentClouds_ += clouds_.size();
+  }
+
+  void publishImages(const ros::TimerEvent& event) {
+    const ros::Time stamp = ros::Time::now();
+    publishTransforms(stamp);
+    countLateEvent(event, imageRate_);
+    for (size_t i = 0; i < imagePubs_.size(); ++i) {
+      const int index = numberOfPointCloudSensors_ + static_cast<int>(i);
+      image_.header.stamp = stamp;
+      image_.header.frame_id = sensorFrameId(index);
+      cameraInfo_.header = image_.header;
+      imagePubs_[i].publish(image_);
+      cameraInfoPubs_[i].publish(cameraInfo_);
+    }
+    numberOfSentImages_ += imagePubs_.size();
+  }
+
+  /// The generator itself is saturated if a timer event starts more than one period late.
+  void countLateEvent(const ros::TimerEvent& event, double rate) {
+    if ((event.current_real - event.current_expected).toSec() > 1.0 / rate) {
+      ++numberOfLateEvents_;
+    }
+  }
+
+  void mapCallback(const grid_map_msgs::GridMapConstPtr& message) {
+    latencyRecorder_.addMap(message->info.header.stamp, ros::Time::now());
+    ++numberOfReceivedMaps_;
+  }
+
+  void statisticsCallback(const elevation_map_msgs::StatisticsConstPtr& message) {
+    processedCloudsPerSecond_ = message->pointcloud_process_fps;
+  }
+
+  void report(const ros::TimerEvent&) {
+    const ros::Time now = ros::Time::now();
+    const double dt = (now - lastReportTime_).toSec();
+    lastReportTime_ = now;
+    if (dt <= 0.0) {
+      return;
+    }
+
+    const double sentCloudsPerSecond = numberOfSentClouds_.exchange(0) / dt;
+    const double sentImagesPerSecond = numberOfSentImages_.exchange(0) / dt;
+    const double mapsPerSecond = numberOfReceivedMaps_.exchange(0) / dt;
+    const double pointsPerSecond = sentCloudsPerSecond * pointsPerCloud_;
+    const double megabytesPerSecond =
+        1e-6 * (pointsPerSecond * pointCloudFields_.size() * sizeof(float) + sentImagesPerSecond * 3.0 * imageWidth_ * imageHeight_);
+    const double processed = processedCloudsPerSecond_;
+    const double dropRate = (sentCloudsPerSecond > 0.0) ? std::max(0.0, 1.0 - processed / sentCloudsPerSecond) : 0.0;
+    const auto latencies = latencyRecorder_.takeLatencies();
+
+    ROS_INFO_STREAM("[SensorLoadGenerator] Sent " << sentCloudsPerSecond << " clouds/s (" << pointsPerSecond << " points/s), "
+                                                  << sentImagesPerSecond << " images/s, " << megabytesPerSecond << " MB/s, "
+                                                  << numberOfLateEvents_.exchange(0) << " late timer events\n"
+                                                  << "\tprocessed " << processed << " clouds/s, drop rate " << 100.0 * dropRate
+                                                  << " %, received " << mapsPerSecond << " maps/s\n"
+                                                  << "\tcloud to map latency [ms] p50: " << 1e3 * percentile(latencies, 50.0)
+                                                  << ", p90: " << 1e3 * percentile(latencies, 90.0)
+                                                  << ", p99: " << 1e3 * percentile(latencies, 99.0)
+                                                  << ", max: " << 1e3 * percentile(latencies, 100.0) << ", "
+                                                  << latencyRecorder_.takeNumberOfDroppedStamps() << " clouds without a map");
+  }
+
+  ros::NodeHandle nh_;
+  tf::TransformBroadcaster tfBroadcaster_;
+  std::mutex tfMutex_;
+  std::vector<ros::Publisher> pointCloudPubs_;
+  std::vector<ros::Publisher> imagePubs_;
+  std::vector<ros::Publisher> cameraInfoPubs_;
+  ros::Subscriber mapSub_;
+  ros::Subscriber statisticsSub_;
+  ros::Timer pointCloudTimer_;
+  ros::Timer imageTimer_;
+  ros::Timer reportTimer_;
+
+  // Settings
+  std::string mapFrameId_;
+  std::string baseFrameId_;
+  int numberOfPointCloudSensors_;
+  int numberOfImageSensors_;
+  int pointsPerCloud_;
+  std::vector<std::string> pointCloudFields_;
+  double pointCloudRate_;
+  int imageWidth_;
+  int imageHeight_;
+  double imageRate_;
+  double sensorHeight_;
+  double baseVelocity_;
+  double reportPeriod_;
+
+  // Messages, only the header changes between publications.
+  std::vector<sensor_msgs::PointCloud2> clouds_;
+  sensor_msgs::Image image_;
+  sensor_msgs::CameraInfo cameraInfo_;
+
+  // Statistics
+  ros::Time startTime_;
+  ros::Time lastReportTime_;
+  LatencyRecorder latencyRecorder_;
+  std::atomic_int numberOfSentClouds_{0};
+  std::atomic_int numberOfSentImages_{0};
+  std::atomic_int numberOfReceivedMaps_{0};
+  std::atomic_int numberOfLateEvents_{0};
+  std::atomic<double> processedCloudsPerSecond_{0.0};
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "sensor_load_generator");
+  ros::NodeHandle nh("~");
+
+  SensorLoadGenerator generator(nh);
+
+  // Publishing, receiving and reporting run on separate threads, such that a saturated stream does not delay the others.
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+  ros::waitForShutdown();
+  return 0;
+}
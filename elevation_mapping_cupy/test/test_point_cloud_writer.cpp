@@ -0,0 +1,144 @@
+//
+// Tests for the point cloud writer, against grid_map::GridMapRosConverter::toPointCloud.
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <map>
+
+#include <grid_map_ros/GridMapRosConverter.hpp>
+
+#include "elevation_mapping_cupy/point_cloud_writer.hpp"
+
+using namespace elevation_mapping_cupy;
+
+namespace {
+
+// A map whose circular buffer does not start at index 0, with some invalid cells.
+grid_map::GridMap makeMap() {
+  grid_map::GridMap map({"elevation", "variance", "traversability"});
+  map.setFrameId("odom");
+  map.setGeometry(grid_map::Length(2.0, 1.6), 0.1, grid_map::Position(0.3, -0.2));
+  map.setTimestamp(1234567890);
+  map.move(grid_map::Position(0.55, -0.45));
+  for (const auto& layer : map.getLayers()) {
+    map.get(layer).setRandom();
+  }
+  map.get("elevation")(3, 4) = NAN;
+  map.get("elevation")(7, 0) = NAN;
+  map.get("elevation")(0, 9) = INFINITY;
+  return map;
+}
+
+float readFloat(const sensor_msgs::PointCloud2& cloud, size_t point, const std::string& field) {
+  for (const auto& pointField : cloud.fields) {
+    if (pointField.name == field) {
+      float value;
+      std::memcpy(&value, &cloud.data[point * cloud.point_step + pointField.offset], sizeof(float));
+      return value;
+    }
+  }
+  ADD_FAILURE() << "Missing field " << field;
+  return NAN;
+}
+
+std::vector<std::string> fieldNames(const sensor_msgs::PointCloud2& cloud) {
+  std::vector<std::string> names;
+  for (const auto& field : cloud.fields) {
+    names.push_back(field.name);
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST(TestPointCloudWriter, matchesGridMapRosConverter) {  // NOLINT
+  const auto map = makeMap();
+  sensor_msgs::PointCloud2 expected;
+  grid_map::GridMapRosConverter::toPointCloud(map, "elevation", expected);
+  sensor_msgs::PointCloud2 cloud;
+  PointCloudWriter().write(map, cloud);
+
+  EXPECT_EQ(cloud.header.frame_id, "odom");
+  EXPECT_EQ(cloud.header.stamp, expected.header.stamp);
+  EXPECT_EQ(cloud.height, 1U);
+  ASSERT_EQ(cloud.width, expected.width);
+  EXPECT_EQ(cloud.width, static_cast<uint32_t>(map.getSize().prod() - 3));
+  EXPECT_EQ(cloud.point_step, expected.point_step);
+  EXPECT_EQ(cloud.row_step, cloud.width * cloud.point_step);
+  EXPECT_EQ(cloud.data.size(), expected.data.size());
+  EXPECT_TRUE(cloud.is_dense);
+  EXPECT_EQ(fieldNames(cloud), std::vector<std::string>({"x", "y", "z", "variance", "traversability"}));
+
+  // The points are in a different order, match them by their cell.
+  std::map<std::pair<int, int>, size_t> expectedPoints;
+  for (size_t point = 0; point < expected.width; ++point) {
+    grid_map::Index index;
+    ASSERT_TRUE(map.getIndex(grid_map::Position(readFloat(expected, point, "x"), readFloat(expected, point, "y")), index));
+    expectedPoints[{index(0), index(1)}] = point;
+  }
+  for (size_t point = 0; point < cloud.width; ++point) {
+    grid_map::Index index;
+    ASSERT_TRUE(map.getIndex(grid_map::Position(readFloat(cloud, point, "x"), readFloat(cloud, point, "y")), index));
+    const auto expectedPoint = expectedPoints.find({index(0), index(1)});
+    ASSERT_NE(expectedPoint, expectedPoints.end());
+    for (const auto& field : fieldNames(expected)) {
+      EXPECT_NEAR(readFloat(cloud, point, field), readFloat(expected, expectedPoint->second, field), 1e-6) << field;
+    }
+    expectedPoints.erase(expectedPoint);
+  }
+  EXPECT_TRUE(expectedPoints.empty());
+}
+
+TEST(TestPointCloudWriter, selectedLayersAndInvalidCells) {  // NOLINT
+  auto map = makeMap();
+  map.add("color", 1.0);
+  sensor_msgs::PointCloud2 cloud;
+  PointCloudWriter("elevation", {"color", "variance"}, false, false).write(map, cloud);
+  EXPECT_EQ(fieldNames(cloud), std::vector<std::string>({"x", "y", "z", "rgb", "variance"}));
+  EXPECT_EQ(cloud.point_step, 5 * sizeof(float));
+  EXPECT_EQ(cloud.width, static_cast<uint32_t>(map.getSize().prod()));
+  EXPECT_FALSE(cloud.is_dense);
+
+  // The buffer is reused for the next map.
+  const uint8_t* buffer = cloud.data.data();
+  PointCloudWriter("elevation", {"variance"}).write(map, cloud);
+  EXPECT_EQ(cloud.data.data(), buffer);
+  EXPECT_EQ(cloud.width, static_cast<uint32_t>(map.getSize().prod() - 3));
+
+  EXPECT_THROW(PointCloudWriter("height").write(map, cloud), std::invalid_argument);
+  EXPECT_THROW(PointCloudWriter("elevation", {"normal_x"}).write(map, cloud), std::invalid_argument);
+}
+
+TEST(TestPointCloudWriter, organized) {  // NOLINT
+  const auto map = makeMap();
+  sensor_msgs::PointCloud2 cloud;
+  PointCloudWriter("elevation", {"variance"}, true, true).write(map, cloud);
+  ASSERT_EQ(cloud.height, static_cast<uint32_t>(map.getSize()(0)));
+  ASSERT_EQ(cloud.width, static_cast<uint32_t>(map.getSize()(1)));
+  EXPECT_EQ(cloud.row_step, cloud.width * cloud.point_step);
+  EXPECT_FALSE(cloud.is_dense);
+
+  // Point (row, col) is the cell at the unwrapped index (row, col).
+  for (int row = 0; row < map.getSize()(0); ++row) {
+    for (int col = 0; col < map.getSize()(1); ++col) {
+      const grid_map::Index& startIndex = map.getStartIndex();
+      const grid_map::Index bufferIndex((startIndex(0) + row) % map.getSize()(0), (startIndex(1) + col) % map.getSize()(1));
+      const size_t point = row * cloud.width + col;
+      const float elevation = map.at("elevation", bufferIndex);
+      EXPECT_FLOAT_EQ(readFloat(cloud, point, "variance"), map.at("variance", bufferIndex));
+      if (!std::isfinite(elevation)) {
+        EXPECT_TRUE(std::isnan(readFloat(cloud, point, "x")));
+        EXPECT_TRUE(std::isnan(readFloat(cloud, point, "y")));
+        continue;
+      }
+      grid_map::Position position;
+      map.getPosition(bufferIndex, position);
+      EXPECT_NEAR(readFloat(cloud, point, "x"), position.x(), 1e-5);
+      EXPECT_NEAR(readFloat(cloud, point, "y"), position.y(), 1e-5);
+      EXPECT_FLOAT_EQ(readFloat(cloud, point, "z"), elevation);
+    }
+  }
+}
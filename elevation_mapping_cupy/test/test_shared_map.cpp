@@ -0,0 +1,220 @@
+//
+// Tests for the shared memory export of the elevation map. The reader runs in a forked process while the writer keeps updating the map.
+//
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "elevation_mapping_cupy/shared_map.hpp"
+
+using namespace elevation_mapping_cupy;
+
+namespace {
+
+std::string uniqueName(const std::string& test) {
+  return "/elevation_mapping_cupy_test_" + test + "_" + std::to_string(getpid());
+}
+
+SharedMapGeometry makeGeometry(int rows, int cols) {
+  SharedMapGeometry geometry;
+  geometry.frameId = "odom";
+  geometry.resolution = 0.04;
+  geometry.lengthX = rows * geometry.resolution;
+  geometry.lengthY = cols * geometry.resolution;
+  geometry.positionX = 1.0;
+  geometry.positionY = -2.0;
+  geometry.rows = rows;
+  geometry.cols = cols;
+  geometry.startIndexRow = 3;
+  geometry.startIndexCol = 5;
+  return geometry;
+}
+
+// Every cell of layer i of update u holds u * 10 + i, such that torn snapshots are detected.
+bool isConsistent(const SharedMapSnapshot& snapshot) {
+  const float value = snapshot.layers[0](0, 0);
+  for (size_t i = 0; i < snapshot.layers.size(); ++i) {
+    if ((snapshot.layers[i].array() != value + static_cast<float>(i)).any()) {
+      return false;
+    }
+  }
+  return static_cast<uint64_t>(value) == snapshot.timestamp * 10;
+}
+
+}  // namespace
+
+TEST(TestSharedMap, roundTrip) {  // NOLINT
+  const auto name = uniqueName("round_trip");
+  SharedMapWriter writer(name, 4, 100 * 100);
+  SharedMapReader reader(name);
+
+  SharedMapSnapshot snapshot;
+  EXPECT_EQ(reader.updateCount(), 0U);
+  EXPECT_FALSE(reader.read(snapshot));
+
+  const auto geometry = makeGeometry(30, 20);
+  const Eigen::MatrixXf elevation = Eigen::MatrixXf::Random(30, 20);
+  const Eigen::MatrixXf variance = Eigen::MatrixXf::Random(30, 20);
+  writer.write(geometry, 123456789, {"elevation", "variance"}, {&elevation, &variance});
+
+  EXPECT_EQ(reader.updateCount(), 1U);
+  ASSERT_TRUE(reader.read(snapshot));
+  EXPECT_EQ(snapshot.updateCount, 1U);
+  EXPECT_EQ(snapshot.timestamp, 123456789U);
+  EXPECT_EQ(snapshot.geometry.frameId, "odom");
+  EXPECT_DOUBLE_EQ(snapshot.geometry.resolution, geometry.resolution);
+  EXPECT_DOUBLE_EQ(snapshot.geometry.lengthX, geometry.lengthX);
+  EXPECT_DOUBLE_EQ(snapshot.geometry.lengthY, geometry.lengthY);
+  EXPECT_DOUBLE_EQ(snapshot.geometry.positionX, geometry.positionX);
+  EXPECT_DOUBLE_EQ(snapshot.geometry.positionY, geometry.positionY);
+  EXPECT_EQ(snapshot.geometry.rows, 30);
+  EXPECT_EQ(snapshot.geometry.cols, 20);
+  EXPECT_EQ(snapshot.geometry.startIndexRow, 3);
+  EXPECT_EQ(snapshot.geometry.startIndexCol, 5);
+  ASSERT_EQ(snapshot.layerNames, std::vector<std::string>({"elevation", "variance"}));
+  ASSERT_NE(snapshot.get("variance"), nullptr);
+  EXPECT_TRUE(snapshot.get("elevation")->isApprox(elevation));
+  EXPECT_TRUE(snapshot.get("variance")->isApprox(variance));
+  EXPECT_EQ(snapshot.get("traversability"), nullptr);
+
+  // A smaller map with fewer layers replaces the previous one.
+  const Eigen::MatrixXf smaller = Eigen::MatrixXf::Ones(10, 10);
+  writer.write(makeGeometry(10, 10), 2, {"elevation"}, {&smaller});
+  ASSERT_TRUE(reader.read(snapshot));
+  EXPECT_EQ(snapshot.updateCount, 2U);
+  ASSERT_EQ(snapshot.layers.size(), 1U);
+  EXPECT_TRUE(snapshot.layers[0].isApprox(smaller));
+}
+
+TEST(TestSharedMap, invalidMaps) {  // NOLINT
+  const auto name = uniqueName("invalid");
+  EXPECT_THROW(SharedMapReader reader(name), std::runtime_error);
+  EXPECT_THROW(SharedMapWriter writer(name, 0, 10), std::invalid_argument);
+
+  SharedMapWriter writer(name, 1, 100);
+  const Eigen::MatrixXf layer = Eigen::MatrixXf::Zero(10, 10);
+  const Eigen::MatrixXf tooLarge = Eigen::MatrixXf::Zero(20, 10);
+  EXPECT_THROW(writer.write(makeGeometry(20, 10), 0, {"elevation"}, {&tooLarge}), std::invalid_argument);
+  EXPECT_THROW(writer.write(makeGeometry(10, 10), 0, {"elevation", "variance"}, {&layer, &layer}), std::invalid_argument);
+  EXPECT_THROW(writer.write(makeGeometry(10, 5), 0, {"elevation"}, {&layer}), std::invalid_argument);
+  EXPECT_THROW(writer.write(makeGeometry(10, 10), 0, {std::string(100, 'x')}, {&layer}), std::invalid_argument);
+
+  // Rejected maps do not change the shared memory.
+  SharedMapReader reader(name);
+  EXPECT_EQ(reader.updateCount(), 0U);
+}
+
+TEST(TestSharedMap, singleWriterPerName) {  // NOLINT
+  const auto name = uniqueName("single_writer");
+  {
+    SharedMapWriter writer(name, 1, 100);
+    EXPECT_THROW(SharedMapWriter second(name, 1, 100), std::runtime_error);
+
+    // The object of the first writer stays readable.
+    const Eigen::MatrixXf layer = Eigen::MatrixXf::Ones(10, 10);
+    writer.write(makeGeometry(10, 10), 1, {"elevation"}, {&layer});
+    SharedMapReader reader(name);
+    EXPECT_EQ(reader.updateCount(), 1U);
+  }
+
+  // The name is free again once the writer is destroyed.
+  SharedMapWriter writer(name, 1, 100);
+}
+
+TEST(TestSharedMap, staleObjectOfDeadWriter) {  // NOLINT
+  const auto name = uniqueName("stale");
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Leaves the object behind, as a writer that crashed.
+    new SharedMapWriter(name, 1, 100);
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+
+  SharedMapWriter writer(name, 2, 100);
+  const Eigen::MatrixXf layer = Eigen::MatrixXf::Ones(10, 10);
+  writer.write(makeGeometry(10, 10), 1, {"elevation", "variance"}, {&layer, &layer});
+  SharedMapReader reader(name);
+  SharedMapSnapshot snapshot;
+  ASSERT_TRUE(reader.read(snapshot));
+  EXPECT_EQ(snapshot.layers.size(), 2U);
+}
+
+TEST(TestSharedMap, writerOnlyRemovesItsOwnObject) {  // NOLINT
+  const auto name = uniqueName("own_object");
+  std::unique_ptr<SharedMapWriter> first(new SharedMapWriter(name, 1, 100));
+  shm_unlink(name.c_str());
+  SharedMapWriter second(name, 1, 100);
+  first.reset();
+  EXPECT_NO_THROW(SharedMapReader reader(name));
+}
+
+TEST(TestSharedMap, readerInSeparateProcess) {  // NOLINT
+  const auto name = uniqueName("processes");
+  const int numUpdates = 2000;
+  const int rows = 200;
+  const int cols = 200;
+  SharedMapWriter writer(name, 3, rows * cols);
+  const auto geometry = makeGeometry(rows, cols);
+  std::vector<Eigen::MatrixXf> layers(3, Eigen::MatrixXf(rows, cols));
+  auto writeUpdate = [&](int update) {
+    for (size_t i = 0; i < layers.size(); ++i) {
+      layers[i].setConstant(static_cast<float>(update * 10 + i));
+    }
+    writer.write(geometry, update, {"elevation", "variance", "traversability"}, {&layers[0], &layers[1], &layers[2]});
+  };
+  writeUpdate(1);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Reader process. Reports through the exit code, gtest assertions do not work here.
+    int exitCode = 0;
+    try {
+      SharedMapReader reader(name);
+      SharedMapSnapshot snapshot;
+      uint64_t lastUpdate = 0;
+      int numSnapshots = 0;
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+      while (lastUpdate < numUpdates && std::chrono::steady_clock::now() < deadline) {
+        if (!reader.read(snapshot)) {
+          continue;
+        }
+        if (!isConsistent(snapshot) || snapshot.updateCount < lastUpdate || snapshot.layers.size() != 3) {
+          exitCode = 1;
+          break;
+        }
+        lastUpdate = snapshot.timestamp;
+        ++numSnapshots;
+      }
+      if (exitCode == 0 && (lastUpdate != numUpdates || numSnapshots < 2)) {
+        exitCode = 2;
+      }
+    } catch (const std::exception&) {
+      exitCode = 3;
+    }
+    _exit(exitCode);
+  }
+
+  // Writer process.
+  for (int update = 2; update <= numUpdates; ++update) {
+    writeUpdate(update);
+    if (update % 100 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
@@ -0,0 +1,304 @@
+/*
+ * Benchmarks for the stages of the plane decomposition pipeline.
+ *
+ * Usage:
+ *   benchmark_convex_plane_decomposition [image folders...] [--benchmark_out=results.json --benchmark_out_format=json]
+ *
+ * Every stage runs on procedurally generated terrains of several sizes and resolutions, and on all png terrains in test/data and in the
+ * optional image folders.
+ */
+
+#include <functional>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core/eigen.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include "convex_plane_decomposition/ConvexRegionGrowing.h"
+#include "convex_plane_decomposition/LoadGridmapFromImage.h"
+#include "convex_plane_decomposition/PlaneDecompositionPipeline.h"
+#include "convex_plane_decomposition/SegmentedPlaneProjection.h"
+#include "convex_plane_decomposition/SyntheticTerrain.h"
+
+using namespace convex_plane_decomposition;
+
+namespace {
+
+const std::string elevationLayer{"elevation"};
+const std::string frameId{"odom"};
+const std::string planeClassificationLayer{"plane_classification"};
+
+/// Resolution [m] of the png terrains
+constexpr double imageResolution = 0.04;
+/// Height [m] between the lowest and highest pixel value of the png terrains
+constexpr double imageHeightScale = 1.25;
+
+/// Number of pre-computed queries for the projection and region growing benchmarks
+constexpr int numberOfQueries = 1000;
+
+using MapFactory = std::function<grid_map::GridMap(const benchmark::State&)>;
+
+/// Synthetic terrain, arguments: {terrain type, map length [cm], resolution [mm]}
+grid_map::GridMap createSyntheticMap(const benchmark::State& state) {
+  const auto type = static_cast<SyntheticTerrainType>(state.range(0));
+  const double length = 0.01 * state.range(1);
+  const double resolution = 0.001 * state.range(2);
+  return createSyntheticTerrain(type, elevationLayer, frameId, length, resolution);
+}
+
+/// Pipeline configuration that keeps the map at its own resolution, such that each stage scales with the benchmarked map size.
+PlaneDecompositionPipeline::Config getConfig(const grid_map::GridMap& map) {
+  PlaneDecompositionPipeline::Config config;
+  config.preprocessingParameters.resolution = map.getResolution();
+  return config;
+}
+
+void setMapCounters(benchmark::State& state, const grid_map::GridMap& map) {
+  state.counters["cells"] = static_cast<double>(map.getSize().prod());
+  state.counters["cells_per_second"] =
+      benchmark::Counter(static_cast<double>(map.getSize().prod()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/// Intermediate results of the pipeline, computed once before the benchmark loop of a later stage.
+struct StageInputs {
+  explicit StageInputs(const grid_map::GridMap& map)
+      : config(getConfig(map)),
+        preprocessing(config.preprocessingParameters),
+        slidingWindowPlaneExtractor(config.slidingWindowPlaneExtractorParameters, config.ransacPlaneExtractorParameters),
+        contourExtraction(config.contourExtractionParameters),
+        postprocessing(config.postprocessingParameters) {
+    planarTerrain.gridMap = map;
+    preprocessing.preprocess(planarTerrain.gridMap, elevationLayer);
+    preprocessedMap = planarTerrain.gridMap;
+
+    slidingWindowPlaneExtractor.runExtraction(planarTerrain.gridMap, elevationLayer);
+    planarTerrain.planarRegions = contourExtraction.extractPlanarRegions(slidingWindowPlaneExtractor.getSegmentedPlanesMap());
+
+    planarTerrain.gridMap.add(planeClassificationLayer);
+    cv::cv2eigen(slidingWindowPlaneExtractor.getBinaryLabeledImage(), planarTerrain.gridMap.get(planeClassificationLayer));
+  }
+
+  PlaneDecompositionPipeline::Config config;
+  GridMapPreprocessing preprocessing;
+  sliding_window_plane_extractor::SlidingWindowPlaneExtractor slidingWindowPlaneExtractor;
+  contour_extraction::ContourExtraction contourExtraction;
+  Postprocessing postprocessing;
+
+  grid_map::GridMap preprocessedMap;
+  PlanarTerrain planarTerrain;  // Before postprocessing
+};
+
+/// Uniformly distributed query points above the map.
+std::vector<Eigen::Vector3d> createQueries(const grid_map::GridMap& map) {
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> unit(-0.5, 0.5);
+  std::vector<Eigen::Vector3d> queries;
+  queries.reserve(numberOfQueries);
+  for (int i = 0; i < numberOfQueries; ++i) {
+    queries.emplace_back(map.getPosition().x() + unit(generator) * map.getLength().x(),
+                         map.getPosition().y() + unit(generator) * map.getLength().y(), unit(generator) + 0.5);
+  }
+  return queries;
+}
+
+void preprocessingBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const auto map = mapFactory(state);
+  GridMapPreprocessing preprocessing(getConfig(map).preprocessingParameters);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto mapCopy = map;
+    state.ResumeTiming();
+    preprocessing.preprocess(mapCopy, elevationLayer);
+    benchmark::ClobberMemory();
+  }
+  setMapCounters(state, map);
+}
+
+void slidingWindowBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const StageInputs inputs(mapFactory(state));
+  const auto config = getConfig(inputs.preprocessedMap);
+  sliding_window_plane_extractor::SlidingWindowPlaneExtractor extractor(config.slidingWindowPlaneExtractorParameters,
+                                                                        config.ransacPlaneExtractorParameters);
+  for (auto _ : state) {
+    extractor.runExtraction(inputs.preprocessedMap, elevationLayer);
+    benchmark::DoNotOptimize(extractor.getSegmentedPlanesMap().highestLabel);
+  }
+  setMapCounters(state, inputs.preprocessedMap);
+  state.counters["ransac_invocations"] = extractor.getNumberOfRansacInvocations();
+}
+
+void contourExtractionBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  StageInputs inputs(mapFactory(state));
+  for (auto _ : state) {
+    auto planarRegions = inputs.contourExtraction.extractPlanarRegions(inputs.slidingWindowPlaneExtractor.getSegmentedPlanesMap());
+    benchmark::DoNotOptimize(planarRegions.data());
+  }
+  setMapCounters(state, inputs.preprocessedMap);
+  state.counters["regions"] = static_cast<double>(inputs.planarTerrain.planarRegions.size());
+}
+
+void postprocessingBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const StageInputs inputs(mapFactory(state));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto planarTerrain = inputs.planarTerrain;
+    state.ResumeTiming();
+    inputs.postprocessing.postprocess(planarTerrain, elevationLayer, planeClassificationLayer);
+    benchmark::ClobberMemory();
+  }
+  setMapCounters(state, inputs.preprocessedMap);
+}
+
+void pipelineBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const auto map = mapFactory(state);
+  PlaneDecompositionPipeline pipeline(getConfig(map));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto mapCopy = map;
+    state.ResumeTiming();
+    pipeline.update(std::move(mapCopy), elevationLayer);
+    benchmark::DoNotOptimize(pipeline.getPlanarTerrain().planarRegions.data());
+  }
+  setMapCounters(state, map);
+  state.counters["regions"] = pipeline.getFrameStatistics().numberOfRegions;
+  state.counters["vertices"] = pipeline.getFrameStatistics().numberOfVertices;
+}
+
+void bestPlanarRegionBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const auto map = mapFactory(state);
+  PlaneDecompositionPipeline pipeline(getConfig(map));
+  pipeline.update(grid_map::GridMap(map), elevationLayer);
+  const auto& planarRegions = pipeline.getPlanarTerrain().planarRegions;
+  if (planarRegions.empty()) {
+    state.SkipWithError("No planar regions");
+    return;
+  }
+
+  const auto queries = createQueries(map);
+  const auto penaltyFunction = [](const Eigen::Vector3d& projectedPoint) { return 0.0; };
+  size_t queryIndex = 0;
+  for (auto _ : state) {
+    const auto projection = getBestPlanarRegionAtPositionInWorld(queries[queryIndex], planarRegions, penaltyFunction);
+    benchmark::DoNotOptimize(projection.cost);
+    queryIndex = (queryIndex + 1) % queries.size();
+  }
+  state.counters["regions"] = static_cast<double>(planarRegions.size());
+}
+
+void bestPlanarRegionsBatchBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const auto map = mapFactory(state);
+  PlaneDecompositionPipeline pipeline(getConfig(map));
+  pipeline.update(grid_map::GridMap(map), elevationLayer);
+  const auto& planarRegions = pipeline.getPlanarTerrain().planarRegions;
+  if (planarRegions.empty()) {
+    state.SkipWithError("No planar regions");
+    return;
+  }
+
+  const auto queries = createQueries(map);
+  const auto penaltyFunction = [](const Eigen::Vector3d& projectedPoint) { return 0.0; };
+  for (auto _ : state) {
+    const auto projections = getBestPlanarRegionsAtPositionsInWorld(queries, planarRegions, penaltyFunction);
+    benchmark::DoNotOptimize(projections.data());
+  }
+  state.counters["regions"] = static_cast<double>(planarRegions.size());
+  state.counters["queries_per_second"] =
+      benchmark::Counter(static_cast<double>(queries.size()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void growConvexPolygonBenchmark(benchmark::State& state, const MapFactory& mapFactory) {
+  const auto map = mapFactory(state);
+  PlaneDecompositionPipeline pipeline(getConfig(map));
+  pipeline.update(grid_map::GridMap(map), elevationLayer);
+  const auto& planarRegions = pipeline.getPlanarTerrain().planarRegions;
+  if (planarRegions.empty()) {
+    state.SkipWithError("No planar regions");
+    return;
+  }
+
+  // Region growing starts from the projection of the query points.
+  const auto penaltyFunction = [](const Eigen::Vector3d& projectedPoint) { return 0.0; };
+  std::vector<PlanarTerrainProjection> projections;
+  for (const auto& query : createQueries(map)) {
+    projections.push_back(getBestPlanarRegionAtPositionInWorld(query, planarRegions, penaltyFunction));
+  }
+
+  const int numberOfVertices = 16;
+  const double growthFactor = 1.05;
+  size_t queryIndex = 0;
+  for (auto _ : state) {
+    const auto& projection = projections[queryIndex];
+    const auto convexRegion = growConvexPolygonInsideShape(projection.regionPtr->boundaryWithInset.boundary,
+                                                           projection.positionInTerrainFrame, numberOfVertices, growthFactor);
+    benchmark::DoNotOptimize(convexRegion.size());
+    queryIndex = (queryIndex + 1) % projections.size();
+  }
+}
+
+const std::vector<std::pair<std::string, void (*)(benchmark::State&, const MapFactory&)>> stageBenchmarks{
+    {"Preprocessing", &preprocessingBenchmark},
+    {"SlidingWindowPlaneExtractor", &slidingWindowBenchmark},
+    {"ContourExtraction", &contourExtractionBenchmark},
+    {"Postprocessing", &postprocessingBenchmark},
+    {"Pipeline", &pipelineBenchmark},
+    {"GetBestPlanarRegionAtPositionInWorld", &bestPlanarRegionBenchmark},
+    {"GetBestPlanarRegionsAtPositionsInWorld", &bestPlanarRegionsBatchBenchmark},
+    {"GrowConvexPolygonInsideShape", &growConvexPolygonBenchmark},
+};
+
+void registerSyntheticTerrainBenchmarks() {
+  const std::vector<int> mapLengthsInCm{200, 400, 800};
+  const std::vector<int> resolutionsInMm{20, 40};
+  for (const auto& stage : stageBenchmarks) {
+    for (const auto type :
+         {SyntheticTerrainType::Flat, SyntheticTerrainType::Stairs, SyntheticTerrainType::RandomBlocks, SyntheticTerrainType::Rubble}) {
+      auto* benchmark =
+          benchmark::RegisterBenchmark((stage.first + "/" + toString(type)).c_str(), stage.second, MapFactory(&createSyntheticMap));
+      benchmark->ArgNames({"type", "length_cm", "resolution_mm"})->Unit(benchmark::kMillisecond);
+      for (const int length : mapLengthsInCm) {
+        for (const int resolution : resolutionsInMm) {
+          benchmark->Args({static_cast<int>(type), length, resolution});
+        }
+      }
+    }
+  }
+}
+
+void registerImageTerrainBenchmarks(const std::vector<std::string>& folders) {
+  for (const auto& folder : folders) {
+    std::vector<cv::String> files;
+    cv::glob(folder + "/*.png", files, false);
+    for (const auto& file : files) {
+      const std::string filePath(file);
+      const std::string fileName = filePath.substr(filePath.find_last_of('/') + 1);
+      const MapFactory loadImage = [filePath](const benchmark::State&) {
+        return loadGridmapFromImage(filePath, elevationLayer, frameId, imageResolution, imageHeightScale);
+      };
+      for (const auto& stage : stageBenchmarks) {
+        benchmark::RegisterBenchmark((stage.first + "/" + fileName).c_str(), stage.second, loadImage)->Unit(benchmark::kMillisecond);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  // Remaining arguments are additional folders with png terrains.
+  const std::string sourceFile(__FILE__);
+  std::vector<std::string> imageFolders{sourceFile.substr(0, sourceFile.find_last_of('/')) + "/../test/data"};
+  for (int i = 1; i < argc; ++i) {
+    imageFolders.emplace_back(argv[i]);
+  }
+
+  registerSyntheticTerrainBenchmarks();
+  registerImageTerrainBenchmarks(imageFolders);
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -6,13 +6,28 @@
 
 namespace convex_plane_decomposition {
 
+enum class InpaintingMethod {
+  MinValues,  ///< Fill each hole with the lowest height on its contour
+  Harmonic    ///< Smooth interpolation of the surrounding heights in full precision
+};
+
+/** Names used in the parameter files: "min_values", "harmonic" */
+std::string toString(InpaintingMethod method);
+
+/// Inverse of toString, throws std::invalid_argument for unknown names.
+InpaintingMethod inpaintingMethodFromString(const std::string& name);
+
 struct PreprocessingParameters {
   /// Resample to this resolution, set to negative values to skip
   double resolution = 0.04;
-  /// Kernel size of the median filter, either 3 or 5
+  /// Kernel size of the median filter, must be odd
   int kernelSize = 3;
   /// Number of times the image is filtered
   int numberOfRepeats = 2;
+  /// Method used to fill missing cells
+  InpaintingMethod inpaintingMethod = InpaintingMethod::MinValues;
+  /// Harmonic inpainting only: cells further than this distance [m] from valid data remain NaN, set to negative values to fill all cells
+  double maxInpaintingDistance = -1.0;
 };
 
 class GridMapPreprocessing {
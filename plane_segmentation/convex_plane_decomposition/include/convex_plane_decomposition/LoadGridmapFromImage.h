@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include <grid_map_core/GridMap.hpp>
@@ -13,14 +15,102 @@ namespace convex_plane_decomposition {
 /**
  * Load an elevation map from a grey scale image.
  *
+ * Supported are 8-bit and 16-bit integer images (e.g. png) and 32-bit float images (e.g. tiff). Integer images are mapped from [0, max]
+ * to [0, scale]. Float images are multiplied by scale, NaN pixels are kept as NaN.
+ *
  * @param filePath : absolute path to file
  * @param elevationLayer : name of the elevation layer
  * @param frameId : frame assigned to loaded map
  * @param resolution : map resolution [m/pixel]
- * @param scale : distance [m] between lowest and highest point in the map
+ * @param scale : distance [m] between lowest and highest point in the map for integer images, factor [m / pixel value] for float images.
  * @return Gridmap with the loaded image as elevation layer.
  */
 grid_map::GridMap loadGridmapFromImage(const std::string& filePath, const std::string& elevationLayer, const std::string& frameId,
                                        double resolution, double scale);
 
-}  // namespace convex_plane_decomposition
\ No newline at end of file
+/**
+ * Load an elevation map from a grey scale image and a mask image of the same size. Cells where the mask is zero are set to NaN.
+ */
+grid_map::GridMap loadGridmapFromImage(const std::string& filePath, const std::string& maskFilePath, const std::string& elevationLayer,
+                                       const std::string& frameId, double resolution, double scale);
+
+/** Data type of the cells in a raw height file. */
+enum class RawHeightFormat { UInt16, Float32 };
+
+/**
+ * Description of a headerless height file: rows x cols cells in row-major order, native (little) endian.
+ * As for images, a row of the file corresponds to the x direction of the map.
+ */
+struct RawHeightFileDescription {
+  int rows = 0;
+  int cols = 0;
+  RawHeightFormat format = RawHeightFormat::Float32;
+  /// Number of bytes to skip at the start of the file
+  size_t headerBytes = 0;
+  /// Float32 cells are multiplied by scale, UInt16 cells are mapped from [0, 65535] to [0, scale].
+  double scale = 1.0;
+  /// UInt16 cells with this value are set to NaN. Negative: no invalid value. Float32 files mark invalid cells with NaN.
+  int invalidValue = -1;
+};
+
+/**
+ * Read-only, memory mapped height file. Crops only touch the pages of the file that contain the requested cells, such that regions of
+ * arbitrarily large terrains can be loaded without reading the entire file.
+ *
+ * The geometry of the full terrain follows loadGridmapFromImage: the terrain is centered at the origin with cell (0, 0) at the maximum x
+ * and y position.
+ */
+class MappedHeightFile {
+ public:
+  MappedHeightFile(const std::string& filePath, const RawHeightFileDescription& description, double resolution);
+  ~MappedHeightFile();
+
+  MappedHeightFile(const MappedHeightFile&) = delete;
+  MappedHeightFile& operator=(const MappedHeightFile&) = delete;
+
+  int rows() const { return description_.rows; }
+  int cols() const { return description_.cols; }
+  double getResolution() const { return resolution_; }
+
+  /** Length [m] of the full terrain */
+  grid_map::Length getLength() const { return {description_.rows * resolution_, description_.cols * resolution_}; }
+
+  /**
+   * Loads a block of cells. The block is clipped to the terrain, throws std::out_of_range if nothing remains.
+   *
+   * @param startIndex : index of the top-left cell of the block
+   * @param size : number of cells of the block
+   * @param elevationLayer : name of the elevation layer
+   * @param frameId : frame assigned to loaded map
+   * @return Gridmap with the block as elevation layer, positioned as the block lies in the full terrain.
+   */
+  grid_map::GridMap crop(const grid_map::Index& startIndex, const grid_map::Size& size, const std::string& elevationLayer,
+                         const std::string& frameId) const;
+
+  /**
+   * Loads all cells that overlap with a region around a position, similar to grid_map::GridMap::getSubmap on the full terrain.
+   *
+   * @param position : requested center of the region [m]
+   * @param length : requested side lengths of the region [m]
+   * @param elevationLayer : name of the elevation layer
+   * @param frameId : frame assigned to loaded map
+   * @return Gridmap with the region as elevation layer.
+   */
+  grid_map::GridMap crop(const grid_map::Position& position, const grid_map::Length& length, const std::string& elevationLayer,
+                         const std::string& frameId) const;
+
+ private:
+  RawHeightFileDescription description_;
+  double resolution_;
+  size_t cellBytes_;
+  size_t mappedBytes_ = 0;
+  void* mappedData_ = nullptr;
+};
+
+/**
+ * Load a full raw height file, see RawHeightFileDescription. Use MappedHeightFile to load regions of large files.
+ */
+grid_map::GridMap loadGridmapFromRawFile(const std::string& filePath, const RawHeightFileDescription& description,
+                                         const std::string& elevationLayer, const std::string& frameId, double resolution);
+
+}  // namespace convex_plane_decomposition
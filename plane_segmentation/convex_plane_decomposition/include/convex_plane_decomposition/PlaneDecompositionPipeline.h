@@ -33,6 +33,30 @@ class PlaneDecompositionPipeline {
     PostprocessingParameters postprocessingParameters;
   };
 
+  /** Size of the result of the last update */
+  struct FrameStatistics {
+    /// Number of segmented labels that were assigned plane parameters
+    int numberOfLabels = 0;
+    /// Number of extracted planar regions
+    int numberOfRegions = 0;
+    /// Number of boundary vertices (outer boundaries and holes) over all regions
+    int numberOfVertices = 0;
+    /// Number of labels that were refined with RANSAC
+    int numberOfRansacInvocations = 0;
+  };
+
+  /** Bytes held by the pipeline after the last update */
+  struct MemoryUsage {
+    /// Layers of the planar terrain map, including the layers added by the pipeline
+    size_t mapLayerBytes = 0;
+    /// Intermediate images and buffers of the sliding window plane extractor
+    size_t slidingWindowBytes = 0;
+    /// Vertices of the boundaries and insets of the planar regions
+    size_t planarRegionBytes = 0;
+
+    size_t totalBytes() const { return mapLayerBytes + slidingWindowBytes + planarRegionBytes; }
+  };
+
   /**
    * Constructor
    * @param config : configuration containing all parameters of the pipeline
@@ -52,6 +76,12 @@ class PlaneDecompositionPipeline {
   /// Fills in the resulting segmentation into a gridmap layer data.
   void getSegmentation(grid_map::GridMap::Matrix& segmentation) const;
 
+  /// Counts of labels, regions, vertices and RANSAC invocations of the last update.
+  const FrameStatistics& getFrameStatistics() const { return frameStatistics_; }
+
+  /// Bytes held by the result and the intermediate buffers, computed on request.
+  MemoryUsage getMemoryUsage() const;
+
   // Timers
   const Timer& getPrepocessTimer() const { return preprocessTimer_; }
   const Timer& getSlidingWindowTimer() const { return slidingWindowTimer_; }
@@ -59,7 +89,10 @@ class PlaneDecompositionPipeline {
   const Timer& getPostprocessTimer() const { return postprocessTimer_; }
 
  private:
+  void updateFrameStatistics();
+
   PlanarTerrain planarTerrain_;
+  FrameStatistics frameStatistics_;
 
   // Pipeline
   GridMapPreprocessing preprocessing_;
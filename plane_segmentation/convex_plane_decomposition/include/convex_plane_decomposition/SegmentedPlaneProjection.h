@@ -74,4 +74,17 @@ PlanarTerrainProjection getBestPlanarRegionAtPositionInWorld(const Eigen::Vector
                                                              const std::vector<PlanarRegion>& planarRegions,
                                                              const std::function<double(const Eigen::Vector3d&)>& penaltyFunction);
 
+/**
+ * Batched version of getBestPlanarRegionAtPositionInWorld. The queries are processed in parallel on
+ * grid_map::parallel::ThreadPool::global(), the penalty function must therefore be safe to call from several threads at once.
+ *
+ * @param positionsInWorld : Query points in world frame
+ * @param planarRegions : Candidate planar regions
+ * @param penaltyFunction : a non-negative (!) and thread-safe scoring function.
+ * @return Projection and information, one per query in the same order
+ */
+std::vector<PlanarTerrainProjection> getBestPlanarRegionsAtPositionsInWorld(
+    const std::vector<Eigen::Vector3d>& positionsInWorld, const std::vector<PlanarRegion>& planarRegions,
+    const std::function<double(const Eigen::Vector3d&)>& penaltyFunction);
+
 }  // namespace convex_plane_decomposition
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include <grid_map_core/GridMap.hpp>
+
+namespace convex_plane_decomposition {
+
+/** Procedurally generated terrains, used to create reproducible elevation maps for benchmarks and load tests. */
+enum class SyntheticTerrainType { Flat, Stairs, RandomBlocks, Rubble };
+
+/// Name of the terrain type: "flat", "stairs", "random_blocks" or "rubble"
+std::string toString(SyntheticTerrainType type);
+
+/// Inverse of toString, throws std::invalid_argument for unknown names.
+SyntheticTerrainType syntheticTerrainTypeFromString(const std::string& name);
+
+/**
+ * Creates an elevation map with a procedurally generated terrain. The terrain features are defined in world coordinates, such that maps
+ * with a different resolution show the same terrain.
+ *
+ * @param type : terrain type
+ * @param elevationLayer : name of the elevation layer
+ * @param frameId : frame assigned to the map
+ * @param length : side length of the square map [m]
+ * @param resolution : map resolution [m/cell]
+ * @param position : position of the map center [m]
+ * @param seed : seed for the random terrain features. The same seed produces the same terrain.
+ * @return Gridmap with the generated terrain as elevation layer.
+ */
+grid_map::GridMap createSyntheticTerrain(SyntheticTerrainType type, const std::string& elevationLayer, const std::string& frameId,
+                                         double length, double resolution, const grid_map::Position& position = grid_map::Position::Zero(),
+                                         unsigned int seed = 0);
+
+}  // namespace convex_plane_decomposition
@@ -4,8 +4,111 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
 namespace convex_plane_decomposition {
 
+/**
+ * Streaming histogram of durations with a fixed memory footprint.
+ *
+ * Buckets are log-linear: durations below 32ns get their own bucket, every power of two above is split into 32 linear sub-buckets. The
+ * relative error of a reported percentile is therefore below 1/32 (~3%). Durations longer than ~68s are collected in the last bucket.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() { reset(); }
+
+  /**
+   *  Remove all samples
+   */
+  void reset() {
+    counts_.fill(0);
+    numSamples_ = 0;
+  }
+
+  /**
+   * Add a single duration to the histogram
+   */
+  void addSample(std::chrono::nanoseconds duration) {
+    const auto value = static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 0));
+    counts_[getBucketIndex(value)]++;
+    numSamples_++;
+  }
+
+  /**
+   * @return Number of samples in the histogram
+   */
+  uint64_t getNumSamples() const { return numSamples_; }
+
+  /**
+   * @param percentile : requested percentile in [0, 100]
+   * @return Upper bound of the bucket containing the requested percentile, 0.0 if the histogram is empty.
+   */
+  double getPercentileInMilliseconds(double percentile) const {
+    if (numSamples_ == 0) {
+      return 0.0;
+    }
+
+    // Rank of the requested sample, counting from 1.
+    const double fraction = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(numSamples_))));
+
+    uint64_t cumulativeCount = 0;
+    for (int i = 0; i < numberOfBuckets; ++i) {
+      cumulativeCount += counts_[i];
+      if (cumulativeCount >= rank) {
+        return getBucketUpperBound(i) * 1e-6;
+      }
+    }
+    return getBucketUpperBound(numberOfBuckets - 1) * 1e-6;
+  }
+
+ private:
+  static constexpr int subBucketBits = 5;
+  static constexpr int numberOfSubBuckets = 1 << subBucketBits;
+  static constexpr int maxMostSignificantBit = 35;  // 2^36 ns ~ 68s
+  static constexpr int numberOfBuckets = numberOfSubBuckets * (maxMostSignificantBit - subBucketBits + 2);
+
+  static int getMostSignificantBit(uint64_t value) {
+    int msb = 0;
+    while (value >>= 1) {
+      ++msb;
+    }
+    return msb;
+  }
+
+  static int getBucketIndex(uint64_t value) {
+    if (value < numberOfSubBuckets) {
+      return static_cast<int>(value);
+    }
+    const int msb = getMostSignificantBit(value);
+    if (msb > maxMostSignificantBit) {
+      return numberOfBuckets - 1;
+    }
+    const int shift = msb - subBucketBits;
+    const int subBucket = static_cast<int>((value >> shift) & (numberOfSubBuckets - 1));
+    return numberOfSubBuckets * (shift + 1) + subBucket;
+  }
+
+  /// Largest duration [ns] that falls in the bucket
+  static double getBucketUpperBound(int index) {
+    if (index < numberOfSubBuckets) {
+      return static_cast<double>(index);
+    }
+    const int shift = index / numberOfSubBuckets - 1;
+    const uint64_t subBucket = index % numberOfSubBuckets;
+    const uint64_t lowerBound = (numberOfSubBuckets + subBucket) << shift;
+    return static_cast<double>(lowerBound + (uint64_t(1) << shift) - 1);
+  }
+
+  std::array<uint64_t, numberOfBuckets> counts_;
+  uint64_t numSamples_;
+};
+
 /**
  * Timer class that can be repeatedly started and stopped. Statistics are collected for all measured intervals .
  *
@@ -28,6 +131,7 @@ class Timer {
     maxIntervalTime_ = std::chrono::nanoseconds::zero();
     lastIntervalTime_ = std::chrono::nanoseconds::zero();
     numTimedIntervals_ = 0;
+    histogram_.reset();
   }
 
   /**
@@ -40,11 +144,19 @@ class Timer {
    */
   void endTimer() {
     auto endTime = std::chrono::steady_clock::now();
-    lastIntervalTime_ = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime_);
+    addInterval(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime_));
+  };
+
+  /**
+   * Add an interval that was measured externally, e.g. the latency between a message stamp and its processing.
+   */
+  void addInterval(std::chrono::nanoseconds interval) {
+    lastIntervalTime_ = interval;
     maxIntervalTime_ = std::max(maxIntervalTime_, lastIntervalTime_);
     totalTime_ += lastIntervalTime_;
     numTimedIntervals_++;
-  };
+    histogram_.addSample(lastIntervalTime_);
+  }
 
   /**
    * @return Number of intervals that were timed
@@ -71,12 +183,19 @@ class Timer {
    */
   double getAverageInMilliseconds() const { return getTotalInMilliseconds() / numTimedIntervals_; }
 
+  /**
+   * @param percentile : requested percentile in [0, 100], e.g. 99.9
+   * @return Approximate duration of the requested percentile of all timed intervals, see LatencyHistogram for the accuracy.
+   */
+  double getPercentileInMilliseconds(double percentile) const { return histogram_.getPercentileInMilliseconds(percentile); }
+
  private:
   int numTimedIntervals_;
   std::chrono::nanoseconds totalTime_;
   std::chrono::nanoseconds maxIntervalTime_;
   std::chrono::nanoseconds lastIntervalTime_;
   std::chrono::steady_clock::time_point startTime_;
+  LatencyHistogram histogram_;
 };
 
-}  // namespace convex_plane_decomposition
\ No newline at end of file
+}  // namespace convex_plane_decomposition
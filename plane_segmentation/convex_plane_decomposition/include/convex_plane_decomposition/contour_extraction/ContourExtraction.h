@@ -23,15 +23,17 @@ class ContourExtraction {
  public:
   ContourExtraction(const ContourExtractionParameters& parameters);
 
+  /** Labels are processed in parallel on grid_map::parallel::ThreadPool::global() */
   std::vector<PlanarRegion> extractPlanarRegions(const SegmentedPlanesMap& segmentedPlanesMap);
 
  private:
+  /** binaryImage is a work buffer, such that it can be reused between the labels of one thread */
+  std::vector<PlanarRegion> extractPlanarRegionsOfLabel(const SegmentedPlanesMap& upSampledMap,
+                                                        const std::pair<int, NormalAndPosition>& label_plane, cv::Mat& binaryImage) const;
+
   ContourExtractionParameters parameters_;
   cv::Mat insetKernel_;
   cv::Mat marginKernel_;
-
-  // Memory to reuse between calls
-  cv::Mat binaryImage_;
 };
 
 /// Modifies the image in-place!
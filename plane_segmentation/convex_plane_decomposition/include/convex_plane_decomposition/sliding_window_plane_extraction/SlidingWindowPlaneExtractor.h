@@ -24,6 +24,12 @@ class SlidingWindowPlaneExtractor {
 
   const cv::Mat& getBinaryLabeledImage() const { return binaryImagePatch_; }
 
+  /** Number of labels that were refined with RANSAC during the last extraction */
+  int getNumberOfRansacInvocations() const { return numberOfRansacInvocations_; }
+
+  /** Bytes held by the intermediate images and buffers, which are kept between extractions */
+  size_t getMemoryUsageInBytes() const;
+
   /** Can be run after extraction for debugging purpose */
   void addSurfaceNormalToMap(grid_map::GridMap& map, const std::string& layerPrefix) const;
 
@@ -32,7 +38,7 @@ class SlidingWindowPlaneExtractor {
                         const std::vector<ransac_plane_extractor::PointWithNormal>& pointsWithNormal) const;
   bool isWithinInclinationLimit(const Eigen::Vector3d& normalVectorPlane) const;
 
-  std::pair<Eigen::Vector3d, double> computeNormalAndErrorForWindow(const Eigen::MatrixXf& windowData) const;
+  std::pair<Eigen::Vector3d, double> computeNormalAndErrorForWindow(const Eigen::Ref<const Eigen::MatrixXf>& windowData) const;
   bool isLocallyPlanar(const Eigen::Vector3d& localNormal, double meanSquaredError) const;
 
   int getLinearIndex(int row, int col) const { return row + col * mapRows_; };
@@ -44,6 +50,7 @@ class SlidingWindowPlaneExtractor {
 
   void runSegmentation();
 
+  /** Runs on the columns of the map in parallel, on grid_map::parallel::ThreadPool::global() */
   void runSlidingWindowDetector();
 
   void setToBackground(int label);
@@ -54,8 +61,10 @@ class SlidingWindowPlaneExtractor {
   const grid_map::GridMap* map_;
   std::string elevationLayer_;
   int mapRows_;
+  int numberOfRansacInvocations_ = 0;
 
   std::vector<Eigen::Vector3d> surfaceNormals_;
+  Eigen::MatrixXf paddedElevation_;
   std::vector<ransac_plane_extractor::PointWithNormal> pointsWithNormal_;
 
   cv::Mat binaryImagePatch_;
@@ -4,11 +4,32 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <grid_map_filters_rsl/TiledFilterChain.hpp>
 #include <grid_map_filters_rsl/inpainting.hpp>
-#include <grid_map_filters_rsl/smoothing.hpp>
+
+#include <stdexcept>
 
 namespace convex_plane_decomposition {
 
+std::string toString(InpaintingMethod method) {
+  switch (method) {
+    case InpaintingMethod::MinValues:
+      return "min_values";
+    case InpaintingMethod::Harmonic:
+      return "harmonic";
+  }
+  return "";
+}
+
+InpaintingMethod inpaintingMethodFromString(const std::string& name) {
+  for (const auto method : {InpaintingMethod::MinValues, InpaintingMethod::Harmonic}) {
+    if (toString(method) == name) {
+      return method;
+    }
+  }
+  throw std::invalid_argument("[GridMapPreprocessing] Unknown inpainting method: " + name);
+}
+
 GridMapPreprocessing::GridMapPreprocessing(const PreprocessingParameters& parameters) : parameters_(parameters) {}
 
 void GridMapPreprocessing::preprocess(grid_map::GridMap& gridMap, const std::string& layer) const {
@@ -18,8 +39,13 @@ void GridMapPreprocessing::preprocess(grid_map::GridMap& gridMap, const std::str
 }
 
 void GridMapPreprocessing::denoise(grid_map::GridMap& gridMap, const std::string& layer) const {
-  int kernelSize = std::max(1, std::min(parameters_.kernelSize, 5));  // must be 1, 3 or 5 for current image type, see doc of cv::medianBlur
-  grid_map::smoothing::median(gridMap, layer, layer, kernelSize, 0, parameters_.numberOfRepeats);
+  const int kernelSize = std::max(1, parameters_.kernelSize);
+  // All repetitions are applied to one tile after the other, while the tile is in cache.
+  grid_map::processing::TiledFilterChain denoisingChain;
+  for (int iter = 0; iter < parameters_.numberOfRepeats; ++iter) {
+    denoisingChain.addMedian(kernelSize, 0, 1);
+  }
+  denoisingChain.apply(gridMap, layer, layer);
 }
 
 void GridMapPreprocessing::changeResolution(grid_map::GridMap& gridMap, const std::string& layer) const {
@@ -32,7 +58,14 @@ void GridMapPreprocessing::changeResolution(grid_map::GridMap& gridMap, const st
 
 void GridMapPreprocessing::inpaint(grid_map::GridMap& gridMap, const std::string& layer) const {
   const std::string& layerOut = "tmp";
-  grid_map::inpainting::minValues(gridMap, layer, layerOut);
+  switch (parameters_.inpaintingMethod) {
+    case InpaintingMethod::MinValues:
+      grid_map::inpainting::minValues(gridMap, layer, layerOut);
+      break;
+    case InpaintingMethod::Harmonic:
+      grid_map::inpainting::harmonicInterpolation(gridMap, layer, layerOut, parameters_.maxInpaintingDistance);
+      break;
+  }
 
   gridMap.get(layer) = std::move(gridMap.get(layerOut));
   gridMap.erase(layerOut);
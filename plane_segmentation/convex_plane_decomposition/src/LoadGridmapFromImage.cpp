@@ -4,6 +4,15 @@
 
 #include "convex_plane_decomposition/LoadGridmapFromImage.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 
@@ -13,24 +22,193 @@ namespace convex_plane_decomposition {
 
 grid_map::GridMap loadGridmapFromImage(const std::string& filePath, const std::string& elevationLayer, const std::string& frameId,
                                        double resolution, double scale) {
-  // Read the file
+  // Read the file, keeping 16-bit and float images at their original depth
   cv::Mat image;
-  image = cv::imread(filePath, cv::ImreadModes::IMREAD_GRAYSCALE);
+  image = cv::imread(filePath, cv::ImreadModes::IMREAD_GRAYSCALE | cv::ImreadModes::IMREAD_ANYDEPTH);
 
   // Check for invalid input
   if (!image.data) {
     throw std::runtime_error("Could not open or find the image");
   }
 
-  // Min max values
-  double minValue, maxValue;
-  cv::minMaxLoc(image, &minValue, &maxValue);
-
   grid_map::GridMap mapOut({elevationLayer});
   mapOut.setFrameId(frameId);
   grid_map::GridMapCvConverter::initializeFromImage(image, resolution, mapOut, grid_map::Position(0.0, 0.0));
-  grid_map::GridMapCvConverter::addLayerFromImage<unsigned char, 1>(image, elevationLayer, mapOut, float(0.0), float(scale), 0.5);
+  switch (image.depth()) {
+    case CV_8U:
+      grid_map::GridMapCvConverter::addLayerFromImage<unsigned char, 1>(image, elevationLayer, mapOut, float(0.0), float(scale), 0.5);
+      break;
+    case CV_16U:
+      grid_map::GridMapCvConverter::addLayerFromImage<unsigned short, 1>(image, elevationLayer, mapOut, float(0.0), float(scale), 0.5);
+      break;
+    case CV_32F:
+      // grid_map_cv takes float images as normalized to [0, 1], such that the range [0, scale] multiplies every pixel by scale.
+      grid_map::GridMapCvConverter::addLayerFromImage<float, 1>(image, elevationLayer, mapOut, float(0.0), float(scale), 0.5);
+      break;
+    default:
+      throw std::runtime_error("Unsupported image depth, use an 8-bit, 16-bit or float image");
+  }
+  return mapOut;
+}
+
+grid_map::GridMap loadGridmapFromImage(const std::string& filePath, const std::string& maskFilePath, const std::string& elevationLayer,
+                                       const std::string& frameId, double resolution, double scale) {
+  auto mapOut = loadGridmapFromImage(filePath, elevationLayer, frameId, resolution, scale);
+
+  cv::Mat mask = cv::imread(maskFilePath, cv::ImreadModes::IMREAD_GRAYSCALE);
+  if (!mask.data) {
+    throw std::runtime_error("Could not open or find the mask image");
+  }
+  auto& elevation = mapOut.get(elevationLayer);
+  if (mask.rows != elevation.rows() || mask.cols != elevation.cols()) {
+    throw std::runtime_error("Mask image has a different size than the elevation image");
+  }
+
+  for (int row = 0; row < mask.rows; ++row) {
+    const auto* maskRow = mask.ptr<unsigned char>(row);
+    for (int col = 0; col < mask.cols; ++col) {
+      if (maskRow[col] == 0) {
+        elevation(row, col) = NAN;
+      }
+    }
+  }
+  return mapOut;
+}
+
+namespace {
+
+size_t getCellBytes(RawHeightFormat format) {
+  switch (format) {
+    case RawHeightFormat::UInt16:
+      return sizeof(uint16_t);
+    case RawHeightFormat::Float32:
+      return sizeof(float);
+  }
+  throw std::invalid_argument("[MappedHeightFile] Unknown raw height format");
+}
+
+/**
+ * Copies a block of the row-major file into the column-major elevation matrix. The copy is done in square tiles such that both the reads
+ * and the writes stay within a few cache lines.
+ */
+template <typename CellType, typename Conversion>
+void copyBlock(const uint8_t* data, int fileCols, const grid_map::Index& startIndex, grid_map::Matrix& elevation, Conversion conversion) {
+  constexpr int tileSize = 64;
+  for (int tileCol = 0; tileCol < elevation.cols(); tileCol += tileSize) {
+    const int tileColEnd = std::min<int>(tileCol + tileSize, elevation.cols());
+    for (int tileRow = 0; tileRow < elevation.rows(); tileRow += tileSize) {
+      const int tileRowEnd = std::min<int>(tileRow + tileSize, elevation.rows());
+      for (int row = tileRow; row < tileRowEnd; ++row) {
+        const uint8_t* fileRow = data + (static_cast<size_t>(startIndex.x() + row) * fileCols + startIndex.y()) * sizeof(CellType);
+        for (int col = tileCol; col < tileColEnd; ++col) {
+          CellType value;
+          std::memcpy(&value, fileRow + col * sizeof(CellType), sizeof(CellType));  // Cells are not necessarily aligned after the header.
+          elevation(row, col) = conversion(value);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+MappedHeightFile::MappedHeightFile(const std::string& filePath, const RawHeightFileDescription& description, double resolution)
+    : description_(description), resolution_(resolution), cellBytes_(getCellBytes(description.format)) {
+  if (description_.rows <= 0 || description_.cols <= 0) {
+    throw std::invalid_argument("[MappedHeightFile] Number of rows and columns must be positive");
+  }
+
+  const int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+  if (fileDescriptor < 0) {
+    throw std::runtime_error("[MappedHeightFile] Could not open " + filePath);
+  }
+
+  struct stat fileStatus;
+  if (::fstat(fileDescriptor, &fileStatus) != 0) {
+    ::close(fileDescriptor);
+    throw std::runtime_error("[MappedHeightFile] Could not read the size of " + filePath);
+  }
+  const size_t expectedBytes = description_.headerBytes + static_cast<size_t>(description_.rows) * description_.cols * cellBytes_;
+  if (static_cast<size_t>(fileStatus.st_size) < expectedBytes) {
+    ::close(fileDescriptor);
+    throw std::runtime_error("[MappedHeightFile] " + filePath + " is smaller than described: " + std::to_string(fileStatus.st_size) +
+                             " < " + std::to_string(expectedBytes) + " bytes");
+  }
+
+  mappedBytes_ = expectedBytes;
+  mappedData_ = ::mmap(nullptr, mappedBytes_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  ::close(fileDescriptor);  // The mapping stays valid after closing the file.
+  if (mappedData_ == MAP_FAILED) {
+    mappedData_ = nullptr;
+    throw std::runtime_error("[MappedHeightFile] Could not map " + filePath);
+  }
+  // Crops access a small part of the file, don't read ahead the full file.
+  ::madvise(mappedData_, mappedBytes_, MADV_RANDOM);
+}
+
+MappedHeightFile::~MappedHeightFile() {
+  if (mappedData_ != nullptr) {
+    ::munmap(mappedData_, mappedBytes_);
+  }
+}
+
+grid_map::GridMap MappedHeightFile::crop(const grid_map::Index& startIndex, const grid_map::Size& size, const std::string& elevationLayer,
+                                         const std::string& frameId) const {
+  // Clip to the terrain
+  const grid_map::Index fileSize(description_.rows, description_.cols);
+  const grid_map::Index clippedStart = startIndex.max(0).min(fileSize);
+  const grid_map::Index clippedEnd = (startIndex + size).max(0).min(fileSize);
+  const grid_map::Size clippedSize = clippedEnd - clippedStart;
+  if ((clippedSize <= 0).any()) {
+    throw std::out_of_range("[MappedHeightFile] Requested crop does not overlap with the terrain");
+  }
+
+  // Center of the block in the full terrain, which is centered at the origin.
+  const grid_map::Position position =
+      resolution_ * (0.5 * fileSize.cast<double>() - clippedStart.cast<double>() - 0.5 * clippedSize.cast<double>()).matrix();
+
+  grid_map::GridMap mapOut({elevationLayer});
+  mapOut.setFrameId(frameId);
+  mapOut.setGeometry(grid_map::Length(resolution_ * clippedSize.cast<double>()), resolution_, position);
+  auto& elevation = mapOut.get(elevationLayer);
+
+  const auto* data = static_cast<const uint8_t*>(mappedData_) + description_.headerBytes;
+  const float scale = static_cast<float>(description_.scale);
+  switch (description_.format) {
+    case RawHeightFormat::UInt16: {
+      const float uint16Scale = scale / static_cast<float>(std::numeric_limits<uint16_t>::max());
+      const int invalidValue = description_.invalidValue;
+      copyBlock<uint16_t>(data, description_.cols, clippedStart, elevation, [=](uint16_t value) {
+        return (static_cast<int>(value) == invalidValue) ? std::numeric_limits<float>::quiet_NaN() : uint16Scale * value;
+      });
+      break;
+    }
+    case RawHeightFormat::Float32: {
+      copyBlock<float>(data, description_.cols, clippedStart, elevation, [=](float value) { return scale * value; });
+      break;
+    }
+  }
   return mapOut;
 }
 
-}  // namespace convex_plane_decomposition
\ No newline at end of file
+grid_map::GridMap MappedHeightFile::crop(const grid_map::Position& position, const grid_map::Length& length,
+                                         const std::string& elevationLayer, const std::string& frameId) const {
+  // Index of the cell containing a position, see grid_map::getIndexFromPosition for a map centered at the origin.
+  const grid_map::Index fileSize(description_.rows, description_.cols);
+  auto getIndex = [&](const Eigen::Array2d& p) -> grid_map::Index {
+    return (0.5 * fileSize.cast<double>() - p / resolution_).floor().cast<int>();
+  };
+
+  // Same corners as grid_map::getSubmapInformation, the crop contains all cells that overlap with the requested region.
+  const grid_map::Index topLeftIndex = getIndex(position.array() + 0.5 * length.array());
+  const grid_map::Index bottomRightIndex = getIndex(position.array() - 0.5 * length.array());
+  return crop(topLeftIndex, grid_map::Size(bottomRightIndex - topLeftIndex + 1), elevationLayer, frameId);
+}
+
+grid_map::GridMap loadGridmapFromRawFile(const std::string& filePath, const RawHeightFileDescription& description,
+                                         const std::string& elevationLayer, const std::string& frameId, double resolution) {
+  const MappedHeightFile heightFile(filePath, description, resolution);
+  return heightFile.crop(grid_map::Index(0, 0), grid_map::Size(description.rows, description.cols), elevationLayer, frameId);
+}
+
+}  // namespace convex_plane_decomposition
@@ -36,10 +36,51 @@ void PlaneDecompositionPipeline::update(grid_map::GridMap&& gridMap, const std::
 
   postprocessing_.postprocess(planarTerrain_, elevationLayer, planeClassificationLayer);
   postprocessTimer_.endTimer();
+
+  updateFrameStatistics();
 }
 
 void PlaneDecompositionPipeline::getSegmentation(grid_map::GridMap::Matrix& segmentation) const {
   cv::cv2eigen(slidingWindowPlaneExtractor_.getSegmentedPlanesMap().labeledImage, segmentation);
 }
 
+PlaneDecompositionPipeline::MemoryUsage PlaneDecompositionPipeline::getMemoryUsage() const {
+  MemoryUsage memoryUsage;
+  for (const auto& layer : planarTerrain_.gridMap.getLayers()) {
+    memoryUsage.mapLayerBytes += planarTerrain_.gridMap.get(layer).size() * sizeof(float);
+  }
+  memoryUsage.slidingWindowBytes = slidingWindowPlaneExtractor_.getMemoryUsageInBytes();
+
+  const auto polygonBytes = [](const CgalPolygonWithHoles2d& polygon) {
+    size_t numberOfVertices = polygon.outer_boundary().size();
+    for (auto holeIt = polygon.holes_begin(); holeIt != polygon.holes_end(); ++holeIt) {
+      numberOfVertices += holeIt->size();
+    }
+    return numberOfVertices * sizeof(CgalPoint2d);
+  };
+  memoryUsage.planarRegionBytes = planarTerrain_.planarRegions.capacity() * sizeof(PlanarRegion);
+  for (const auto& planarRegion : planarTerrain_.planarRegions) {
+    memoryUsage.planarRegionBytes += polygonBytes(planarRegion.boundaryWithInset.boundary);
+    for (const auto& inset : planarRegion.boundaryWithInset.insets) {
+      memoryUsage.planarRegionBytes += sizeof(CgalPolygonWithHoles2d) + polygonBytes(inset);
+    }
+  }
+  return memoryUsage;
+}
+
+void PlaneDecompositionPipeline::updateFrameStatistics() {
+  frameStatistics_.numberOfLabels = static_cast<int>(slidingWindowPlaneExtractor_.getSegmentedPlanesMap().labelPlaneParameters.size());
+  frameStatistics_.numberOfRegions = static_cast<int>(planarTerrain_.planarRegions.size());
+  frameStatistics_.numberOfRansacInvocations = slidingWindowPlaneExtractor_.getNumberOfRansacInvocations();
+
+  frameStatistics_.numberOfVertices = 0;
+  for (const auto& planarRegion : planarTerrain_.planarRegions) {
+    const auto& boundary = planarRegion.boundaryWithInset.boundary;
+    frameStatistics_.numberOfVertices += static_cast<int>(boundary.outer_boundary().size());
+    for (auto holeIt = boundary.holes_begin(); holeIt != boundary.holes_end(); ++holeIt) {
+      frameStatistics_.numberOfVertices += static_cast<int>(holeIt->size());
+    }
+  }
+}
+
 }  // namespace convex_plane_decomposition
\ No newline at end of file
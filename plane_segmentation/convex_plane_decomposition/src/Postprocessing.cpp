@@ -112,20 +112,10 @@ void Postprocessing::addSmoothLayer(grid_map::GridMap& gridMap, const Eigen::Mat
 
   gridMap.add("elevationWithNaNClosed", toEigen(elevationWithNaNCv));
 
-  // Dilation with a slope of 45 deg
-  int halfDilationSize = (dilationSize - 1) / 2;
-  float slope = gridMap.getResolution();  // dh dpixel
-  Eigen::MatrixXf offsets(dilationSize, dilationSize);
-  for (int i = 0; i < dilationSize; ++i) {
-    for (int j = 0; j < dilationSize; ++j) {
-      const auto dx = (i - halfDilationSize);
-      const auto dy = (j - halfDilationSize);
-      offsets(i, j) = slope * std::sqrt(dx * dx + dy * dy);
-    }
-  }
-  grid_map::processing::applyKernelFunction(
-      gridMap, "elevationWithNaNClosed", "elevationWithNaNClosedDilated", dilationSize,
-      [&](const Eigen::Ref<const grid_map::GridMap::Matrix>& data) -> float { return (data - offsets).maxCoeffOfFinites(); });
+  // Dilation with a slope of 45 deg. Within dilationSize / 2 cells of the map border, the window is clipped and the cone is centered at
+  // the cell. Before coneDilate, the window was shifted to stay inside the map and the cone was centered at the shifted window.
+  const float slope = gridMap.getResolution();  // dh dpixel
+  grid_map::processing::coneDilate(gridMap, "elevationWithNaNClosed", "elevationWithNaNClosedDilated", slope, dilationSize);
 
   // Convert to openCV
   auto elevationWithNaNImage = toCv(gridMap.get("elevationWithNaNClosedDilated"));
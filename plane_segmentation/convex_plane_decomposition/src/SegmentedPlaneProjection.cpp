@@ -6,6 +6,8 @@
 
 #include "convex_plane_decomposition/GeometryUtils.h"
 
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+
 namespace convex_plane_decomposition {
 
 namespace {  // Helper functions that only make sense in this context
@@ -147,4 +149,16 @@ PlanarTerrainProjection getBestPlanarRegionAtPositionInWorld(const Eigen::Vector
   return projection;
 }
 
+std::vector<PlanarTerrainProjection> getBestPlanarRegionsAtPositionsInWorld(
+    const std::vector<Eigen::Vector3d>& positionsInWorld, const std::vector<PlanarRegion>& planarRegions,
+    const std::function<double(const Eigen::Vector3d&)>& penaltyFunction) {
+  std::vector<PlanarTerrainProjection> projections(positionsInWorld.size());
+  grid_map::parallel::ThreadPool::global().parallelFor(0, static_cast<int>(positionsInWorld.size()), [&](int queryBegin, int queryEnd) {
+    for (int queryIndex = queryBegin; queryIndex < queryEnd; ++queryIndex) {
+      projections[queryIndex] = getBestPlanarRegionAtPositionInWorld(positionsInWorld[queryIndex], planarRegions, penaltyFunction);
+    }
+  });
+  return projections;
+}
+
 }  // namespace convex_plane_decomposition
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "convex_plane_decomposition/SyntheticTerrain.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace convex_plane_decomposition {
+
+namespace {
+
+/// Rectangular block with a (possibly) tilted top surface
+struct Block {
+  grid_map::Position center;
+  grid_map::Position halfSize;
+  double height;
+  grid_map::Position slope;
+};
+
+struct BlockTiling {
+  /// Side length of the world tiles that are filled with blocks [m]
+  double tileSize;
+  int blocksPerTile;
+  double minHalfSize;
+  double maxHalfSize;
+  double minHeight;
+  double maxHeight;
+  double maxSlope;
+};
+
+/**
+ * Blocks are generated per world tile with a generator seeded by the tile coordinates. A tile therefore always contains the same blocks,
+ * independent of the map position, resolution and size.
+ */
+std::vector<Block> generateBlocks(const BlockTiling& tiling, const grid_map::Position& minCorner, const grid_map::Position& maxCorner,
+                                  unsigned int seed) {
+  const int minTileX = static_cast<int>(std::floor((minCorner.x() - tiling.maxHalfSize) / tiling.tileSize));
+  const int maxTileX = static_cast<int>(std::floor((maxCorner.x() + tiling.maxHalfSize) / tiling.tileSize));
+  const int minTileY = static_cast<int>(std::floor((minCorner.y() - tiling.maxHalfSize) / tiling.tileSize));
+  const int maxTileY = static_cast<int>(std::floor((maxCorner.y() + tiling.maxHalfSize) / tiling.tileSize));
+
+  std::vector<Block> blocks;
+  blocks.reserve((maxTileX - minTileX + 1) * (maxTileY - minTileY + 1) * tiling.blocksPerTile);
+  for (int tileX = minTileX; tileX <= maxTileX; ++tileX) {
+    for (int tileY = minTileY; tileY <= maxTileY; ++tileY) {
+      std::seed_seq seedSequence{seed, static_cast<unsigned int>(tileX), static_cast<unsigned int>(tileY)};
+      std::mt19937 generator(seedSequence);
+      std::uniform_real_distribution<double> unit(0.0, 1.0);
+      auto uniform = [&](double a, double b) { return a + (b - a) * unit(generator); };
+
+      for (int i = 0; i < tiling.blocksPerTile; ++i) {
+        Block block;
+        block.center = {(tileX + unit(generator)) * tiling.tileSize, (tileY + unit(generator)) * tiling.tileSize};
+        block.halfSize = {uniform(tiling.minHalfSize, tiling.maxHalfSize), uniform(tiling.minHalfSize, tiling.maxHalfSize)};
+        block.height = uniform(tiling.minHeight, tiling.maxHeight);
+        block.slope = {uniform(-tiling.maxSlope, tiling.maxSlope), uniform(-tiling.maxSlope, tiling.maxSlope)};
+        blocks.push_back(block);
+      }
+    }
+  }
+  return blocks;
+}
+
+/// Rasterizes the blocks into the elevation data by taking the maximum over the ground and all overlapping blocks.
+void addBlocks(const std::vector<Block>& blocks, const grid_map::GridMap& map, grid_map::Matrix& elevation) {
+  const double resolution = map.getResolution();
+  // Position of the outer edge of cell (0, 0). The index increases in negative x and y direction.
+  const grid_map::Position topCorner = map.getPosition() + 0.5 * map.getLength().matrix();
+  const int rows = elevation.rows();
+  const int cols = elevation.cols();
+
+  for (const auto& block : blocks) {
+    auto toIndex = [&](double distanceFromTopCorner) { return static_cast<int>(std::floor(distanceFromTopCorner / resolution)); };
+    const int minRow = std::max(0, toIndex(topCorner.x() - block.center.x() - block.halfSize.x()));
+    const int maxRow = std::min(rows - 1, toIndex(topCorner.x() - block.center.x() + block.halfSize.x()));
+    const int minCol = std::max(0, toIndex(topCorner.y() - block.center.y() - block.halfSize.y()));
+    const int maxCol = std::min(cols - 1, toIndex(topCorner.y() - block.center.y() + block.halfSize.y()));
+
+    for (int col = minCol; col <= maxCol; ++col) {
+      const double dy = topCorner.y() - (col + 0.5) * resolution - block.center.y();
+      if (std::abs(dy) > block.halfSize.y()) {
+        continue;
+      }
+      for (int row = minRow; row <= maxRow; ++row) {
+        const double dx = topCorner.x() - (row + 0.5) * resolution - block.center.x();
+        if (std::abs(dx) > block.halfSize.x()) {
+          continue;
+        }
+        const float height = static_cast<float>(block.height + block.slope.x() * dx + block.slope.y() * dy);
+        elevation(row, col) = std::max(elevation(row, col), height);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+std::string toString(SyntheticTerrainType type) {
+  switch (type) {
+    case SyntheticTerrainType::Flat:
+      return "flat";
+    case SyntheticTerrainType::Stairs:
+      return "stairs";
+    case SyntheticTerrainType::RandomBlocks:
+      return "random_blocks";
+    case SyntheticTerrainType::Rubble:
+      return "rubble";
+  }
+  throw std::invalid_argument("[SyntheticTerrain] Unknown terrain type");
+}
+
+SyntheticTerrainType syntheticTerrainTypeFromString(const std::string& name) {
+  for (const auto type : {SyntheticTerrainType::Flat, SyntheticTerrainType::Stairs, SyntheticTerrainType::RandomBlocks,
+                          SyntheticTerrainType::Rubble}) {
+    if (toString(type) == name) {
+      return type;
+    }
+  }
+  throw std::invalid_argument("[SyntheticTerrain] Unknown terrain type: " + name);
+}
+
+grid_map::GridMap createSyntheticTerrain(SyntheticTerrainType type, const std::string& elevationLayer, const std::string& frameId,
+                                         double length, double resolution, const grid_map::Position& position, unsigned int seed) {
+  grid_map::GridMap mapOut({elevationLayer});
+  mapOut.setFrameId(frameId);
+  mapOut.setGeometry(grid_map::Length(length, length), resolution, position);
+  auto& elevation = mapOut.get(elevationLayer);
+  elevation.setZero();
+
+  const grid_map::Position minCorner = mapOut.getPosition() - 0.5 * mapOut.getLength().matrix();
+  const grid_map::Position maxCorner = mapOut.getPosition() + 0.5 * mapOut.getLength().matrix();
+
+  switch (type) {
+    case SyntheticTerrainType::Flat: {
+      break;
+    }
+    case SyntheticTerrainType::Stairs: {
+      const double stepHeight = 0.15;
+      const double stepDepth = 0.3;
+      const grid_map::Position topCorner = maxCorner;
+      for (int row = 0; row < elevation.rows(); ++row) {
+        const double x = topCorner.x() - (row + 0.5) * resolution;
+        elevation.row(row).setConstant(static_cast<float>(stepHeight * std::floor(x / stepDepth)));
+      }
+      break;
+    }
+    case SyntheticTerrainType::RandomBlocks: {
+      const BlockTiling tiling{1.0, 1, 0.15, 0.5, 0.05, 0.4, 0.0};
+      addBlocks(generateBlocks(tiling, minCorner, maxCorner, seed), mapOut, elevation);
+      break;
+    }
+    case SyntheticTerrainType::Rubble: {
+      const BlockTiling tiling{0.5, 4, 0.05, 0.2, 0.0, 0.25, 0.3};
+      addBlocks(generateBlocks(tiling, minCorner, maxCorner, seed), mapOut, elevation);
+      break;
+    }
+  }
+  return mapOut;
+}
+
+}  // namespace convex_plane_decomposition
@@ -6,13 +6,16 @@
 #include "convex_plane_decomposition/contour_extraction/Upsampling.h"
 
 #include <convex_plane_decomposition/GeometryUtils.h>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <iterator>
+
 namespace convex_plane_decomposition {
 namespace contour_extraction {
 
 ContourExtraction::ContourExtraction(const ContourExtractionParameters& parameters)
-    : parameters_(parameters), binaryImage_(cv::Size(0, 0), CV_8UC1) {
+    : parameters_(parameters) {
   {
     int erosionSize = 1;  // single sided length of the kernel
     int erosionType = cv::MORPH_CROSS;
@@ -28,38 +31,58 @@ ContourExtraction::ContourExtraction(const ContourExtractionParameters& paramete
 std::vector<PlanarRegion> ContourExtraction::extractPlanarRegions(const SegmentedPlanesMap& segmentedPlanesMap) {
   const auto upSampledMap = upSample(segmentedPlanesMap);
 
+  // Labels are processed in parallel, each range of labels with its own binary image. The regions are concatenated in label order
+  // afterwards, such that the result does not depend on the number of threads.
+  const int numLabels = static_cast<int>(upSampledMap.labelPlaneParameters.size());
+  std::vector<std::vector<PlanarRegion>> planarRegionsPerLabel(numLabels);
+  grid_map::parallel::ThreadPool::global().parallelFor(0, numLabels, [&](int labelBegin, int labelEnd) {
+    cv::Mat binaryImage;
+    for (int labelId = labelBegin; labelId < labelEnd; ++labelId) {
+      planarRegionsPerLabel[labelId] = extractPlanarRegionsOfLabel(upSampledMap, upSampledMap.labelPlaneParameters[labelId], binaryImage);
+    }
+  });
+
   std::vector<PlanarRegion> planarRegions;
   planarRegions.reserve(upSampledMap.highestLabel + 1); // Can be more or less in the end if regions are split or removed.
-  for (const auto& label_plane : upSampledMap.labelPlaneParameters) {
-    const int label = label_plane.first;
-    binaryImage_ = upSampledMap.labeledImage == label;
-
-    // Try with safety margin
-    cv::erode(binaryImage_, binaryImage_, marginKernel_, cv::Point(-1,-1), 1, cv::BORDER_REPLICATE);
-    auto boundariesAndInsets = contour_extraction::extractBoundaryAndInset(binaryImage_, insetKernel_);
-
-    // If safety margin makes the region disappear -> try without
-    if (boundariesAndInsets.empty()) {
-      binaryImage_ = upSampledMap.labeledImage == label;
-      // still 1 pixel erosion to remove the growth after upsampling
-      cv::erode(binaryImage_, binaryImage_, insetKernel_, cv::Point(-1,-1), 1, cv::BORDER_REPLICATE);
-      boundariesAndInsets = contour_extraction::extractBoundaryAndInset(binaryImage_, insetKernel_);
-    }
+  for (auto& planarRegionsOfLabel : planarRegionsPerLabel) {
+    std::move(planarRegionsOfLabel.begin(), planarRegionsOfLabel.end(), std::back_inserter(planarRegions));
+  }
+  return planarRegions;
+}
 
-    const auto plane_parameters = getTransformLocalToGlobal(label_plane.second);
-    for (auto& boundaryAndInset : boundariesAndInsets) {
-      // Transform points from pixel space to local terrain frame
-      transformInPlace(boundaryAndInset, [&](CgalPoint2d& point) {
-        auto pointInWorld = pixelToWorldFrame(point, upSampledMap.resolution, upSampledMap.mapOrigin);
-        point = projectToPlaneAlongGravity(pointInWorld, plane_parameters);
-      });
-
-      PlanarRegion planarRegion;
-      planarRegion.boundaryWithInset = std::move(boundaryAndInset);
-      planarRegion.transformPlaneToWorld = plane_parameters;
-      planarRegion.bbox2d = planarRegion.boundaryWithInset.boundary.outer_boundary().bbox();
-      planarRegions.push_back(std::move(planarRegion));
-    }
+std::vector<PlanarRegion> ContourExtraction::extractPlanarRegionsOfLabel(const SegmentedPlanesMap& upSampledMap,
+                                                                         const std::pair<int, NormalAndPosition>& label_plane,
+                                                                         cv::Mat& binaryImage) const {
+  const int label = label_plane.first;
+  binaryImage = upSampledMap.labeledImage == label;
+
+  // Try with safety margin
+  cv::erode(binaryImage, binaryImage, marginKernel_, cv::Point(-1,-1), 1, cv::BORDER_REPLICATE);
+  auto boundariesAndInsets = contour_extraction::extractBoundaryAndInset(binaryImage, insetKernel_);
+
+  // If safety margin makes the region disappear -> try without
+  if (boundariesAndInsets.empty()) {
+    binaryImage = upSampledMap.labeledImage == label;
+    // still 1 pixel erosion to remove the growth after upsampling
+    cv::erode(binaryImage, binaryImage, insetKernel_, cv::Point(-1,-1), 1, cv::BORDER_REPLICATE);
+    boundariesAndInsets = contour_extraction::extractBoundaryAndInset(binaryImage, insetKernel_);
+  }
+
+  std::vector<PlanarRegion> planarRegions;
+  planarRegions.reserve(boundariesAndInsets.size());
+  const auto plane_parameters = getTransformLocalToGlobal(label_plane.second);
+  for (auto& boundaryAndInset : boundariesAndInsets) {
+    // Transform points from pixel space to local terrain frame
+    transformInPlace(boundaryAndInset, [&](CgalPoint2d& point) {
+      auto pointInWorld = pixelToWorldFrame(point, upSampledMap.resolution, upSampledMap.mapOrigin);
+      point = projectToPlaneAlongGravity(pointInWorld, plane_parameters);
+    });
+
+    PlanarRegion planarRegion;
+    planarRegion.boundaryWithInset = std::move(boundaryAndInset);
+    planarRegion.transformPlaneToWorld = plane_parameters;
+    planarRegion.bbox2d = planarRegion.boundaryWithInset.boundary.outer_boundary().bbox();
+    planarRegions.push_back(std::move(planarRegion));
   }
   return planarRegions;
 }
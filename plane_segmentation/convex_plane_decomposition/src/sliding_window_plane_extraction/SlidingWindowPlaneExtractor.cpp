@@ -10,6 +10,7 @@
 #include <opencv2/imgproc.hpp>
 
 #include <grid_map_core/grid_map_core.hpp>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
 
 namespace convex_plane_decomposition {
 namespace sliding_window_plane_extractor {
@@ -57,13 +58,13 @@ void SlidingWindowPlaneExtractor::runExtraction(const grid_map::GridMap& map, co
   // Initialize based on map size.
   segmentedPlanesMap_.highestLabel = -1;
   segmentedPlanesMap_.labelPlaneParameters.clear();
+  numberOfRansacInvocations_ = 0;
   const auto& mapSize = map_->getSize();
   binaryImagePatch_ = cv::Mat(mapSize(0), mapSize(1), CV_8U, 0.0);  // Zero initialize to set untouched pixels to not planar;
   // Need a buffer of at least the linear size of the image. But no need to shrink if the buffer is already bigger.
   const int linearMapSize = mapSize(0) * mapSize(1);
   if (surfaceNormals_.size() < linearMapSize) {
-    surfaceNormals_.reserve(linearMapSize);
-    std::fill_n(surfaceNormals_.begin(), linearMapSize, Eigen::Vector3d::Zero());
+    surfaceNormals_.resize(linearMapSize, Eigen::Vector3d::Zero());
   }
 
   // Run
@@ -76,7 +77,8 @@ void SlidingWindowPlaneExtractor::runExtraction(const grid_map::GridMap& map, co
   binaryImagePatch_.setTo(1, binaryImagePatch_ == 255);
 }
 
-std::pair<Eigen::Vector3d, double> SlidingWindowPlaneExtractor::computeNormalAndErrorForWindow(const Eigen::MatrixXf& windowData) const {
+std::pair<Eigen::Vector3d, double> SlidingWindowPlaneExtractor::computeNormalAndErrorForWindow(
+    const Eigen::Ref<const Eigen::MatrixXf>& windowData) const {
   // Gather surrounding data.
   size_t nPoints = 0;
   Eigen::Vector3d sum = Eigen::Vector3d::Zero();
@@ -113,26 +115,31 @@ bool SlidingWindowPlaneExtractor::isLocallyPlanar(const Eigen::Vector3d& localNo
 }
 
 void SlidingWindowPlaneExtractor::runSlidingWindowDetector() {
-  grid_map::SlidingWindowIterator window_iterator(*map_, elevationLayer_, grid_map::SlidingWindowIterator::EdgeHandling::EMPTY,
-                                                  parameters_.kernel_size);
-  const int kernelMiddle = (parameters_.kernel_size - 1) / 2;
-
-  for (; !window_iterator.isPastEnd(); ++window_iterator) {
-    grid_map::Index index = *window_iterator;
-    Eigen::MatrixXf window_data = window_iterator.getData();
-    const auto middleValue = window_data(kernelMiddle, kernelMiddle);
-
-    if (!std::isfinite(middleValue)) {
-      binaryImagePatch_.at<bool>(index.x(), index.y()) = false;
-    } else {
-      Eigen::Vector3d n;
-      double meanSquaredError;
-      std::tie(n, meanSquaredError) = computeNormalAndErrorForWindow(window_data);
-
-      surfaceNormals_[getLinearIndex(index.x(), index.y())] = n;
-      binaryImagePatch_.at<bool>(index.x(), index.y()) = isLocallyPlanar(n, meanSquaredError);
+  const auto& elevationData = (*map_)[elevationLayer_];
+  const int kernelSize = parameters_.kernel_size;
+  const int kernelMiddle = (kernelSize - 1) / 2;
+
+  // Pad the map with NaN, such that the window around every cell lies inside (EMPTY edge handling of grid_map::SlidingWindowIterator).
+  paddedElevation_.setConstant(elevationData.rows() + 2 * kernelMiddle, elevationData.cols() + 2 * kernelMiddle, NAN);
+  paddedElevation_.block(kernelMiddle, kernelMiddle, elevationData.rows(), elevationData.cols()) = elevationData;
+
+  // Columns are processed in parallel, each cell only writes its own normal and pixel.
+  grid_map::parallel::ThreadPool::global().parallelFor(0, static_cast<int>(elevationData.cols()), [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      for (int row = 0; row < elevationData.rows(); ++row) {
+        if (!std::isfinite(elevationData(row, col))) {
+          binaryImagePatch_.at<bool>(row, col) = false;
+        } else {
+          Eigen::Vector3d n;
+          double meanSquaredError;
+          std::tie(n, meanSquaredError) = computeNormalAndErrorForWindow(paddedElevation_.block(row, col, kernelSize, kernelSize));
+
+          surfaceNormals_[getLinearIndex(row, col)] = n;
+          binaryImagePatch_.at<bool>(row, col) = isLocallyPlanar(n, meanSquaredError);
+        }
+      }
     }
-  }
+  });
 
   // opening filter
   if (parameters_.planarity_opening_filter > 0) {
@@ -224,6 +231,7 @@ void SlidingWindowPlaneExtractor::refineLabelWithRansac(int label, std::vector<r
   CGAL::get_default_random() = CGAL::Random(0);
 
   // Run ransac
+  ++numberOfRansacInvocations_;
   ransac_plane_extractor::RansacPlaneExtractor ransac_plane_extractor(ransacParameters_);
   ransac_plane_extractor.detectPlanes(pointsWithNormal);
   const auto& planes = ransac_plane_extractor.getDetectedPlanes();
@@ -274,6 +282,14 @@ void SlidingWindowPlaneExtractor::addSurfaceNormalToMap(grid_map::GridMap& map,
   }
 }
 
+size_t SlidingWindowPlaneExtractor::getMemoryUsageInBytes() const {
+  const auto matBytes = [](const cv::Mat& mat) { return mat.total() * mat.elemSize(); };
+  return matBytes(binaryImagePatch_) + matBytes(segmentedPlanesMap_.labeledImage) + paddedElevation_.size() * sizeof(float) +
+         surfaceNormals_.capacity() * sizeof(Eigen::Vector3d) +
+         pointsWithNormal_.capacity() * sizeof(ransac_plane_extractor::PointWithNormal) +
+         segmentedPlanesMap_.labelPlaneParameters.capacity() * sizeof(std::pair<int, NormalAndPosition>);
+}
+
 bool SlidingWindowPlaneExtractor::isGloballyPlanar(const Eigen::Vector3d& normalVectorPlane, const Eigen::Vector3d& supportVectorPlane,
                                                    const std::vector<ransac_plane_extractor::PointWithNormal>& pointsWithNormal) const {
   // Part of the plane projection that is independent of the point
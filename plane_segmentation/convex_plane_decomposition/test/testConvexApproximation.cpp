@@ -99,3 +99,38 @@ TEST(TestConvexApproximation, runOnDemoMap) {
     }
   }
 }
+
+TEST(TestConvexApproximation, batchedProjection) {
+  PlaneDecompositionPipeline::Config config;
+  const auto resolution = config.preprocessingParameters.resolution;
+  const std::string elevationLayer{"elevation_test"};
+  const Eigen::Array2d submapSize(3.0, 3.0);
+
+  boost::filesystem::path filePath(__FILE__);
+  std::string folder = filePath.parent_path().generic_string() + std::string{"/data/"};
+  const auto loadedMap = loadGridmapFromImage(folder + "terrain.png", elevationLayer, "odom_test", resolution, 1.25);
+  bool success = false;
+  auto elevationMap = loadedMap.getSubmap(loadedMap.getPosition(), submapSize, success);
+  ASSERT_TRUE(success);
+
+  PlaneDecompositionPipeline pipeline(config);
+  pipeline.update(std::move(elevationMap), elevationLayer);
+  const auto& planarRegions = pipeline.getPlanarTerrain().planarRegions;
+
+  std::vector<Eigen::Vector3d> queries;
+  for (double x = -submapSize.x() / 2.0; x < submapSize.x() / 2.0; x += submapSize.x() / 16.0) {
+    for (double y = -submapSize.y() / 2.0; y < submapSize.y() / 2.0; y += submapSize.y() / 16.0) {
+      queries.emplace_back(x, y, 0.5);
+    }
+  }
+  auto penaltyFunction = [](const Eigen::Vector3d& projectedPoint) { return 0.1 * std::abs(projectedPoint.z()); };
+
+  const auto projections = getBestPlanarRegionsAtPositionsInWorld(queries, planarRegions, penaltyFunction);
+  ASSERT_EQ(projections.size(), queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    const auto projectionCheck = getBestPlanarRegionAtPositionInWorld(queries[i], planarRegions, penaltyFunction);
+    ASSERT_EQ(projections[i].regionPtr, projectionCheck.regionPtr);
+    ASSERT_DOUBLE_EQ(projections[i].cost, projectionCheck.cost);
+    ASSERT_TRUE(projections[i].positionInWorld.isApprox(projectionCheck.positionInWorld));
+  }
+}
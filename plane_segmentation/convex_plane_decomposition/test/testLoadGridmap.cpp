@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "convex_plane_decomposition/LoadGridmapFromImage.h"
+
+using namespace convex_plane_decomposition;
+
+namespace {
+
+template <typename T>
+std::string writeRawFile(const std::string& name, const std::vector<T>& data, size_t headerBytes = 0) {
+  const std::string filePath = "/tmp/" + name;
+  std::ofstream file(filePath, std::ios::binary);
+  const std::vector<char> header(headerBytes, 0);
+  file.write(header.data(), header.size());
+  file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+  return filePath;
+}
+
+}  // namespace
+
+TEST(TestLoadGridmap, rawFloatFile) {
+  const int rows = 37;
+  const int cols = 23;
+  std::vector<float> data(rows * cols);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 0.01f * i;
+  }
+  data[5 * cols + 7] = NAN;
+
+  RawHeightFileDescription description;
+  description.rows = rows;
+  description.cols = cols;
+  description.format = RawHeightFormat::Float32;
+  description.headerBytes = 3;  // Unaligned cells
+  description.scale = 2.0;
+  const auto filePath = writeRawFile("testLoadGridmap_float.raw", data, description.headerBytes);
+
+  const auto map = loadGridmapFromRawFile(filePath, description, "elevation", "odom", 0.1);
+  std::remove(filePath.c_str());
+
+  ASSERT_EQ(map.getSize()(0), rows);
+  ASSERT_EQ(map.getSize()(1), cols);
+  ASSERT_TRUE(map.getPosition().isZero(1e-9));
+  const auto& elevation = map.get("elevation");
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      if (row == 5 && col == 7) {
+        ASSERT_TRUE(std::isnan(elevation(row, col)));
+      } else {
+        ASSERT_FLOAT_EQ(elevation(row, col), 2.0f * data[row * cols + col]);
+      }
+    }
+  }
+}
+
+TEST(TestLoadGridmap, rawUInt16File) {
+  const int rows = 4;
+  const int cols = 3;
+  std::vector<uint16_t> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 65535, 65535};
+
+  RawHeightFileDescription description;
+  description.rows = rows;
+  description.cols = cols;
+  description.format = RawHeightFormat::UInt16;
+  description.scale = 1.5;
+  description.invalidValue = 0;
+  const auto filePath = writeRawFile("testLoadGridmap_uint16.raw", data);
+
+  const auto map = loadGridmapFromRawFile(filePath, description, "elevation", "odom", 0.1);
+  std::remove(filePath.c_str());
+
+  const auto& elevation = map.get("elevation");
+  ASSERT_TRUE(std::isnan(elevation(0, 0)));
+  ASSERT_FLOAT_EQ(elevation(1, 2), 1.5f * 5.0f / 65535.0f);
+  ASSERT_FLOAT_EQ(elevation(3, 1), 1.5f);
+}
+
+TEST(TestLoadGridmap, cropMatchesFullTerrain) {
+  const int rows = 150;
+  const int cols = 130;
+  std::vector<float> data(rows * cols);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 0.001f * i;
+  }
+
+  RawHeightFileDescription description;
+  description.rows = rows;
+  description.cols = cols;
+  const auto filePath = writeRawFile("testLoadGridmap_crop.raw", data);
+  const double resolution = 0.05;
+  const MappedHeightFile heightFile(filePath, description, resolution);
+  const auto fullMap = loadGridmapFromRawFile(filePath, description, "elevation", "odom", resolution);
+  std::remove(filePath.c_str());  // The mapping stays valid
+
+  auto checkCrop = [&](const grid_map::GridMap& crop) {
+    const auto& elevation = crop.get("elevation");
+    for (int row = 0; row < elevation.rows(); ++row) {
+      for (int col = 0; col < elevation.cols(); ++col) {
+        grid_map::Position position;
+        crop.getPosition(grid_map::Index(row, col), position);
+        ASSERT_FLOAT_EQ(elevation(row, col), fullMap.atPosition("elevation", position));
+      }
+    }
+  };
+
+  // Crop by index, partially outside of the terrain
+  const auto indexCrop = heightFile.crop(grid_map::Index(120, -10), grid_map::Size(70, 50), "elevation", "odom");
+  ASSERT_EQ(indexCrop.getSize()(0), 30);
+  ASSERT_EQ(indexCrop.getSize()(1), 40);
+  checkCrop(indexCrop);
+
+  // Crop by position
+  const grid_map::Position requestedPosition(0.83, -1.21);
+  const auto positionCrop = heightFile.crop(requestedPosition, grid_map::Length(1.0, 2.0), "elevation", "odom");
+  ASSERT_TRUE(positionCrop.isInside(requestedPosition));
+  ASSERT_GE(positionCrop.getLength()(0), 1.0);
+  ASSERT_GE(positionCrop.getLength()(1), 2.0);
+  checkCrop(positionCrop);
+
+  ASSERT_THROW(heightFile.crop(grid_map::Index(rows, 0), grid_map::Size(10, 10), "elevation", "odom"), std::out_of_range);
+}
+
+TEST(TestLoadGridmap, sixteenBitImageWithMask) {
+  const int rows = 20;
+  const int cols = 30;
+  cv::Mat image(rows, cols, CV_16UC1);
+  cv::Mat mask(rows, cols, CV_8UC1, cv::Scalar(255));
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      image.at<uint16_t>(row, col) = static_cast<uint16_t>(100 * row + col);
+    }
+  }
+  mask.at<uint8_t>(3, 4) = 0;
+  const std::string imagePath = "/tmp/testLoadGridmap_16bit.png";
+  const std::string maskPath = "/tmp/testLoadGridmap_mask.png";
+  cv::imwrite(imagePath, image);
+  cv::imwrite(maskPath, mask);
+
+  const double scale = 3.0;
+  const auto map = loadGridmapFromImage(imagePath, maskPath, "elevation", "odom", 0.1, scale);
+  std::remove(imagePath.c_str());
+  std::remove(maskPath.c_str());
+
+  const auto& elevation = map.get("elevation");
+  ASSERT_TRUE(std::isnan(elevation(3, 4)));
+  // 16-bit precision is preserved, neighbouring values are distinguishable
+  ASSERT_FLOAT_EQ(elevation(7, 11), scale * 711.0f / 65535.0f);
+  ASSERT_FLOAT_EQ(elevation(7, 12), scale * 712.0f / 65535.0f);
+}
+
+TEST(TestLoadGridmap, floatTiffWithMask) {
+  const int rows = 20;
+  const int cols = 30;
+  cv::Mat image(rows, cols, CV_32FC1);
+  cv::Mat mask(rows, cols, CV_8UC1, cv::Scalar(255));
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      image.at<float>(row, col) = 0.25f * row - 0.01f * col;  // Values outside of [0, 1], including negative ones
+    }
+  }
+  image.at<float>(8, 9) = NAN;
+  mask.at<uint8_t>(3, 4) = 0;
+  const std::string imagePath = "/tmp/testLoadGridmap_float.tiff";
+  const std::string maskPath = "/tmp/testLoadGridmap_float_mask.png";
+  ASSERT_TRUE(cv::imwrite(imagePath, image));
+  ASSERT_TRUE(cv::imwrite(maskPath, mask));
+
+  const double scale = 2.5;
+  const auto map = loadGridmapFromImage(imagePath, maskPath, "elevation", "odom", 0.1, scale);
+  const auto unmaskedMap = loadGridmapFromImage(imagePath, "elevation", "odom", 0.1, scale);
+  std::remove(imagePath.c_str());
+  std::remove(maskPath.c_str());
+
+  ASSERT_EQ(map.getSize()(0), rows);
+  ASSERT_EQ(map.getSize()(1), cols);
+  const auto& elevation = map.get("elevation");
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      if ((row == 3 && col == 4) || (row == 8 && col == 9)) {
+        ASSERT_TRUE(std::isnan(elevation(row, col))) << row << ", " << col;
+      } else {
+        // Float images are multiplied by scale, they are not normalized to a range.
+        ASSERT_FLOAT_EQ(elevation(row, col), static_cast<float>(scale) * image.at<float>(row, col)) << row << ", " << col;
+      }
+    }
+  }
+
+  // Without the mask, only the NaN pixel is NaN.
+  const auto& unmaskedElevation = unmaskedMap.get("elevation");
+  ASSERT_TRUE(std::isnan(unmaskedElevation(8, 9)));
+  ASSERT_FLOAT_EQ(unmaskedElevation(3, 4), static_cast<float>(scale) * image.at<float>(3, 4));
+}
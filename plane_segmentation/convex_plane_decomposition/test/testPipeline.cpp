@@ -8,6 +8,7 @@
 
 #include "convex_plane_decomposition/LoadGridmapFromImage.h"
 #include "convex_plane_decomposition/PlaneDecompositionPipeline.h"
+#include "convex_plane_decomposition/SyntheticTerrain.h"
 
 using namespace convex_plane_decomposition;
 
@@ -33,3 +34,48 @@ TEST(TestPipeline, runOnDemoMap) {
   PlaneDecompositionPipeline pipeline(config);
   ASSERT_NO_THROW(pipeline.update(std::move(elevationMap), elevationLayer));
 }
+
+TEST(TestPipeline, runOnSyntheticTerrain) {
+  PlaneDecompositionPipeline::Config config;
+  const auto resolution = config.preprocessingParameters.resolution;
+  const std::string elevationLayer{"elevation_test"};
+  const std::string frameId{"odom_test"};
+  const double mapLength = 3.0;
+
+  PlaneDecompositionPipeline pipeline(config);
+  for (const auto type :
+       {SyntheticTerrainType::Flat, SyntheticTerrainType::Stairs, SyntheticTerrainType::RandomBlocks, SyntheticTerrainType::Rubble}) {
+    auto elevationMap = createSyntheticTerrain(type, elevationLayer, frameId, mapLength, resolution);
+    ASSERT_EQ(syntheticTerrainTypeFromString(toString(type)), type);
+    ASSERT_NO_THROW(pipeline.update(std::move(elevationMap), elevationLayer));
+    ASSERT_GT(pipeline.getFrameStatistics().numberOfRegions, 0);
+  }
+}
+
+TEST(TestPipeline, memoryUsage) {
+  PlaneDecompositionPipeline::Config config;
+  const auto resolution = config.preprocessingParameters.resolution;
+  const std::string elevationLayer{"elevation_test"};
+  const std::string frameId{"odom_test"};
+
+  PlaneDecompositionPipeline pipeline(config);
+  ASSERT_EQ(pipeline.getMemoryUsage().mapLayerBytes, 0U);
+
+  auto elevationMap = createSyntheticTerrain(SyntheticTerrainType::Stairs, elevationLayer, frameId, 3.0, resolution);
+  const size_t numberOfCells = elevationMap.getSize().prod();
+  pipeline.update(std::move(elevationMap), elevationLayer);
+  const auto memoryUsage = pipeline.getMemoryUsage();
+
+  // Every layer of the result holds one float per cell.
+  const auto& gridMap = pipeline.getPlanarTerrain().gridMap;
+  ASSERT_EQ(gridMap.getSize().prod(), numberOfCells);
+  ASSERT_EQ(memoryUsage.mapLayerBytes, gridMap.getLayers().size() * numberOfCells * sizeof(float));
+
+  // Binary image (uint8), labeled image (int32), and surface normals.
+  ASSERT_GE(memoryUsage.slidingWindowBytes, numberOfCells * (sizeof(uint8_t) + sizeof(int32_t) + sizeof(Eigen::Vector3d)));
+
+  const auto& statistics = pipeline.getFrameStatistics();
+  ASSERT_GE(memoryUsage.planarRegionBytes,
+            statistics.numberOfRegions * sizeof(PlanarRegion) + statistics.numberOfVertices * sizeof(CgalPoint2d));
+  ASSERT_EQ(memoryUsage.totalBytes(), memoryUsage.mapLayerBytes + memoryUsage.slidingWindowBytes + memoryUsage.planarRegionBytes);
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "convex_plane_decomposition/Timer.h"
+
+using namespace convex_plane_decomposition;
+
+TEST(TestTimer, emptyHistogram) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(histogram.getNumSamples(), 0);
+  ASSERT_DOUBLE_EQ(histogram.getPercentileInMilliseconds(50.0), 0.0);
+}
+
+TEST(TestTimer, percentilesOfUniformIntervals) {
+  Timer timer;
+  for (int i = 1; i <= 1000; ++i) {
+    timer.addInterval(std::chrono::milliseconds(i));
+  }
+
+  // Histogram buckets have a relative width of 1/32.
+  const double relativeTolerance = 1.0 / 32.0;
+  for (double percentile : {50.0, 90.0, 99.0, 99.9}) {
+    const double expected = 10.0 * percentile;
+    ASSERT_NEAR(timer.getPercentileInMilliseconds(percentile), expected, relativeTolerance * expected);
+    ASSERT_GE(timer.getPercentileInMilliseconds(percentile), expected);
+  }
+  ASSERT_DOUBLE_EQ(timer.getMaxIntervalInMilliseconds(), 1000.0);
+  ASSERT_DOUBLE_EQ(timer.getAverageInMilliseconds(), 500.5);
+}
+
+TEST(TestTimer, tailLatency) {
+  Timer timer;
+  for (int i = 0; i < 999; ++i) {
+    timer.addInterval(std::chrono::microseconds(100));
+  }
+  timer.addInterval(std::chrono::milliseconds(50));
+
+  ASSERT_LT(timer.getPercentileInMilliseconds(99.0), 0.11);
+  ASSERT_GT(timer.getPercentileInMilliseconds(99.95), 49.0);
+
+  timer.reset();
+  ASSERT_DOUBLE_EQ(timer.getPercentileInMilliseconds(99.0), 0.0);
+}
@@ -0,0 +1,38 @@
+/**
+ * @brief       Parameters of the batch tool, read from yaml files in the format of config/parameters.yaml.
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
+
+#include <convex_plane_decomposition/PlaneDecompositionPipeline.h>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+
+namespace convex_plane_decomposition {
+
+struct BatchParameters {
+  PlaneDecompositionPipeline::Config config;
+  grid_map::parallel::ThreadPoolSettings threadPoolSettings;
+};
+
+/**
+ * Sets a pipeline parameter by its name in the parameter files, e.g. "preprocessing/kernelSize", see ParameterTable.h.
+ * @throw std::runtime_error if the parameter is unknown.
+ */
+void setParameter(PlaneDecompositionPipeline::Config& config, const std::string& name, const YAML::Node& value);
+
+/** Flattens a nested yaml map into {"prefix/name", value} pairs. */
+void flattenYaml(const YAML::Node& node, const std::string& prefix, std::vector<std::pair<std::string, YAML::Node>>& entries);
+
+/**
+ * Reads the pipeline parameters and the `thread_pool` section of a parameter file.
+ * @throw std::runtime_error if a parameter is unknown.
+ */
+BatchParameters loadBatchParameters(const YAML::Node& node);
+
+}  // namespace convex_plane_decomposition
@@ -11,6 +11,9 @@
 
 #include <grid_map_msgs/GridMap.h>
 
+#include <convex_plane_decomposition_msgs/GetMemoryUsage.h>
+#include <convex_plane_decomposition_msgs/MemoryUsage.h>
+
 #include <convex_plane_decomposition/Timer.h>
 
 namespace convex_plane_decomposition {
@@ -28,10 +31,32 @@ class ConvexPlaneExtractionROS {
   bool loadParameters(const ros::NodeHandle& nodeHandle);
 
   /**
-   * Callback method for the incoming grid map message.
+   * Callback method for the incoming grid map message. Taken by shared pointer, such that messages of a nodelet in the same manager are
+   * not copied.
    * @param message the incoming message.
    */
-  void callback(const grid_map_msgs::GridMap& message);
+  void callback(const grid_map_msgs::GridMapConstPtr& message);
+
+  /**
+   * Publishes the latency percentiles of all pipeline stages and the counts of the last processed frame.
+   */
+  void publishStatistics(const ros::TimerEvent& event);
+
+  /**
+   * Publishes the bytes held by the pipeline and by the last published messages.
+   */
+  void publishMemoryUsage(const ros::TimerEvent& event);
+
+  bool getMemoryUsage(convex_plane_decomposition_msgs::GetMemoryUsage::Request& request,
+                      convex_plane_decomposition_msgs::GetMemoryUsage::Response& response);
+
+  convex_plane_decomposition_msgs::MemoryUsage collectMemoryUsage() const;
+
+  /**
+   * Checks if a visualization layer fits in the memory budget.
+   * @return false if the layer must not be added.
+   */
+  bool checkMemoryBudget(const std::string& layer, size_t layerBytes) const;
 
   Eigen::Isometry3d getTransformToTargetFrame(const std::string& sourceFrame, const ros::Time& time);
 
@@ -42,6 +67,10 @@ class ConvexPlaneExtractionROS {
   double subMapWidth_;
   double subMapLength_;
   bool publishToController_;
+  double statisticsPublishFrequency_;
+  double memoryUsagePublishFrequency_;
+  size_t memoryBudgetBytes_;
+  bool memoryBudgetRefuseLayers_;
 
   // ROS communication
   ros::Subscriber elevationMapSubscriber_;
@@ -49,14 +78,23 @@ class ConvexPlaneExtractionROS {
   ros::Publisher boundaryPublisher_;
   ros::Publisher insetPublisher_;
   ros::Publisher regionPublisher_;
+  ros::Publisher statisticsPublisher_;
+  ros::Timer statisticsTimer_;
+  ros::Publisher memoryUsagePublisher_;
+  ros::Timer memoryUsageTimer_;
+  ros::ServiceServer memoryUsageService_;
   tf2_ros::Buffer tfBuffer_;
   tf2_ros::TransformListener tfListener_;
 
   // Pipeline
   std::unique_ptr<PlaneDecompositionPipeline> planeDecompositionPipeline_;
 
+  // Serialized size of the last published planar terrain and filtered map
+  size_t outputMessageBytes_ = 0;
+
   // Timing
   Timer callbackTimer_;
+  Timer inputToOutputTimer_;
 };
 
 }  // namespace convex_plane_decomposition
@@ -11,6 +11,7 @@
 #include <convex_plane_decomposition/contour_extraction/ContourExtractionParameters.h>
 #include <convex_plane_decomposition/ransac/RansacPlaneExtractorParameters.h>
 #include <convex_plane_decomposition/sliding_window_plane_extraction/SlidingWindowPlaneExtractorParameters.h>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
 
 namespace convex_plane_decomposition {
 
@@ -27,4 +28,6 @@ sliding_window_plane_extractor::SlidingWindowPlaneExtractorParameters loadSlidin
 
 PostprocessingParameters loadPostprocessingParameters(const ros::NodeHandle& nodeHandle, const std::string& prefix);
 
+grid_map::parallel::ThreadPoolSettings loadThreadPoolSettings(const ros::NodeHandle& nodeHandle, const std::string& prefix);
+
 }  // namespace convex_plane_decomposition
@@ -0,0 +1,96 @@
+/**
+ * @brief       Names of the parameters in the parameter files, shared by the ROS loaders and the batch tool.
+ *
+ * The functions below call `read(name, value)` for every parameter of a section, with `value` holding the current setting in the unit of
+ * the parameter file. `read` returns true if it assigned a new value, after which conversions to the unit of the parameter struct,
+ * e.g. degrees to cosines, are applied.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include <convex_plane_decomposition/PlaneDecompositionPipeline.h>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+
+namespace convex_plane_decomposition {
+
+/** @throw std::invalid_argument for an unknown inpainting method. Read last, such that all other parameters are set when it throws. */
+template <typename Read>
+void readParameters(PreprocessingParameters& parameters, Read&& read) {
+  read("resolution", parameters.resolution);
+  read("kernelSize", parameters.kernelSize);
+  read("numberOfRepeats", parameters.numberOfRepeats);
+  read("maxInpaintingDistance", parameters.maxInpaintingDistance);
+  std::string inpaintingMethod = toString(parameters.inpaintingMethod);
+  if (read("inpaintingMethod", inpaintingMethod)) {
+    parameters.inpaintingMethod = inpaintingMethodFromString(inpaintingMethod);
+  }
+}
+
+template <typename Read>
+void readParameters(contour_extraction::ContourExtractionParameters& parameters, Read&& read) {
+  read("marginSize", parameters.marginSize);
+}
+
+template <typename Read>
+void readParameters(ransac_plane_extractor::RansacPlaneExtractorParameters& parameters, Read&& read) {
+  read("probability", parameters.probability);
+  read("min_points", parameters.min_points);
+  read("epsilon", parameters.epsilon);
+  read("cluster_epsilon", parameters.cluster_epsilon);
+  read("normal_threshold", parameters.normal_threshold);
+}
+
+template <typename Read>
+void readParameters(sliding_window_plane_extractor::SlidingWindowPlaneExtractorParameters& parameters, Read&& read) {
+  read("kernel_size", parameters.kernel_size);
+  read("planarity_opening_filter", parameters.planarity_opening_filter);
+  double planeInclinationDegrees = std::acos(parameters.plane_inclination_threshold) * 180.0 / M_PI;
+  if (read("plane_inclination_threshold_degrees", planeInclinationDegrees)) {
+    parameters.plane_inclination_threshold = std::cos(planeInclinationDegrees * M_PI / 180.0);
+  }
+  double localPlaneInclinationDegrees = std::acos(parameters.local_plane_inclination_threshold) * 180.0 / M_PI;
+  if (read("local_plane_inclination_threshold_degrees", localPlaneInclinationDegrees)) {
+    parameters.local_plane_inclination_threshold = std::cos(localPlaneInclinationDegrees * M_PI / 180.0);
+  }
+  read("plane_patch_error_threshold", parameters.plane_patch_error_threshold);
+  read("min_number_points_per_label", parameters.min_number_points_per_label);
+  read("connectivity", parameters.connectivity);
+  read("include_ransac_refinement", parameters.include_ransac_refinement);
+  read("global_plane_fit_distance_error_threshold", parameters.global_plane_fit_distance_error_threshold);
+  read("global_plane_fit_angle_error_threshold_degrees", parameters.global_plane_fit_angle_error_threshold_degrees);
+}
+
+template <typename Read>
+void readParameters(PostprocessingParameters& parameters, Read&& read) {
+  read("extracted_planes_height_offset", parameters.extracted_planes_height_offset);
+  read("nonplanar_height_offset", parameters.nonplanar_height_offset);
+  read("nonplanar_horizontal_offset", parameters.nonplanar_horizontal_offset);
+  read("smoothing_dilation_size", parameters.smoothing_dilation_size);
+  read("smoothing_box_kernel_size", parameters.smoothing_box_kernel_size);
+  read("smoothing_gauss_kernel_size", parameters.smoothing_gauss_kernel_size);
+}
+
+template <typename Read>
+void readParameters(grid_map::parallel::ThreadPoolSettings& settings, Read&& read) {
+  read("num_threads", settings.numThreads);
+  read("cpu_affinity", settings.cpuAffinity);
+  read("deterministic", settings.deterministic);
+}
+
+/** Reads all sections of the pipeline, with names prefixed by their section, e.g. "preprocessing/kernelSize". */
+template <typename Read>
+void readParameters(PlaneDecompositionPipeline::Config& config, Read&& read) {
+  const auto readSection = [&read](const std::string& section) {
+    return [&read, section](const std::string& name, auto& value) { return read(section + name, value); };
+  };
+  readParameters(config.preprocessingParameters, readSection("preprocessing/"));
+  readParameters(config.contourExtractionParameters, readSection("contour_extraction/"));
+  readParameters(config.ransacPlaneExtractorParameters, readSection("ransac_plane_refinement/"));
+  readParameters(config.slidingWindowPlaneExtractorParameters, readSection("sliding_window_plane_extractor/"));
+  readParameters(config.postprocessingParameters, readSection("postprocessing/"));
+}
+
+}  // namespace convex_plane_decomposition
@@ -0,0 +1,70 @@
+/**
+ * @brief       Parameters of the batch tool, see BatchParameters.h.
+ */
+
+#include "convex_plane_decomposition_ros/BatchParameters.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "convex_plane_decomposition_ros/ParameterTable.h"
+
+namespace convex_plane_decomposition {
+
+namespace {
+
+/**
+ * Sets the parameter `name` of a parameter struct or of the pipeline config, with the names of ParameterTable.h.
+ * @return false if the parameter is unknown.
+ */
+template <typename Parameters>
+bool setParameterByName(Parameters& parameters, const std::string& name, const YAML::Node& value) {
+  bool isKnown = false;
+  readParameters(parameters, [&](const std::string& parameterName, auto& parameter) {
+    if (parameterName != name) {
+      return false;
+    }
+    parameter = value.as<std::decay_t<decltype(parameter)>>();
+    isKnown = true;
+    return true;
+  });
+  return isKnown;
+}
+
+}  // namespace
+
+void setParameter(PlaneDecompositionPipeline::Config& config, const std::string& name, const YAML::Node& value) {
+  if (!setParameterByName(config, name, value)) {
+    throw std::runtime_error("[BatchPlaneDecomposition] Unknown parameter `" + name + "`");
+  }
+}
+
+void flattenYaml(const YAML::Node& node, const std::string& prefix, std::vector<std::pair<std::string, YAML::Node>>& entries) {
+  for (const auto& entry : node) {
+    const std::string name = prefix + entry.first.as<std::string>();
+    if (entry.second.IsMap()) {
+      flattenYaml(entry.second, name + "/", entries);
+    } else {
+      entries.emplace_back(name, entry.second);
+    }
+  }
+}
+
+BatchParameters loadBatchParameters(const YAML::Node& node) {
+  BatchParameters parameters;
+  std::vector<std::pair<std::string, YAML::Node>> entries;
+  flattenYaml(node, "", entries);
+  const std::string threadPoolPrefix = "thread_pool/";
+  for (const auto& entry : entries) {
+    if (entry.first.compare(0, threadPoolPrefix.size(), threadPoolPrefix) != 0) {
+      setParameter(parameters.config, entry.first, entry.second);
+      continue;
+    }
+    if (!setParameterByName(parameters.threadPoolSettings, entry.first.substr(threadPoolPrefix.size()), entry.second)) {
+      throw std::runtime_error("[BatchPlaneDecomposition] Unknown parameter `" + entry.first + "`");
+    }
+  }
+  return parameters;
+}
+
+}  // namespace convex_plane_decomposition
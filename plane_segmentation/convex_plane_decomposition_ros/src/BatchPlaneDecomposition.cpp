@@ -0,0 +1,423 @@
+/*
+ * Offline batch processing of recorded elevation maps, without a running ROS system.
+ *
+ * Elevation maps are read from rosbags or from folders with png images, and are processed in parallel with one set of pipelines per worker
+ * thread. All combinations of the parameter values in the sweep file are evaluated for every map. Per frame metrics are written to a CSV
+ * file.
+ *
+ * Usage:
+ *   convex_plane_decomposition_ros_batch --output metrics.csv [options]
+ *
+ * Options:
+ *   --bag <file>                 rosbag with grid_map_msgs/GridMap messages, requires --topic. Can be repeated.
+ *   --topic <name>               topic of the elevation maps in the rosbags
+ *   --images <folder>            folder with png height images, see loadGridmapFromImage. Can be repeated.
+ *   --image_resolution <m>       resolution of the png images (default 0.04)
+ *   --image_height_scale <m>     height between the lowest and highest pixel value (default 1.0)
+ *   --layer <name>               elevation layer (default "elevation")
+ *   --submap_length <m>          extract a centered submap before processing, as done by the node (default: full map)
+ *   --submap_width <m>
+ *   --parameters <file>          pipeline parameters, same format as config/parameters.yaml (default: built-in defaults). With more than
+ *                                one worker thread, the stages of each worker run on that thread regardless of the `thread_pool` section.
+ *   --sweep <file>               parameter values to sweep, see config/batch_sweep.yaml
+ *   --threads <n>                number of worker threads (default: number of cores)
+ */
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+#include <grid_map_ros/GridMapRosConverter.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include <convex_plane_decomposition/GridMapPreprocessing.h>
+#include <convex_plane_decomposition/LoadGridmapFromImage.h>
+#include <convex_plane_decomposition/PlaneDecompositionPipeline.h>
+
+#include "convex_plane_decomposition_ros/BatchParameters.h"
+
+using namespace convex_plane_decomposition;
+
+namespace {
+
+/// A parameter configuration of the sweep, with the swept values as text for the CSV output.
+struct SweepConfig {
+  PlaneDecompositionPipeline::Config config;
+  std::vector<std::string> values;
+};
+
+/// Creates all combinations of the swept parameter values on top of the base configuration.
+std::vector<SweepConfig> createSweep(const PlaneDecompositionPipeline::Config& baseConfig, const std::string& sweepFile,
+                                     std::vector<std::string>& sweptParameterNames) {
+  std::vector<std::pair<std::string, YAML::Node>> sweepEntries;
+  if (!sweepFile.empty()) {
+    flattenYaml(YAML::LoadFile(sweepFile), "", sweepEntries);
+  }
+
+  std::vector<SweepConfig> sweep{{baseConfig, {}}};
+  for (const auto& entry : sweepEntries) {
+    sweptParameterNames.push_back(entry.first);
+    YAML::Node values;
+    if (entry.second.IsSequence()) {
+      values = entry.second;
+    } else {
+      values.push_back(entry.second);
+    }
+
+    std::vector<SweepConfig> extendedSweep;
+    extendedSweep.reserve(sweep.size() * values.size());
+    for (const auto& sweepConfig : sweep) {
+      for (const auto& value : values) {
+        SweepConfig extendedConfig = sweepConfig;
+        setParameter(extendedConfig.config, entry.first, value);
+        extendedConfig.values.push_back(value.as<std::string>());
+        extendedSweep.push_back(std::move(extendedConfig));
+      }
+    }
+    sweep = std::move(extendedSweep);
+  }
+  return sweep;
+}
+
+struct Frame {
+  int id;
+  std::string name;
+  grid_map::GridMap map;
+};
+
+/// Bounded queue between the reader and the worker threads. Limits the number of maps that are held in memory.
+class FrameQueue {
+ public:
+  explicit FrameQueue(size_t capacity) : capacity_(capacity) {}
+
+  /// Returns false, and drops the frame, if the queue is closed.
+  bool push(std::unique_ptr<Frame> frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this] { return queue_.size() < capacity_ || closed_; });
+    if (closed_) {
+      return false;
+    }
+    queue_.push(std::move(frame));
+    notEmpty_.notify_one();
+    return true;
+  }
+
+  /// Returns nullptr if the queue is closed and empty.
+  std::unique_ptr<Frame> pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this] { return !queue_.empty() || closed_; });
+    if (queue_.empty()) {
+      return nullptr;
+    }
+    auto frame = std::move(queue_.front());
+    queue_.pop();
+    notFull_.notify_one();
+    return frame;
+  }
+
+  /// The workers process the remaining frames, further frames are dropped.
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  bool closed_ = false;
+  std::queue<std::unique_ptr<Frame>> queue_;
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+};
+
+struct Options {
+  std::string output;
+  std::vector<std::string> bags;
+  std::string topic;
+  std::vector<std::string> imageFolders;
+  double imageResolution = 0.04;
+  double imageHeightScale = 1.0;
+  std::string elevationLayer = "elevation";
+  double submapLength = -1.0;
+  double submapWidth = -1.0;
+  std::string parameterFile;
+  std::string sweepFile;
+  int numberOfThreads = std::max(1U, std::thread::hardware_concurrency());
+};
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string key(argv[i]);
+    if (i + 1 >= argc) {
+      throw std::runtime_error("[BatchPlaneDecomposition] Missing value for option " + key);
+    }
+    const std::string value(argv[++i]);
+    if (key == "--output") {
+      options.output = value;
+    } else if (key == "--bag") {
+      options.bags.push_back(value);
+    } else if (key == "--topic") {
+      options.topic = value;
+    } else if (key == "--images") {
+      options.imageFolders.push_back(value);
+    } else if (key == "--image_resolution") {
+      options.imageResolution = std::stod(value);
+    } else if (key == "--image_height_scale") {
+      options.imageHeightScale = std::stod(value);
+    } else if (key == "--layer") {
+      options.elevationLayer = value;
+    } else if (key == "--submap_length") {
+      options.submapLength = std::stod(value);
+    } else if (key == "--submap_width") {
+      options.submapWidth = std::stod(value);
+    } else if (key == "--parameters") {
+      options.parameterFile = value;
+    } else if (key == "--sweep") {
+      options.sweepFile = value;
+    } else if (key == "--threads") {
+      options.numberOfThreads = std::max(1, std::stoi(value));
+    } else {
+      throw std::runtime_error("[BatchPlaneDecomposition] Unknown option " + key);
+    }
+  }
+  if (options.output.empty()) {
+    throw std::runtime_error("[BatchPlaneDecomposition] Option --output is required");
+  }
+  if (!options.bags.empty() && options.topic.empty()) {
+    throw std::runtime_error("[BatchPlaneDecomposition] Option --topic is required to read rosbags");
+  }
+  return options;
+}
+
+/// Same submap extraction as ConvexPlaneExtractionROS. Returns false if the submap could not be extracted.
+bool extractSubmap(const Options& options, grid_map::GridMap& map) {
+  if (options.submapLength <= 0.0 || options.submapWidth <= 0.0) {
+    return true;
+  }
+  grid_map::Index centerIndex;
+  grid_map::Position centerPosition;
+  map.getIndex(map.getPosition(), centerIndex);
+  map.getPosition(centerIndex, centerPosition);
+  bool success;
+  map = map.getSubmap(centerPosition, grid_map::Length(options.submapLength, options.submapWidth), success);
+  return success;
+}
+
+/// Reads all frames and pushes them into the queue, until the queue is closed. Runs on the main thread.
+void readFrames(const Options& options, FrameQueue& frameQueue) {
+  int frameId = 0;
+
+  for (const auto& folder : options.imageFolders) {
+    std::vector<cv::String> files;
+    cv::glob(folder + "/*.png", files, false);
+    for (const auto& file : files) {
+      std::unique_ptr<Frame> frame(new Frame{frameId++, file, grid_map::GridMap()});
+      frame->map = loadGridmapFromImage(file, options.elevationLayer, "odom", options.imageResolution, options.imageHeightScale);
+      if (extractSubmap(options, frame->map) && !frameQueue.push(std::move(frame))) {
+        return;
+      }
+    }
+  }
+
+  for (const auto& bagFile : options.bags) {
+    rosbag::Bag bag(bagFile, rosbag::bagmode::Read);
+    rosbag::View view(bag, rosbag::TopicQuery(options.topic));
+    for (const auto& messageInstance : view) {
+      const auto message = messageInstance.instantiate<grid_map_msgs::GridMap>();
+      if (message == nullptr) {
+        continue;
+      }
+      const std::string frameName = bagFile + "@" + std::to_string(messageInstance.getTime().toSec());
+      std::unique_ptr<Frame> frame(new Frame{frameId++, frameName, grid_map::GridMap()});
+      grid_map::GridMapRosConverter::fromMessage(*message, frame->map, {options.elevationLayer}, false, false);
+      if (frame->map.exists(options.elevationLayer) && extractSubmap(options, frame->map) && !frameQueue.push(std::move(frame))) {
+        return;
+      }
+    }
+  }
+  frameQueue.close();
+}
+
+/// Quotes a CSV field if it contains a separator, a quote or a line break.
+std::string toCsvField(const std::string& value) {
+  if (value.find_first_of(",\"\r\n") == std::string::npos) {
+    return value;
+  }
+  std::string quoted = "\"";
+  for (char character : value) {
+    if (character == '"') {
+      quoted += '"';
+    }
+    quoted += character;
+  }
+  return quoted + "\"";
+}
+
+/// Closes the queue and joins the workers when leaving the scope, also if reading the frames throws. Destroying a joinable std::thread
+/// terminates the process.
+class WorkerJoiner {
+ public:
+  WorkerJoiner(FrameQueue& frameQueue, std::vector<std::thread>& workers) : frameQueue_(frameQueue), workers_(workers) {}
+  ~WorkerJoiner() {
+    frameQueue_.close();
+    for (auto& worker : workers_) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+
+ private:
+  FrameQueue& frameQueue_;
+  std::vector<std::thread>& workers_;
+};
+
+struct FrameMetrics {
+  int numberOfRegions;
+  int numberOfVertices;
+  int numberOfLabels;
+  int numberOfRansacInvocations;
+  double coverage;
+  double preprocessMs;
+  double slidingWindowMs;
+  double contourExtractionMs;
+  double postprocessMs;
+};
+
+FrameMetrics runPipeline(PlaneDecompositionPipeline& pipeline, grid_map::GridMap map, const std::string& elevationLayer) {
+  pipeline.update(std::move(map), elevationLayer);
+
+  const auto& frameStatistics = pipeline.getFrameStatistics();
+  const auto& gridMap = pipeline.getPlanarTerrain().gridMap;
+  const auto& planeClassification = gridMap.get("plane_classification");
+
+  FrameMetrics metrics;
+  metrics.numberOfRegions = frameStatistics.numberOfRegions;
+  metrics.numberOfVertices = frameStatistics.numberOfVertices;
+  metrics.numberOfLabels = frameStatistics.numberOfLabels;
+  metrics.numberOfRansacInvocations = frameStatistics.numberOfRansacInvocations;
+  metrics.coverage = (planeClassification.size() > 0) ? planeClassification.mean() : 0.0;
+  metrics.preprocessMs = pipeline.getPrepocessTimer().getLastIntervalInMilliseconds();
+  metrics.slidingWindowMs = pipeline.getSlidingWindowTimer().getLastIntervalInMilliseconds();
+  metrics.contourExtractionMs = pipeline.getContourExtractionTimer().getLastIntervalInMilliseconds();
+  metrics.postprocessMs = pipeline.getPostprocessTimer().getLastIntervalInMilliseconds();
+  return metrics;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    const Options options = parseOptions(argc, argv);
+
+    // Base parameters and sweep
+    BatchParameters baseParameters;
+    if (!options.parameterFile.empty()) {
+      baseParameters = loadBatchParameters(YAML::LoadFile(options.parameterFile));
+    }
+    std::vector<std::string> sweptParameterNames;
+    const auto sweep = createSweep(baseParameters.config, options.sweepFile, sweptParameterNames);
+    std::cerr << "[BatchPlaneDecomposition] Evaluating " << sweep.size() << " configuration(s) with " << options.numberOfThreads
+              << " thread(s)." << std::endl;
+
+    // Output
+    std::ofstream csv(options.output);
+    if (!csv) {
+      throw std::runtime_error("[BatchPlaneDecomposition] Could not open " + options.output);
+    }
+    csv << "config_id";
+    for (const auto& name : sweptParameterNames) {
+      csv << "," << toCsvField(name);
+    }
+    csv << ",frame_id,frame_name,cells,regions,vertices,labels,ransac_invocations,coverage,"
+           "preprocess_ms,sliding_window_ms,contour_extraction_ms,postprocess_ms,total_ms\n";
+    csv << std::setprecision(6);
+    std::mutex csvMutex;
+
+    // Workers, each with its own pipeline per configuration. The frames are already processed in parallel, the stages run on the worker
+    // thread only instead of sharing the thread pool.
+    auto threadPoolSettings = baseParameters.threadPoolSettings;
+    if (options.numberOfThreads > 1) {
+      threadPoolSettings.numThreads = 1;
+    }
+    grid_map::parallel::ThreadPool::global().configure(threadPoolSettings);
+    FrameQueue frameQueue(2 * options.numberOfThreads);
+    std::atomic_int numberOfProcessedFrames{0};
+    std::exception_ptr workerException;
+    std::mutex workerExceptionMutex;
+    auto processFrames = [&]() {
+      std::vector<std::unique_ptr<PlaneDecompositionPipeline>> pipelines(sweep.size());
+      while (auto frame = frameQueue.pop()) {
+        if (!containsFiniteValue(frame->map.get(options.elevationLayer))) {
+          continue;
+        }
+        for (size_t configId = 0; configId < sweep.size(); ++configId) {
+          if (pipelines[configId] == nullptr) {
+            pipelines[configId].reset(new PlaneDecompositionPipeline(sweep[configId].config));
+          }
+          const auto metrics = runPipeline(*pipelines[configId], frame->map, options.elevationLayer);
+          const double totalMs = metrics.preprocessMs + metrics.slidingWindowMs + metrics.contourExtractionMs + metrics.postprocessMs;
+
+          std::lock_guard<std::mutex> lock(csvMutex);
+          csv << configId;
+          for (const auto& value : sweep[configId].values) {
+            csv << "," << toCsvField(value);
+          }
+          csv << "," << frame->id << "," << toCsvField(frame->name) << "," << frame->map.getSize().prod() << ","
+              << metrics.numberOfRegions << "," << metrics.numberOfVertices << "," << metrics.numberOfLabels << ","
+              << metrics.numberOfRansacInvocations << "," << metrics.coverage << "," << metrics.preprocessMs << ","
+              << metrics.slidingWindowMs << "," << metrics.contourExtractionMs << "," << metrics.postprocessMs << "," << totalMs << "\n";
+        }
+        ++numberOfProcessedFrames;
+      }
+    };
+    // The first exception of a worker stops reading and is rethrown after all workers are joined.
+    auto worker = [&]() {
+      try {
+        processFrames();
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(workerExceptionMutex);
+          if (!workerException) {
+            workerException = std::current_exception();
+          }
+        }
+        frameQueue.close();
+      }
+    };
+
+    std::vector<std::thread> workers;
+    {
+      WorkerJoiner workerJoiner(frameQueue, workers);
+      for (int i = 0; i < options.numberOfThreads; ++i) {
+        workers.emplace_back(worker);
+      }
+      readFrames(options, frameQueue);
+    }
+    if (workerException) {
+      std::rethrow_exception(workerException);
+    }
+
+    std::cerr << "[BatchPlaneDecomposition] Processed " << numberOfProcessedFrames << " frame(s), results written to " << options.output
+              << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
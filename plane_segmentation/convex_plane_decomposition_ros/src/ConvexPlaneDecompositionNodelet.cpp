@@ -0,0 +1,42 @@
+#include "convex_plane_decomposition_ros/ConvexPlaneDecompositionRos.h"
+
+#include <memory>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/callback_queue.h>
+
+namespace convex_plane_decomposition {
+
+/**
+ * Runs ConvexPlaneExtractionROS in a nodelet manager, such that the elevation map of a mapping nodelet in the same manager is received
+ * without serialization. The callbacks of the extraction are served from their own queue at `frequency`, which reproduces the
+ * spinOnce + rate loop of the standalone node.
+ */
+class ConvexPlaneDecompositionNodelet : public nodelet::Nodelet {
+ private:
+  void onInit() override {
+    ros::NodeHandle& nodeHandle = getPrivateNodeHandle();
+
+    double frequency;
+    if (!nodeHandle.getParam("frequency", frequency) || frequency <= 0.0) {
+      NODELET_ERROR("[ConvexPlaneDecompositionNodelet] Could not read a positive parameter `frequency`.");
+      return;
+    }
+
+    ros::NodeHandle queueNodeHandle(nodeHandle);
+    queueNodeHandle.setCallbackQueue(&callbackQueue_);
+    convexPlaneExtractionRos_ = std::make_unique<ConvexPlaneExtractionROS>(queueNodeHandle);
+
+    spinTimer_ = nodeHandle.createTimer(ros::Duration(1.0 / frequency), [this](const ros::TimerEvent&) { callbackQueue_.callAvailable(); });
+  }
+
+  // Destroyed in reverse order: the timer stops before the extraction and its queue go away.
+  ros::CallbackQueue callbackQueue_;
+  std::unique_ptr<ConvexPlaneExtractionROS> convexPlaneExtractionRos_;
+  ros::Timer spinTimer_;
+};
+
+}  // namespace convex_plane_decomposition
+
+PLUGINLIB_EXPORT_CLASS(convex_plane_decomposition::ConvexPlaneDecompositionNodelet, nodelet::Nodelet)
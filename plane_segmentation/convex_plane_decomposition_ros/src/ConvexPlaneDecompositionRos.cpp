@@ -1,11 +1,15 @@
 #include "convex_plane_decomposition_ros/ConvexPlaneDecompositionRos.h"
 
+#include <boost/make_shared.hpp>
+
 #include <grid_map_core/GridMap.hpp>
 #include <grid_map_cv/GridMapCvProcessing.hpp>
 #include <grid_map_ros/GridMapRosConverter.hpp>
 
 #include <convex_plane_decomposition/PlaneDecompositionPipeline.h>
+#include <convex_plane_decomposition_msgs/PipelineStatistics.h>
 #include <convex_plane_decomposition_msgs/PlanarTerrain.h>
+#include <grid_map_filters_rsl/ThreadPool.hpp>
 
 #include "convex_plane_decomposition_ros/MessageConversion.h"
 #include "convex_plane_decomposition_ros/ParameterLoading.h"
@@ -22,6 +26,17 @@ ConvexPlaneExtractionROS::ConvexPlaneExtractionROS(ros::NodeHandle& nodeHandle)
     boundaryPublisher_ = nodeHandle.advertise<visualization_msgs::MarkerArray>("boundaries", 1);
     insetPublisher_ = nodeHandle.advertise<visualization_msgs::MarkerArray>("insets", 1);
     regionPublisher_ = nodeHandle.advertise<convex_plane_decomposition_msgs::PlanarTerrain>("planar_terrain", 1);
+    if (statisticsPublishFrequency_ > 0.0) {
+      statisticsPublisher_ = nodeHandle.advertise<convex_plane_decomposition_msgs::PipelineStatistics>("statistics", 1);
+      statisticsTimer_ = nodeHandle.createTimer(ros::Duration(1.0 / statisticsPublishFrequency_),
+                                                &ConvexPlaneExtractionROS::publishStatistics, this);
+    }
+    if (memoryUsagePublishFrequency_ > 0.0) {
+      memoryUsagePublisher_ = nodeHandle.advertise<convex_plane_decomposition_msgs::MemoryUsage>("memory_usage", 1);
+      memoryUsageTimer_ = nodeHandle.createTimer(ros::Duration(1.0 / memoryUsagePublishFrequency_),
+                                                 &ConvexPlaneExtractionROS::publishMemoryUsage, this);
+    }
+    memoryUsageService_ = nodeHandle.advertiseService("get_memory_usage", &ConvexPlaneExtractionROS::getMemoryUsage, this);
   }
 }
 
@@ -30,12 +45,14 @@ ConvexPlaneExtractionROS::~ConvexPlaneExtractionROS() {
     std::stringstream infoStream;
     infoStream << "\n########################################################################\n";
     infoStream << "The benchmarking is computed over " << callbackTimer_.getNumTimedIntervals() << " iterations. \n";
-    infoStream << "PlaneExtraction Benchmarking    : Average time [ms], Max time [ms]\n";
+    infoStream << "PlaneExtraction Benchmarking    : Average time [ms], Max time [ms], p50 [ms], p99 [ms], p99.9 [ms]\n";
     auto printLine = [](std::string name, const Timer& timer) {
       std::stringstream ss;
       ss << std::fixed << std::setprecision(2);
       ss << "\t" << name << "\t: " << std::setw(17) << timer.getAverageInMilliseconds() << ", " << std::setw(13)
-         << timer.getMaxIntervalInMilliseconds() << "\n";
+         << timer.getMaxIntervalInMilliseconds() << ", " << std::setw(8) << timer.getPercentileInMilliseconds(50.0) << ", "
+         << std::setw(8) << timer.getPercentileInMilliseconds(99.0) << ", " << std::setw(10) << timer.getPercentileInMilliseconds(99.9)
+         << "\n";
       return ss.str();
     };
     infoStream << printLine("Pre-process        ", planeDecompositionPipeline_->getPrepocessTimer());
@@ -43,6 +60,7 @@ ConvexPlaneExtractionROS::~ConvexPlaneExtractionROS() {
     infoStream << printLine("Contour extraction ", planeDecompositionPipeline_->getContourExtractionTimer());
     infoStream << printLine("Post-process       ", planeDecompositionPipeline_->getPostprocessTimer());
     infoStream << printLine("Total callback     ", callbackTimer_);
+    infoStream << printLine("Input to output    ", inputToOutputTimer_);
     std::cerr << infoStream.str() << std::endl;
   }
 }
@@ -72,6 +90,12 @@ bool ConvexPlaneExtractionROS::loadParameters(const ros::NodeHandle& nodeHandle)
     ROS_ERROR("[ConvexPlaneExtractionROS] Could not read parameter `publish_to_controller`.");
     return false;
   }
+  nodeHandle.param("statistics_publish_frequency", statisticsPublishFrequency_, 1.0);
+  nodeHandle.param("memory_usage_publish_frequency", memoryUsagePublishFrequency_, 1.0);
+  double memoryBudgetMb;
+  nodeHandle.param("memory_budget_mb", memoryBudgetMb, 0.0);
+  memoryBudgetBytes_ = static_cast<size_t>(std::max(memoryBudgetMb, 0.0) * 1024.0 * 1024.0);
+  nodeHandle.param("memory_budget_refuse_layers", memoryBudgetRefuseLayers_, false);
 
   PlaneDecompositionPipeline::Config config;
   config.preprocessingParameters = loadPreprocessingParameters(nodeHandle, "preprocessing/");
@@ -80,18 +104,25 @@ bool ConvexPlaneExtractionROS::loadParameters(const ros::NodeHandle& nodeHandle)
   config.slidingWindowPlaneExtractorParameters = loadSlidingWindowPlaneExtractorParameters(nodeHandle, "sliding_window_plane_extractor/");
   config.postprocessingParameters = loadPostprocessingParameters(nodeHandle, "postprocessing/");
 
+  try {
+    grid_map::parallel::ThreadPool::global().configure(loadThreadPoolSettings(nodeHandle, "thread_pool/"));
+  } catch (const std::exception& e) {
+    ROS_ERROR_STREAM("[ConvexPlaneExtractionROS] Could not configure the thread pool: " << e.what());
+    return false;
+  }
+
   planeDecompositionPipeline_ = std::make_unique<PlaneDecompositionPipeline>(config);
 
   return true;
 }
 
-void ConvexPlaneExtractionROS::callback(const grid_map_msgs::GridMap& message) {
+void ConvexPlaneExtractionROS::callback(const grid_map_msgs::GridMapConstPtr& message) {
   callbackTimer_.startTimer();
 
   // Convert message to map.
   grid_map::GridMap messageMap;
   std::vector<std::string> layers{elevationLayer_};
-  grid_map::GridMapRosConverter::fromMessage(message, messageMap, layers, false, false);
+  grid_map::GridMapRosConverter::fromMessage(*message, messageMap, layers, false, false);
   if (!containsFiniteValue(messageMap.get(elevationLayer_))) {
     ROS_WARN("[ConvexPlaneExtractionROS] map does not contain any values");
     callbackTimer_.endTimer();
@@ -135,22 +166,32 @@ void ConvexPlaneExtractionROS::callback(const grid_map_msgs::GridMap& message) {
   planeDecompositionPipeline_->update(std::move(elevationMap), elevationLayer_);
   auto& planarTerrain = planeDecompositionPipeline_->getPlanarTerrain();
 
-  // Publish terrain
+  // Publish terrain. Messages are published by shared pointer, subscribers in the same nodelet manager receive them without a copy.
+  size_t outputMessageBytes = 0;
   if (publishToController_) {
-    regionPublisher_.publish(toMessage(planarTerrain));
+    const auto planarTerrainMessage = boost::make_shared<convex_plane_decomposition_msgs::PlanarTerrain>(toMessage(planarTerrain));
+    outputMessageBytes += ros::serialization::serializationLength(*planarTerrainMessage);
+    regionPublisher_.publish(planarTerrainMessage);
   }
 
   // --- Visualize in Rviz --- Not published to the controller
+  const size_t layerBytes = elevationRaw.size() * sizeof(float);
   // Add raw map
-  planarTerrain.gridMap.add("elevation_raw", elevationRaw);
+  if (checkMemoryBudget("elevation_raw", layerBytes)) {
+    planarTerrain.gridMap.add("elevation_raw", elevationRaw);
+  }
 
   // Add segmentation
-  planarTerrain.gridMap.add("segmentation");
-  planeDecompositionPipeline_->getSegmentation(planarTerrain.gridMap.get("segmentation"));
+  if (checkMemoryBudget("segmentation", layerBytes)) {
+    planarTerrain.gridMap.add("segmentation");
+    planeDecompositionPipeline_->getSegmentation(planarTerrain.gridMap.get("segmentation"));
+  }
 
-  grid_map_msgs::GridMap outputMessage;
-  grid_map::GridMapRosConverter::toMessage(planarTerrain.gridMap, outputMessage);
+  const auto outputMessage = boost::make_shared<grid_map_msgs::GridMap>();
+  grid_map::GridMapRosConverter::toMessage(planarTerrain.gridMap, *outputMessage);
+  outputMessageBytes += ros::serialization::serializationLength(*outputMessage);
   filteredmapPublisher_.publish(outputMessage);
+  outputMessageBytes_ = outputMessageBytes;
 
   const double lineWidth = 0.005;  // [m] RViz marker size
   boundaryPublisher_.publish(convertBoundariesToRosMarkers(planarTerrain.planarRegions, planarTerrain.gridMap.getFrameId(),
@@ -158,9 +199,120 @@ void ConvexPlaneExtractionROS::callback(const grid_map_msgs::GridMap& message) {
   insetPublisher_.publish(convertInsetsToRosMarkers(planarTerrain.planarRegions, planarTerrain.gridMap.getFrameId(),
                                                     planarTerrain.gridMap.getTimestamp(), lineWidth));
 
+  // Latency from the stamp of the input map to the publication of all outputs.
+  if (!message->info.header.stamp.isZero()) {
+    inputToOutputTimer_.addInterval(std::chrono::nanoseconds((ros::Time::now() - message->info.header.stamp).toNSec()));
+  }
+
   callbackTimer_.endTimer();
 }
 
+void ConvexPlaneExtractionROS::publishStatistics(const ros::TimerEvent& event) {
+  if (planeDecompositionPipeline_ == nullptr || callbackTimer_.getNumTimedIntervals() == 0) {
+    return;
+  }
+
+  auto toStageMessage = [](const std::string& name, const Timer& timer) {
+    convex_plane_decomposition_msgs::StageStatistics stageMsg;
+    stageMsg.name = name;
+    stageMsg.number_of_samples = timer.getNumTimedIntervals();
+    if (timer.getNumTimedIntervals() > 0) {
+      stageMsg.last_ms = timer.getLastIntervalInMilliseconds();
+      stageMsg.average_ms = timer.getAverageInMilliseconds();
+      stageMsg.max_ms = timer.getMaxIntervalInMilliseconds();
+      stageMsg.p50_ms = timer.getPercentileInMilliseconds(50.0);
+      stageMsg.p90_ms = timer.getPercentileInMilliseconds(90.0);
+      stageMsg.p99_ms = timer.getPercentileInMilliseconds(99.0);
+      stageMsg.p999_ms = timer.getPercentileInMilliseconds(99.9);
+    }
+    return stageMsg;
+  };
+
+  convex_plane_decomposition_msgs::PipelineStatistics statisticsMsg;
+  statisticsMsg.header.stamp = event.current_real;
+  statisticsMsg.stages.push_back(toStageMessage("preprocess", planeDecompositionPipeline_->getPrepocessTimer()));
+  statisticsMsg.stages.push_back(toStageMessage("sliding_window", planeDecompositionPipeline_->getSlidingWindowTimer()));
+  statisticsMsg.stages.push_back(toStageMessage("contour_extraction", planeDecompositionPipeline_->getContourExtractionTimer()));
+  statisticsMsg.stages.push_back(toStageMessage("postprocess", planeDecompositionPipeline_->getPostprocessTimer()));
+  statisticsMsg.stages.push_back(toStageMessage("callback", callbackTimer_));
+  statisticsMsg.stages.push_back(toStageMessage("input_to_output", inputToOutputTimer_));
+
+  const auto& frameStatistics = planeDecompositionPipeline_->getFrameStatistics();
+  statisticsMsg.number_of_labels = frameStatistics.numberOfLabels;
+  statisticsMsg.number_of_regions = frameStatistics.numberOfRegions;
+  statisticsMsg.number_of_vertices = frameStatistics.numberOfVertices;
+  statisticsMsg.number_of_ransac_invocations = frameStatistics.numberOfRansacInvocations;
+
+  auto& threadPool = grid_map::parallel::ThreadPool::global();
+  const auto threadPoolStatistics = threadPool.statistics();
+  threadPool.resetStatistics();
+  statisticsMsg.thread_pool_size = threadPoolStatistics.numThreads;
+  statisticsMsg.thread_pool_utilization = threadPoolStatistics.utilization;
+  statisticsMsg.thread_pool_loops = threadPoolStatistics.numLoops;
+  statisticsMsg.thread_pool_chunks = threadPoolStatistics.numChunks;
+  statisticsMsg.thread_pool_stolen_chunks = threadPoolStatistics.numStolenChunks;
+
+  statisticsPublisher_.publish(statisticsMsg);
+}
+
+void ConvexPlaneExtractionROS::publishMemoryUsage(const ros::TimerEvent& event) {
+  if (planeDecompositionPipeline_ == nullptr) {
+    return;
+  }
+  auto memoryUsageMsg = collectMemoryUsage();
+  memoryUsageMsg.header.stamp = event.current_real;
+  if (memoryBudgetBytes_ > 0 && memoryUsageMsg.total_bytes > memoryBudgetBytes_) {
+    ROS_WARN_STREAM_THROTTLE(10.0, "[ConvexPlaneExtractionROS] Memory usage exceeds the budget (" << memoryUsageMsg.total_bytes << " > "
+                                                                                                   << memoryBudgetBytes_ << " bytes).");
+  }
+  memoryUsagePublisher_.publish(memoryUsageMsg);
+}
+
+bool ConvexPlaneExtractionROS::getMemoryUsage(convex_plane_decomposition_msgs::GetMemoryUsage::Request& request,
+                                              convex_plane_decomposition_msgs::GetMemoryUsage::Response& response) {
+  if (planeDecompositionPipeline_ == nullptr) {
+    return false;
+  }
+  response.usage = collectMemoryUsage();
+  response.usage.header.stamp = ros::Time::now();
+  return true;
+}
+
+convex_plane_decomposition_msgs::MemoryUsage ConvexPlaneExtractionROS::collectMemoryUsage() const {
+  convex_plane_decomposition_msgs::MemoryUsage memoryUsageMsg;
+  auto addComponent = [&memoryUsageMsg](const std::string& name, size_t bytes) {
+    convex_plane_decomposition_msgs::MemoryComponent component;
+    component.name = name;
+    component.bytes = bytes;
+    memoryUsageMsg.components.push_back(component);
+    memoryUsageMsg.total_bytes += bytes;
+  };
+
+  const auto pipelineMemoryUsage = planeDecompositionPipeline_->getMemoryUsage();
+  addComponent("map_layers", pipelineMemoryUsage.mapLayerBytes);
+  addComponent("sliding_window", pipelineMemoryUsage.slidingWindowBytes);
+  addComponent("planar_regions", pipelineMemoryUsage.planarRegionBytes);
+  addComponent("output_messages", outputMessageBytes_);
+  memoryUsageMsg.budget_bytes = memoryBudgetBytes_;
+  return memoryUsageMsg;
+}
+
+bool ConvexPlaneExtractionROS::checkMemoryBudget(const std::string& layer, size_t layerBytes) const {
+  if (memoryBudgetBytes_ == 0) {
+    return true;
+  }
+  const size_t usedBytes = collectMemoryUsage().total_bytes;
+  if (usedBytes + layerBytes <= memoryBudgetBytes_) {
+    return true;
+  }
+  if (memoryBudgetRefuseLayers_) {
+    ROS_WARN_STREAM_THROTTLE(10.0, "[ConvexPlaneExtractionROS] Layer " << layer << " is not added, it would exceed the memory budget.");
+    return false;
+  }
+  ROS_WARN_STREAM_THROTTLE(10.0, "[ConvexPlaneExtractionROS] Layer " << layer << " exceeds the memory budget.");
+  return true;
+}
+
 Eigen::Isometry3d ConvexPlaneExtractionROS::getTransformToTargetFrame(const std::string& sourceFrame, const ros::Time& time) {
   geometry_msgs::TransformStamped transformStamped;
   try {
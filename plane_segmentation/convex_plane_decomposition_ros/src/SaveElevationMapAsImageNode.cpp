@@ -2,6 +2,15 @@
 // Created by rgrandia on 11.06.20.
 //
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
 #include <ros/ros.h>
 
 #include <grid_map_core/GridMap.hpp>
@@ -10,40 +19,218 @@
 
 #include <opencv2/imgcodecs.hpp>
 
-int count = 0;
-double frequency;
-std::string elevationMapTopic;
-std::string elevationLayer;
-std::string imageName;
-
-void callback(const grid_map_msgs::GridMap::ConstPtr& message) {
-  grid_map::GridMap messageMap;
-  grid_map::GridMapRosConverter::fromMessage(*message, messageMap);
-
-  const auto& data = messageMap[elevationLayer];
-  float maxHeight = std::numeric_limits<float>::lowest();
-  float minHeight = std::numeric_limits<float>::max();
-  for (int i = 0; i < data.rows(); i++) {
-    for (int j = 0; j < data.cols(); j++) {
-      const auto value = data(i, j);
-      if (!std::isnan(value)) {
-        maxHeight = std::max(maxHeight, value);
-        minHeight = std::min(minHeight, value);
+namespace {
+
+/**
+ * Records elevation maps to disk in the background. The subscriber callback only queues the message, conversion and writing is done by a
+ * pool of writer threads. When the writers can not keep up, new maps are dropped and counted instead of blocking the callback.
+ *
+ * For every recorded map <imageName>_<count>.yaml describes the map geometry and pose, and lists per layer:
+ *   - png8 / png16 : <imageName>_<count>_<layer>.png with the range [offset, offset + scale] mapped to the full integer range, and
+ *                    <imageName>_<count>_<layer>_mask.png which is zero for NaN cells.
+ *   - tiff         : <imageName>_<count>_<layer>.tiff with the heights as 32-bit float, NaN cells are NaN.
+ * These files can be read back with convex_plane_decomposition::loadGridmapFromImage.
+ */
+class ElevationMapRecorder {
+ public:
+  ElevationMapRecorder(std::string imageName, std::vector<std::string> layers, std::string format, double frequency, size_t queueSize,
+                       int numberOfWriters)
+      : imageName_(std::move(imageName)),
+        layers_(std::move(layers)),
+        format_(std::move(format)),
+        minimumPeriod_((frequency > 0.0) ? 1.0 / frequency : 0.0),
+        queueSize_(queueSize) {
+    for (int i = 0; i < numberOfWriters; ++i) {
+      writers_.emplace_back([this]() { writerLoop(); });
+    }
+  }
+
+  ~ElevationMapRecorder() { stop(); }
+
+  /** Finishes writing the queued maps and stops the writer threads. */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(queueMutex_);
+      stopRequested_ = true;
+    }
+    queueNotEmpty_.notify_all();
+    for (auto& writer : writers_) {
+      if (writer.joinable()) {
+        writer.join();
       }
     }
   }
 
-  cv::Mat image;
-  grid_map::GridMapCvConverter::toImage<unsigned char, 1>(messageMap, elevationLayer, CV_8UC1, minHeight, maxHeight, image);
+  void callback(const grid_map_msgs::GridMap::ConstPtr& message) {
+    ++numberOfReceived_;
 
-  int range = 100 * (maxHeight - minHeight);
-  cv::imwrite(imageName + "_" + std::to_string(count++) + "_" + std::to_string(range) + "cm.png", image);
-}
+    // Rate limit on the message stamps, such that recording from a bag gives the same result as recording online.
+    const auto stamp = message->info.header.stamp;
+    if (!lastRecordedStamp_.isZero() && stamp >= lastRecordedStamp_ && (stamp - lastRecordedStamp_).toSec() < minimumPeriod_) {
+      ++numberOfSkipped_;
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(queueMutex_);
+      if (queue_.size() >= queueSize_) {
+        ++numberOfDropped_;
+        ROS_WARN_THROTTLE(5.0, "[SaveElevationMapAsImage] Writers can not keep up, dropped %d map(s) so far.", numberOfDropped_.load());
+        return;
+      }
+      queue_.push_back({count_++, message});
+    }
+    lastRecordedStamp_ = stamp;
+    queueNotEmpty_.notify_one();
+  }
+
+  void printSummary() const {
+    ROS_INFO("[SaveElevationMapAsImage] Received %d, skipped by rate %d, dropped %d, written %d, failed %d map(s).",
+             numberOfReceived_.load(), numberOfSkipped_.load(), numberOfDropped_.load(), numberOfWritten_.load(), numberOfFailed_.load());
+  }
+
+ private:
+  struct QueuedMap {
+    int count;
+    grid_map_msgs::GridMap::ConstPtr message;
+  };
+
+  void writerLoop() {
+    while (true) {
+      QueuedMap queuedMap;
+      {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        queueNotEmpty_.wait(lock, [this] { return !queue_.empty() || stopRequested_; });
+        if (queue_.empty()) {
+          return;
+        }
+        queuedMap = std::move(queue_.front());
+        queue_.pop_front();
+      }
+
+      try {
+        write(queuedMap);
+        ++numberOfWritten_;
+      } catch (const std::exception& e) {
+        ++numberOfFailed_;
+        ROS_ERROR("[SaveElevationMapAsImage] Failed to write map %d: %s", queuedMap.count, e.what());
+      }
+    }
+  }
+
+  void write(const QueuedMap& queuedMap) const {
+    grid_map::GridMap map;
+    // Fails if a layer is missing or the message is malformed, such that no partial map is written.
+    if (!grid_map::GridMapRosConverter::fromMessage(*queuedMap.message, map, layers_, false, false)) {
+      throw std::runtime_error("could not convert the message, check that it contains all requested layers.");
+    }
+    // Images are written in the storage order of the default start index.
+    map.convertToDefaultStartIndex();
+
+    const std::string baseName = imageName_ + "_" + std::to_string(queuedMap.count);
+    const auto& info = queuedMap.message->info;
+
+    std::ofstream metadata(baseName + ".yaml");
+    metadata << std::setprecision(9);
+    metadata << "stamp: " << info.header.stamp.toSec() << "\n";
+    metadata << "frame_id: " << info.header.frame_id << "\n";
+    metadata << "resolution: " << map.getResolution() << "\n";
+    metadata << "size: [" << map.getSize()(0) << ", " << map.getSize()(1) << "]\n";
+    metadata << "position: [" << map.getPosition().x() << ", " << map.getPosition().y() << "]\n";
+    metadata << "pose:\n";
+    metadata << "  position: [" << info.pose.position.x << ", " << info.pose.position.y << ", " << info.pose.position.z << "]\n";
+    metadata << "  orientation: [" << info.pose.orientation.x << ", " << info.pose.orientation.y << ", " << info.pose.orientation.z << ", "
+             << info.pose.orientation.w << "]\n";
+    metadata << "format: " << format_ << "\n";
+    metadata << "layers:\n";
+
+    for (const auto& layer : layers_) {
+      const auto& data = map.get(layer);
+      const std::string layerName = baseName + "_" + layer;
+
+      if (format_ == "tiff") {
+        cv::Mat image(data.rows(), data.cols(), CV_32FC1);
+        for (int i = 0; i < data.rows(); i++) {
+          for (int j = 0; j < data.cols(); j++) {
+            image.at<float>(i, j) = data(i, j);
+          }
+        }
+        cv::imwrite(layerName + ".tiff", image);
+        metadata << "  " << layer << ": {file: " << layerName << ".tiff, offset: 0.0, scale: 1.0}\n";
+        continue;
+      }
+
+      // Integer images: map the finite range to the full integer range, NaN cells are stored in a separate mask.
+      float maxHeight = std::numeric_limits<float>::lowest();
+      float minHeight = std::numeric_limits<float>::max();
+      cv::Mat mask(data.rows(), data.cols(), CV_8UC1);
+      for (int i = 0; i < data.rows(); i++) {
+        for (int j = 0; j < data.cols(); j++) {
+          const auto value = data(i, j);
+          const bool isFinite = std::isfinite(value);
+          if (isFinite) {
+            maxHeight = std::max(maxHeight, value);
+            minHeight = std::min(minHeight, value);
+          }
+          mask.at<unsigned char>(i, j) = isFinite ? 255 : 0;
+        }
+      }
+      if (minHeight > maxHeight) {  // No finite values
+        minHeight = maxHeight = 0.0;
+      }
+      if (maxHeight - minHeight == 0.0F) {  // Flat layer: toImage divides by the range, all cells map to zero, i.e. to the offset.
+        maxHeight = minHeight + 1.0F;
+      }
+
+      cv::Mat image;
+      if (format_ == "png16") {
+        grid_map::GridMapCvConverter::toImage<unsigned short, 1>(map, layer, CV_16UC1, minHeight, maxHeight, image);
+      } else {
+        grid_map::GridMapCvConverter::toImage<unsigned char, 1>(map, layer, CV_8UC1, minHeight, maxHeight, image);
+      }
+      cv::imwrite(layerName + ".png", image);
+      cv::imwrite(layerName + "_mask.png", mask);
+      metadata << "  " << layer << ": {file: " << layerName << ".png, mask: " << layerName << "_mask.png, offset: " << minHeight
+               << ", scale: " << maxHeight - minHeight << "}\n";
+    }
+  }
+
+  // Settings
+  const std::string imageName_;
+  const std::vector<std::string> layers_;
+  const std::string format_;
+  const double minimumPeriod_;
+  const size_t queueSize_;
+
+  // Only accessed from the subscriber callback
+  ros::Time lastRecordedStamp_;
+  int count_ = 0;
+
+  // Queue
+  std::mutex queueMutex_;
+  std::condition_variable queueNotEmpty_;
+  std::deque<QueuedMap> queue_;
+  bool stopRequested_ = false;
+  std::vector<std::thread> writers_;
+
+  // Counters
+  std::atomic_int numberOfReceived_{0};
+  std::atomic_int numberOfSkipped_{0};
+  std::atomic_int numberOfDropped_{0};
+  std::atomic_int numberOfWritten_{0};
+  std::atomic_int numberOfFailed_{0};
+};
+
+}  // namespace
 
 int main(int argc, char** argv) {
   ros::init(argc, argv, "save_elevation_map_to_image");
   ros::NodeHandle nodeHandle("~");
 
+  double frequency;
+  std::string elevationMapTopic;
+  std::string elevationLayer;
+  std::string imageName;
   if (!nodeHandle.getParam("frequency", frequency)) {
     ROS_ERROR("[ConvexPlaneExtractionROS] Could not read parameter `frequency`.");
     return 1;
@@ -61,13 +248,25 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  auto elevationMapSubscriber_ = nodeHandle.subscribe<grid_map_msgs::GridMap>(elevationMapTopic, 1, callback);
-
-  ros::Rate rate(frequency);
-  while (ros::ok()) {
-    ros::spinOnce();
-    rate.sleep();
+  // Optional recorder settings
+  std::vector<std::string> layers{elevationLayer};
+  nodeHandle.param("layers", layers, layers);
+  std::string format = nodeHandle.param<std::string>("format", "png16");
+  if (format != "png8" && format != "png16" && format != "tiff") {
+    ROS_ERROR("[ConvexPlaneExtractionROS] Parameter `format` must be png8, png16 or tiff, got `%s`.", format.c_str());
+    return 1;
   }
+  const int queueSize = std::max(1, nodeHandle.param("queue_size", 10));
+  const int numberOfWriters = std::max(1, nodeHandle.param("writer_threads", 2));
+
+  ElevationMapRecorder recorder(imageName, layers, format, frequency, queueSize, numberOfWriters);
+  auto elevationMapSubscriber_ =
+      nodeHandle.subscribe<grid_map_msgs::GridMap>(elevationMapTopic, queueSize, &ElevationMapRecorder::callback, &recorder);
+  ros::Timer summaryTimer = nodeHandle.createTimer(ros::Duration(10.0), [&](const ros::TimerEvent&) { recorder.printSummary(); });
 
+  ros::spin();
+
+  recorder.stop();
+  recorder.printSummary();
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,218 @@
+/*
+ * Load generator for the plane decomposition node: publishes procedurally generated elevation maps at a fixed rate and measures the
+ * latency until the corresponding planar terrain is received.
+ */
+
+#include <deque>
+#include <mutex>
+#include <random>
+
+#include <ros/ros.h>
+
+#include <grid_map_core/GridMap.hpp>
+#include <grid_map_ros/GridMapRosConverter.hpp>
+
+#include <convex_plane_decomposition/SyntheticTerrain.h>
+#include <convex_plane_decomposition/Timer.h>
+
+#include <convex_plane_decomposition_msgs/PlanarTerrain.h>
+
+using namespace convex_plane_decomposition;
+
+namespace {
+
+struct SyntheticMapSettings {
+  SyntheticTerrainType terrainType;
+  double length;
+  double resolution;
+  int numberOfLayers;
+  Eigen::Vector2d velocity;
+  int numberOfHoles;
+  double holeRadius;
+  int seed;
+  std::string elevationLayer;
+  std::string frameId;
+};
+
+/**
+ * Keeps track of the stamps of the published maps and matches them with the stamps of the received planar terrains. Maps for which no
+ * terrain was received, while a terrain of a later map was, are counted as lost.
+ */
+class LatencyTracker {
+ public:
+  void addSent(const ros::Time& stamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingStamps_.push_back(stamp);
+    while (pendingStamps_.size() > maxPendingStamps) {
+      pendingStamps_.pop_front();
+      ++numberOfLost_;
+    }
+  }
+
+  void addReceived(const ros::Time& stamp, const ros::Time& receiveTime) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!pendingStamps_.empty() && pendingStamps_.front() < stamp) {
+      pendingStamps_.pop_front();
+      ++numberOfLost_;
+    }
+    if (pendingStamps_.empty() || pendingStamps_.front() != stamp) {
+      ++numberOfUnmatched_;
+      return;
+    }
+    pendingStamps_.pop_front();
+    latencyTimer_.addInterval(std::chrono::nanoseconds((receiveTime - stamp).toNSec()));
+  }
+
+  void printAndReset(double elapsedTime, int numberOfPublished, double requestedFrequency, const Timer& generationTimer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ROS_INFO_STREAM("[SyntheticElevationMap] Published " << numberOfPublished << " maps at " << numberOfPublished / elapsedTime
+                                                         << " Hz (requested " << requestedFrequency << " Hz), generation average "
+                                                         << generationTimer.getAverageInMilliseconds() << " [ms]\n"
+                                                         << "\tplanar_terrain received: " << latencyTimer_.getNumTimedIntervals()
+                                                         << ", lost: " << numberOfLost_ << ", unmatched: " << numberOfUnmatched_ << "\n"
+                                                         << "\tlatency [ms] average: " << latencyTimer_.getAverageInMilliseconds()
+                                                         << ", p50: " << latencyTimer_.getPercentileInMilliseconds(50.0)
+                                                         << ", p99: " << latencyTimer_.getPercentileInMilliseconds(99.0)
+                                                         << ", max: " << latencyTimer_.getMaxIntervalInMilliseconds());
+    latencyTimer_.reset();
+    numberOfLost_ = 0;
+    numberOfUnmatched_ = 0;
+  }
+
+ private:
+  static constexpr size_t maxPendingStamps = 1000;
+
+  std::mutex mutex_;
+  std::deque<ros::Time> pendingStamps_;
+  Timer latencyTimer_;
+  int numberOfLost_ = 0;
+  int numberOfUnmatched_ = 0;
+};
+
+/** Cuts circular NaN holes at random locations into all layers. */
+void addHoles(grid_map::GridMap& map, int numberOfHoles, double holeRadius, std::mt19937& generator) {
+  const int radiusInCells = static_cast<int>(std::ceil(holeRadius / map.getResolution()));
+  const int rows = map.getSize()(0);
+  const int cols = map.getSize()(1);
+  std::uniform_int_distribution<int> rowDistribution(0, rows - 1);
+  std::uniform_int_distribution<int> colDistribution(0, cols - 1);
+
+  for (int hole = 0; hole < numberOfHoles; ++hole) {
+    const int centerRow = rowDistribution(generator);
+    const int centerCol = colDistribution(generator);
+    for (const auto& layer : map.getLayers()) {
+      auto& data = map.get(layer);
+      for (int col = std::max(0, centerCol - radiusInCells); col <= std::min(cols - 1, centerCol + radiusInCells); ++col) {
+        for (int row = std::max(0, centerRow - radiusInCells); row <= std::min(rows - 1, centerRow + radiusInCells); ++row) {
+          const int dRow = row - centerRow;
+          const int dCol = col - centerCol;
+          if (dRow * dRow + dCol * dCol <= radiusInCells * radiusInCells) {
+            data(row, col) = NAN;
+          }
+        }
+      }
+    }
+  }
+}
+
+grid_map::GridMap createMap(const SyntheticMapSettings& settings, const grid_map::Position& position) {
+  auto map = createSyntheticTerrain(settings.terrainType, settings.elevationLayer, settings.frameId, settings.length, settings.resolution,
+                                    position, settings.seed);
+  // Additional layers only add load to the serialization, transport and conversion.
+  for (int i = 1; i < settings.numberOfLayers; ++i) {
+    map.add("synthetic_layer_" + std::to_string(i), map.get(settings.elevationLayer));
+  }
+  return map;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "synthetic_elevation_map");
+  ros::NodeHandle nodeHandle("~");
+
+  double frequency;
+  std::string elevationMapTopicOut;
+  std::string planarTerrainTopic;
+  std::string terrainType;
+  SyntheticMapSettings settings;
+  if (!nodeHandle.getParam("frequency", frequency)) {
+    ROS_ERROR("[ConvexPlaneExtractionROS:SyntheticElevationMap] Could not read parameter `frequency`.");
+    return 1;
+  }
+  if (!nodeHandle.getParam("elevation_topic_out", elevationMapTopicOut)) {
+    ROS_ERROR("[ConvexPlaneExtractionROS:SyntheticElevationMap] Could not read parameter `elevation_topic_out`.");
+    return 1;
+  }
+  if (!nodeHandle.getParam("height_layer", settings.elevationLayer)) {
+    ROS_ERROR("[ConvexPlaneExtractionROS:SyntheticElevationMap] Could not read parameter `height_layer`.");
+    return 1;
+  }
+  planarTerrainTopic = nodeHandle.param<std::string>("planar_terrain_topic", "/convex_plane_decomposition_ros/planar_terrain");
+  terrainType = nodeHandle.param<std::string>("terrain", "random_blocks");
+  settings.frameId = nodeHandle.param<std::string>("frame_id", "odom");
+  settings.length = nodeHandle.param("length", 8.0);
+  settings.resolution = nodeHandle.param("resolution", 0.04);
+  settings.numberOfLayers = std::max(1, nodeHandle.param("number_of_layers", 1));
+  settings.velocity.x() = nodeHandle.param("velocity_x", 0.0);
+  settings.velocity.y() = nodeHandle.param("velocity_y", 0.0);
+  settings.numberOfHoles = nodeHandle.param("number_of_holes", 0);
+  settings.holeRadius = nodeHandle.param("hole_radius", 0.1);
+  settings.seed = nodeHandle.param("seed", 0);
+  const double reportPeriod = nodeHandle.param("report_period", 5.0);
+
+  try {
+    settings.terrainType = syntheticTerrainTypeFromString(terrainType);
+  } catch (const std::invalid_argument& e) {
+    ROS_ERROR("[ConvexPlaneExtractionROS:SyntheticElevationMap] %s", e.what());
+    return 1;
+  }
+
+  LatencyTracker latencyTracker;
+  auto publisher = nodeHandle.advertise<grid_map_msgs::GridMap>(elevationMapTopicOut, 1);
+  auto planarTerrainSubscriber = nodeHandle.subscribe<convex_plane_decomposition_msgs::PlanarTerrain>(
+      planarTerrainTopic, 10, [&](const convex_plane_decomposition_msgs::PlanarTerrain::ConstPtr& message) {
+        latencyTracker.addReceived(message->gridmap.info.header.stamp, ros::Time::now());
+      });
+
+  // Receive the planar terrain on a separate thread, such that the latency is not affected by the publishing loop.
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  std::mt19937 holeGenerator(settings.seed);
+  const bool isMoving = !settings.velocity.isZero();
+  const auto staticMap = createMap(settings, grid_map::Position::Zero());
+  Timer generationTimer;
+
+  const ros::Time startTime = ros::Time::now();
+  ros::Time reportTime = startTime;
+  int numberOfPublished = 0;
+  ros::Rate rate(frequency);
+  while (ros::ok()) {
+    generationTimer.startTimer();
+    const ros::Time now = ros::Time::now();
+    auto map = isMoving ? createMap(settings, settings.velocity * (now - startTime).toSec()) : staticMap;
+    addHoles(map, settings.numberOfHoles, settings.holeRadius, holeGenerator);
+    map.setTimestamp(now.toNSec());
+
+    grid_map_msgs::GridMap message;
+    grid_map::GridMapRosConverter::toMessage(map, message);
+    generationTimer.endTimer();
+
+    latencyTracker.addSent(message.info.header.stamp);
+    publisher.publish(message);
+    ++numberOfPublished;
+
+    const double elapsedTime = (ros::Time::now() - reportTime).toSec();
+    if (elapsedTime >= reportPeriod) {
+      latencyTracker.printAndReset(elapsedTime, numberOfPublished, frequency, generationTimer);
+      generationTimer.reset();
+      reportTime = ros::Time::now();
+      numberOfPublished = 0;
+    }
+
+    rate.sleep();
+  }
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * @brief       Tests for the parameter files of the batch tool.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "convex_plane_decomposition_ros/BatchParameters.h"
+#include "convex_plane_decomposition_ros/ParameterTable.h"
+
+using namespace convex_plane_decomposition;
+
+TEST(TestBatchParameters, loadsShippedParameterFile) {  // NOLINT
+  const auto node = YAML::LoadFile(PARAMETER_FILE);
+  BatchParameters parameters;
+  ASSERT_NO_THROW(parameters = loadBatchParameters(node));
+
+  EXPECT_EQ(parameters.config.preprocessingParameters.kernelSize, node["preprocessing"]["kernelSize"].as<int>());
+  EXPECT_DOUBLE_EQ(parameters.config.preprocessingParameters.resolution, node["preprocessing"]["resolution"].as<double>());
+  EXPECT_DOUBLE_EQ(parameters.config.slidingWindowPlaneExtractorParameters.plane_inclination_threshold,
+                   std::cos(node["sliding_window_plane_extractor"]["plane_inclination_threshold_degrees"].as<double>() * M_PI / 180.0));
+  EXPECT_EQ(parameters.threadPoolSettings.numThreads, node["thread_pool"]["num_threads"].as<int>());
+  EXPECT_EQ(parameters.threadPoolSettings.cpuAffinity, node["thread_pool"]["cpu_affinity"].as<std::vector<int>>());
+  EXPECT_EQ(parameters.threadPoolSettings.deterministic, node["thread_pool"]["deterministic"].as<bool>());
+}
+
+TEST(TestBatchParameters, shippedParameterFileSetsAllParameters) {  // NOLINT
+  // The ROS node reads the same names, and reports every one of them that is missing.
+  std::vector<std::pair<std::string, YAML::Node>> entries;
+  flattenYaml(YAML::LoadFile(PARAMETER_FILE), "", entries);
+  std::vector<std::string> names;
+  for (const auto& entry : entries) {
+    names.push_back(entry.first);
+  }
+
+  PlaneDecompositionPipeline::Config config;
+  grid_map::parallel::ThreadPoolSettings threadPoolSettings;
+  const auto expectInFile = [&](const std::string& name, const auto&) {
+    EXPECT_NE(std::find(names.begin(), names.end(), name), names.end()) << name;
+    return false;
+  };
+  readParameters(config, expectInFile);
+  readParameters(threadPoolSettings,
+                 [&](const std::string& name, const auto& value) { return expectInFile("thread_pool/" + name, value); });
+}
+
+TEST(TestBatchParameters, threadPoolSection) {  // NOLINT
+  const auto parameters = loadBatchParameters(YAML::Load("thread_pool: {num_threads: 2, cpu_affinity: [1, 3], deterministic: true}"));
+  EXPECT_EQ(parameters.threadPoolSettings.numThreads, 2);
+  EXPECT_EQ(parameters.threadPoolSettings.cpuAffinity, std::vector<int>({1, 3}));
+  EXPECT_TRUE(parameters.threadPoolSettings.deterministic);
+
+  EXPECT_THROW(loadBatchParameters(YAML::Load("thread_pool: {numThreads: 2}")), std::runtime_error);
+  EXPECT_THROW(loadBatchParameters(YAML::Load("preprocessing: {kernel_size: 3}")), std::runtime_error);
+}
+
+TEST(TestBatchParameters, shippedSweepFileUsesKnownParameters) {  // NOLINT
+  std::vector<std::pair<std::string, YAML::Node>> entries;
+  flattenYaml(YAML::LoadFile(SWEEP_FILE), "", entries);
+  ASSERT_FALSE(entries.empty());
+  for (const auto& entry : entries) {
+    for (const auto& value : entry.second) {
+      PlaneDecompositionPipeline::Config config;
+      EXPECT_NO_THROW(setParameter(config, entry.first, value)) << entry.first;
+    }
+  }
+}
@@ -0,0 +1,614 @@
+/**
+ * @brief       Benchmarks for grid map filters.
+ *
+ * Usage:
+ *   benchmark_grid_map_filters_rsl [--benchmark_filter=<regex>] [--benchmark_out=results.json --benchmark_out_format=json]
+ *
+ * Compare a run with the checked-in benchmark/baseline.json, or two runs before and after a change, with benchmark/compare_to_baseline.py,
+ * see the README of plane_segmentation.
+ */
+
+#include <cmath>
+#include <functional>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <grid_map_filters_rsl/GridMapDerivative.hpp>
+#include <grid_map_filters_rsl/TiledFilterChain.hpp>
+#include <grid_map_filters_rsl/ValidityMask.hpp>
+#include <grid_map_filters_rsl/inpainting.hpp>
+#include <grid_map_filters_rsl/lookup.hpp>
+#include <grid_map_filters_rsl/processing.hpp>
+#include <grid_map_filters_rsl/smoothing.hpp>
+
+using namespace grid_map;
+
+namespace {
+
+/// Square map with random heights, scattered nan cells and a centered disk shaped nan-patch. The hole diameter is relative to the map size.
+GridMap createMapWithHole(int size, double holeDiameterFraction, double nanFraction = 0.05) {
+  GridMap map;
+  map.setGeometry(Length(size * 0.04, size * 0.04), 0.04, Position(0.0, 0.0));
+  map.add("elevation");
+  auto& H = map.get("elevation");
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> heights(-1.0F, 1.0F);
+  std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+  const double center = 0.5 * size;
+  const double holeRadius = 0.5 * holeDiameterFraction * size;
+  for (int colId = 0; colId < H.cols(); ++colId) {
+    for (int rowId = 0; rowId < H.rows(); ++rowId) {
+      const bool inHole = std::hypot(rowId - center, colId - center) < holeRadius;
+      H(rowId, colId) = (inHole || unit(generator) < nanFraction) ? NAN : heights(generator);
+    }
+  }
+  return map;
+}
+
+void setCellCounters(benchmark::State& state, const GridMap& map) {
+  state.counters["cells"] = static_cast<double>(map.getSize().prod());
+  state.counters["cells_per_second"] =
+      benchmark::Counter(static_cast<double>(map.getSize().prod()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/// Arguments: {map size [cells], hole diameter [% of map size], scattered nan cells [%]}.
+/// Hole sizes and nan densities are varied separately.
+void holeArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"size", "hole_percent", "nan_percent"});
+  for (int size : {128, 256, 512, 1024}) {
+    for (int holePercent : {0, 10, 50, 90}) {
+      benchmark->Args({size, holePercent, 5});
+    }
+    for (int nanPercent : {0, 25, 50}) {
+      benchmark->Args({size, 10, nanPercent});
+    }
+  }
+  benchmark->Unit(benchmark::kMicrosecond);
+}
+
+/// Map with a hole and scattered nan cells, as given by holeArguments.
+GridMap createMapWithHole(const benchmark::State& state) {
+  return createMapWithHole(state.range(0), state.range(1) / 100.0, state.range(2) / 100.0);
+}
+
+/// Arguments: {map size [cells], kernel size [cells]}
+void kernelArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"size", "kernel"});
+  for (int size : {128, 256, 512, 1024}) {
+    for (int kernelSize : {3, 5, 9, 15, 31}) {
+      benchmark->Args({size, kernelSize});
+    }
+  }
+  benchmark->Unit(benchmark::kMicrosecond);
+}
+
+/// Arguments: {map size [cells], new resolution [% of the map resolution], number of layers}
+void resampleArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"size", "resolution_percent", "layers"});
+  for (int size : {128, 256, 512, 1024}) {
+    for (int resolutionPercent : {50, 125, 200}) {
+      for (int numLayers : {1, 4}) {
+        benchmark->Args({size, resolutionPercent, numLayers});
+      }
+    }
+  }
+  benchmark->Unit(benchmark::kMicrosecond);
+}
+
+/// Square map with smooth terrain within [-0.22, 0.22], box shaped obstacles of height 1 on about 2% of the cells and scattered nan cells.
+GridMap createTerrainMap(int size) {
+  GridMap map = createMapWithHole(size, 0.0);
+  auto& H = map.get("elevation");
+  for (int colId = 0; colId < H.cols(); ++colId) {
+    for (int rowId = 0; rowId < H.rows(); ++rowId) {
+      if (std::isfinite(H(rowId, colId))) {
+        H(rowId, colId) = 0.2F * std::sin(0.05F * rowId) * std::cos(0.03F * colId) + 0.02F * H(rowId, colId);
+      }
+    }
+  }
+  std::mt19937 generator(2);
+  std::uniform_int_distribution<int> corner(0, size - 8);
+  for (int obstacleId = 0; obstacleId < size * size / 50 / 64; ++obstacleId) {
+    H.block(corner(generator), corner(generator), 8, 8).setConstant(1.0F);
+  }
+  return map;
+}
+
+/// Arguments: {map size [cells], segment length [cells]}
+void segmentArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"size", "length"});
+  for (int size : {128, 512, 1024}) {
+    for (int length : {2, 8, 32, 128, 512}) {
+      benchmark->Args({size, length});
+    }
+  }
+  benchmark->Unit(benchmark::kMicrosecond);
+}
+
+/// Segments of the given length with random start in the map and random direction.
+std::vector<lookup::LookupSegment> createSegments(const GridMap& map, int lengthInCells, int numSegments = 1000) {
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> coordinate(-0.5, 0.5);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::vector<lookup::LookupSegment> segments(numSegments);
+  for (auto& segment : segments) {
+    segment.start = map.getPosition() + map.getLength().matrix().cwiseProduct(Position(coordinate(generator), coordinate(generator)));
+    const double direction = angle(generator);
+    segment.end = segment.start + lengthInCells * map.getResolution() * Position(std::cos(direction), std::sin(direction));
+  }
+  return segments;
+}
+
+void setSegmentCounters(benchmark::State& state, size_t numSegments) {
+  state.counters["segments_per_second"] =
+      benchmark::Counter(static_cast<double>(numSegments), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+}  // namespace
+
+static void BM_DerivativeEstimateGradientAndCurvature(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  derivative::GridMapDerivative derivativeFilter;
+  derivativeFilter.initialize(map.getResolution());
+  const auto& H = map.get("elevation");
+  map.add("slope");
+  map.add("curvature_xx");
+  Eigen::Vector2d gradient;
+  Eigen::Matrix2d curvature;
+  for (auto _ : state) {
+    for (GridMapIterator iterator(map); !iterator.isPastEnd(); ++iterator) {
+      derivativeFilter.estimateGradientAndCurvature(map, gradient, curvature, *iterator, H);
+      map.at("slope", *iterator) = gradient.norm();
+      map.at("curvature_xx", *iterator) = curvature(0, 0);
+    }
+    benchmark::DoNotOptimize(map.get("slope").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_DerivativeEstimateGradientAndCurvature)->Apply(holeArguments);
+
+static void BM_DerivativeEstimateGradient(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  derivative::GridMapDerivative derivativeFilter;
+  derivativeFilter.initialize(map.getResolution());
+  const auto& H = map.get("elevation");
+  map.add("slope");
+  Eigen::Vector2d gradient;
+  for (auto _ : state) {
+    for (GridMapIterator iterator(map); !iterator.isPastEnd(); ++iterator) {
+      derivativeFilter.estimateGradient(map, gradient, *iterator, H);
+      map.at("slope", *iterator) = gradient.norm();
+    }
+    benchmark::DoNotOptimize(map.get("slope").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_DerivativeEstimateGradient)->Apply(holeArguments);
+
+static void BM_DerivativeLayers(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  derivative::GridMapDerivative derivativeFilter;
+  derivativeFilter.initialize(map.getResolution());
+  derivative::GridMapDerivative::DerivativeLayers layers;
+  layers.gradientX = "gradient_x";
+  layers.gradientY = "gradient_y";
+  layers.slope = "slope";
+  layers.curvatureXX = "curvature_xx";
+  layers.curvatureXY = "curvature_xy";
+  layers.curvatureYY = "curvature_yy";
+  for (auto _ : state) {
+    derivativeFilter.computeDerivativeLayers(map, "elevation", layers);
+    benchmark::DoNotOptimize(map.get("slope").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_DerivativeLayers)->Apply(holeArguments)->UseRealTime();
+
+static void BM_InpaintingMinValues(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    inpainting::minValues(map, "elevation", "filled");
+    benchmark::DoNotOptimize(map.get("filled").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_InpaintingMinValues)->Apply(holeArguments);
+
+static void BM_InpaintingBiLinearInterpolation(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    inpainting::biLinearInterpolation(map, "elevation", "filled");
+    benchmark::DoNotOptimize(map.get("filled").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_InpaintingBiLinearInterpolation)->Apply(holeArguments)->UseRealTime();
+
+static void BM_InpaintingHarmonicInterpolation(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    inpainting::harmonicInterpolation(map, "elevation", "filled");
+    benchmark::DoNotOptimize(map.get("filled").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_InpaintingHarmonicInterpolation)->Apply(holeArguments);
+
+static void BM_InpaintingNonlinearInterpolation(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    inpainting::nonlinearInterpolation(map, "elevation", "filled", 3.0 * map.getResolution());
+    benchmark::DoNotOptimize(map.get("filled").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_InpaintingNonlinearInterpolation)->Apply(holeArguments)->UseRealTime();
+
+static void BM_InpaintingResample(benchmark::State& state) {
+  const auto original = createMapWithHole(state.range(0), 0.1);
+  const double newResolution = original.getResolution() * state.range(1) / 100.0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto map = original;
+    for (int layerId = 1; layerId < state.range(2); ++layerId) {
+      map.add("layer" + std::to_string(layerId), map.get("elevation"));
+    }
+    state.ResumeTiming();
+    inpainting::resample(map, "all", newResolution);
+    benchmark::DoNotOptimize(map.get("elevation").data());
+  }
+  setCellCounters(state, original);
+}
+BENCHMARK(BM_InpaintingResample)->Apply(resampleArguments)->UseRealTime();
+
+static void BM_ProcessingDilate(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    processing::dilate(map, "elevation", "filtered", Matrix(), state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingDilate)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingDilateDisk(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    processing::dilate(map, "elevation", "filtered", Matrix(), state.range(1), true, processing::KernelShape::Disk);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingDilateDisk)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingErode(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    processing::erode(map, "elevation", "filtered", Matrix(), state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingErode)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingDilateMasked(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const Matrix& H = map.get("elevation");
+  const Matrix mask = H.unaryExpr([](float value) { return std::isfinite(value) ? 1.0F : NAN; });
+  for (auto _ : state) {
+    processing::dilate(map, "elevation", "filtered", mask, state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingDilateMasked)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingDilateValidityMask(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    processing::dilate(map, "elevation", "filtered", validity, state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingDilateValidityMask)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingErodeValidityMask(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    processing::erode(map, "elevation", "filtered", validity, state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingErodeValidityMask)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingApplyKernelFunction(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const int kernelSize = state.range(1);
+  const Eigen::MatrixXf offsets = Eigen::MatrixXf::Random(kernelSize, kernelSize);
+  auto function = [&](const Eigen::Block<const Matrix>& data) { return (data - offsets).maxCoeffOfFinites(); };
+  for (auto _ : state) {
+    processing::applyKernelFunction(map, "elevation", "filtered", kernelSize, function, true);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingApplyKernelFunction)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingApplyKernelStdFunction(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const int kernelSize = state.range(1);
+  const Eigen::MatrixXf offsets = Eigen::MatrixXf::Random(kernelSize, kernelSize);
+  const std::function<float(const Eigen::Ref<const Matrix>&)> function = [&](const Eigen::Ref<const Matrix>& data) {
+    return (data - offsets).maxCoeffOfFinites();
+  };
+  for (auto _ : state) {
+    processing::applyKernelFunction(map, "elevation", "filtered", kernelSize, function);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingApplyKernelStdFunction)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingConeDilate(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    processing::coneDilate(map, "elevation", "filtered", map.getResolution(), state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingConeDilate)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ProcessingConeErode(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    processing::coneErode(map, "elevation", "filtered", map.getResolution(), state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingConeErode)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_LookupMaxValueLineIterator(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const auto& H = map.get("elevation");
+  const auto segments = createSegments(map, state.range(1));
+  for (auto _ : state) {
+    for (const auto& segment : segments) {
+      benchmark::DoNotOptimize(lookup::maxValueBetweenLocations(segment.start, segment.end, map, H));
+    }
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupMaxValueLineIterator)->Apply(segmentArguments);
+
+static void BM_LookupMaxValuePyramid(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const lookup::MaxPyramid pyramid(map, map.get("elevation"));
+  const auto segments = createSegments(map, state.range(1));
+  for (auto _ : state) {
+    for (const auto& segment : segments) {
+      benchmark::DoNotOptimize(lookup::maxValueBetweenLocations(segment.start, segment.end, map, pyramid));
+    }
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupMaxValuePyramid)->Apply(segmentArguments);
+
+static void BM_LookupIsMaxValueBelow(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const lookup::MaxPyramid pyramid(map, map.get("elevation"));
+  const auto segments = createSegments(map, state.range(1));
+  for (auto _ : state) {
+    for (const auto& segment : segments) {
+      benchmark::DoNotOptimize(lookup::isMaxValueBelow(segment.start, segment.end, map, pyramid, 0.5F));
+    }
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupIsMaxValueBelow)->Apply(segmentArguments);
+
+static void BM_LookupMaxValuesBetweenLocations(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const lookup::MaxPyramid pyramid(map, map.get("elevation"));
+  const auto segments = createSegments(map, state.range(1));
+  std::vector<lookup::LookupResult> results;
+  for (auto _ : state) {
+    lookup::maxValuesBetweenLocations(segments, map, pyramid, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupMaxValuesBetweenLocations)->Apply(segmentArguments)->UseRealTime();
+
+static void BM_LookupAreMaxValuesBelow(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const lookup::MaxPyramid pyramid(map, map.get("elevation"));
+  const auto segments = createSegments(map, state.range(1));
+  std::vector<uint8_t> isBelow;
+  for (auto _ : state) {
+    lookup::areMaxValuesBelow(segments, map, pyramid, 0.5F, isBelow);
+    benchmark::DoNotOptimize(isBelow.data());
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupAreMaxValuesBelow)->Apply(segmentArguments)->UseRealTime();
+
+static void BM_LookupValuesBetweenLocations(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const auto segments = createSegments(map, state.range(1));
+  std::vector<Position3> lineValues;
+  for (auto _ : state) {
+    for (const auto& segment : segments) {
+      lookup::valuesBetweenLocations(segment.start, segment.end, map, map.get("elevation"), lineValues);
+      benchmark::DoNotOptimize(lineValues.data());
+    }
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupValuesBetweenLocations)->Apply(segmentArguments);
+
+static void BM_LookupProjectToMapWithMargin(benchmark::State& state) {
+  const auto map = createTerrainMap(state.range(0));
+  const auto segments = createSegments(map, state.range(1));
+  for (auto _ : state) {
+    for (const auto& segment : segments) {
+      benchmark::DoNotOptimize(lookup::projectToMapWithMargin(map, segment.end));
+    }
+  }
+  setSegmentCounters(state, segments.size());
+}
+BENCHMARK(BM_LookupProjectToMapWithMargin)->Apply(segmentArguments);
+
+static void BM_LookupMaxPyramid(benchmark::State& state) {
+  const auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    const lookup::MaxPyramid pyramid(map, map.get("elevation"));
+    benchmark::DoNotOptimize(pyramid.level(0).data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_LookupMaxPyramid)->Apply(holeArguments)->UseRealTime();
+
+static void BM_ProcessingOutline(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    processing::outline(map, "elevation", "filtered");
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingOutline)->Apply(holeArguments)->UseRealTime();
+
+static void BM_ProcessingOutlineValidityMask(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    processing::outline(map, "elevation", "filtered", validity);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ProcessingOutlineValidityMask)->Apply(holeArguments)->UseRealTime();
+
+static void BM_ValidityMaskFromLayer(benchmark::State& state) {
+  auto map = createMapWithHole(state);
+  for (auto _ : state) {
+    auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+    benchmark::DoNotOptimize(validity);
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ValidityMaskFromLayer)->Apply(holeArguments)->UseRealTime();
+
+static void BM_ValidityMaskDilated(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    auto dilated = validity.dilated(state.range(1));
+    benchmark::DoNotOptimize(dilated);
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ValidityMaskDilated)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_ValidityMaskWindowCounts(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    auto counts = validity.windowCounts(state.range(1));
+    benchmark::DoNotOptimize(counts.data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_ValidityMaskWindowCounts)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_SmoothingMedian(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    smoothing::median(map, "elevation", "filtered", state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_SmoothingMedian)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_SmoothingMedianValidityMask(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const auto validity = mask::ValidityMask::fromLayer(map, "elevation");
+  for (auto _ : state) {
+    smoothing::median(map, "elevation", "filtered", validity, state.range(1));
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_SmoothingMedianValidityMask)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_SmoothingBoxBlur(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    smoothing::boxBlur(map, "elevation", "filtered", state.range(1), 2);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_SmoothingBoxBlur)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_SmoothingGaussianBlur(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  for (auto _ : state) {
+    smoothing::gaussianBlur(map, "elevation", "filtered", state.range(1), state.range(1) / 3.0);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_SmoothingGaussianBlur)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_FilterChainSequential(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const int kernelSize = state.range(1);
+  for (auto _ : state) {
+    processing::dilate(map, "elevation", "filtered", Matrix(), kernelSize);
+    processing::erode(map, "filtered", "filtered", Matrix(), kernelSize);
+    processing::coneDilate(map, "filtered", "filtered", 0.04F, kernelSize);
+    smoothing::median(map, "filtered", "filtered", 3, 0, 2);
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_FilterChainSequential)->Apply(kernelArguments)->UseRealTime();
+
+static void BM_FilterChainTiled(benchmark::State& state) {
+  auto map = createMapWithHole(state.range(0), 0.1);
+  const int kernelSize = state.range(1);
+  processing::TiledFilterChain chain;
+  chain.addDilation(kernelSize).addErosion(kernelSize).addConeDilation(0.04F, kernelSize).addMedian(3, 0, 2);
+  for (auto _ : state) {
+    chain.apply(map, "elevation", "filtered");
+    benchmark::DoNotOptimize(map.get("filtered").data());
+  }
+  setCellCounters(state, map);
+}
+BENCHMARK(BM_FilterChainTiled)->Apply(kernelArguments)->UseRealTime();
+
+int main(int argc, char** argv) {
+  // Build of the filters, which is part of the context of the json results. compare_to_baseline.py only compares runs of the same build.
+#ifdef NDEBUG
+  benchmark::AddCustomContext("build_type", "release");
+#else
+  benchmark::AddCustomContext("build_type", "debug");
+#endif
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Compare Google Benchmark json runs with a baseline and flag regressions.
+
+Usage:
+    compare_to_baseline.py results.json [--baseline baseline.json] [--threshold 0.15] [--metric real_time] [--filter <regex>]
+    compare_to_baseline.py results.json --update-baseline
+
+The default baseline is benchmark/baseline.json, recorded on the reference machine given in its context. Runs on other machines are
+compared with a baseline from the reference commit recorded on the same machine. The script refuses runs with a different number of
+cpus or build type, unless --ignore-context is given. Benchmarks that were run with repetitions are compared by their median. The script
+exits with status 1 if any benchmark is slower than the baseline by more than the threshold, such that it can be used in CI.
+
+--update-baseline replaces the baseline by the medians of a release run, with the context of the run.
+"""
+import argparse
+import json
+import os
+import re
+import sys
+
+TIME_UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baseline.json")
+
+
+def load_results(file_name, metric):
+    """Returns the context and {benchmark name: time [ns]} of a json file written with --benchmark_out_format=json."""
+    with open(file_name) as file:
+        results = json.load(file)
+    benchmarks = results["benchmarks"]
+
+    iteration_times = {}
+    median_times = {}
+    for benchmark in benchmarks:
+        if benchmark.get("error_occurred", False):
+            continue
+        name = benchmark.get("run_name", benchmark["name"])
+        time = benchmark[metric] * TIME_UNIT_TO_NS[benchmark.get("time_unit", "ns")]
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                median_times[name] = time
+        else:
+            iteration_times.setdefault(name, []).append(time)
+
+    times = {name: sorted(values)[len(values) // 2] for name, values in iteration_times.items()}
+    times.update(median_times)
+    return results.get("context", {}), times
+
+
+def check_context(baseline_context, contender_context):
+    """Returns the reasons why the timings of the two runs are not comparable, and prints warnings."""
+    errors = []
+    for key in ["num_cpus", "library_build_type", "build_type"]:
+        if baseline_context.get(key) != contender_context.get(key):
+            errors.append("{} differs: {} (baseline) vs {} (contender)".format(key, baseline_context.get(key), contender_context.get(key)))
+    if baseline_context.get("host_name") != contender_context.get("host_name"):
+        print("Warning: the runs were recorded on different hosts, the baseline on: {}.".format(
+            baseline_context.get("machine", baseline_context.get("host_name"))), file=sys.stderr)
+    for name, context in [("baseline", baseline_context), ("contender", contender_context)]:
+        if context.get("library_build_type") == "debug":
+            print("Warning: the {} was recorded with a debug build of google benchmark.".format(name), file=sys.stderr)
+    return errors
+
+
+def write_baseline(file_name, context, real_times, cpu_times):
+    """Writes the median times of each benchmark in ns, one benchmark per line, such that updates of the baseline diff well."""
+    lines = [
+        json.dumps(
+            {"name": name, "run_name": name, "run_type": "iteration", "real_time": time, "cpu_time": cpu_times[name], "time_unit": "ns"},
+            sort_keys=True,
+        )
+        for name, time in sorted(real_times.items())
+    ]
+    with open(file_name, "w") as file:
+        file.write('{\n"context": ' + json.dumps(context, indent=2, sort_keys=True) + ',\n"benchmarks": [\n')
+        file.write(",\n".join(lines) + "\n]\n}\n")
+
+
+def format_time(time_ns):
+    for unit in ["s", "ms", "us"]:
+        if time_ns >= TIME_UNIT_TO_NS[unit]:
+            return "{:.3g} {}".format(time_ns / TIME_UNIT_TO_NS[unit], unit)
+    return "{:.3g} ns".format(time_ns)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("contender", help="json results to check")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="json results of the baseline")
+    parser.add_argument("--update-baseline", action="store_true", help="write the medians of the contender to the baseline")
+    parser.add_argument("--threshold", type=float, default=0.15, help="relative slowdown that is flagged as regression")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="real_time", help="time that is compared")
+    parser.add_argument("--filter", default=".*", help="only compare benchmarks whose name matches this regex")
+    parser.add_argument("--all", action="store_true", help="also print benchmarks within the threshold")
+    parser.add_argument("--ignore-context", action="store_true", help="compare runs with a different number of cpus or build type")
+    args = parser.parse_args()
+
+    if args.update_baseline:
+        context, real_times = load_results(args.contender, "real_time")
+        _, cpu_times = load_results(args.contender, "cpu_time")
+        if context.get("build_type") != "release":
+            print("Error: the baseline must be recorded with a release build.", file=sys.stderr)
+            return 2
+        context.pop("executable", None)
+        write_baseline(args.baseline, context, real_times, cpu_times)
+        print("Wrote {} benchmarks to {}.".format(len(real_times), args.baseline))
+        return 0
+
+    baseline_context, baseline = load_results(args.baseline, args.metric)
+    contender_context, contender = load_results(args.contender, args.metric)
+    context_errors = check_context(baseline_context, contender_context)
+    if context_errors and not args.ignore_context:
+        for error in context_errors:
+            print("Error: " + error, file=sys.stderr)
+        print("Record both runs on the same machine and build, or pass --ignore-context.", file=sys.stderr)
+        return 2
+    name_filter = re.compile(args.filter)
+    names = [name for name in contender if name_filter.search(name)]
+
+    regressions = []
+    improvements = []
+    rows = []
+    for name in names:
+        if name not in baseline:
+            rows.append((name, "-", format_time(contender[name]), "-", "new"))
+            continue
+        ratio = contender[name] / baseline[name]
+        if ratio > 1.0 + args.threshold:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif ratio < 1.0 / (1.0 + args.threshold):
+            status = "improved"
+            improvements.append(name)
+        else:
+            status = ""
+        if status or args.all:
+            rows.append((name, format_time(baseline[name]), format_time(contender[name]), "{:+.1%}".format(ratio - 1.0), status))
+    missing = [name for name in baseline if name_filter.search(name) and name not in contender]
+
+    if rows:
+        rows.insert(0, ("benchmark", "baseline", "contender", "change", ""))
+        widths = [max(len(row[column]) for row in rows) for column in range(5)]
+        for row in rows:
+            cells = [cell.ljust(width) if column == 0 else cell.rjust(width) for column, (cell, width) in enumerate(zip(row, widths))]
+            print("  ".join(cells))
+    print(
+        "\n{} compared, {} regressions, {} improvements (threshold {:.0%}, {}), {} not run.".format(
+            len(names), len(regressions), len(improvements), args.threshold, args.metric, len(missing)
+        )
+    )
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,6 +9,9 @@
 
 #pragma once
 
+// stl.
+#include <string>
+
 // grid_map_core
 #include <grid_map_core/grid_map_core.hpp>
 
@@ -21,8 +24,19 @@ class GridMapDerivative {
   using Gradient = Eigen::Vector2d;
   using Curvature = Eigen::Matrix2d;
   using Kernel = Eigen::Matrix<float, kernelSize_, 1>;
+  using ShortKernel = Eigen::Matrix<float, 3, 1>;
 
  public:
+  /// Names of the layers written by computeDerivativeLayers. Layers with empty names are not computed.
+  struct DerivativeLayers {
+    std::string gradientX;
+    std::string gradientY;
+    std::string slope;  ///< Norm of the gradient
+    std::string curvatureXX;
+    std::string curvatureXY;
+    std::string curvatureYY;
+  };
+
   GridMapDerivative();
   ~GridMapDerivative() = default;
 
@@ -55,6 +69,18 @@ class GridMapDerivative {
   void estimateGradientAndCurvature(const grid_map::GridMap& gridMap, Gradient& gradient, Curvature& curvature,
                                     const grid_map::Index& index, const grid_map::Matrix& H) const;
 
+  /**
+   * @brief Computes gradient, slope and curvature of all cells at once and writes them into new layers (existing layers are overwritten).
+   * The kernels are applied to whole columns of the layer, in parallel. Without nan values, the results are the ones of
+   * estimateGradientAndCurvature at every cell. Where the kernel reaches a nan value, the derivative falls back to the central difference
+   * of the direct neighbours, then to the one-sided difference (first order only). Cells that are nan, or have no finite neighbours in a
+   * direction, are nan.
+   * @param gridMap         The grid map
+   * @param layer           layer to differentiate
+   * @param outputLayers    names of the layers to write
+   */
+  void computeDerivativeLayers(grid_map::GridMap& gridMap, const std::string& layer, const DerivativeLayers& outputLayers) const;
+
  private:
   /**
    * @brief Return center of kernel s.t. kernel does not reach boundaries of grid map. By default returns 0 (equals central difference).
@@ -70,6 +96,12 @@ class GridMapDerivative {
 
   //! Second order derivative kernel.
   Kernel kernelD2_;
+
+  //! First order derivative kernel of the direct neighbours, used close to nan values.
+  ShortKernel shortKernelD1_;
+
+  //! Second order derivative kernel of the direct neighbours, used close to nan values.
+  ShortKernel shortKernelD2_;
 };
 }  // namespace derivative
 }  // namespace grid_map
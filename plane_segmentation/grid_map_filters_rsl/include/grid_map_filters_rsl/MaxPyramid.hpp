@@ -0,0 +1,51 @@
+/**
+ * @file        MaxPyramid.hpp
+ * @brief       Pyramid of block maxima of a layer, for fast bounds on the maximum along lines.
+ */
+
+#pragma once
+
+// stl.
+#include <vector>
+
+// grid map.
+#include <grid_map_core/grid_map_core.hpp>
+
+namespace grid_map {
+namespace lookup {
+
+/**
+ * Pyramid of block maxima of a layer: level k stores the maximum of the finite values in each aligned block of 2^k x 2^k cells, level 0
+ * are the values themselves. Cells without finite values store std::numeric_limits<float>::lowest(). Built once per map in O(number of
+ * cells), after which the maximum in any box of cells is bounded from above with at most four lookups.
+ */
+class MaxPyramid {
+ public:
+  /**
+   * @param gridMap : map object for map information. Must have the default start index (see GridMap::convertToDefaultStartIndex).
+   * @param data : map data to find the maximum in.
+   */
+  MaxPyramid(const grid_map::GridMap& gridMap, const grid_map::Matrix& data);
+
+  /// Number of levels, the last level has a single cell.
+  int numLevels() const { return static_cast<int>(levels_.size()); }
+
+  /// Block maxima of a level.
+  const grid_map::Matrix& level(int levelId) const { return levels_[levelId]; }
+
+  /// Value of a cell, std::numeric_limits<float>::lowest() if not finite.
+  float value(const grid_map::Index& index) const { return levels_.front()(index.x(), index.y()); }
+
+  /**
+   * Upper bound of the finite values in the box of cells between the corners (inclusive). Uses the finest level at which the box is
+   * covered by 2 x 2 blocks, such that the bound is exact for single cells and close for small boxes.
+   * @return upper bound, std::numeric_limits<float>::lowest() if the box has no finite values.
+   */
+  float upperBoundInBox(const grid_map::Index& corner1, const grid_map::Index& corner2) const;
+
+ private:
+  std::vector<grid_map::Matrix> levels_;
+};
+
+}  // namespace lookup
+}  // namespace grid_map
@@ -0,0 +1,161 @@
+/**
+ * @file        ThreadPool.hpp
+ * @brief       Thread pool that is shared by the plane segmentation packages, with a work-stealing parallel for.
+ */
+
+#pragma once
+
+// stl.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace grid_map {
+namespace parallel {
+
+struct ThreadPoolSettings {
+  /// Number of threads that process a loop, including the calling thread. 0 uses the number of cpus in cpuAffinity, or else of cores.
+  int numThreads = 0;
+  /// Cpus the worker threads are pinned to, assigned round robin (Linux only). The calling thread is not pinned. Empty to not pin.
+  std::vector<int> cpuAffinity;
+  /// Runs every loop on the calling thread as a single range, such that results never depend on the scheduling.
+  bool deterministic = false;
+};
+
+/// Usage of a pool since its construction or the last call to resetStatistics.
+struct ThreadPoolStatistics {
+  int numThreads = 0;
+  double elapsedSeconds = 0.0;
+  /// Time spent in loops, summed over all threads.
+  double busySeconds = 0.0;
+  /// busySeconds / (numThreads * elapsedSeconds), in [0, 1].
+  double utilization = 0.0;
+  uint64_t numLoops = 0;
+  uint64_t numChunks = 0;
+  /// Chunks that were processed by another thread than the one they were assigned to.
+  uint64_t numStolenChunks = 0;
+};
+
+/**
+ * Fixed set of worker threads that process the loops of all plane segmentation stages, such that they do not oversubscribe the cores.
+ * A loop over [begin, end) is split into contiguous chunks, and each thread starts on its own consecutive chunks. Threads that run out
+ * of chunks steal the last chunk of another thread, such that uneven work is balanced.
+ *
+ * The calling thread takes part in the loop and returns once all chunks are done. Loops that are started from within a loop, or while the
+ * pool is busy with a loop of another thread, run on the calling thread only. Exceptions thrown by the loop body are rethrown in the
+ * calling thread once all chunks are done.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(const ThreadPoolSettings& settings = ThreadPoolSettings());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Pool used by grid_map::parallel::forEachRange and the plane segmentation stages. Uses all cores until configured otherwise.
+  static ThreadPool& global();
+
+  /// True on worker threads and on threads that take part in a loop.
+  static bool isInParallelFor();
+
+  /// Replaces the worker threads, after the running loop is done. Must not be called from within a loop.
+  void configure(const ThreadPoolSettings& settings);
+
+  const ThreadPoolSettings& settings() const { return settings_; }
+
+  /// Number of threads that process a loop, including the calling thread.
+  int numThreads() const { return numThreads_; }
+
+  /**
+   * Calls rangeFunction(rangeBegin, rangeEnd) on disjoint ranges that cover [begin, end), from up to numThreads() threads.
+   * @param minRangeSize : minimum number of indices per range, small loops run on the calling thread only.
+   */
+  template <typename RangeFunction>
+  void parallelFor(int begin, int end, RangeFunction&& rangeFunction, int minRangeSize = 1) {
+    using Function = typename std::remove_reference<RangeFunction>::type;
+    const RangeCallback callback = [](void* function, int rangeBegin, int rangeEnd) {
+      (*static_cast<Function*>(function))(rangeBegin, rangeEnd);
+    };
+    run(begin, end, minRangeSize, callback, const_cast<void*>(static_cast<const void*>(&rangeFunction)));
+  }
+
+  /**
+   * Calls tileFunction(rowBegin, rowEnd, colBegin, colEnd) for the tiles of tileSize x tileSize cells that cover a numRows x numCols
+   * matrix, in parallel. Tiles at the end of the matrix may be smaller.
+   */
+  template <typename TileFunction>
+  void parallelForTiles(int numRows, int numCols, int tileSize, TileFunction&& tileFunction) {
+    const int numTileRows = (numRows + tileSize - 1) / tileSize;
+    const int numTileCols = (numCols + tileSize - 1) / tileSize;
+    parallelFor(0, numTileRows * numTileCols, [&](int tileBegin, int tileEnd) {
+      for (int tileId = tileBegin; tileId < tileEnd; ++tileId) {
+        const int rowBegin = (tileId % numTileRows) * tileSize;
+        const int colBegin = (tileId / numTileRows) * tileSize;
+        tileFunction(rowBegin, std::min(rowBegin + tileSize, numRows), colBegin, std::min(colBegin + tileSize, numCols));
+      }
+    });
+  }
+
+  ThreadPoolStatistics statistics() const;
+  void resetStatistics();
+
+ private:
+  using RangeCallback = void (*)(void* function, int rangeBegin, int rangeEnd);
+
+  /// Chunks [front, back) of a thread. Both ends are packed in one word, such that the owner and thieves can update them atomically.
+  struct ChunkQueue {
+    std::atomic<uint64_t> frontAndBack{0};
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  void run(int begin, int end, int minRangeSize, RangeCallback callback, void* function);
+  void runChunks(int threadId);
+  int popFront(int threadId);
+  int popBack(int threadId);
+  int chunkBegin(int chunkId) const;
+  void startWorkers();
+  void stopWorkers();
+  /// Runs the loops published after firstLoopId, the id of the last loop when the worker was started.
+  void workerLoop(int threadId, uint64_t firstLoopId);
+
+  ThreadPoolSettings settings_;
+  std::atomic<int> numThreads_{1};
+  std::vector<std::thread> workers_;
+  std::unique_ptr<ChunkQueue[]> queues_;
+
+  // Current loop.
+  std::mutex loopMutex_;
+  int loopBegin_ = 0;
+  int loopSize_ = 0;
+  int numChunks_ = 0;
+  RangeCallback callback_ = nullptr;
+  void* function_ = nullptr;
+  std::mutex exceptionMutex_;
+  std::exception_ptr exception_;
+
+  // Hand-over to the workers.
+  std::mutex mutex_;
+  std::condition_variable startCondition_;
+  std::condition_variable doneCondition_;
+  uint64_t loopId_ = 0;
+  int numRunningWorkers_ = 0;
+  bool stop_ = false;
+
+  // Statistics.
+  std::atomic<int64_t> statisticsStartNs_{0};
+  std::atomic<int64_t> busyNs_{0};
+  std::atomic<uint64_t> numLoops_{0};
+  std::atomic<uint64_t> numChunksTotal_{0};
+  std::atomic<uint64_t> numStolenChunks_{0};
+};
+
+}  // namespace parallel
+}  // namespace grid_map
@@ -0,0 +1,99 @@
+/**
+ * @file        TiledFilterChain.hpp
+ * @brief       Applies a chain of filters tile by tile, such that intermediate results stay in small buffers.
+ */
+
+#pragma once
+
+// stl.
+#include <functional>
+#include <string>
+#include <vector>
+
+// grid map.
+#include <grid_map_core/grid_map_core.hpp>
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/processing.hpp>
+
+namespace grid_map {
+namespace processing {
+
+/// Part of a layer that is covered by a tile buffer.
+struct TileRegion {
+  grid_map::Index topLeftIndex{0, 0};
+  grid_map::Size size{0, 0};
+};
+
+/**
+ * Chain of filters that is applied tile by tile instead of filter by filter. Each tile is extended by the windows of the filters, the
+ * halo, such that all filters run on a buffer of a few tiles in size while the layer is read and written only once. Tiles are processed in
+ * parallel.
+ *
+ * A filter maps a matrix to a matrix of the same size, where the value of each cell depends only on the values in its kernelSize x
+ * kernelSize window. At the matrix border, the window may be shifted to stay inside, clipped or padded, as the filters of this package and
+ * the open-cv border modes do. The buffer of a tile covers the windows of all cells that are needed from it and ends at the map border
+ * wherever a window reaches it. The result is therefore identical to applying the filters one after another to the whole layer.
+ */
+class TiledFilterChain {
+ public:
+  /// Filters the values of a tile. The region tells where the tile lies in the layer, e.g. to read other layers.
+  using TileFilter = std::function<grid_map::Matrix(const grid_map::Matrix& tile, const TileRegion& region)>;
+
+  /// @param tileSize : number of rows and columns of the result that are computed per tile.
+  explicit TiledFilterChain(int tileSize = 64);
+
+  /// Appends a filter, whose window has kernelSize x kernelSize cells.
+  TiledFilterChain& addFilter(int kernelSize, TileFilter filter);
+
+  /// Appends a function of the value of each cell, with signature float(float).
+  template <typename CellFunction>
+  TiledFilterChain& addCellFunction(CellFunction cellFunction) {
+    return addFilter(1, [cellFunction](const grid_map::Matrix& tile, const TileRegion& /*region*/) -> grid_map::Matrix {
+      return tile.unaryExpr(cellFunction);
+    });
+  }
+
+  /// Appends processing::applyKernelFunction. func must be safe to call concurrently.
+  template <typename KernelFunction>
+  TiledFilterChain& addKernelFunction(int kernelSize, KernelFunction func) {
+    return addFilter(kernelSize, [kernelSize, func](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+      return applyKernelFunction(tile, kernelSize, func);
+    });
+  }
+
+  /// Appends smoothing::median, including its repetitions.
+  TiledFilterChain& addMedian(int kernelSize, int deltaKernelSize = 2, int numberOfRepeats = 1);
+
+  /// Appends processing::dilate without mask.
+  TiledFilterChain& addDilation(int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+  /// Appends processing::erode without mask.
+  TiledFilterChain& addErosion(int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+  /// Appends processing::coneDilate.
+  TiledFilterChain& addConeDilation(float slope, int kernelSize);
+
+  /// Appends processing::coneErode.
+  TiledFilterChain& addConeErosion(float slope, int kernelSize);
+
+  int numFilters() const { return static_cast<int>(filters_.size()); }
+
+  /// Applies all filters to the data. Returns the data if the chain is empty.
+  grid_map::Matrix apply(const grid_map::Matrix& data) const;
+
+  /// Applies all filters from layerIn to layerOut. In-place operation (layerIn = layerOut) is supported.
+  void apply(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut) const;
+
+ private:
+  struct KernelFilter {
+    int kernelSize;
+    TileFilter filter;
+  };
+
+  int tileSize_;
+  std::vector<KernelFilter> filters_;
+};
+
+}  // namespace processing
+}  // namespace grid_map
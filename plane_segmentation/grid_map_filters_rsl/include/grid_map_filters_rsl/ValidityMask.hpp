@@ -0,0 +1,100 @@
+/**
+ * @file        ValidityMask.hpp
+ * @brief       Bit-packed mask of valid cells of a grid map layer.
+ */
+
+#pragma once
+
+// stl.
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// grid map.
+#include <grid_map_core/grid_map_core.hpp>
+
+namespace grid_map {
+namespace mask {
+
+/**
+ * Bit-packed mask of valid cells. Compute it once per layer and pass it along with the layer to processing::dilate, processing::erode,
+ * processing::outline and smoothing::median, which then handle words of 64 invalid or valid cells at once instead of checking every value.
+ *
+ * The bits are stored column-major, like the layers: each column is stored in wordsPerCol() words, where bit i of word w is the cell in
+ * row 64 * w + i. Bits past the last row are always zero.
+ */
+class ValidityMask {
+ public:
+  using Word = uint64_t;
+  static constexpr int bitsPerWord = 64;
+
+  ValidityMask() = default;
+
+  /// Mask of the given size with all cells set to isValid.
+  ValidityMask(int rows, int cols, bool isValid = false);
+
+  /// Cells with finite values are valid.
+  static ValidityMask fromFinite(const grid_map::Matrix& data);
+
+  /// Cells with finite values in the layer are valid.
+  static ValidityMask fromLayer(const grid_map::GridMap& map, const std::string& layer) { return fromFinite(map.get(layer)); }
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int wordsPerCol() const { return wordsPerCol_; }
+
+  bool isValid(int row, int col) const { return ((word(row / bitsPerWord, col) >> (row % bitsPerWord)) & Word{1}) != 0; }
+  void setValid(int row, int col, bool isValid);
+
+  /// Word wordId of column col.
+  Word word(int wordId, int col) const { return words_[col * wordsPerCol_ + wordId]; }
+  /// Word of column col, in which all bits that correspond to cells are set.
+  Word fullWord(int wordId) const;
+
+  /// Number of valid cells.
+  int count() const;
+  /// Number of valid cells in the rows [rowBegin, rowEnd) of column col.
+  int count(int col, int rowBegin, int rowEnd) const;
+
+  ValidityMask& operator&=(const ValidityMask& other);
+  ValidityMask& operator|=(const ValidityMask& other);
+  /// Mask in which invalid cells are valid and vice versa.
+  ValidityMask operator~() const;
+
+  /**
+   * A cell is valid if any cell in the kernelSize x kernelSize window is valid. As in processing::dilate, the window is shifted at the
+   * border to stay inside the map.
+   */
+  ValidityMask dilated(int kernelSize) const;
+
+  /// A cell is valid if all cells in the kernelSize x kernelSize window are valid. Window as in dilated.
+  ValidityMask eroded(int kernelSize) const;
+
+  /// Number of valid cells in the kernelSize x kernelSize window of each cell. Window as in dilated.
+  Eigen::MatrixXi windowCounts(int kernelSize) const;
+
+  /// Copy of data with nan in invalid cells.
+  grid_map::Matrix applyTo(const grid_map::Matrix& data) const;
+
+  /// Mask as matrix, 1 for valid and nan for invalid cells, as used by processing::dilate and processing::erode.
+  grid_map::Matrix toMatrix() const;
+
+ private:
+  Word& mutableWord(int wordId, int col) { return words_[col * wordsPerCol_ + wordId]; }
+
+  int rows_ = 0;
+  int cols_ = 0;
+  int wordsPerCol_ = 0;
+  std::vector<Word> words_;
+};
+
+inline ValidityMask operator&(ValidityMask lhs, const ValidityMask& rhs) {
+  return lhs &= rhs;
+}
+
+inline ValidityMask operator|(ValidityMask lhs, const ValidityMask& rhs) {
+  return lhs |= rhs;
+}
+
+}  // namespace mask
+}  // namespace grid_map
@@ -16,6 +16,7 @@ namespace inpainting {
 
 /**
  * @brief Inpaint missing data using min-value in neighborhood. The neighborhood search is performed along the contour of nan-patches.
+ * Runs in linear time in the number of cells, independent of the size of the nan-patches.
  * In-place operation (layerIn = layerOut) is NOT supported.
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
@@ -25,13 +26,26 @@ void minValues(grid_map::GridMap& map, const std::string& layerIn, const std::st
 
 /**
  * @brief Inpaint missing data using bi-linear interpolation. The neighborhood search is only performed along the column and the row of the
- * missing element. In-place operation (layerIn = layerOut) is NOT supported.
+ * missing element. The nearest valid neighbours are precomputed with one sweep per direction, such that the filter runs in linear time in
+ * the number of cells. Rows are processed in parallel. In-place operation (layerIn = layerOut) is NOT supported.
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
  * @param layerOut      output layer (filtered map is written into this layer)
  */
 void biLinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut);
 
+/**
+ * @brief Inpaint missing data with the harmonic interpolation of the surrounding data, i.e. the smoothest surface (solution of the Laplace
+ * equation) that passes through all finite cells. Non-finite cells are inpainted. Cells at the map border have no constraint on the slope
+ * across the border. Solved in float precision with multigrid cycles from a pull-push initial guess, the cost is linear in the number of
+ * cells regardless of the size of the nan-patches. In-place operation (layerIn = layerOut) is supported.
+ * @param map               grid map
+ * @param layerIn           reference layer (filter is applied wrt this layer)
+ * @param layerOut          output layer (filtered map is written into this layer)
+ * @param maxFillDistance   cells further than this distance [m] from the nearest valid cell remain nan. Negative values fill all cells.
+ */
+void harmonicInterpolation(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, double maxFillDistance = -1.0);
+
 /**
  * @brief nonlinear interpolation (open-cv function). In-place operation (layerIn = layerOut) is supported.
  * @param map           grid map
@@ -42,8 +56,11 @@ void biLinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, c
 void nonlinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, double inpaintRadius);
 
 /**
- * @brief Up- or down-sample elevation map (open-cv function). In-place operation only. Only the layer with name "layer" is resampled, while
- * all other layers (if there are any) are left untouched (exception if layer="all", which applies filter to all layers).
+ * @brief Up- or down-sample elevation map. In-place operation only. Only the layer with name "layer" is resampled, the geometry of the map
+ * changes for all layers, such that all other layers (if there are any) are cleared (exception if layer="all", which applies filter to
+ * all layers). When downsampling, each new cell is the average of the old cells it covers, weighted by the overlapping area. When
+ * upsampling, the old cells are interpolated bi-linearly. Nan values are left out of the averages and interpolations, new cells without
+ * any finite values in their area are nan. All layers are resampled at once, in parallel.
  * @param map         grid map
  * @param layer       resampling is done based in this layer. If "all", resamples all layers
  * @param newRes      new resolution.
@@ -8,9 +8,16 @@
 
 #pragma once
 
+// stl.
+#include <cstdint>
+#include <vector>
+
 // grid map.
 #include <grid_map_core/grid_map_core.hpp>
 
+// grid map filters rsl.
+#include <grid_map_filters_rsl/MaxPyramid.hpp>
+
 namespace grid_map {
 namespace lookup {
 
@@ -20,6 +27,12 @@ struct LookupResult {
   grid_map::Position position{0.0, 0.0};
 };
 
+/// Line between two points in a map, as used by the batched lookups.
+struct LookupSegment {
+  grid_map::Position start{0.0, 0.0};
+  grid_map::Position end{0.0, 0.0};
+};
+
 /**
  * Finds the maximum value between two points in a map
  *
@@ -27,11 +40,63 @@ struct LookupResult {
  * @param position2 : ending point of the lookup line.
  * @param gridMap : map object for map information.
  * @param data : map data to find the maximum in.
- * @return validity, value, and location of the maximum. A result is flagged as invalid if there are no finite values found.
+ * @return validity, value, and location of the maximum. A result is flagged as invalid if there are no finite values found. If the maximum
+ * is attained more than once, the location closest to position1.
  */
 LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
                                       const grid_map::GridMap& gridMap, const grid_map::Matrix& data);
 
+/**
+ * Finds the maximum value between two points in a map, with the same result as the lookup on the data the pyramid was built from. The
+ * pyramid bounds the maximum of runs of line cells, such that only the parts of the line that can contain the maximum are visited.
+ *
+ * @param position1 : starting point of the lookup line.
+ * @param position2 : ending point of the lookup line.
+ * @param gridMap : map object for map information.
+ * @param pyramid : max pyramid of the map data to find the maximum in.
+ * @return validity, value, and location of the maximum. If the maximum is attained more than once, the location closest to position1.
+ */
+LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
+                                      const grid_map::GridMap& gridMap, const MaxPyramid& pyramid);
+
+/**
+ * Checks whether all values between two points in a map are below a threshold, e.g. whether a segment is free of collisions. Runs of line
+ * cells are accepted with a coarse bound of the pyramid, and only refined where the bound reaches the threshold.
+ *
+ * @param position1 : starting point of the lookup line.
+ * @param position2 : ending point of the lookup line.
+ * @param gridMap : map object for map information.
+ * @param pyramid : max pyramid of the map data.
+ * @param threshold : values at or above the threshold fail the check.
+ * @return true if all finite values along the line are below the threshold. Lines without finite values pass.
+ */
+bool isMaxValueBelow(const grid_map::Position& position1, const grid_map::Position& position2, const grid_map::GridMap& gridMap,
+                     const MaxPyramid& pyramid, float threshold);
+
+/**
+ * Finds the maximum value along each segment, in parallel.
+ *
+ * @param segments : lookup lines.
+ * @param gridMap : map object for map information.
+ * @param pyramid : max pyramid of the map data to find the maxima in.
+ * @param results : result of maxValueBetweenLocations for each segment. Resized to the number of segments, such that a buffer that is
+ * reused between calls is not reallocated.
+ */
+void maxValuesBetweenLocations(const std::vector<LookupSegment>& segments, const grid_map::GridMap& gridMap, const MaxPyramid& pyramid,
+                               std::vector<LookupResult>& results);
+
+/**
+ * Checks for each segment whether all values along it are below a threshold, in parallel.
+ *
+ * @param segments : lookup lines.
+ * @param gridMap : map object for map information.
+ * @param pyramid : max pyramid of the map data.
+ * @param threshold : values at or above the threshold fail the check.
+ * @param isBelow : 1 if the segment passes isMaxValueBelow, 0 otherwise. Resized to the number of segments.
+ */
+void areMaxValuesBelow(const std::vector<LookupSegment>& segments, const grid_map::GridMap& gridMap, const MaxPyramid& pyramid,
+                       float threshold, std::vector<uint8_t>& isBelow);
+
 /**
  * Returns all values along a line between two points in a map
  *
@@ -44,6 +109,14 @@ LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const
 std::vector<grid_map::Position3> valuesBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
                                                         const grid_map::GridMap& gridMap, const grid_map::Matrix& data);
 
+/**
+ * Same as above, writing into a caller provided vector to avoid an allocation per lookup.
+ *
+ * @param lineValues : cleared and filled with all points generated by a line iteration.
+ */
+void valuesBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2, const grid_map::GridMap& gridMap,
+                            const grid_map::Matrix& data, std::vector<grid_map::Position3>& lineValues);
+
 /**
  * Project a point to inside the given gridmap with a specified margin
  *
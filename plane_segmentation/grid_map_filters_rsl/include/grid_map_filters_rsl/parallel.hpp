@@ -0,0 +1,35 @@
+/**
+ * @file        parallel.hpp
+ * @brief       Helpers to distribute the rows or columns of a layer over threads.
+ */
+
+#pragma once
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+
+// stl.
+#include <utility>
+
+namespace grid_map {
+namespace parallel {
+
+/**
+ * @brief Splits [begin, end) into contiguous ranges and calls rangeFunction(rangeBegin, rangeEnd) once per range, on the threads of
+ * ThreadPool::global(). The calling thread processes ranges too. Ranges never overlap, such that each range can write to its own part of a
+ * matrix. There are a few ranges per thread, which are balanced between the threads by work-stealing.
+ * @param begin           first index
+ * @param end             one past the last index
+ * @param rangeFunction   callable with signature void(int rangeBegin, int rangeEnd)
+ * @param minRangeSize    minimum number of indices per range, small problems are processed on the calling thread only.
+ *
+ * Nested calls, e.g. from a filter that is applied to tiles in parallel, process all indices on the calling thread, such that the number
+ * of threads does not multiply.
+ */
+template <typename RangeFunction>
+void forEachRange(int begin, int end, RangeFunction&& rangeFunction, int minRangeSize = 32) {
+  ThreadPool::global().parallelFor(begin, end, std::forward<RangeFunction>(rangeFunction), minRangeSize);
+}
+
+}  // namespace parallel
+}  // namespace grid_map
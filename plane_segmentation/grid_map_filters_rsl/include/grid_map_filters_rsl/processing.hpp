@@ -8,16 +8,29 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 // grid map.
 #include <grid_map_core/grid_map_core.hpp>
 
+// grid map filters rsl.
+#include <grid_map_filters_rsl/ValidityMask.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+
 namespace grid_map {
 namespace processing {
 
+/// Structuring element of the morphological filters.
+enum class KernelShape {
+  Square,  ///< kernelSize x kernelSize window. At the border, the window is shifted to stay inside the map.
+  Disk     ///< Disk with a radius of (kernelSize - 1) / 2 cells. At the border, the disk is clipped.
+};
+
 /**
- * @brief Replaces values by max in region. In-place operation (layerIn = layerOut) is NOT supported. Supports nan values.
+ * @brief Replaces values by max in region. In-place operation (layerIn = layerOut) is supported. Supports nan values.
+ * Runs in O(1) per cell with respect to the kernel size for the square kernel, and in O(kernelSize) for the disk.
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
  * @param layerOut      output layer (filtered map is written into this layer)
@@ -25,12 +38,14 @@ namespace processing {
  *                      applies unmasked dilation.
  * @param kernelSize    vicinity considered by filter (must be odd).
  * @param inpaint       if true, also replaces potential nan values by the maximum
+ * @param shape         structuring element
  */
 void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
-            bool inpaint = true);
+            bool inpaint = true, KernelShape shape = KernelShape::Square);
 
 /**
- * @brief Replaces values by min in region. In-place operation (layerIn = layerOut) is NOT supported. Supports nan values.
+ * @brief Replaces values by min in region. In-place operation (layerIn = layerOut) is supported. Supports nan values.
+ * Runs in O(1) per cell with respect to the kernel size for the square kernel, and in O(kernelSize) for the disk.
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
  * @param layerOut      output layer (filtered map is written into this layer)
@@ -38,13 +53,66 @@ void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::strin
  *                      applies unmasked dilation.
  * @param kernelSize    vicinity considered by filter (must be odd).
  * @param inpaint       if true, also replaces potential nan values by the minimum
+ * @param shape         structuring element
  */
 void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
-           bool inpaint = true);
+           bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+/**
+ * @brief Same as dilate above, with the cells considered by the filter given as bit-packed mask. Words of 64 cells that are all invalid or
+ * all valid are handled at once, and the values are not checked for nan.
+ * @param validity      cells considered by the filter, which must be finite in layerIn, e.g. mask::ValidityMask::fromLayer(map, layerIn)
+ *                      and the cells of the float mask above.
+ */
+void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+            int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+/// Same as erode above, with the cells considered by the filter given as bit-packed mask, as in dilate.
+void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+           int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+/// Same as dilate with an empty mask, on a matrix. Returns the dilated values.
+grid_map::Matrix dilate(const grid_map::Matrix& data, int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+/// Same as erode with an empty mask, on a matrix. Returns the eroded values.
+grid_map::Matrix erode(const grid_map::Matrix& data, int kernelSize, bool inpaint = true, KernelShape shape = KernelShape::Square);
+
+/**
+ * @brief Replaces values by the max of the values in region, lowered by a cone: max(H(q) - slope * |p - q|), where |p - q| is the
+ * Euclidean distance between the cells p and q in number of cells. The region is a kernelSize x kernelSize window, clipped at the border.
+ * In-place operation (layerIn = layerOut) is supported. Supports nan values, which are ignored. Cells without finite values in their
+ * region are nan.
+ * The window is decomposed into its columns, and the cones are reduced along the columns of the map for each column offset. For kernels
+ * of 101 cells and more, this uses the generalized distance transform in O(kernelSize * log(kernelSize)) per cell. Smaller kernels go
+ * through the window in O(kernelSize^2) per cell, which vectorizes and is faster than the transform for these sizes.
+ * @param map           grid map
+ * @param layerIn       reference layer (filter is applied wrt this layer)
+ * @param layerOut      output layer (filtered map is written into this layer)
+ * @param slope         height difference per cell [m / cell], must be non-negative.
+ * @param kernelSize    vicinity considered by filter (must be odd).
+ */
+void coneDilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, float slope, int kernelSize);
+
+/**
+ * @brief Replaces values by the min of the values in region, raised by a cone: min(H(q) + slope * |p - q|). Counterpart of coneDilate.
+ * In-place operation (layerIn = layerOut) is supported. Supports nan values, which are ignored.
+ * @param map           grid map
+ * @param layerIn       reference layer (filter is applied wrt this layer)
+ * @param layerOut      output layer (filtered map is written into this layer)
+ * @param slope         height difference per cell [m / cell], must be non-negative.
+ * @param kernelSize    vicinity considered by filter (must be odd).
+ */
+void coneErode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, float slope, int kernelSize);
+
+/// Same as coneDilate, on a matrix. Returns the dilated values.
+grid_map::Matrix coneDilate(const grid_map::Matrix& data, float slope, int kernelSize);
+
+/// Same as coneErode, on a matrix. Returns the eroded values.
+grid_map::Matrix coneErode(const grid_map::Matrix& data, float slope, int kernelSize);
 
 /**
- * @brief Extracts a thin layer of height values, surrounding patches of nan-values. In-place operation (layerIn = layerOut) is NOT
- * supported. Supports nan values.
+ * @brief Extracts a thin layer of height values, surrounding patches of nan-values: keeps the finite values with a non-finite value in
+ * their 3x3 window, all other cells are nan. In-place operation (layerIn = layerOut) is supported. Supports nan values.
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
  * @param layerOut      output layer (filtered map is written into this layer)
@@ -52,7 +120,15 @@ void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string
 void outline(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut);
 
 /**
- * @brief Replaces values by output of a function. In-place operation (layerIn = layerOut) is NOT supported. Supports nan values.
+ * @brief Same as above, with the validity of layerIn given, e.g. computed once with mask::ValidityMask::fromLayer and shared between
+ * filters. The outline is computed on the bit-packed mask, 64 cells at a time.
+ * @param validity      valid cells of layerIn
+ */
+void outline(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity);
+
+/**
+ * @brief Replaces values by output of a function. In-place operation (layerIn = layerOut) is supported. Supports nan values.
+ * func is called serially from the calling thread. Use the templated version below with inParallel = true for stateless functions.
  *
  * @param map           grid map
  * @param layerIn       reference layer (filter is applied wrt this layer)
@@ -62,5 +138,60 @@ void outline(grid_map::GridMap& map, const std::string& layerIn, const std::stri
 void applyKernelFunction(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize,
                          std::function<float(const Eigen::Ref<const grid_map::GridMap::Matrix>&)> func);
 
+/**
+ * @brief Function values of the kernelSize x kernelSize window around each cell, as applyKernelFunction on a map below. Returns the
+ * function values.
+ */
+template <typename KernelFunction>
+grid_map::Matrix applyKernelFunction(const grid_map::Matrix& H_in, int kernelSize, KernelFunction&& func, bool inParallel = false) {
+  grid_map::Matrix H_out(H_in.rows(), H_in.cols());
+
+  // Corner of the kernel window for each row and column index, shifted such that we don't overshoot.
+  const auto maxKernelId = (kernelSize - 1) / 2;
+  auto computeCornerIds = [&](int size) {
+    std::vector<int> cornerIds(size);
+    for (int id = 0; id < size; ++id) {
+      cornerIds[id] = std::min(std::max(id - maxKernelId, 0), size - kernelSize);
+    }
+    return cornerIds;
+  };
+  const std::vector<int> cornerRowIds = computeCornerIds(H_in.rows());
+  const std::vector<int> cornerColIds = computeCornerIds(H_in.cols());
+
+  auto applyInRange = [&](int colBegin, int colEnd) {
+    for (auto colId = colBegin; colId < colEnd; ++colId) {
+      for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
+        // Apply user defined function
+        H_out(rowId, colId) = func(H_in.block(cornerRowIds[rowId], cornerColIds[colId], kernelSize, kernelSize));
+      }
+    }
+  };
+  if (inParallel) {
+    parallel::forEachRange(0, static_cast<int>(H_in.cols()), applyInRange);
+  } else {
+    applyInRange(0, static_cast<int>(H_in.cols()));
+  }
+  return H_out;
+}
+
+/**
+ * @brief Replaces values by output of a function. In-place operation (layerIn = layerOut) is supported. Supports nan values.
+ * The function is inlined and receives the kernelSize x kernelSize window as a view into the layer, no values are copied. At the border,
+ * the window is shifted to stay inside the map.
+ *
+ * @param map           grid map
+ * @param layerIn       reference layer (filter is applied wrt this layer)
+ * @param layerOut      output layer (filtered map is written into this layer)
+ * @param kernelSize    vicinity considered by filter (must be odd and not larger than the map).
+ * @param func          callable with signature float(const Eigen::Block<const grid_map::Matrix>&)
+ * @param inParallel    if true, ranges of columns are processed in parallel, such that func must be safe to call concurrently.
+ *                      Otherwise func is called serially from the calling thread.
+ */
+template <typename KernelFunction>
+void applyKernelFunction(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize,
+                         KernelFunction&& func, bool inParallel = false) {
+  map.add(layerOut, applyKernelFunction(map.get(layerIn), kernelSize, std::forward<KernelFunction>(func), inParallel));
+}
+
 }  // namespace processing
 }  // namespace grid_map
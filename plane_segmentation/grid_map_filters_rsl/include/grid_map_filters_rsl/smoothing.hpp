@@ -11,11 +11,16 @@
 // grid map.
 #include <grid_map_core/grid_map_core.hpp>
 
+// grid map filters rsl.
+#include <grid_map_filters_rsl/ValidityMask.hpp>
+
 namespace grid_map {
 namespace smoothing {
 
 /**
- * @brief Sequential median filter (open-cv function). In-place operation (layerIn = layerOut) is supported.
+ * @brief Sequential median filter. In-place operation (layerIn = layerOut) is supported.
+ * If all kernel sizes are at most 5, the open-cv function is used. Otherwise, computes the exact median of the finite values in the
+ * window, which is clipped at the border. The mean of the two middle values is used for an even number of values. Nan cells remain nan.
  * @param map               grid map
  * @param layerIn           reference layer (filter is applied wrt this layer)
  * @param layerOut          output layer (filtered map is written into this layer)
@@ -26,6 +31,21 @@ namespace smoothing {
 void median(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize, int deltaKernelSize = 2,
             int numberOfRepeats = 1);
 
+/// Same as above, on a matrix. Returns the filtered values.
+grid_map::Matrix median(const grid_map::Matrix& data, int kernelSize, int deltaKernelSize = 2, int numberOfRepeats = 1);
+
+/**
+ * @brief Exact median of the valid values in the window, as the median above for kernel sizes larger than 5, for all kernel sizes. The
+ * valid values are collected from the bit-packed mask, which skips words of 64 invalid cells at once. Invalid cells are nan.
+ * @param validity      cells considered by the filter, which must be finite in layerIn, e.g. mask::ValidityMask::fromLayer(map, layerIn)
+ */
+void median(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+            int kernelSize, int deltaKernelSize = 2, int numberOfRepeats = 1);
+
+/// Same as above, on a matrix. Returns the filtered values.
+grid_map::Matrix median(const grid_map::Matrix& data, const mask::ValidityMask& validity, int kernelSize, int deltaKernelSize = 2,
+                        int numberOfRepeats = 1);
+
 /**
  * @brief Sequential box blur filter (open cv-function). In-place operation (layerIn = layerOut) is supported.
  * @param map               grid map
@@ -9,12 +9,128 @@
 
 // grid map filters rsl.
 #include <grid_map_filters_rsl/GridMapDerivative.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+
+// stl.
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace grid_map {
 namespace derivative {
+
+namespace {
+
+/// Value of the neighbour of cell (rowId, colId) at offset along dimension dim (0: rows, 1: columns), nan outside of the map.
+float neighbourValue(const grid_map::Matrix& H, int rowId, int colId, int dim, int offset) {
+  const int neighbourRowId = rowId + (dim == 0 ? offset : 0);
+  const int neighbourColId = colId + (dim == 1 ? offset : 0);
+  if (neighbourRowId < 0 || neighbourRowId >= H.rows() || neighbourColId < 0 || neighbourColId >= H.cols()) {
+    return NAN;
+  }
+  return H(neighbourRowId, neighbourColId);
+}
+
+/**
+ * Applies the 5-point kernel along dimension dim (0: x / rows, 1: y / columns) to all cells, as one vectorized expression per column. Close
+ * to the border, the kernel is shifted inwards as in GridMapDerivative::getKernelCenter, i.e. the cell takes the value of the closest cell
+ * at which the kernel fits. Nan values are propagated. All cells are nan if the kernel does not fit into the map.
+ */
+grid_map::Matrix applyKernel(const grid_map::Matrix& H, const Eigen::Matrix<float, 5, 1>& kernel, int dim) {
+  constexpr int kernelSize = 5;
+  constexpr int maxKernelId = 2;
+  const int numRows = H.rows();
+  const int numCols = H.cols();
+  grid_map::Matrix result(numRows, numCols);
+  if ((dim == 0 ? numRows : numCols) < kernelSize) {
+    result.setConstant(NAN);
+    return result;
+  }
+
+  parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      if (dim == 0) {
+        const int n = numRows - kernelSize + 1;
+        const auto column = H.col(colId);
+        result.col(colId).segment(maxKernelId, n) = kernel(0) * column.segment(0, n) + kernel(1) * column.segment(1, n) +
+                                                    kernel(2) * column.segment(2, n) + kernel(3) * column.segment(3, n) +
+                                                    kernel(4) * column.segment(4, n);
+        result.col(colId).head(maxKernelId).setConstant(result(maxKernelId, colId));
+        result.col(colId).tail(maxKernelId).setConstant(result(numRows - maxKernelId - 1, colId));
+      } else {
+        const int firstColId = std::min(std::max(colId, maxKernelId), numCols - maxKernelId - 1) - maxKernelId;
+        result.col(colId) = kernel(0) * H.col(firstColId) + kernel(1) * H.col(firstColId + 1) + kernel(2) * H.col(firstColId + 2) +
+                            kernel(3) * H.col(firstColId + 3) + kernel(4) * H.col(firstColId + 4);
+      }
+    }
+  });
+  return result;
+}
+
+/**
+ * Sets the derivative of non-finite cells of H to nan. Where the derivative is nan at finite cells, i.e. the kernel reached a nan value,
+ * uses the short kernel of the direct neighbours around the cell. If this is nan as well and oneSidedScale is non-zero, uses the
+ * one-sided difference oneSidedScale * (H(previous) - H(cell)), or oneSidedScale * (H(cell) - H(next)).
+ */
+void fixNaNNeighbourhoods(const grid_map::Matrix& H, grid_map::Matrix& derivative, int dim, const Eigen::Matrix<float, 3, 1>& shortKernel,
+                          float oneSidedScale) {
+  const int numRows = H.rows();
+  const int numCols = H.cols();
+  parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+    Eigen::VectorXf shortResult(numRows);
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      auto result = derivative.col(colId).array();
+      if (!result.isNaN().any()) {
+        continue;
+      }
+
+      // Short kernel around the cell, nan at the border.
+      shortResult.setConstant(NAN);
+      if (dim == 0 && numRows >= 3) {
+        const auto column = H.col(colId);
+        shortResult.segment(1, numRows - 2) = shortKernel(0) * column.segment(0, numRows - 2) +
+                                              shortKernel(1) * column.segment(1, numRows - 2) +
+                                              shortKernel(2) * column.segment(2, numRows - 2);
+      } else if (dim == 1 && colId > 0 && colId < numCols - 1) {
+        shortResult = shortKernel(0) * H.col(colId - 1) + shortKernel(1) * H.col(colId) + shortKernel(2) * H.col(colId + 1);
+      }
+      result = result.isNaN().select(shortResult.array(), result);
+      result = H.col(colId).array().isFinite().select(result, NAN);
+
+      // One-sided differences, only at the few cells with a nan-neighbour on both sides.
+      if (oneSidedScale == 0.0F || !(result.isNaN() && H.col(colId).array().isFinite()).any()) {
+        continue;
+      }
+      for (int rowId = 0; rowId < numRows; ++rowId) {
+        const float value = H(rowId, colId);
+        if (std::isnan(result(rowId)) && std::isfinite(value)) {
+          const float previous = neighbourValue(H, rowId, colId, dim, -1);
+          const float next = neighbourValue(H, rowId, colId, dim, 1);
+          if (std::isfinite(previous)) {
+            result(rowId) = oneSidedScale * (previous - value);
+          } else if (std::isfinite(next)) {
+            result(rowId) = oneSidedScale * (value - next);
+          }
+        }
+      }
+    }
+  });
+}
+
+/// Moves the values into the layer, which is added if missing.
+void setLayer(grid_map::GridMap& gridMap, const std::string& layer, grid_map::Matrix&& values) {
+  if (!gridMap.exists(layer)) {
+    gridMap.add(layer);
+  }
+  gridMap.get(layer) = std::move(values);
+}
+
+}  // namespace
+
 constexpr int GridMapDerivative::kernelSize_;
 
-GridMapDerivative::GridMapDerivative() : kernelD1_(Kernel::Zero()), kernelD2_(Kernel::Zero()) {}
+GridMapDerivative::GridMapDerivative()
+    : kernelD1_(Kernel::Zero()), kernelD2_(Kernel::Zero()), shortKernelD1_(ShortKernel::Zero()), shortKernelD2_(ShortKernel::Zero()) {}
 
 bool GridMapDerivative::initialize(float res) {
   // Central finite difference: https://en.wikipedia.org/wiki/Finite_difference_coefficient
@@ -22,6 +138,10 @@ bool GridMapDerivative::initialize(float res) {
   kernelD2_ << -1.0 / 12.0, 4.0 / 3.0, -5.0 / 2.0, 4.0 / 3.0, -1.0 / 12.0;
   kernelD1_ /= res;
   kernelD2_ /= (res * res);
+  shortKernelD1_ << 1.0 / 2.0, 0.0, -1.0 / 2.0;
+  shortKernelD2_ << 1.0, -2.0, 1.0;
+  shortKernelD1_ /= res;
+  shortKernelD2_ /= (res * res);
   return res > 0.0;
 }
 
@@ -62,6 +182,56 @@ void GridMapDerivative::estimateGradientAndCurvature(const grid_map::GridMap& gr
   curvature(1U, 0U) = curvature(0U, 1U);
 }
 
+void GridMapDerivative::computeDerivativeLayers(grid_map::GridMap& gridMap, const std::string& layer,
+                                                const DerivativeLayers& outputLayers) const {
+  const grid_map::Matrix& H = gridMap.get(layer);
+
+  // The kernels have the sign of the world frame, the one-sided differences take the same sign.
+  const float oneSidedScale = 2.0F * shortKernelD1_(0);
+  auto derivative = [&](const grid_map::Matrix& values, const Kernel& kernel, const ShortKernel& shortKernel, float scale, int dim) {
+    grid_map::Matrix result = applyKernel(values, kernel, dim);
+    fixNaNNeighbourhoods(values, result, dim, shortKernel, scale);
+    return result;
+  };
+
+  const bool needsGradientX = !outputLayers.gradientX.empty() || !outputLayers.slope.empty() || !outputLayers.curvatureXY.empty();
+  const bool needsGradientY = !outputLayers.gradientY.empty() || !outputLayers.slope.empty();
+  grid_map::Matrix gradientX = needsGradientX ? derivative(H, kernelD1_, shortKernelD1_, oneSidedScale, 0) : grid_map::Matrix();
+  grid_map::Matrix gradientY = needsGradientY ? derivative(H, kernelD1_, shortKernelD1_, oneSidedScale, 1) : grid_map::Matrix();
+  grid_map::Matrix curvatureXX;
+  grid_map::Matrix curvatureXY;
+  grid_map::Matrix curvatureYY;
+  if (!outputLayers.curvatureXX.empty()) {
+    curvatureXX = derivative(H, kernelD2_, shortKernelD2_, 0.0F, 0);
+  }
+  if (!outputLayers.curvatureYY.empty()) {
+    curvatureYY = derivative(H, kernelD2_, shortKernelD2_, 0.0F, 1);
+  }
+  if (!outputLayers.curvatureXY.empty()) {
+    curvatureXY = derivative(gradientX, kernelD1_, shortKernelD1_, oneSidedScale, 1);
+  }
+
+  // The input layer is not used anymore, it may be overwritten.
+  if (!outputLayers.slope.empty()) {
+    setLayer(gridMap, outputLayers.slope, (gradientX.array().square() + gradientY.array().square()).sqrt().matrix());
+  }
+  if (!outputLayers.gradientX.empty()) {
+    setLayer(gridMap, outputLayers.gradientX, std::move(gradientX));
+  }
+  if (!outputLayers.gradientY.empty()) {
+    setLayer(gridMap, outputLayers.gradientY, std::move(gradientY));
+  }
+  if (!outputLayers.curvatureXX.empty()) {
+    setLayer(gridMap, outputLayers.curvatureXX, std::move(curvatureXX));
+  }
+  if (!outputLayers.curvatureXY.empty()) {
+    setLayer(gridMap, outputLayers.curvatureXY, std::move(curvatureXY));
+  }
+  if (!outputLayers.curvatureYY.empty()) {
+    setLayer(gridMap, outputLayers.curvatureYY, std::move(curvatureYY));
+  }
+}
+
 Eigen::Vector2i GridMapDerivative::getKernelCenter(const grid_map::GridMap& gridMap, const grid_map::Index& centerIndex, int maxKernelId) {
   constexpr auto minId = 0;
   Eigen::Vector2i centerId;
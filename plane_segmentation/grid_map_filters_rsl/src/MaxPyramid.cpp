@@ -0,0 +1,70 @@
+/**
+ * @file        MaxPyramid.cpp
+ * @brief       Pyramid of block maxima of a layer, for fast bounds on the maximum along lines.
+ */
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/MaxPyramid.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+
+// stl.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace grid_map {
+namespace lookup {
+
+MaxPyramid::MaxPyramid(const grid_map::GridMap& gridMap, const grid_map::Matrix& data) {
+  if (!gridMap.isDefaultStartIndex()) {
+    throw std::invalid_argument("MaxPyramid: the map must have the default start index.");
+  }
+  if (data.size() == 0) {
+    throw std::invalid_argument("MaxPyramid: the map must not be empty.");
+  }
+
+  constexpr float lowest = std::numeric_limits<float>::lowest();
+  levels_.push_back(data.unaryExpr([](float value) { return std::isfinite(value) ? value : lowest; }));
+  while (levels_.back().size() > 1) {
+    const grid_map::Matrix& fine = levels_.back();
+    const int numRows = (fine.rows() + 1) / 2;
+    const int numCols = (fine.cols() + 1) / 2;
+    grid_map::Matrix coarse(numRows, numCols);
+    parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+      for (int colId = colBegin; colId < colEnd; ++colId) {
+        const int fineColId = 2 * colId;
+        const int lastFineColId = std::min(fineColId + 1, static_cast<int>(fine.cols()) - 1);
+        for (int rowId = 0; rowId < numRows; ++rowId) {
+          const int fineRowId = 2 * rowId;
+          const int lastFineRowId = std::min(fineRowId + 1, static_cast<int>(fine.rows()) - 1);
+          coarse(rowId, colId) = std::max(std::max(fine(fineRowId, fineColId), fine(lastFineRowId, fineColId)),
+                                          std::max(fine(fineRowId, lastFineColId), fine(lastFineRowId, lastFineColId)));
+        }
+      }
+    });
+    levels_.push_back(std::move(coarse));
+  }
+}
+
+float MaxPyramid::upperBoundInBox(const grid_map::Index& corner1, const grid_map::Index& corner2) const {
+  const grid_map::Index minIndex = corner1.min(corner2);
+  const grid_map::Index maxIndex = corner1.max(corner2);
+
+  // Finest level at which the box touches at most two blocks in each direction.
+  int levelId = 0;
+  while ((maxIndex.x() >> levelId) - (minIndex.x() >> levelId) > 1 || (maxIndex.y() >> levelId) - (minIndex.y() >> levelId) > 1) {
+    ++levelId;
+  }
+
+  const grid_map::Matrix& blocks = levels_[levelId];
+  const int firstRowId = minIndex.x() >> levelId;
+  const int lastRowId = maxIndex.x() >> levelId;
+  const int firstColId = minIndex.y() >> levelId;
+  const int lastColId = maxIndex.y() >> levelId;
+  return std::max(std::max(blocks(firstRowId, firstColId), blocks(lastRowId, firstColId)),
+                  std::max(blocks(firstRowId, lastColId), blocks(lastRowId, lastColId)));
+}
+
+}  // namespace lookup
+}  // namespace grid_map
@@ -0,0 +1,311 @@
+/**
+ * @file        ThreadPool.cpp
+ * @brief       Thread pool that is shared by the plane segmentation packages, with a work-stealing parallel for.
+ */
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+
+// stl.
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace grid_map {
+namespace parallel {
+
+namespace {
+
+/// Chunks per thread, such that threads that finish early can steal work.
+constexpr int chunksPerThread = 4;
+
+bool& isInParallelForFlag() {
+  static thread_local bool isInLoop = false;
+  return isInLoop;
+}
+
+int64_t nowInNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t packChunks(int front, int back) {
+  return (static_cast<uint64_t>(front) << 32) | static_cast<uint32_t>(back);
+}
+
+int frontChunk(uint64_t frontAndBack) {
+  return static_cast<int>(frontAndBack >> 32);
+}
+
+int backChunk(uint64_t frontAndBack) {
+  return static_cast<int>(frontAndBack & 0xFFFFFFFF);
+}
+
+const ThreadPoolSettings& checkSettings(const ThreadPoolSettings& settings) {
+  if (settings.numThreads < 0) {
+    throw std::invalid_argument("ThreadPool: the number of threads must not be negative.");
+  }
+  for (int cpu : settings.cpuAffinity) {
+    if (cpu < 0) {
+      throw std::invalid_argument("ThreadPool: cpu ids must not be negative.");
+    }
+  }
+  return settings;
+}
+
+void pinToCpu(std::thread& thread, int cpu) {
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(cpu, &cpuSet);
+  const int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+  if (error != 0) {
+    throw std::runtime_error("ThreadPool: could not pin a worker to cpu " + std::to_string(cpu) + ", error " + std::to_string(error) + ".");
+  }
+#else
+  (void)thread;
+  (void)cpu;
+#endif
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolSettings& settings) : settings_(checkSettings(settings)) {
+  startWorkers();
+  resetStatistics();
+}
+
+ThreadPool::~ThreadPool() {
+  stopWorkers();
+}
+
+ThreadPool& ThreadPool::global() {
+  static ThreadPool pool;
+  return pool;
+}
+
+bool ThreadPool::isInParallelFor() {
+  return isInParallelForFlag();
+}
+
+void ThreadPool::configure(const ThreadPoolSettings& settings) {
+  if (isInParallelFor()) {
+    throw std::runtime_error("ThreadPool: cannot be configured from within a loop.");
+  }
+  checkSettings(settings);
+
+  std::lock_guard<std::mutex> loopLock(loopMutex_);
+  stopWorkers();
+  settings_ = settings;
+  startWorkers();
+  resetStatistics();
+}
+
+void ThreadPool::startWorkers() {
+  int numThreads = 1;
+  if (!settings_.deterministic) {
+    if (settings_.numThreads > 0) {
+      numThreads = settings_.numThreads;
+    } else if (!settings_.cpuAffinity.empty()) {
+      numThreads = static_cast<int>(settings_.cpuAffinity.size());
+    } else {
+      numThreads = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    }
+  }
+
+  numThreads_ = numThreads;
+  queues_.reset(new ChunkQueue[numThreads]);
+  // loopId_ keeps counting across configure(), new workers must only wait for loops published after now.
+  uint64_t loopId;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+    loopId = loopId_;
+  }
+  workers_.reserve(numThreads - 1);
+  for (int threadId = 1; threadId < numThreads; ++threadId) {
+    workers_.emplace_back(&ThreadPool::workerLoop, this, threadId, loopId);
+    if (!settings_.cpuAffinity.empty()) {
+      pinToCpu(workers_.back(), settings_.cpuAffinity[(threadId - 1) % settings_.cpuAffinity.size()]);
+    }
+  }
+}
+
+void ThreadPool::stopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  startCondition_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void ThreadPool::workerLoop(int threadId, uint64_t firstLoopId) {
+  isInParallelForFlag() = true;
+  uint64_t lastLoopId = firstLoopId;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      startCondition_.wait(lock, [&]() { return stop_ || loopId_ != lastLoopId; });
+      if (stop_) {
+        return;
+      }
+      lastLoopId = loopId_;
+    }
+    runChunks(threadId);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--numRunningWorkers_ == 0) {
+        doneCondition_.notify_one();
+      }
+    }
+  }
+}
+
+void ThreadPool::run(int begin, int end, int minRangeSize, RangeCallback callback, void* function) {
+  const int numIndices = end - begin;
+  if (numIndices <= 0) {
+    return;
+  }
+  if (isInParallelFor()) {
+    callback(function, begin, end);
+    return;
+  }
+
+  std::unique_lock<std::mutex> loopLock(loopMutex_, std::try_to_lock);
+  const int maxNumChunks = numThreads() * chunksPerThread;
+  const int numChunks = std::max(1, std::min(maxNumChunks, numIndices / std::max(1, minRangeSize)));
+  const int64_t startNs = nowInNanoseconds();
+  if (!loopLock.owns_lock() || numChunks == 1 || numThreads() == 1) {
+    isInParallelForFlag() = true;
+    try {
+      callback(function, begin, end);
+    } catch (...) {
+      isInParallelForFlag() = false;
+      throw;
+    }
+    isInParallelForFlag() = false;
+    busyNs_ += nowInNanoseconds() - startNs;
+    ++numLoops_;
+    ++numChunksTotal_;
+    return;
+  }
+
+  // Each thread starts with consecutive chunks, the calling thread with the first ones.
+  loopBegin_ = begin;
+  loopSize_ = numIndices;
+  numChunks_ = numChunks;
+  callback_ = callback;
+  function_ = function;
+  exception_ = nullptr;
+  const int numLoopThreads = numThreads();
+  for (int threadId = 0; threadId < numLoopThreads; ++threadId) {
+    queues_[threadId].frontAndBack = packChunks(threadId * numChunks / numLoopThreads, (threadId + 1) * numChunks / numLoopThreads);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    numRunningWorkers_ = static_cast<int>(workers_.size());
+    ++loopId_;
+  }
+  startCondition_.notify_all();
+
+  isInParallelForFlag() = true;
+  runChunks(0);
+  isInParallelForFlag() = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCondition_.wait(lock, [&]() { return numRunningWorkers_ == 0; });
+  }
+  ++numLoops_;
+  numChunksTotal_ += numChunks;
+
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+}
+
+void ThreadPool::runChunks(int threadId) {
+  const int64_t startNs = nowInNanoseconds();
+  const int numLoopThreads = numThreads();
+  auto runChunk = [&](int chunkId) {
+    try {
+      callback_(function_, chunkBegin(chunkId), chunkBegin(chunkId + 1));
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exceptionMutex_);
+      if (!exception_) {
+        exception_ = std::current_exception();
+      }
+    }
+  };
+
+  for (int chunkId = popFront(threadId); chunkId >= 0; chunkId = popFront(threadId)) {
+    runChunk(chunkId);
+  }
+  // Steal from the other threads, starting with the next one.
+  for (int offset = 1; offset < numLoopThreads; ++offset) {
+    const int victimId = (threadId + offset) % numLoopThreads;
+    for (int chunkId = popBack(victimId); chunkId >= 0; chunkId = popBack(victimId)) {
+      ++numStolenChunks_;
+      runChunk(chunkId);
+    }
+  }
+  busyNs_ += nowInNanoseconds() - startNs;
+}
+
+int ThreadPool::popFront(int threadId) {
+  auto& frontAndBack = queues_[threadId].frontAndBack;
+  uint64_t chunks = frontAndBack.load();
+  while (frontChunk(chunks) < backChunk(chunks)) {
+    if (frontAndBack.compare_exchange_weak(chunks, packChunks(frontChunk(chunks) + 1, backChunk(chunks)))) {
+      return frontChunk(chunks);
+    }
+  }
+  return -1;
+}
+
+int ThreadPool::popBack(int threadId) {
+  auto& frontAndBack = queues_[threadId].frontAndBack;
+  uint64_t chunks = frontAndBack.load();
+  while (frontChunk(chunks) < backChunk(chunks)) {
+    if (frontAndBack.compare_exchange_weak(chunks, packChunks(frontChunk(chunks), backChunk(chunks) - 1))) {
+      return backChunk(chunks) - 1;
+    }
+  }
+  return -1;
+}
+
+int ThreadPool::chunkBegin(int chunkId) const {
+  return loopBegin_ + static_cast<int>((static_cast<int64_t>(loopSize_) * chunkId) / numChunks_);
+}
+
+ThreadPoolStatistics ThreadPool::statistics() const {
+  ThreadPoolStatistics statistics;
+  statistics.numThreads = numThreads();
+  statistics.elapsedSeconds = 1e-9 * static_cast<double>(nowInNanoseconds() - statisticsStartNs_);
+  statistics.busySeconds = 1e-9 * static_cast<double>(busyNs_);
+  if (statistics.elapsedSeconds > 0.0) {
+    statistics.utilization = std::min(1.0, statistics.busySeconds / (statistics.numThreads * statistics.elapsedSeconds));
+  }
+  statistics.numLoops = numLoops_;
+  statistics.numChunks = numChunksTotal_;
+  statistics.numStolenChunks = numStolenChunks_;
+  return statistics;
+}
+
+void ThreadPool::resetStatistics() {
+  statisticsStartNs_ = nowInNanoseconds();
+  busyNs_ = 0;
+  numLoops_ = 0;
+  numChunksTotal_ = 0;
+  numStolenChunks_ = 0;
+}
+
+}  // namespace parallel
+}  // namespace grid_map
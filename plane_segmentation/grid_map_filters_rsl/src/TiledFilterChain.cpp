@@ -0,0 +1,135 @@
+/**
+ * @file        TiledFilterChain.cpp
+ * @brief       Applies a chain of filters tile by tile, such that intermediate results stay in small buffers.
+ */
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/TiledFilterChain.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+#include <grid_map_filters_rsl/smoothing.hpp>
+
+// stl.
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace grid_map {
+namespace processing {
+
+namespace {
+
+/**
+ * Range of rows or columns that contains the windows of all cells in [begin, end). Windows of kernelSize cells start (kernelSize - 1) / 2
+ * cells before their cell. If they are shifted at the border, the first and last window reach up to kernelSize cells into the map.
+ */
+std::pair<int, int> windowRange(int begin, int end, int kernelSize, int size) {
+  const int numCellsBefore = (kernelSize - 1) / 2;
+  const int numCellsAfter = kernelSize - 1 - numCellsBefore;
+  return {std::max(0, std::min(begin - numCellsBefore, size - kernelSize)), std::min(size, std::max(end + numCellsAfter, kernelSize))};
+}
+
+TileRegion windowRegion(const TileRegion& region, int kernelSize, const grid_map::Size& size) {
+  const auto rows = windowRange(region.topLeftIndex.x(), region.topLeftIndex.x() + region.size.x(), kernelSize, size.x());
+  const auto cols = windowRange(region.topLeftIndex.y(), region.topLeftIndex.y() + region.size.y(), kernelSize, size.y());
+  return {grid_map::Index(rows.first, cols.first), grid_map::Size(rows.second - rows.first, cols.second - cols.first)};
+}
+
+}  // namespace
+
+TiledFilterChain::TiledFilterChain(int tileSize) : tileSize_(tileSize) {
+  if (tileSize_ < 1) {
+    throw std::invalid_argument("TiledFilterChain: the tile size must be positive.");
+  }
+}
+
+TiledFilterChain& TiledFilterChain::addFilter(int kernelSize, TileFilter filter) {
+  if (kernelSize < 1) {
+    throw std::invalid_argument("TiledFilterChain: the kernel size must be positive.");
+  }
+  filters_.push_back({kernelSize, std::move(filter)});
+  return *this;
+}
+
+TiledFilterChain& TiledFilterChain::addMedian(int kernelSize, int deltaKernelSize, int numberOfRepeats) {
+  // The repetitions are one filter, since open-cv is used depending on the largest kernel size.
+  int totalKernelSize = 1;
+  for (int iter = 0; iter < numberOfRepeats; ++iter) {
+    totalKernelSize += kernelSize + iter * deltaKernelSize - 1;
+  }
+  return addFilter(totalKernelSize, [=](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+    return smoothing::median(tile, kernelSize, deltaKernelSize, numberOfRepeats);
+  });
+}
+
+TiledFilterChain& TiledFilterChain::addDilation(int kernelSize, bool inpaint, KernelShape shape) {
+  return addFilter(kernelSize, [=](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+    return dilate(tile, kernelSize, inpaint, shape);
+  });
+}
+
+TiledFilterChain& TiledFilterChain::addErosion(int kernelSize, bool inpaint, KernelShape shape) {
+  return addFilter(kernelSize, [=](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+    return erode(tile, kernelSize, inpaint, shape);
+  });
+}
+
+TiledFilterChain& TiledFilterChain::addConeDilation(float slope, int kernelSize) {
+  return addFilter(kernelSize, [=](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+    return coneDilate(tile, slope, kernelSize);
+  });
+}
+
+TiledFilterChain& TiledFilterChain::addConeErosion(float slope, int kernelSize) {
+  return addFilter(kernelSize, [=](const grid_map::Matrix& tile, const TileRegion& /*region*/) {
+    return coneErode(tile, slope, kernelSize);
+  });
+}
+
+grid_map::Matrix TiledFilterChain::apply(const grid_map::Matrix& data) const {
+  if (filters_.empty()) {
+    return data;
+  }
+
+  const grid_map::Size size(data.rows(), data.cols());
+  const int numTileRows = (size.x() + tileSize_ - 1) / tileSize_;
+  const int numTileCols = (size.y() + tileSize_ - 1) / tileSize_;
+  grid_map::Matrix result(size.x(), size.y());
+
+  parallel::forEachRange(
+      0, numTileRows * numTileCols,
+      [&](int tileBegin, int tileEnd) {
+        // regions[i] is the input of filter i, the last region is the tile of the result.
+        std::vector<TileRegion> regions(filters_.size() + 1);
+        grid_map::Matrix buffer;
+        for (int tileId = tileBegin; tileId < tileEnd; ++tileId) {
+          // Column-major, such that consecutive tiles share the halo columns.
+          const grid_map::Index topLeftIndex((tileId % numTileRows) * tileSize_, (tileId / numTileRows) * tileSize_);
+          regions.back() = {topLeftIndex, (size - topLeftIndex).min(tileSize_)};
+          for (int filterId = numFilters() - 1; filterId >= 0; --filterId) {
+            regions[filterId] = windowRegion(regions[filterId + 1], filters_[filterId].kernelSize, size);
+          }
+
+          buffer = data.block(regions[0].topLeftIndex.x(), regions[0].topLeftIndex.y(), regions[0].size.x(), regions[0].size.y());
+          for (int filterId = 0; filterId < numFilters(); ++filterId) {
+            grid_map::Matrix filtered = filters_[filterId].filter(buffer, regions[filterId]);
+            const TileRegion& nextRegion = regions[filterId + 1];
+            if ((nextRegion.size == regions[filterId].size).all()) {
+              buffer = std::move(filtered);
+            } else {
+              const grid_map::Index offset = nextRegion.topLeftIndex - regions[filterId].topLeftIndex;
+              buffer = filtered.block(offset.x(), offset.y(), nextRegion.size.x(), nextRegion.size.y());
+            }
+          }
+          result.block(topLeftIndex.x(), topLeftIndex.y(), buffer.rows(), buffer.cols()) = buffer;
+        }
+      },
+      1);
+  return result;
+}
+
+void TiledFilterChain::apply(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut) const {
+  map.add(layerOut, apply(map.get(layerIn)));
+}
+
+}  // namespace processing
+}  // namespace grid_map
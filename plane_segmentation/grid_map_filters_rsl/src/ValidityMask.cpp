@@ -0,0 +1,322 @@
+/**
+ * @file        ValidityMask.cpp
+ * @brief       Bit-packed mask of valid cells of a grid map layer.
+ */
+
+// grid map filters rsl.
+#include <grid_map_filters_rsl/ValidityMask.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+
+// stl.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace grid_map {
+namespace mask {
+
+namespace {
+
+using Word = ValidityMask::Word;
+constexpr int bitsPerWord = ValidityMask::bitsPerWord;
+
+/// Word with the lowest numBits bits set.
+Word lowBits(int numBits) {
+  return numBits >= bitsPerWord ? ~Word{0} : (Word{1} << numBits) - Word{1};
+}
+
+/// Packs 64 flags of value 0 or 1 into a word, flag i into bit i. Each multiplication gathers 8 flags (little endian).
+Word packFlags(const uint8_t* flags) {
+  Word bits = 0;
+  for (int byte = 0; byte < 8; ++byte) {
+    uint64_t eightFlags;
+    std::memcpy(&eightFlags, flags + 8 * byte, sizeof(eightFlags));
+    bits |= ((eightFlags * 0x0102040810204080ULL) >> 56) << (8 * byte);
+  }
+  return bits;
+}
+
+/// Inverse of packFlags.
+void unpackFlags(Word bits, uint8_t* flags) {
+  for (int byte = 0; byte < 8; ++byte) {
+    // Byte i of spread is nonzero if bit i is set, adding 0x7f moves this into the highest bit of the byte.
+    const uint64_t spread = (((bits >> (8 * byte)) & 0xFFULL) * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    const uint64_t eightFlags = ((spread + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+    std::memcpy(flags + 8 * byte, &eightFlags, sizeof(eightFlags));
+  }
+}
+
+/// value if isValid is 1, nan if it is 0. Selects the bits without branching, such that the loops over the cells are vectorized.
+float selectValid(float value, uint8_t isValid) {
+  constexpr uint32_t nanBits = 0x7FC00000U;
+  uint32_t valueBits;
+  std::memcpy(&valueBits, &value, sizeof(value));
+  const uint32_t keep = 0U - static_cast<uint32_t>(isValid);
+  const uint32_t resultBits = (valueBits & keep) | (nanBits & ~keep);
+  float result;
+  std::memcpy(&result, &resultBits, sizeof(result));
+  return result;
+}
+
+/// Bit r of the result is bit r - shift of the column, shift can be negative. Cells shifted in from outside the column are zero.
+Word shiftedWord(const Word* column, int numWords, int wordId, int shift) {
+  const int wordShift = shift >= 0 ? shift / bitsPerWord : -((-shift + bitsPerWord - 1) / bitsPerWord);
+  const int bitShift = shift - wordShift * bitsPerWord;  // in [0, 64)
+  const int upperSource = wordId - wordShift;            // word providing the upper bits of the result
+  const int lowerSource = upperSource - 1;               // word providing the lower bits of the result
+  Word result = 0;
+  if (upperSource >= 0 && upperSource < numWords) {
+    result |= column[upperSource] << bitShift;
+  }
+  if (bitShift > 0 && lowerSource >= 0 && lowerSource < numWords) {
+    result |= column[lowerSource] >> (bitsPerWord - bitShift);
+  }
+  return result;
+}
+
+/// Start of the kernelSize window of cell id in [0, size). The window is shifted at the border to stay inside [0, size).
+int windowStart(int id, int kernelSize, int size) {
+  return std::min(std::max(id - (kernelSize - 1) / 2, 0), size - kernelSize);
+}
+
+}  // namespace
+
+constexpr int ValidityMask::bitsPerWord;
+
+ValidityMask::ValidityMask(int rows, int cols, bool isValid)
+    : rows_(rows), cols_(cols), wordsPerCol_((rows + bitsPerWord - 1) / bitsPerWord), words_(wordsPerCol_ * cols, Word{0}) {
+  if (rows < 0 || cols < 0) {
+    throw std::invalid_argument("ValidityMask: size must not be negative.");
+  }
+  if (isValid) {
+    for (int col = 0; col < cols_; ++col) {
+      for (int wordId = 0; wordId < wordsPerCol_; ++wordId) {
+        mutableWord(wordId, col) = fullWord(wordId);
+      }
+    }
+  }
+}
+
+ValidityMask ValidityMask::fromFinite(const grid_map::Matrix& data) {
+  ValidityMask mask(data.rows(), data.cols());
+  parallel::forEachRange(0, mask.cols_, [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      const float* values = data.col(col).data();
+      for (int wordId = 0; wordId < mask.wordsPerCol_; ++wordId) {
+        const int rowBegin = wordId * bitsPerWord;
+        const int numBits = std::min(bitsPerWord, mask.rows_ - rowBegin);
+        uint8_t isFinite[bitsPerWord] = {};
+        for (int bit = 0; bit < numBits; ++bit) {
+          isFinite[bit] = static_cast<uint8_t>(std::abs(values[rowBegin + bit]) <= std::numeric_limits<float>::max());
+        }
+        mask.mutableWord(wordId, col) = packFlags(isFinite);
+      }
+    }
+  });
+  return mask;
+}
+
+void ValidityMask::setValid(int row, int col, bool isValid) {
+  const Word bit = Word{1} << (row % bitsPerWord);
+  Word& bits = mutableWord(row / bitsPerWord, col);
+  bits = isValid ? (bits | bit) : (bits & ~bit);
+}
+
+ValidityMask::Word ValidityMask::fullWord(int wordId) const {
+  return lowBits(rows_ - wordId * bitsPerWord);
+}
+
+int ValidityMask::count() const {
+  int numValid = 0;
+  for (const Word bits : words_) {
+    numValid += __builtin_popcountll(bits);
+  }
+  return numValid;
+}
+
+int ValidityMask::count(int col, int rowBegin, int rowEnd) const {
+  if (rowBegin >= rowEnd) {
+    return 0;
+  }
+  const int firstWord = rowBegin / bitsPerWord;
+  const int lastWord = (rowEnd - 1) / bitsPerWord;
+  int numValid = 0;
+  for (int wordId = firstWord; wordId <= lastWord; ++wordId) {
+    Word bits = word(wordId, col);
+    if (wordId == firstWord) {
+      bits &= ~lowBits(rowBegin - firstWord * bitsPerWord);
+    }
+    if (wordId == lastWord) {
+      bits &= lowBits(rowEnd - lastWord * bitsPerWord);
+    }
+    numValid += __builtin_popcountll(bits);
+  }
+  return numValid;
+}
+
+ValidityMask& ValidityMask::operator&=(const ValidityMask& other) {
+  if (rows_ != other.rows_ || cols_ != other.cols_) {
+    throw std::invalid_argument("ValidityMask: sizes do not match.");
+  }
+  for (size_t i = 0; i < words_.size(); ++i) {
+    words_[i] &= other.words_[i];
+  }
+  return *this;
+}
+
+ValidityMask& ValidityMask::operator|=(const ValidityMask& other) {
+  if (rows_ != other.rows_ || cols_ != other.cols_) {
+    throw std::invalid_argument("ValidityMask: sizes do not match.");
+  }
+  for (size_t i = 0; i < words_.size(); ++i) {
+    words_[i] |= other.words_[i];
+  }
+  return *this;
+}
+
+ValidityMask ValidityMask::operator~() const {
+  ValidityMask inverted(*this);
+  for (int col = 0; col < cols_; ++col) {
+    for (int wordId = 0; wordId < wordsPerCol_; ++wordId) {
+      inverted.mutableWord(wordId, col) = ~word(wordId, col) & fullWord(wordId);
+    }
+  }
+  return inverted;
+}
+
+ValidityMask ValidityMask::dilated(int kernelSize) const {
+  if (kernelSize < 1) {
+    throw std::invalid_argument("ValidityMask::dilated: kernelSize must be positive.");
+  }
+  if (rows_ == 0 || cols_ == 0) {
+    return *this;
+  }
+
+  // Vertical pass: or of the shifted columns, the first and last rows are then set for the window shifted to stay inside the map.
+  const int kernelRows = std::min(kernelSize, rows_);
+  const int kernelCols = std::min(kernelSize, cols_);
+  const int halfBefore = (kernelRows - 1) / 2;
+  const int halfAfter = kernelRows - 1 - halfBefore;
+  ValidityMask vertical(rows_, cols_);
+  parallel::forEachRange(0, cols_, [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      const Word* column = &words_[col * wordsPerCol_];
+      for (int wordId = 0; wordId < wordsPerCol_; ++wordId) {
+        Word bits = 0;
+        for (int shift = -halfAfter; shift <= halfBefore; ++shift) {
+          bits |= shiftedWord(column, wordsPerCol_, wordId, shift);
+        }
+        vertical.mutableWord(wordId, col) = bits & fullWord(wordId);
+      }
+      for (int row = 0; row < halfBefore; ++row) {
+        vertical.setValid(row, col, count(col, 0, kernelRows) > 0);
+      }
+      for (int row = rows_ - halfAfter; row < rows_; ++row) {
+        vertical.setValid(row, col, count(col, rows_ - kernelRows, rows_) > 0);
+      }
+    }
+  });
+
+  // Horizontal pass: or of the words of the columns in the window.
+  ValidityMask result(rows_, cols_);
+  parallel::forEachRange(0, cols_, [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      const int start = windowStart(col, kernelCols, cols_);
+      for (int wordId = 0; wordId < wordsPerCol_; ++wordId) {
+        Word bits = 0;
+        for (int i = start; i < start + kernelCols; ++i) {
+          bits |= vertical.word(wordId, i);
+        }
+        result.mutableWord(wordId, col) = bits;
+      }
+    }
+  });
+  return result;
+}
+
+ValidityMask ValidityMask::eroded(int kernelSize) const {
+  return ~(~*this).dilated(kernelSize);
+}
+
+Eigen::MatrixXi ValidityMask::windowCounts(int kernelSize) const {
+  if (kernelSize < 1) {
+    throw std::invalid_argument("ValidityMask::windowCounts: kernelSize must be positive.");
+  }
+  const int kernelRows = std::min(kernelSize, rows_);
+  const int kernelCols = std::min(kernelSize, cols_);
+
+  // Sliding counts of the vertical windows, starting from the popcount of the first window, then sliding sums over the columns.
+  const int halfBefore = (kernelRows - 1) / 2;
+  const int halfAfter = kernelRows - 1 - halfBefore;
+  Eigen::MatrixXi vertical(rows_, cols_);
+  parallel::forEachRange(0, cols_, [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      int* verticalCounts = vertical.col(col).data();
+      int windowCount = count(col, 0, kernelRows);
+      for (int row = 0; row <= std::min(halfBefore, rows_ - 1); ++row) {
+        verticalCounts[row] = windowCount;
+      }
+      for (int row = halfBefore + 1; row < rows_ - halfAfter; ++row) {
+        windowCount += static_cast<int>(isValid(row + halfAfter, col)) - static_cast<int>(isValid(row - halfBefore - 1, col));
+        verticalCounts[row] = windowCount;
+      }
+      for (int row = std::max(rows_ - halfAfter, halfBefore + 1); row < rows_; ++row) {
+        verticalCounts[row] = windowCount;
+      }
+    }
+  });
+
+  Eigen::MatrixXi counts(rows_, cols_);
+  if (cols_ == 0) {
+    return counts;
+  }
+  Eigen::VectorXi windowSum = vertical.leftCols(kernelCols).rowwise().sum();
+  for (int col = 0; col < cols_; ++col) {
+    const int start = windowStart(col, kernelCols, cols_);
+    if (col > 0 && start != windowStart(col - 1, kernelCols, cols_)) {
+      windowSum += vertical.col(start + kernelCols - 1) - vertical.col(start - 1);
+    }
+    counts.col(col) = windowSum;
+  }
+  return counts;
+}
+
+grid_map::Matrix ValidityMask::applyTo(const grid_map::Matrix& data) const {
+  if (data.rows() != rows_ || data.cols() != cols_) {
+    throw std::invalid_argument("ValidityMask::applyTo: sizes do not match.");
+  }
+  grid_map::Matrix result(rows_, cols_);
+  constexpr auto nan = std::numeric_limits<float>::quiet_NaN();
+  parallel::forEachRange(0, cols_, [&](int colBegin, int colEnd) {
+    for (int col = colBegin; col < colEnd; ++col) {
+      for (int wordId = 0; wordId < wordsPerCol_; ++wordId) {
+        const int rowBegin = wordId * bitsPerWord;
+        const int numRows = std::min(bitsPerWord, rows_ - rowBegin);
+        const Word bits = word(wordId, col);
+        if (bits == 0) {
+          result.col(col).segment(rowBegin, numRows).setConstant(nan);
+        } else if (bits == fullWord(wordId)) {
+          result.col(col).segment(rowBegin, numRows) = data.col(col).segment(rowBegin, numRows);
+        } else {
+          uint8_t isValid[bitsPerWord];
+          unpackFlags(bits, isValid);
+          const float* in = data.col(col).data() + rowBegin;
+          float* out = result.col(col).data() + rowBegin;
+          for (int bit = 0; bit < numRows; ++bit) {
+            out[bit] = selectValid(in[bit], isValid[bit]);
+          }
+        }
+      }
+    }
+  });
+  return result;
+}
+
+grid_map::Matrix ValidityMask::toMatrix() const {
+  return applyTo(grid_map::Matrix::Ones(rows_, cols_));
+}
+
+}  // namespace mask
+}  // namespace grid_map
@@ -8,6 +8,7 @@
 
 // grid map filters rsl.
 #include <grid_map_filters_rsl/inpainting.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
 #include <grid_map_filters_rsl/processing.hpp>
 
 // open cv.
@@ -17,11 +18,381 @@
 #include <opencv2/photo.hpp>
 
 // stl.
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <vector>
 
 namespace grid_map {
 namespace inpainting {
 
+namespace {
+inline float square(float x) {
+  return x * x;
+}
+
+/**
+ * Evaluates the least squares fit of a bi-linear function (https://en.wikipedia.org/wiki/Bilinear_interpolation) through four scattered
+ * cells at the query index. Coordinates are cell indices.
+ */
+float evaluateBiLinearFit(const std::array<Eigen::Vector2i, 4>& indices, const std::array<float, 4>& values,
+                          const Eigen::Vector2i& index0) {
+  Eigen::Matrix4f A;
+  Eigen::Vector4f b;
+  A.setOnes();
+  for (auto id = 0U; id < 4U; ++id) {
+    A(id, 1U) = static_cast<float>(indices[id].x());
+    A(id, 2U) = static_cast<float>(indices[id].y());
+    A(id, 3U) = static_cast<float>(indices[id].x() * indices[id].y());
+    b(id) = values[id];
+  }
+  const Eigen::Vector4f weights = A.colPivHouseholderQr().solve(b);
+  return weights.dot(Eigen::Vector4f(1.0, static_cast<float>(index0.x()), static_cast<float>(index0.y()),
+                                     static_cast<float>(index0.x() * index0.y())));
+}
+
+/// Cell types of the harmonic interpolation.
+constexpr uint8_t excludedCell = 0;  // outside of the domain, like cells outside of the map
+constexpr uint8_t fixedCell = 1;     // valid cell, or zero correction on coarse levels
+constexpr uint8_t unknownCell = 2;   // cell to be interpolated
+
+/**
+ * One level of the multigrid hierarchy of the harmonic interpolation. Solves the discrete Laplace equation sum_n (x_n - x) / h^2 = rhs for
+ * unknown cells, where n are the 4-neighbours that are not excluded and h is the cell size in multiples of the finest cell size. Only the
+ * unknown cells are visited, such that small nan-patches in large maps are cheap.
+ */
+struct MultigridLevel {
+  static constexpr int noNeighbour = -1;
+
+  Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> cellTypes;
+  Eigen::MatrixXf values;
+  Eigen::MatrixXf rhs;
+  float squaredCellSize;
+
+  /// Storage index of the unknown cells and of their neighbours that are not excluded (noNeighbour otherwise).
+  std::vector<int> unknownCells;
+  std::vector<std::array<int, 4>> neighbours;
+};
+constexpr int MultigridLevel::noNeighbour;
+
+/** Sets up the lists of unknown cells and their neighbours, and allocates the values and rhs. */
+void initializeLevel(MultigridLevel& level, float squaredCellSize) {
+  const auto& cellTypes = level.cellTypes;
+  const int numRows = cellTypes.rows();
+  auto neighbourIfIncluded = [&](int cellId) {
+    return (cellTypes(cellId) != excludedCell) ? cellId : MultigridLevel::noNeighbour;
+  };
+
+  const auto numUnknownCells = static_cast<size_t>((cellTypes.array() == unknownCell).count());
+  level.unknownCells.clear();
+  level.unknownCells.reserve(numUnknownCells);
+  level.neighbours.clear();
+  level.neighbours.reserve(numUnknownCells);
+  for (int colId = 0; colId < cellTypes.cols(); ++colId) {
+    for (int rowId = 0; rowId < numRows; ++rowId) {
+      const int cellId = colId * numRows + rowId;
+      if (cellTypes(cellId) != unknownCell) {
+        continue;
+      }
+      level.unknownCells.push_back(cellId);
+      level.neighbours.push_back({(rowId > 0) ? neighbourIfIncluded(cellId - 1) : MultigridLevel::noNeighbour,
+                                  (rowId < numRows - 1) ? neighbourIfIncluded(cellId + 1) : MultigridLevel::noNeighbour,
+                                  (colId > 0) ? neighbourIfIncluded(cellId - numRows) : MultigridLevel::noNeighbour,
+                                  (colId < cellTypes.cols() - 1) ? neighbourIfIncluded(cellId + numRows) : MultigridLevel::noNeighbour});
+    }
+  }
+  level.rhs.setZero(cellTypes.rows(), cellTypes.cols());
+  if (level.values.size() != cellTypes.size()) {
+    level.values.setZero(cellTypes.rows(), cellTypes.cols());
+  }
+  level.squaredCellSize = squaredCellSize;
+}
+
+/** Gauss-Seidel sweeps over the unknown cells. Returns the largest change of the last sweep. */
+float relax(MultigridLevel& level, int numSweeps) {
+  float* values = level.values.data();
+  const float* rhs = level.rhs.data();
+  float maxChange = 0.0F;
+  for (int sweep = 0; sweep < numSweeps; ++sweep) {
+    maxChange = 0.0F;
+    for (size_t i = 0; i < level.unknownCells.size(); ++i) {
+      float sum = 0.0F;
+      int numNeighbours = 0;
+      for (const auto neighbourId : level.neighbours[i]) {
+        if (neighbourId != MultigridLevel::noNeighbour) {
+          sum += values[neighbourId];
+          ++numNeighbours;
+        }
+      }
+      if (numNeighbours > 0) {
+        const int cellId = level.unknownCells[i];
+        const float newValue = (sum - level.squaredCellSize * rhs[cellId]) / static_cast<float>(numNeighbours);
+        maxChange = std::max(maxChange, std::abs(newValue - values[cellId]));
+        values[cellId] = newValue;
+      }
+    }
+  }
+  return maxChange;
+}
+
+/**
+ * Cell types of the next coarser level: fixed if any child is fixed, such that the correction vanishes towards the valid cells and every
+ * coarse problem stays well posed. Else unknown if any child is unknown.
+ */
+MultigridLevel coarsen(const MultigridLevel& fine) {
+  MultigridLevel coarse;
+  coarse.cellTypes.setConstant((fine.cellTypes.rows() + 1) / 2, (fine.cellTypes.cols() + 1) / 2, excludedCell);
+  for (int colId = 0; colId < fine.cellTypes.cols(); ++colId) {
+    for (int rowId = 0; rowId < fine.cellTypes.rows(); ++rowId) {
+      auto& coarseType = coarse.cellTypes(rowId / 2, colId / 2);
+      const auto fineType = fine.cellTypes(rowId, colId);
+      if (fineType == fixedCell || (fineType == unknownCell && coarseType == excludedCell)) {
+        coarseType = fineType;
+      }
+    }
+  }
+  initializeLevel(coarse, 4.0F * fine.squaredCellSize);
+  return coarse;
+}
+
+/** Multigrid V-cycle on the levels starting at levelId. Coarser levels solve for the correction of the residual of the finer level. */
+void vCycle(std::vector<MultigridLevel>& levels, size_t levelId) {
+  constexpr int numSmoothingSweeps = 2;
+  constexpr int numCoarsestSweeps = 32;
+  auto& level = levels[levelId];
+  if (levelId + 1 == levels.size()) {
+    relax(level, numCoarsestSweeps);
+    return;
+  }
+
+  relax(level, numSmoothingSweeps);
+
+  // Restrict the residual to the coarse level.
+  auto& coarse = levels[levelId + 1];
+  const int numRows = level.values.rows();
+  const float* values = level.values.data();
+  coarse.values.setZero();
+  coarse.rhs.setZero();
+  for (size_t i = 0; i < level.unknownCells.size(); ++i) {
+    const int cellId = level.unknownCells[i];
+    float laplacian = 0.0F;
+    for (const auto neighbourId : level.neighbours[i]) {
+      if (neighbourId != MultigridLevel::noNeighbour) {
+        laplacian += values[neighbourId] - values[cellId];
+      }
+    }
+    const float residual = level.rhs(cellId) - laplacian / level.squaredCellSize;
+    coarse.rhs((cellId % numRows) / 2, (cellId / numRows) / 2) += 0.25F * residual;
+  }
+
+  vCycle(levels, levelId + 1);
+
+  // Prolongate the correction with bi-linear interpolation between the coarse cell centers. Excluded cells are replaced by the parent.
+  auto coarseCorrection = [&](int coarseRowId, int coarseColId, float parentCorrection) {
+    const bool isInside = coarseRowId >= 0 && coarseRowId < coarse.values.rows() && coarseColId >= 0 && coarseColId < coarse.values.cols();
+    return (isInside && coarse.cellTypes(coarseRowId, coarseColId) != excludedCell) ? coarse.values(coarseRowId, coarseColId)
+                                                                                     : parentCorrection;
+  };
+  for (const auto cellId : level.unknownCells) {
+    const int rowId = cellId % numRows;
+    const int colId = cellId / numRows;
+    const int parentRowId = rowId / 2;
+    const int parentColId = colId / 2;
+    const int neighbourRowId = (rowId % 2 == 0) ? parentRowId - 1 : parentRowId + 1;
+    const int neighbourColId = (colId % 2 == 0) ? parentColId - 1 : parentColId + 1;
+    const float parentCorrection = coarse.values(parentRowId, parentColId);
+    level.values(cellId) += 0.5625F * parentCorrection + 0.1875F * coarseCorrection(neighbourRowId, parentColId, parentCorrection) +
+                            0.1875F * coarseCorrection(parentRowId, neighbourColId, parentCorrection) +
+                            0.0625F * coarseCorrection(neighbourRowId, neighbourColId, parentCorrection);
+  }
+
+  relax(level, numSmoothingSweeps);
+}
+
+/**
+ * Pull-push fill: averages the valid cells over an image pyramid (pull), and assigns each nan cell the value of its coarsest ancestor that
+ * has data (push). Used as initial guess of the harmonic interpolation.
+ */
+void pullPush(Eigen::MatrixXf& values) {
+  if (values.rows() <= 1 && values.cols() <= 1) {
+    return;
+  }
+  if (!values.hasNaN()) {
+    return;
+  }
+
+  // Pull
+  Eigen::MatrixXf coarseSum = Eigen::MatrixXf::Zero((values.rows() + 1) / 2, (values.cols() + 1) / 2);
+  Eigen::MatrixXf coarseWeight = Eigen::MatrixXf::Zero(coarseSum.rows(), coarseSum.cols());
+  for (int colId = 0; colId < values.cols(); ++colId) {
+    for (int rowId = 0; rowId < values.rows(); ++rowId) {
+      const float value = values(rowId, colId);
+      if (!std::isnan(value)) {
+        coarseSum(rowId / 2, colId / 2) += value;
+        coarseWeight(rowId / 2, colId / 2) += 1.0F;
+      }
+    }
+  }
+  Eigen::MatrixXf coarseValues = (coarseWeight.array() > 0.0F).select(coarseSum.array() / coarseWeight.array(), NAN);
+  pullPush(coarseValues);
+
+  // Push
+  for (int colId = 0; colId < values.cols(); ++colId) {
+    for (int rowId = 0; rowId < values.rows(); ++rowId) {
+      if (std::isnan(values(rowId, colId))) {
+        values(rowId, colId) = coarseValues(rowId / 2, colId / 2);
+      }
+    }
+  }
+}
+
+/** Approximate euclidean distance [cells] of each cell to the nearest valid cell, two-pass chamfer transform with 8-neighbours. */
+Eigen::MatrixXf distanceToValidCells(const Eigen::MatrixXf& values) {
+  constexpr float straightDistance = 1.0F;
+  const float diagonalDistance = std::sqrt(2.0F);
+  const int numRows = values.rows();
+  const int numCols = values.cols();
+  constexpr float infinity = std::numeric_limits<float>::infinity();
+  Eigen::MatrixXf distance = values.array().isNaN().select(Eigen::MatrixXf::Constant(numRows, numCols, infinity), 0.0F);
+
+  auto update = [&](int rowId, int colId, int neighbourRowId, int neighbourColId, float step) {
+    if (neighbourRowId >= 0 && neighbourRowId < numRows && neighbourColId >= 0 && neighbourColId < numCols) {
+      distance(rowId, colId) = std::min(distance(rowId, colId), distance(neighbourRowId, neighbourColId) + step);
+    }
+  };
+  for (int colId = 0; colId < numCols; ++colId) {
+    for (int rowId = 0; rowId < numRows; ++rowId) {
+      update(rowId, colId, rowId - 1, colId, straightDistance);
+      update(rowId, colId, rowId - 1, colId - 1, diagonalDistance);
+      update(rowId, colId, rowId, colId - 1, straightDistance);
+      update(rowId, colId, rowId + 1, colId - 1, diagonalDistance);
+    }
+  }
+  for (int colId = numCols - 1; colId >= 0; --colId) {
+    for (int rowId = numRows - 1; rowId >= 0; --rowId) {
+      update(rowId, colId, rowId + 1, colId, straightDistance);
+      update(rowId, colId, rowId + 1, colId + 1, diagonalDistance);
+      update(rowId, colId, rowId, colId + 1, straightDistance);
+      update(rowId, colId, rowId - 1, colId + 1, diagonalDistance);
+    }
+  }
+  return distance;
+}
+
+/**
+ * Weights of the source cells that contribute to each target cell along one dimension of the map, stored like a sparse matrix: the weights
+ * of target cell i are weights[weightsBegin[i] ... weightsBegin[i + 1]), belonging to the consecutive source cells from firstSource[i].
+ */
+struct ResamplingWeights {
+  std::vector<int> firstSource;
+  std::vector<int> weightsBegin;
+  std::vector<float> weights;
+};
+
+/**
+ * Target cell i covers the source cells [i * scale, (i + 1) * scale), scale = oldSize / newSize. When downsampling, the weights are the
+ * overlap of this area with the source cells. When upsampling, the source is linearly interpolated at the center of the target cell,
+ * with the same alignment and border handling as cv::resize with cv::INTER_LINEAR.
+ */
+ResamplingWeights computeResamplingWeights(int oldSize, int newSize) {
+  ResamplingWeights result;
+  result.weightsBegin.push_back(0);
+  const double scale = static_cast<double>(oldSize) / newSize;
+  for (int targetId = 0; targetId < newSize; ++targetId) {
+    if (newSize < oldSize) {
+      const double areaBegin = targetId * scale;
+      const double areaEnd = (targetId + 1) * scale;
+      const int firstSource = static_cast<int>(std::floor(areaBegin));
+      const int lastSource = std::min(static_cast<int>(std::ceil(areaEnd)), oldSize) - 1;
+      result.firstSource.push_back(firstSource);
+      for (int sourceId = firstSource; sourceId <= lastSource; ++sourceId) {
+        const double overlap = std::min<double>(areaEnd, sourceId + 1) - std::max<double>(areaBegin, sourceId);
+        result.weights.push_back(static_cast<float>(std::max(overlap, 0.0)));
+      }
+    } else {
+      const double center = (targetId + 0.5) * scale - 0.5;
+      int firstSource = static_cast<int>(std::floor(center));
+      double fraction = center - firstSource;
+      if (firstSource < 0) {
+        firstSource = 0;
+        fraction = 0.0;
+      } else if (firstSource >= oldSize - 1) {
+        firstSource = oldSize - 1;
+        fraction = 0.0;
+      }
+      result.firstSource.push_back(firstSource);
+      result.weights.push_back(static_cast<float>(1.0 - fraction));
+      if (fraction > 0.0) {
+        result.weights.push_back(static_cast<float>(fraction));
+      }
+    }
+    result.weightsBegin.push_back(static_cast<int>(result.weights.size()));
+  }
+  return result;
+}
+
+/**
+ * Resamples the layers to newRows x newCols cells with the separable weights. Non-finite values are left out and the weights are normalized
+ * over the finite values, such that nan-cells do not spread into their neighbourhood. Target cells without finite source values are nan.
+ * The rows are resampled first, then the columns. Both passes are distributed over the columns of all layers at once.
+ */
+std::vector<grid_map::Matrix> resampleLayers(const std::vector<const grid_map::Matrix*>& layers, const ResamplingWeights& rowWeights,
+                                             const ResamplingWeights& colWeights) {
+  const int numLayers = static_cast<int>(layers.size());
+  if (numLayers == 0) {
+    return {};
+  }
+  const int oldCols = layers.front()->cols();
+  const int newRows = static_cast<int>(rowWeights.firstSource.size());
+  const int newCols = static_cast<int>(colWeights.firstSource.size());
+
+  // Weighted sums of the finite values and sums of their weights, after resampling the rows.
+  std::vector<grid_map::Matrix> weightedSums(numLayers, grid_map::Matrix(newRows, oldCols));
+  std::vector<grid_map::Matrix> weightSums(numLayers, grid_map::Matrix(newRows, oldCols));
+  parallel::forEachRange(0, numLayers * oldCols, [&](int begin, int end) {
+    for (int id = begin; id < end; ++id) {
+      const int layerId = id / oldCols;
+      const int colId = id % oldCols;
+      const float* values = layers[layerId]->col(colId).data();
+      for (int rowId = 0; rowId < newRows; ++rowId) {
+        float weightedSum = 0.0F;
+        float weightSum = 0.0F;
+        const float* source = values + rowWeights.firstSource[rowId];
+        for (int weightId = rowWeights.weightsBegin[rowId]; weightId < rowWeights.weightsBegin[rowId + 1]; ++weightId, ++source) {
+          if (std::isfinite(*source)) {
+            weightedSum += rowWeights.weights[weightId] * *source;
+            weightSum += rowWeights.weights[weightId];
+          }
+        }
+        weightedSums[layerId](rowId, colId) = weightedSum;
+        weightSums[layerId](rowId, colId) = weightSum;
+      }
+    }
+  });
+
+  std::vector<grid_map::Matrix> resampled(numLayers, grid_map::Matrix(newRows, newCols));
+  parallel::forEachRange(0, numLayers * newCols, [&](int begin, int end) {
+    Eigen::VectorXf weightedSum(newRows);
+    Eigen::VectorXf weightSum(newRows);
+    for (int id = begin; id < end; ++id) {
+      const int layerId = id / newCols;
+      const int colId = id % newCols;
+      weightedSum.setZero();
+      weightSum.setZero();
+      int sourceColId = colWeights.firstSource[colId];
+      for (int weightId = colWeights.weightsBegin[colId]; weightId < colWeights.weightsBegin[colId + 1]; ++weightId, ++sourceColId) {
+        weightedSum += colWeights.weights[weightId] * weightedSums[layerId].col(sourceColId);
+        weightSum += colWeights.weights[weightId] * weightSums[layerId].col(sourceColId);
+      }
+      resampled[layerId].col(colId) = (weightSum.array() > 0.0F).select(weightedSum.array() / weightSum.array(), NAN);
+    }
+  });
+  return resampled;
+}
+}  // namespace
+
 void minValues(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut) {
   // Create new layer if missing
   if (!map.exists(layerOut)) {
@@ -38,57 +409,68 @@ void minValues(grid_map::GridMap& map, const std::string& layerIn, const std::st
   const int maxColId = numCols - 1;
   const int numRows = H_in.rows();
   const int maxRowId = numRows - 1;
-
-  // Common operation of updating the minimum and keeping track if the minimum was updated.
-  auto compareAndStoreMin = [](float newValue, float& currentMin, bool& changedValue) {
-    if (!std::isnan(newValue)) {
-      if (newValue < currentMin || std::isnan(currentMin)) {
-        currentMin = newValue;
-        changedValue = true;
-      }
-    }
-  };
+  const Eigen::Index numCells = H_in.size();
 
   /*
-   * Fill each cell that needs inpainting with the min of its neighbours until the map doesn't change anymore.
-   * This way each inpainted area gets the minimum value along its contour.
-   *
-   * We will be reading and writing to H_out during iteration. However, the aliasing does not break the correctness of the algorithm.
+   * Each 4-connected nan-patch is filled with the minimum of the valid cells along its contour, which is the fixed point of repeatedly
+   * filling each nan cell with the min of its neighbours. The patches are labeled with a flood fill that collects the contour minimum on
+   * the way, such that every cell is visited a constant number of times, independent of the size of the patches.
    */
-  bool hasAtLeastOneValue = true;
-  bool changedValue = true;
-  while (changedValue && hasAtLeastOneValue) {
-    hasAtLeastOneValue = false;
-    changedValue = false;
-    for (int colId = 0; colId < numCols; ++colId) {
-      for (int rowId = 0; rowId < numRows; ++rowId) {
-        if (std::isnan(H_in(rowId, colId))) {
-          auto& middleValue = H_out(rowId, colId);
+  constexpr int noLabel = -1;
+  std::vector<int> labels(numCells, noLabel);
+  std::vector<float> patchMinValues;
+  std::vector<Eigen::Index> cellsToVisit;
+  const float* dataIn = H_in.data();
+
+  for (Eigen::Index seedId = 0; seedId < numCells; ++seedId) {
+    if (!std::isnan(dataIn[seedId]) || labels[seedId] != noLabel) {
+      continue;
+    }
 
-          // left
-          if (colId > 0) {
-            const auto leftValue = H_out(rowId, colId - 1);
-            compareAndStoreMin(leftValue, middleValue, changedValue);
-          }
-          // right
-          if (colId < maxColId) {
-            const auto rightValue = H_out(rowId, colId + 1);
-            compareAndStoreMin(rightValue, middleValue, changedValue);
-          }
-          // top
-          if (rowId > 0) {
-            const auto topValue = H_out(rowId - 1, colId);
-            compareAndStoreMin(topValue, middleValue, changedValue);
-          }
-          // bottom
-          if (rowId < maxRowId) {
-            const auto bottomValue = H_out(rowId + 1, colId);
-            compareAndStoreMin(bottomValue, middleValue, changedValue);
-          }
-        } else {
-          hasAtLeastOneValue = true;
+    const int label = static_cast<int>(patchMinValues.size());
+    float minValue = NAN;
+    auto visitNeighbour = [&](Eigen::Index neighbourId) {
+      const float value = dataIn[neighbourId];
+      if (std::isnan(value)) {
+        if (labels[neighbourId] == noLabel) {
+          labels[neighbourId] = label;
+          cellsToVisit.push_back(neighbourId);
         }
+      } else if (value < minValue || std::isnan(minValue)) {
+        minValue = value;
+      }
+    };
+
+    labels[seedId] = label;
+    cellsToVisit.push_back(seedId);
+    while (!cellsToVisit.empty()) {
+      const Eigen::Index cellId = cellsToVisit.back();
+      cellsToVisit.pop_back();
+
+      // Column-major storage
+      const int rowId = static_cast<int>(cellId % numRows);
+      const int colId = static_cast<int>(cellId / numRows);
+      if (colId > 0) {
+        visitNeighbour(cellId - numRows);  // left
       }
+      if (colId < maxColId) {
+        visitNeighbour(cellId + numRows);  // right
+      }
+      if (rowId > 0) {
+        visitNeighbour(cellId - 1);  // top
+      }
+      if (rowId < maxRowId) {
+        visitNeighbour(cellId + 1);  // bottom
+      }
+    }
+    patchMinValues.push_back(minValue);
+  }
+
+  // Fill. Patches without valid contour (only possible if the whole map is nan) remain nan.
+  float* dataOut = H_out.data();
+  for (Eigen::Index cellId = 0; cellId < numCells; ++cellId) {
+    if (labels[cellId] != noLabel) {
+      dataOut[cellId] = patchMinValues[labels[cellId]];
     }
   }
 }
@@ -102,98 +484,136 @@ void biLinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, c
     map.get(layerOut) = map.get(layerIn);
   }
 
-  // Helper variables.
-  std::array<Eigen::Vector2i, 4> indices;
-  std::array<float, 4> values;
-  Eigen::Matrix4f A;
-  Eigen::Vector4f b;
-  A.setOnes();
-  Eigen::Vector4f weights;
-  bool success = true;
-  constexpr auto infinity = std::numeric_limits<float>::max();
-
-  // Init.
-  std::fill(values.begin(), values.end(), NAN);
-  std::fill(indices.begin(), indices.end(), Eigen::Vector2i(0, 0));
-
   // Reference to in and out maps.
   const grid_map::Matrix& H_in = map.get(layerIn);
   grid_map::Matrix& H_out = map.get(layerOut);
+  const int numRows = H_in.rows();
+  const int numCols = H_in.cols();
 
-  for (auto colId = 0; colId < H_in.cols(); ++colId) {
-    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
-      if (std::isnan(H_in(rowId, colId))) {
-        // Note: if we don't find a valid neighbour, we use the previous index-value pair.
-        auto minValue = infinity;
-        const Eigen::Vector2i index0(rowId, colId);
-
-        // Search in negative direction.
-        for (auto id = rowId - 1; id >= 0; --id) {
-          auto newValue = H_in(id, colId);
-          if (!std::isnan(newValue)) {
-            indices[0] = Eigen::Vector2i(id, colId);
-            values[0] = newValue;
-            minValue = std::fmin(minValue, newValue);
-            break;
-          }
+  /*
+   * Nearest valid neighbour of every cell in negative and positive row and column direction (-1 if there is none), computed with one
+   * sweep per direction instead of searching outward from every nan cell.
+   */
+  constexpr int noNeighbour = -1;
+  Eigen::MatrixXi topRowIds(numRows, numCols);
+  Eigen::MatrixXi bottomRowIds(numRows, numCols);
+  Eigen::MatrixXi leftColIds(numRows, numCols);
+  Eigen::MatrixXi rightColIds(numRows, numCols);
+  parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      int validRowId = noNeighbour;
+      for (int rowId = 0; rowId < numRows; ++rowId) {
+        topRowIds(rowId, colId) = validRowId;
+        if (!std::isnan(H_in(rowId, colId))) {
+          validRowId = rowId;
         }
-
-        for (auto id = colId - 1; id >= 0; --id) {
-          auto newValue = H_in(rowId, id);
-          if (!std::isnan(newValue)) {
-            indices[1] = Eigen::Vector2i(rowId, id);
-            values[1] = newValue;
-            minValue = std::fmin(minValue, newValue);
-            break;
-          }
+      }
+      validRowId = noNeighbour;
+      for (int rowId = numRows - 1; rowId >= 0; --rowId) {
+        bottomRowIds(rowId, colId) = validRowId;
+        if (!std::isnan(H_in(rowId, colId))) {
+          validRowId = rowId;
         }
+      }
+    }
+  });
+  parallel::forEachRange(0, numRows, [&](int rowBegin, int rowEnd) {
+    const int numRowsInRange = rowEnd - rowBegin;
+    auto isNaN = [&](int colId) { return H_in.col(colId).segment(rowBegin, numRowsInRange).array().isNaN(); };
+    leftColIds.col(0).segment(rowBegin, numRowsInRange).setConstant(noNeighbour);
+    for (int colId = 1; colId < numCols; ++colId) {
+      leftColIds.col(colId).segment(rowBegin, numRowsInRange) =
+          isNaN(colId - 1).select(leftColIds.col(colId - 1).segment(rowBegin, numRowsInRange), colId - 1);
+    }
+    rightColIds.col(numCols - 1).segment(rowBegin, numRowsInRange).setConstant(noNeighbour);
+    for (int colId = numCols - 2; colId >= 0; --colId) {
+      rightColIds.col(colId).segment(rowBegin, numRowsInRange) =
+          isNaN(colId + 1).select(rightColIds.col(colId + 1).segment(rowBegin, numRowsInRange), colId + 1);
+    }
+  });
 
-        // Search in positive direction.
-        for (auto id = rowId + 1; id < H_in.rows(); ++id) {
-          auto newValue = H_in(id, colId);
-          if (!std::isnan(newValue)) {
-            indices[2] = Eigen::Vector2i(id, colId);
-            values[2] = newValue;
-            minValue = std::fmin(minValue, newValue);
-            break;
-          }
+  /*
+   * Cells that lack a valid neighbour in some direction reuse the neighbour found for the previous such nan cell (in storage order), or
+   * fall back to the min of the neighbours they have. This depends on the visiting order, so these cells are handled in a serial pass.
+   * They only occur where a nan-patch touches the map border.
+   */
+  std::array<Eigen::Vector2i, 4> indices;
+  std::array<float, 4> values;
+  std::fill(values.begin(), values.end(), NAN);
+  std::fill(indices.begin(), indices.end(), Eigen::Vector2i(0, 0));
+  bool success = true;
+  constexpr auto infinity = std::numeric_limits<float>::max();
+
+  for (int colId = 0; colId < numCols; ++colId) {
+    for (int rowId = 0; rowId < numRows; ++rowId) {
+      if (!std::isnan(H_in(rowId, colId))) {
+        continue;
+      }
+      const std::array<Eigen::Vector2i, 4> neighbours{
+          Eigen::Vector2i(topRowIds(rowId, colId), colId), Eigen::Vector2i(rowId, leftColIds(rowId, colId)),
+          Eigen::Vector2i(bottomRowIds(rowId, colId), colId), Eigen::Vector2i(rowId, rightColIds(rowId, colId))};
+      auto minValue = infinity;
+      bool hasAllNeighbours = true;
+      for (size_t id = 0; id < 4; ++id) {
+        if (neighbours[id].minCoeff() == noNeighbour) {
+          hasAllNeighbours = false;
+        } else {
+          indices[id] = neighbours[id];
+          values[id] = H_in(neighbours[id].x(), neighbours[id].y());
+          minValue = std::fmin(minValue, values[id]);
         }
+      }
+      if (hasAllNeighbours) {
+        continue;  // Interpolated below.
+      }
 
-        for (auto id = colId + 1; id < H_in.cols(); ++id) {
-          auto newValue = H_in(rowId, id);
-          if (!std::isnan(newValue)) {
-            indices[3] = Eigen::Vector2i(rowId, id);
-            values[3] = newValue;
-            minValue = std::fmin(minValue, newValue);
-            break;
-          }
+      // Cannot interpolate if there are not 4 corner points.
+      if (std::any_of(values.begin(), values.end(), [](float value) { return std::isnan(value); })) {
+        if (minValue < infinity) {
+          H_out(rowId, colId) = minValue;
+        } else {
+          success = false;
         }
+        continue;
+      }
 
-        // Cannot interpolate if there are not 4 corner points.
-        if (std::any_of(values.begin(), values.end(), [](float value) { return std::isnan(value); })) {
-          if (minValue < infinity) {
-            H_out(rowId, colId) = minValue;
-          } else {
-            success = false;
-          }
+      H_out(rowId, colId) = evaluateBiLinearFit(indices, values, Eigen::Vector2i(rowId, colId));
+    }
+  }
+
+  /*
+   * Cells with a valid neighbour in all four directions. The neighbours lie on a cross through the cell, for which the least squares fit
+   * of a bi-linear function evaluates to a weighted mean of the linear interpolations along the column and along the row. The weight of
+   * each interpolation is (d_1 + d_2)^2 / (d_1^2 + d_2^2), with d_1 and d_2 the distances to its two neighbours.
+   */
+  parallel::forEachRange(0, numRows, [&](int rowBegin, int rowEnd) {
+    for (int colId = 0; colId < numCols; ++colId) {
+      for (int rowId = rowBegin; rowId < rowEnd; ++rowId) {
+        if (!std::isnan(H_in(rowId, colId))) {
           continue;
         }
-
-        // Interpolation weights (https://en.wikipedia.org/wiki/Bilinear_interpolation).
-        for (auto id = 0U; id < 4U; ++id) {
-          A(id, 1U) = static_cast<float>(indices[id].x());
-          A(id, 2U) = static_cast<float>(indices[id].y());
-          A(id, 3U) = static_cast<float>(indices[id].x() * indices[id].y());
-          b(id) = values[id];
+        const int topRowId = topRowIds(rowId, colId);
+        const int bottomRowId = bottomRowIds(rowId, colId);
+        const int leftColId = leftColIds(rowId, colId);
+        const int rightColId = rightColIds(rowId, colId);
+        if (topRowId == noNeighbour || bottomRowId == noNeighbour || leftColId == noNeighbour || rightColId == noNeighbour) {
+          continue;  // Handled above.
         }
-        weights = A.colPivHouseholderQr().solve(b);
 
-        // Value according to bi-linear interpolation.
-        H_out(rowId, colId) = weights.dot(Eigen::Vector4f(1.0, static_cast<float>(index0.x()), static_cast<float>(index0.y()),
-                                                          static_cast<float>(index0.x() * index0.y())));
+        const auto distanceTop = static_cast<float>(rowId - topRowId);
+        const auto distanceBottom = static_cast<float>(bottomRowId - rowId);
+        const auto distanceLeft = static_cast<float>(colId - leftColId);
+        const auto distanceRight = static_cast<float>(rightColId - colId);
+        const float columnValue =
+            (distanceBottom * H_in(topRowId, colId) + distanceTop * H_in(bottomRowId, colId)) / (distanceTop + distanceBottom);
+        const float rowValue =
+            (distanceRight * H_in(rowId, leftColId) + distanceLeft * H_in(rowId, rightColId)) / (distanceLeft + distanceRight);
+        const float columnWeight = square(distanceTop + distanceBottom) / (square(distanceTop) + square(distanceBottom));
+        const float rowWeight = square(distanceLeft + distanceRight) / (square(distanceLeft) + square(distanceRight));
+        H_out(rowId, colId) = (columnWeight * columnValue + rowWeight * rowValue) / (columnWeight + rowWeight);
       }
     }
-  }
+  });
 
   // If failed, try again.
   if (!success) {
@@ -202,6 +622,57 @@ void biLinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, c
   }
 }
 
+void harmonicInterpolation(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, double maxFillDistance) {
+  // Solver settings, the tolerance is relative to the height range of the map.
+  constexpr int maxNumCycles = 20;
+  constexpr float relativeTolerance = 1e-6F;
+  constexpr int minCoarseSize = 4;
+
+  // Create new layer if missing
+  if (!map.exists(layerOut)) {
+    map.add(layerOut, map.get(layerIn));
+  } else {
+    map.get(layerOut) = map.get(layerIn);
+  }
+  grid_map::Matrix& H_out = map.get(layerOut);
+  if (H_out.allFinite() || !H_out.array().isFinite().any()) {
+    return;
+  }
+  // Infinite cells are missing data as well, not seeds.
+  H_out = H_out.unaryExpr([](float value) { return std::isfinite(value) ? value : NAN; });
+
+  // Finest level
+  std::vector<MultigridLevel> levels(1);
+  auto& finest = levels.front();
+  finest.cellTypes.setConstant(H_out.rows(), H_out.cols(), fixedCell);
+  finest.cellTypes = H_out.array().isNaN().select(unknownCell, finest.cellTypes);
+  if (maxFillDistance >= 0.0) {
+    const float maxDistanceInCells = static_cast<float>(maxFillDistance / map.getResolution());
+    finest.cellTypes = (distanceToValidCells(H_out).array() > maxDistanceInCells).select(excludedCell, finest.cellTypes);
+  }
+
+  // Pull-push initial guess
+  finest.values = H_out;
+  pullPush(finest.values);
+  initializeLevel(finest, 1.0F);
+
+  // Coarse levels
+  while (std::max(levels.back().cellTypes.rows(), levels.back().cellTypes.cols()) > minCoarseSize && !levels.back().unknownCells.empty()) {
+    levels.push_back(coarsen(levels.back()));
+  }
+
+  const float tolerance = relativeTolerance * std::max(1.0F, H_out.maxCoeffOfFinites() - H_out.minCoeffOfFinites());
+  for (int cycle = 0; cycle < maxNumCycles; ++cycle) {
+    vCycle(levels, 0);
+    if (relax(levels.front(), 1) < tolerance) {
+      break;
+    }
+  }
+
+  // Excluded cells remain nan.
+  H_out = (levels.front().cellTypes.array() == excludedCell).select(H_out, levels.front().values);
+}
+
 void nonlinearInterpolation(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, double inpaintRadius) {
   // Create new layer if missing.
   if (!map.exists(layerOut)) {
@@ -259,32 +730,28 @@ void resample(grid_map::GridMap& map, const std::string& layer, double newRes) {
     layer_names.push_back(layer);
   }
 
-  for (const auto& layer_name : layer_names) {
-    Eigen::MatrixXf elevationMap = std::move(map.get(layer_name));
+  // Compute new dimensions.
+  const double scaling = oldRes / newRes;
+  const grid_map::Size newSize(std::max(1, static_cast<int>(oldSize[0] * scaling)), std::max(1, static_cast<int>(oldSize[1] * scaling)));
 
-    // Convert elevation map to open-cv image.
-    cv::Mat elevationImage;
-    cv::eigen2cv(elevationMap, elevationImage);
-
-    // Compute new dimensions.
-    const double scaling = oldRes / newRes;
-    int width = int(elevationImage.size[1] * scaling);
-    int height = int(elevationImage.size[0] * scaling);
-    cv::Size dim{width, height};
-
-    // Resize image
-    cv::Mat resizedImage;
-    cv::resize(elevationImage, resizedImage, dim, 0, 0, cv::INTER_LINEAR);
-    cv::cv2eigen(resizedImage, elevationMap);
+  // Resample all layers at once, the weights are shared by the layers.
+  map.convertToDefaultStartIndex();
+  std::vector<const grid_map::Matrix*> layers;
+  for (const auto& layer_name : layer_names) {
+    layers.push_back(&map.get(layer_name));
+  }
+  std::vector<grid_map::Matrix> resampled =
+      resampleLayers(layers, computeResamplingWeights(oldSize[0], newSize[0]), computeResamplingWeights(oldSize[1], newSize[1]));
 
-    // Compute true new resolution. Might be slightly different due to rounding. Take average of both dimensions.
-    grid_map::Size newSize = {elevationMap.rows(), elevationMap.cols()};
-    newRes = 0.5 * ((oldSize[0] * oldRes) / newSize[0] + (oldSize[1] * oldRes) / newSize[1]);
+  // Compute true new resolution. Might be slightly different due to rounding. Take average of both dimensions.
+  newRes = 0.5 * ((oldSize[0] * oldRes) / newSize[0] + (oldSize[1] * oldRes) / newSize[1]);
 
-    // Store new map.
-    map.setGeometry({newSize[0] * newRes, newSize[1] * newRes}, newRes, oldPos);
-    map.get(layer_name) = std::move(elevationMap);
+  // Store new map.
+  map.setGeometry({newSize[0] * newRes, newSize[1] * newRes}, newRes, oldPos);
+  for (size_t layerId = 0; layerId < layer_names.size(); ++layerId) {
+    map.get(layer_names[layerId]) = std::move(resampled[layerId]);
   }
 }
+
 }  // namespace inpainting
 }  // namespace grid_map
@@ -8,13 +8,173 @@
 
 // grid map filters rsl.
 #include <grid_map_filters_rsl/lookup.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
 
 // stl.
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
 
 namespace grid_map {
 namespace lookup {
 
+namespace {
+
+/// Runs of at most this many line cells are searched cell by cell instead of being split further.
+constexpr int maxCellsPerLeaf = 32;
+
+/// Cell of a line with the state of the Bresenham iteration at that cell.
+struct LineCell {
+  int id;
+  grid_map::Index index;
+  int numerator;
+};
+
+/**
+ * The cells of a grid_map::LineIterator between two indices with random access: the line takes one step along the major axis per cell
+ * and steps along the minor axis whenever the Bresenham numerator overflows, which is closed form in the cell number. Both index
+ * coordinates are monotone along the line, such that any run of cells lies in the box spanned by its first and last cell.
+ */
+class LineCells {
+ public:
+  LineCells(const grid_map::Index& start, const grid_map::Index& end) : start_(start), end_(end), majorStep_(0, 0), minorStep_(0, 0) {
+    const grid_map::Index delta = (end - start).abs();
+    const int majorAxis = (delta.x() >= delta.y()) ? 0 : 1;
+    majorStep_(majorAxis) = (end(majorAxis) >= start(majorAxis)) ? 1 : -1;
+    minorStep_(1 - majorAxis) = (end(1 - majorAxis) >= start(1 - majorAxis)) ? 1 : -1;
+    majorStart_ = start(majorAxis);
+    majorSign_ = majorStep_(majorAxis);
+    denominator_ = delta(majorAxis);
+    numeratorStart_ = denominator_ / 2;
+    numeratorAdd_ = delta(1 - majorAxis);
+  }
+
+  LineCell first() const { return {0, start_, numeratorStart_}; }
+
+  /// The line ends exactly at the end index, the numerator is not needed after the last cell.
+  LineCell last() const { return {denominator_, end_, 0}; }
+
+  LineCell at(int cellId) const {
+    const int totalNumerator = numeratorStart_ + cellId * numeratorAdd_;
+    return {cellId, start_ + cellId * majorStep_ + (totalNumerator / denominator_) * minorStep_, totalNumerator % denominator_};
+  }
+
+  /// Advances to the next cell, as grid_map::LineIterator::operator++.
+  void next(LineCell& cell) const {
+    cell.numerator += numeratorAdd_;
+    if (cell.numerator >= denominator_) {
+      cell.numerator -= denominator_;
+      cell.index += minorStep_;
+    }
+    cell.index += majorStep_;
+    ++cell.id;
+  }
+
+  /**
+   * Splits the cells between first and last at the coarsest aligned block boundary along the major axis that lies between them. Both
+   * halves then lie in a single block column of the pyramid level below that boundary, such that their bounding boxes touch at most two
+   * blocks of that level.
+   * @return last cell of the first half.
+   */
+  LineCell split(const LineCell& first, const LineCell& last) const {
+    const int firstMajor = majorStart_ + majorSign_ * first.id;
+    const int lastMajor = majorStart_ + majorSign_ * last.id;
+    int highestDifferentBit = 0;
+    while (((firstMajor ^ lastMajor) >> (highestDifferentBit + 1)) != 0) {
+      ++highestDifferentBit;
+    }
+    const int boundary = (std::max(firstMajor, lastMajor) >> highestDifferentBit) << highestDifferentBit;
+    return at((majorSign_ > 0) ? boundary - 1 - majorStart_ : majorStart_ - boundary);
+  }
+
+ private:
+  grid_map::Index start_;
+  grid_map::Index end_;
+  grid_map::Index majorStep_;
+  grid_map::Index minorStep_;
+  int majorStart_;
+  int majorSign_;
+  int denominator_;
+  int numeratorStart_;
+  int numeratorAdd_;
+};
+
+LineCells getLineCells(const grid_map::Position& position1, const grid_map::Position& position2, const grid_map::GridMap& gridMap,
+                       const MaxPyramid& pyramid) {
+  if (!gridMap.isDefaultStartIndex() || pyramid.level(0).rows() != gridMap.getSize().x() ||
+      pyramid.level(0).cols() != gridMap.getSize().y()) {
+    throw std::invalid_argument("lookup: the max pyramid does not match the map.");
+  }
+
+  // Map corner points into grid map. The line iteration doesn't account for the case where the line does not intersect the map.
+  grid_map::Index startIndex;
+  grid_map::Index endIndex;
+  gridMap.getIndex(projectToMapWithMargin(gridMap, position1), startIndex);
+  gridMap.getIndex(projectToMapWithMargin(gridMap, position2), endIndex);
+  return {startIndex, endIndex};
+}
+
+/**
+ * Updates maxValue and maxCellId with the first maximum in the cells [first, last], if it is larger than maxValue or equal and before
+ * maxCellId. The upper bound of the values in the cells is passed along to save its computation. The half with the larger bound is
+ * searched first, such that the other half can mostly be skipped.
+ */
+void searchMax(const LineCells& cells, const MaxPyramid& pyramid, const LineCell& first, const LineCell& last, float upperBound,
+               float& maxValue, int& maxCellId) {
+  if (upperBound < maxValue || (upperBound == maxValue && first.id > maxCellId)) {
+    return;
+  }
+  if (last.id - first.id < maxCellsPerLeaf) {
+    float leafMaxValue = std::numeric_limits<float>::lowest();
+    int leafMaxCellId = first.id;
+    for (LineCell cell = first; cell.id <= last.id; cells.next(cell)) {
+      const float value = pyramid.value(cell.index);
+      if (value > leafMaxValue) {
+        leafMaxValue = value;
+        leafMaxCellId = cell.id;
+      }
+    }
+    if (leafMaxValue > maxValue || (leafMaxValue == maxValue && leafMaxCellId < maxCellId)) {
+      maxValue = leafMaxValue;
+      maxCellId = leafMaxCellId;
+    }
+    return;
+  }
+  const LineCell firstHalfLast = cells.split(first, last);
+  LineCell secondHalfFirst = firstHalfLast;
+  cells.next(secondHalfFirst);
+  const float firstHalfUpperBound = pyramid.upperBoundInBox(first.index, firstHalfLast.index);
+  const float secondHalfUpperBound = pyramid.upperBoundInBox(secondHalfFirst.index, last.index);
+  if (secondHalfUpperBound > firstHalfUpperBound) {
+    searchMax(cells, pyramid, secondHalfFirst, last, secondHalfUpperBound, maxValue, maxCellId);
+    searchMax(cells, pyramid, first, firstHalfLast, firstHalfUpperBound, maxValue, maxCellId);
+  } else {
+    searchMax(cells, pyramid, first, firstHalfLast, firstHalfUpperBound, maxValue, maxCellId);
+    searchMax(cells, pyramid, secondHalfFirst, last, secondHalfUpperBound, maxValue, maxCellId);
+  }
+}
+
+/// Returns true if all values in the cells [first, last] are below the threshold.
+bool isBelow(const LineCells& cells, const MaxPyramid& pyramid, const LineCell& first, const LineCell& last, float threshold) {
+  if (pyramid.upperBoundInBox(first.index, last.index) < threshold) {
+    return true;
+  }
+  if (last.id - first.id < maxCellsPerLeaf) {
+    for (LineCell cell = first; cell.id <= last.id; cells.next(cell)) {
+      if (pyramid.value(cell.index) >= threshold) {
+        return false;
+      }
+    }
+    return true;
+  }
+  const LineCell firstHalfLast = cells.split(first, last);
+  LineCell secondHalfFirst = firstHalfLast;
+  cells.next(secondHalfFirst);
+  return isBelow(cells, pyramid, first, firstHalfLast, threshold) && isBelow(cells, pyramid, secondHalfFirst, last, threshold);
+}
+
+}  // namespace
+
 LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
                                       const grid_map::GridMap& gridMap, const grid_map::Matrix& data) {
   // Map corner points into grid map. The line iteration doesn't account for the case where the line does not intersect the map.
@@ -27,8 +187,8 @@ LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const
   for (grid_map::LineIterator iterator(gridMap, startPos, endPos); !iterator.isPastEnd(); ++iterator) {
     const grid_map::Index index = *iterator;
     const auto value = data(index(0), index(1));
-    if (std::isfinite(value)) {
-      searchMaxValue = std::max(searchMaxValue, value);
+    if (std::isfinite(value) && value > searchMaxValue) {
+      searchMaxValue = value;
       maxIndex = index;
     }
   }
@@ -41,8 +201,58 @@ LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const
   return {maxValueFound, searchMaxValue, maxPosition};
 }
 
+LookupResult maxValueBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
+                                      const grid_map::GridMap& gridMap, const MaxPyramid& pyramid) {
+  const LineCells cells = getLineCells(position1, position2, gridMap, pyramid);
+
+  // The bound of the whole line can not prune anything, the search starts with the bounds of the halves.
+  float searchMaxValue = std::numeric_limits<float>::lowest();
+  int maxCellId = 0;
+  searchMax(cells, pyramid, cells.first(), cells.last(), std::numeric_limits<float>::max(), searchMaxValue, maxCellId);
+
+  // Get position of max
+  grid_map::Position maxPosition;
+  gridMap.getPosition((maxCellId == 0) ? cells.first().index : cells.at(maxCellId).index, maxPosition);
+
+  const bool maxValueFound = searchMaxValue > std::numeric_limits<float>::lowest();
+  return {maxValueFound, searchMaxValue, maxPosition};
+}
+
+bool isMaxValueBelow(const grid_map::Position& position1, const grid_map::Position& position2, const grid_map::GridMap& gridMap,
+                     const MaxPyramid& pyramid, float threshold) {
+  const LineCells cells = getLineCells(position1, position2, gridMap, pyramid);
+  return isBelow(cells, pyramid, cells.first(), cells.last(), threshold);
+}
+
+void maxValuesBetweenLocations(const std::vector<LookupSegment>& segments, const grid_map::GridMap& gridMap, const MaxPyramid& pyramid,
+                               std::vector<LookupResult>& results) {
+  results.resize(segments.size());
+  parallel::forEachRange(0, static_cast<int>(segments.size()), [&](int segmentBegin, int segmentEnd) {
+    for (int segmentId = segmentBegin; segmentId < segmentEnd; ++segmentId) {
+      results[segmentId] = maxValueBetweenLocations(segments[segmentId].start, segments[segmentId].end, gridMap, pyramid);
+    }
+  });
+}
+
+void areMaxValuesBelow(const std::vector<LookupSegment>& segments, const grid_map::GridMap& gridMap, const MaxPyramid& pyramid,
+                       float threshold, std::vector<uint8_t>& isBelow) {
+  isBelow.resize(segments.size());
+  parallel::forEachRange(0, static_cast<int>(segments.size()), [&](int segmentBegin, int segmentEnd) {
+    for (int segmentId = segmentBegin; segmentId < segmentEnd; ++segmentId) {
+      isBelow[segmentId] = isMaxValueBelow(segments[segmentId].start, segments[segmentId].end, gridMap, pyramid, threshold) ? 1 : 0;
+    }
+  });
+}
+
 std::vector<grid_map::Position3> valuesBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2,
                                                         const grid_map::GridMap& gridMap, const grid_map::Matrix& data) {
+  std::vector<grid_map::Position3> lineValues;
+  valuesBetweenLocations(position1, position2, gridMap, data, lineValues);
+  return lineValues;
+}
+
+void valuesBetweenLocations(const grid_map::Position& position1, const grid_map::Position& position2, const grid_map::GridMap& gridMap,
+                            const grid_map::Matrix& data, std::vector<grid_map::Position3>& lineValues) {
   // Map corner points into grid map. The line iteration doesn't account for the case where the line does not intersect the map.
   const grid_map::Position startPos = projectToMapWithMargin(gridMap, position1);
   const grid_map::Position endPos = projectToMapWithMargin(gridMap, position2);
@@ -52,7 +262,7 @@ std::vector<grid_map::Position3> valuesBetweenLocations(const grid_map::Position
   const int manhattanPixels = std::ceil(manhattanDistance / gridMap.getResolution()) + 1;
 
   // Container for results
-  std::vector<grid_map::Position3> lineValues;
+  lineValues.clear();
   lineValues.reserve(manhattanPixels);
 
   // Line iteration
@@ -66,8 +276,6 @@ std::vector<grid_map::Position3> valuesBetweenLocations(const grid_map::Position
       lineValues.push_back({position.x(), position.y(), value});
     }
   }
-
-  return lineValues;
 }
 
 grid_map::Position projectToMapWithMargin(const grid_map::GridMap& gridMap, const grid_map::Position& position, double margin) {
@@ -7,173 +7,477 @@
  */
 
 // grid map filters rsl.
+#include <grid_map_filters_rsl/parallel.hpp>
 #include <grid_map_filters_rsl/processing.hpp>
 
+// stl.
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
 namespace grid_map {
 namespace processing {
 
-void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
-            bool inpaint) {
-  // Create new layer if missing
-  if (!map.exists(layerOut)) {
-    map.add(layerOut, map.get(layerIn));
-  }
+namespace {
 
-  // Reference to in and out maps.
-  const grid_map::Matrix& H_in = map.get(layerIn);
-  grid_map::Matrix& H_out = map.get(layerOut);
+/// Max of two values, ignoring nan. Nan if both are nan.
+struct MaxOfFinites {
+  static float apply(float a, float b) { return std::isnan(a) ? b : ((std::isnan(b) || a >= b) ? a : b); }
+};
 
-  // Apply mask.
-  grid_map::Matrix H_in_masked;
-  if (mask.cols() == 0 || mask.rows() == 0) {
-    H_in_masked = H_in;
-  } else {
-    H_in_masked = H_in.cwiseProduct(mask);
+/// Min of two values, ignoring nan. Nan if both are nan.
+struct MinOfFinites {
+  static float apply(float a, float b) { return std::isnan(a) ? b : ((std::isnan(b) || a <= b) ? a : b); }
+};
+
+/**
+ * Reduces the values in a window along each row with Op, using the van Herk/Gil-Werman algorithm: The row is split into blocks of the
+ * window size, in which running reductions from the left (prefix) and from the right (suffix) are computed. Every window covers the end
+ * of one block and the start of the next one, such that it takes three reductions per cell regardless of the window size.
+ *
+ * The window of column c starts at c - windowOffset. If clipAtBorder, the window is clipped at the map border. Otherwise, it is shifted
+ * to stay inside the map. Ranges of rows are processed in parallel.
+ */
+template <typename Op>
+Eigen::MatrixXf reduceAlongRows(const Eigen::MatrixXf& in, int windowSize, int windowOffset, bool clipAtBorder) {
+  const int numRows = in.rows();
+  const int numCols = in.cols();
+  if (!clipAtBorder) {
+    windowSize = std::min(windowSize, numCols);
   }
-  const auto maxKernelId = (kernelSize - 1) / 2;
+  // Columns of nan before and after the map, such that clipped windows do not need special treatment.
+  const int paddingBefore = clipAtBorder ? windowOffset : 0;
+  const int paddingAfter = clipAtBorder ? windowSize - 1 - windowOffset : 0;
+  const int numPaddedCols = paddingBefore + numCols + paddingAfter;
+  Eigen::MatrixXf out(numRows, numCols);
 
-  for (auto colId = 0; colId < H_in.cols(); ++colId) {
-    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
-      // Move index to the korner of the kernel window.
-      auto cornerColId = std::max(colId - maxKernelId, 0);
-      auto cornerRowId = std::max(rowId - maxKernelId, 0);
+  parallel::forEachRange(0, numRows, [&](int rowBegin, int rowEnd) {
+    const int numRowsInRange = rowEnd - rowBegin;
+    const std::vector<float> nanColumn(numRowsInRange, NAN);
+    auto paddedColumn = [&](int paddedColId) {
+      const int colId = paddedColId - paddingBefore;
+      return (colId < 0 || colId >= numCols) ? nanColumn.data() : in.col(colId).data() + rowBegin;
+    };
+    auto reduce = [numRowsInRange](const float* a, const float* b, float* result) {
+      for (int i = 0; i < numRowsInRange; ++i) {
+        result[i] = Op::apply(a[i], b[i]);
+      }
+    };
 
-      // Make sure we don't overshoot.
-      if (cornerColId + kernelSize > H_in.cols()) {
-        cornerColId = H_in.cols() - kernelSize;
+    Eigen::MatrixXf prefix(numRowsInRange, numPaddedCols);
+    for (int colId = 0; colId < numPaddedCols; ++colId) {
+      if (colId % windowSize == 0) {
+        std::copy_n(paddedColumn(colId), numRowsInRange, prefix.col(colId).data());
+      } else {
+        reduce(prefix.col(colId - 1).data(), paddedColumn(colId), prefix.col(colId).data());
       }
+    }
+    Eigen::MatrixXf suffix(numRowsInRange, numPaddedCols);
+    for (int colId = numPaddedCols - 1; colId >= 0; --colId) {
+      if (colId % windowSize == windowSize - 1 || colId == numPaddedCols - 1) {
+        std::copy_n(paddedColumn(colId), numRowsInRange, suffix.col(colId).data());
+      } else {
+        reduce(paddedColumn(colId), suffix.col(colId + 1).data(), suffix.col(colId).data());
+      }
+    }
 
-      if (cornerRowId + kernelSize > H_in.rows()) {
-        cornerRowId = H_in.rows() - kernelSize;
+    for (int colId = 0; colId < numCols; ++colId) {
+      // First column of the window, in padded coordinates.
+      const int windowStart = clipAtBorder ? colId : std::max(0, std::min(colId - windowOffset, numCols - windowSize));
+      reduce(suffix.col(windowStart).data(), prefix.col(windowStart + windowSize - 1).data(), out.col(colId).data() + rowBegin);
+    }
+  });
+  return out;
+}
+
+/**
+ * Reduces the values in the structuring element of every cell with Op.
+ * The square is separable into a reduction along the rows followed by one along the columns. The disk is decomposed into one row segment
+ * per row offset. The segments are reduced along the rows once per distinct half width and then combined along the columns.
+ */
+template <typename Op>
+Eigen::MatrixXf reduceInKernel(const Eigen::MatrixXf& in, int kernelSize, KernelShape shape) {
+  const int maxKernelId = (kernelSize - 1) / 2;
+  if (shape == KernelShape::Square) {
+    const Eigen::MatrixXf alongRows = reduceAlongRows<Op>(in, kernelSize, maxKernelId, false);
+    const Eigen::MatrixXf alongCols = reduceAlongRows<Op>(alongRows.transpose(), kernelSize, maxKernelId, false);
+    return alongCols.transpose();
+  }
+
+  // Half width of the disk at each row offset.
+  std::vector<int> halfWidths(maxKernelId + 1);
+  std::vector<Eigen::MatrixXf> segments;
+  std::vector<int> segmentIds(maxKernelId + 1);
+  for (int rowOffset = 0; rowOffset <= maxKernelId; ++rowOffset) {
+    halfWidths[rowOffset] = static_cast<int>(std::sqrt(static_cast<double>(maxKernelId * maxKernelId - rowOffset * rowOffset)));
+    if (rowOffset == 0 || halfWidths[rowOffset] != halfWidths[rowOffset - 1]) {
+      segments.push_back(reduceAlongRows<Op>(in, 2 * halfWidths[rowOffset] + 1, halfWidths[rowOffset], true));
+    }
+    segmentIds[rowOffset] = static_cast<int>(segments.size()) - 1;
+  }
+
+  const int numRows = in.rows();
+  Eigen::MatrixXf out(in.rows(), in.cols());
+  parallel::forEachRange(0, static_cast<int>(in.cols()), [&](int colBegin, int colEnd) {
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      float* result = out.col(colId).data();
+      std::fill_n(result, numRows, NAN);
+      for (int rowOffset = -maxKernelId; rowOffset <= maxKernelId; ++rowOffset) {
+        const float* segment = segments[segmentIds[std::abs(rowOffset)]].col(colId).data() + rowOffset;
+        for (int rowId = std::max(0, -rowOffset); rowId < std::min(numRows, numRows - rowOffset); ++rowId) {
+          result[rowId] = Op::apply(result[rowId], segment[rowId]);
+        }
       }
+    }
+  });
+  return out;
+}
+
+/**
+ * Dilation (Op = MaxOfFinites) or erosion (Op = MinOfFinites) of H_in, where H_in_masked are the values of H_in that are considered by the
+ * filter. The reduction is computed once for all cells and then written to the cells that are filtered. Non-finite values are ignored, as
+ * in maxCoeffOfFinites / minCoeffOfFinites.
+ */
+template <typename Op>
+grid_map::Matrix morphologicalFilter(const grid_map::Matrix& H_in, grid_map::Matrix H_in_masked, int kernelSize, bool inpaint,
+                                     KernelShape shape) {
+  H_in_masked = H_in_masked.unaryExpr([](float value) { return std::isfinite(value) ? value : NAN; });
 
-      // Find maximum in region.
+  const grid_map::Matrix reducedInKernel = reduceInKernel<Op>(H_in_masked, kernelSize, shape);
+
+  grid_map::Matrix H_out(H_in.rows(), H_in.cols());
+  for (auto colId = 0; colId < H_in.cols(); ++colId) {
+    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
       if (inpaint || !std::isnan(H_in(rowId, colId))) {
-        const auto maxInKernel = H_in_masked.block(cornerRowId, cornerColId, kernelSize, kernelSize).maxCoeffOfFinites();
-        H_out(rowId, colId) = std::isnan(maxInKernel) ? H_in(rowId, colId) : maxInKernel;
+        const auto valueInKernel = reducedInKernel(rowId, colId);
+        H_out(rowId, colId) = std::isnan(valueInKernel) ? H_in(rowId, colId) : valueInKernel;
       } else {
         H_out(rowId, colId) = NAN;
       }
     }
   }
+  return H_out;
 }
 
-void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
-           bool inpaint) {
-  // Create new layer if missing
-  if (!map.exists(layerOut)) {
-    map.add(layerOut, map.get(layerIn));
+/**
+ * Same as above, with the values considered by the filter given as the valid cells of a bit mask, which are finite in H_in. Cells without
+ * valid cells in their square window keep their value, which is copied for whole words of such cells.
+ */
+template <typename Op>
+grid_map::Matrix morphologicalFilter(const grid_map::Matrix& H_in, const mask::ValidityMask& validity, int kernelSize, bool inpaint,
+                                     KernelShape shape) {
+  if (validity.rows() != H_in.rows() || validity.cols() != H_in.cols()) {
+    throw std::invalid_argument("processing: the size of the validity mask does not match the layer.");
   }
+  const grid_map::Matrix reducedInKernel = reduceInKernel<Op>(validity.applyTo(H_in), kernelSize, shape);
+  // The square window contains the disk, such that the disk can be empty in cells of this mask.
+  const mask::ValidityMask isFiltered = validity.dilated(kernelSize);
 
-  // Reference to in and out maps.
-  const grid_map::Matrix& H_in = map.get(layerIn);
-  grid_map::Matrix& H_out = map.get(layerOut);
+  const int numRows = H_in.rows();
+  grid_map::Matrix H_out(H_in.rows(), H_in.cols());
+  parallel::forEachRange(0, static_cast<int>(H_in.cols()), [&](int colBegin, int colEnd) {
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      for (int wordId = 0; wordId < isFiltered.wordsPerCol(); ++wordId) {
+        const int rowBegin = wordId * mask::ValidityMask::bitsPerWord;
+        const int numRowsInWord = std::min(mask::ValidityMask::bitsPerWord, numRows - rowBegin);
+        const float* in = H_in.col(colId).data() + rowBegin;
+        const float* reduced = reducedInKernel.col(colId).data() + rowBegin;
+        float* out = H_out.col(colId).data() + rowBegin;
+        const auto bits = isFiltered.word(wordId, colId);
+        if (bits == 0) {
+          std::copy_n(in, numRowsInWord, out);
+        } else if (bits == isFiltered.fullWord(wordId) && inpaint && shape == KernelShape::Square) {
+          std::copy_n(reduced, numRowsInWord, out);
+        } else {
+          for (int i = 0; i < numRowsInWord; ++i) {
+            out[i] = (!std::isnan(reduced[i]) && (inpaint || !std::isnan(in[i]))) ? reduced[i] : in[i];
+          }
+        }
+      }
+    }
+  });
+  return H_out;
+}
+
+/// Same as above, from layerIn to layerOut of the map.
+template <typename Op>
+void morphologicalFilter(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, grid_map::Matrix H_in_masked,
+                         int kernelSize, bool inpaint, KernelShape shape) {
+  map.add(layerOut, morphologicalFilter<Op>(map.get(layerIn), std::move(H_in_masked), kernelSize, inpaint, shape));
+}
 
-  // Apply mask.
-  grid_map::Matrix H_in_masked;
+/// Values of the layer that are considered by the filter, with the float mask. An empty mask keeps all values.
+grid_map::Matrix applyMask(const grid_map::GridMap& map, const std::string& layer, const grid_map::Matrix& mask) {
   if (mask.cols() == 0 || mask.rows() == 0) {
-    H_in_masked = H_in;
-  } else {
-    H_in_masked = H_in.cwiseProduct(mask);
+    return map.get(layer);
   }
-  const auto maxKernelId = (kernelSize - 1) / 2;
+  return map.get(layer).cwiseProduct(mask);
+}
 
-  for (auto colId = 0; colId < H_in.cols(); ++colId) {
-    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
-      // Move index to the korner of the kernel window.
-      auto cornerColId = std::max(colId - maxKernelId, 0);
-      auto cornerRowId = std::max(rowId - maxKernelId, 0);
+/**
+ * Upper envelope of cones height - costs[|x - position|], the generalized distance transform of Felzenszwalb and Huttenlocher restricted
+ * to a range of query positions. Cones are added in increasing position while the query position increases. Two cones of the same
+ * convex cost intersect at most once, such that a later cone that is above an earlier one stays above it for all larger x.
+ */
+class ConeEnvelope {
+ public:
+  explicit ConeEnvelope(const float* costs) : costs_(costs) {}
 
-      // Make sure we don't overshoot.
-      if (cornerColId + kernelSize > H_in.cols()) {
-        cornerColId = H_in.cols() - kernelSize;
-      }
+  /// Removes all cones. Queries will be in [xBegin, xEnd], where all cones must be within the cost range.
+  void reset(int xBegin, int xEnd) {
+    positions_.clear();
+    heights_.clear();
+    starts_.clear();
+    frontId_ = 0;
+    x_ = xBegin;
+    xEnd_ = xEnd;
+  }
 
-      if (cornerRowId + kernelSize > H_in.rows()) {
-        cornerRowId = H_in.rows() - kernelSize;
+  void add(int position, float height) {
+    while (positions_.size() > frontId_) {
+      const int start = findStart(position, height);
+      if (start > xEnd_) {
+        return;  // Never above the last cone.
+      }
+      if (positions_.size() > frontId_ + 1 && start <= starts_.back()) {
+        removeLast();  // The last cone is never above both its neighbours.
+      } else if (positions_.size() == frontId_ + 1 && start <= x_) {
+        removeLast();  // Already above the front.
+      } else {
+        push(position, height, start);
+        return;
       }
+    }
+    push(position, height, x_);
+  }
 
-      // Find minimum in region.
-      if (inpaint || !std::isnan(H_in(rowId, colId))) {
-        const auto minInKernel = H_in_masked.block(cornerRowId, cornerColId, kernelSize, kernelSize).minCoeffOfFinites();
-        H_out(rowId, colId) = std::isnan(minInKernel) ? H_in(rowId, colId) : minInKernel;
+  /// Moves the query position to x, cones added afterwards are only evaluated from x on.
+  void moveTo(int x) {
+    x_ = x;
+    while (frontId_ + 1 < positions_.size() && starts_[frontId_ + 1] <= x) {
+      ++frontId_;
+    }
+  }
+
+  /// Max of all cones at the query position, -infinity if there are none.
+  float max() const { return (positions_.size() == frontId_) ? -std::numeric_limits<float>::infinity() : value(frontId_, x_); }
+
+ private:
+  float value(size_t id, int x) const { return heights_[id] - costs_[std::abs(x - positions_[id])]; }
+
+  /// First x in [x_, xEnd_] at which the new cone is not below the last one, xEnd_ + 1 if there is none.
+  int findStart(int position, float height) const {
+    const size_t lastId = positions_.size() - 1;
+    auto isNotBelow = [&](int x) { return height - costs_[std::abs(x - position)] >= value(lastId, x); };
+    int begin = std::max(x_, starts_.back());
+    int end = xEnd_ + 1;
+    // Most cones are either above or below the last one over the whole range.
+    if (isNotBelow(begin)) {
+      return begin;
+    }
+    if (!isNotBelow(xEnd_)) {
+      return end;
+    }
+    while (begin < end) {
+      const int x = begin + (end - begin) / 2;
+      if (isNotBelow(x)) {
+        end = x;
       } else {
-        H_out(rowId, colId) = NAN;
+        begin = x + 1;
       }
     }
+    return begin;
   }
-}
 
-void outline(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut) {
-  // Create new layer if missing
-  if (!map.exists(layerOut)) {
-    map.add(layerOut, map.get(layerIn));
+  void push(int position, float height, int start) {
+    positions_.push_back(position);
+    heights_.push_back(height);
+    starts_.push_back(start);
   }
 
-  // Reference to in and out maps.
-  const grid_map::Matrix& H_in = map.get(layerIn);
-  grid_map::Matrix& H_out = map.get(layerOut);
+  void removeLast() {
+    positions_.pop_back();
+    heights_.pop_back();
+    starts_.pop_back();
+  }
 
-  constexpr auto kernelSize = 3;
-  constexpr auto maxKernelId = (kernelSize - 1) / 2;
+  const float* costs_;
+  std::vector<int> positions_;
+  std::vector<float> heights_;
+  std::vector<int> starts_;  // First query position at which the cone is the maximum.
+  size_t frontId_ = 0;
+  int x_ = 0;
+  int xEnd_ = 0;
+};
 
-  for (auto colId = 0; colId < H_in.cols(); ++colId) {
-    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
-      // Move index to the korner of the kernel window.
-      auto cornerColId = std::max(colId - maxKernelId, 0);
-      auto cornerRowId = std::max(rowId - maxKernelId, 0);
+/**
+ * out[x] = max(in[q] - costs[|x - q|]) with the costs of the envelope, over all finite in[q] with |x - q| <= maxDistance, -infinity if
+ * there are none. As in the van Herk/Gil-Werman algorithm, the line is split into blocks of the window size 2 * maxDistance + 1. Each
+ * window covers the end of one block, whose cones are collected with decreasing x, and the start of the next block, whose cones are
+ * collected with increasing x. Both sets only grow, such that it takes amortized O(log(maxDistance)) per cell.
+ */
+void coneDilateLineWithEnvelope(const float* in, float* out, int size, int maxDistance, ConeEnvelope& envelope) {
+  const int windowSize = 2 * maxDistance + 1;
+  auto isValid = [&](int position) { return position >= 0 && position < size && !std::isnan(in[position]); };
 
-      // Make sure we don't overshoot.
-      if (cornerColId + kernelSize > H_in.cols()) {
-        cornerColId = H_in.cols() - kernelSize;
-      }
+  // The windows [x - maxDistance, x + maxDistance] of x in [blockStart, blockStart + windowSize - 1] start in the block that ends at
+  // blockStart + maxDistance and end in the next block.
+  for (int blockStart = 0; blockStart < size; blockStart += windowSize) {
+    const int xBegin = blockStart;
+    const int xEnd = std::min(size - 1, blockStart + windowSize - 1);
 
-      if (cornerRowId + kernelSize > H_in.rows()) {
-        cornerRowId = H_in.rows() - kernelSize;
+    // End of the block: [x - maxDistance, blockEnd], mirrored such that positions and queries increase.
+    const int blockEnd = blockStart + maxDistance;
+    envelope.reset(-xEnd, -xBegin);
+    for (int x = xEnd; x >= xBegin; --x) {
+      envelope.moveTo(-x);
+      for (int position = (x == xEnd) ? blockEnd : x - maxDistance; position >= x - maxDistance; --position) {
+        if (isValid(position)) {
+          envelope.add(-position, in[position]);
+        }
       }
+      out[x] = envelope.max();
+    }
 
-      // Check if grid cell touches the nan grid cell.
-      if (H_in.block(cornerRowId, cornerColId, kernelSize, kernelSize).hasNaN()) {
-        H_out(rowId, colId) = H_in(rowId, colId);
-      } else {
-        H_out(rowId, colId) = NAN;
+    // Start of the next block: [blockEnd + 1, x + maxDistance].
+    envelope.reset(xBegin, xEnd);
+    for (int x = xBegin; x <= xEnd; ++x) {
+      envelope.moveTo(x);
+      for (int position = (x == xBegin) ? blockEnd + 1 : x + maxDistance; position <= x + maxDistance; ++position) {
+        if (isValid(position)) {
+          envelope.add(position, in[position]);
+        }
       }
+      out[x] = std::max(out[x], envelope.max());
     }
   }
 }
 
-void applyKernelFunction(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize,
-                         std::function<float(const Eigen::Ref<const grid_map::GridMap::Matrix>&)> func) {
-  // Create new layer if missing
-  if (!map.exists(layerOut)) {
-    map.add(layerOut, map.get(layerIn));
+/// Same as coneDilateLineWithEnvelope, by going through the window. Nan values drop out, since std::max(a, nan) = a.
+void coneDilateLineDirectly(const float* in, float* out, int size, const float* costs, int maxDistance) {
+  std::fill_n(out, size, -std::numeric_limits<float>::infinity());
+  for (int distance = -maxDistance; distance <= maxDistance; ++distance) {
+    const float cost = costs[std::abs(distance)];
+    const float* shiftedIn = in + distance;
+    for (int x = std::max(0, -distance); x < std::min(size, size - distance); ++x) {
+      out[x] = std::max(out[x], shiftedIn[x] - cost);
+    }
   }
+}
 
-  // Reference to in and out maps.
-  const grid_map::Matrix& H_in = map.get(layerIn);
-  grid_map::Matrix& H_out = map.get(layerOut);
-
-  const auto maxKernelId = (kernelSize - 1) / 2;
+/**
+ * out(p) = max(in(q) - slope * |p - q|) over q in the window of size kernelSize around p, clipped at the border. The Euclidean distance is
+ * not separable. Instead, the window is decomposed into its columns: For each column offset, the cones are reduced along the columns of
+ * the map, which are then combined.
+ */
+Eigen::MatrixXf coneDilateMatrix(const Eigen::MatrixXf& in, float slope, int kernelSize) {
+  // Going through the window is O(kernelSize^2) per cell instead of O(kernelSize * log(kernelSize)), but it vectorizes well, such that it
+  // is faster than the envelope for windows of up to ~100 cells.
+  constexpr int minWindowSizeForEnvelope = 101;
 
-  for (auto colId = 0; colId < H_in.cols(); ++colId) {
-    for (auto rowId = 0; rowId < H_in.rows(); ++rowId) {
-      // Move index to the korner of the kernel window.
-      auto cornerColId = std::max(colId - maxKernelId, 0);
-      auto cornerRowId = std::max(rowId - maxKernelId, 0);
+  const int maxKernelId = (kernelSize - 1) / 2;
+  const int numRows = in.rows();
+  const int numCols = in.cols();
+  const Eigen::MatrixXf inWithNaN = in.unaryExpr([](float value) { return std::isfinite(value) ? value : NAN; });
+  Eigen::MatrixXf out = Eigen::MatrixXf::Constant(numRows, numCols, -std::numeric_limits<float>::infinity());
+  Eigen::MatrixXf alongCols(numRows, numCols);
+  std::vector<float> costs(maxKernelId + 1);
 
-      // Make sure we don't overshoot.
-      if (cornerColId + kernelSize > H_in.cols()) {
-        cornerColId = H_in.cols() - kernelSize;
+  for (int colOffset = 0; colOffset <= maxKernelId; ++colOffset) {
+    for (int rowOffset = 0; rowOffset <= maxKernelId; ++rowOffset) {
+      costs[rowOffset] = slope * std::sqrt(rowOffset * rowOffset + colOffset * colOffset);
+    }
+    parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+      ConeEnvelope envelope(costs.data());
+      for (int colId = colBegin; colId < colEnd; ++colId) {
+        if (kernelSize < minWindowSizeForEnvelope) {
+          coneDilateLineDirectly(inWithNaN.col(colId).data(), alongCols.col(colId).data(), numRows, costs.data(), maxKernelId);
+        } else {
+          coneDilateLineWithEnvelope(inWithNaN.col(colId).data(), alongCols.col(colId).data(), numRows, maxKernelId, envelope);
+        }
       }
-
-      if (cornerRowId + kernelSize > H_in.rows()) {
-        cornerRowId = H_in.rows() - kernelSize;
+    });
+    parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+      for (int colId = colBegin; colId < colEnd; ++colId) {
+        auto combine = [&](int sourceColId) {
+          out.col(colId) = out.col(colId).cwiseMax(alongCols.col(sourceColId));
+        };
+        if (colId - colOffset >= 0) {
+          combine(colId - colOffset);
+        }
+        if (colOffset > 0 && colId + colOffset < numCols) {
+          combine(colId + colOffset);
+        }
       }
-
-      // Apply user defined function
-      H_out(rowId, colId) = func(H_in.block(cornerRowId, cornerColId, kernelSize, kernelSize));
-    }
+    });
   }
+
+  // Cells without finite values in their window.
+  return out.unaryExpr([](float value) { return std::isinf(value) ? NAN : value; });
+}
+
+}  // namespace
+
+void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
+            bool inpaint, KernelShape shape) {
+  morphologicalFilter<MaxOfFinites>(map, layerIn, layerOut, applyMask(map, layerIn, mask), kernelSize, inpaint, shape);
+}
+
+void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const grid_map::Matrix& mask, int kernelSize,
+           bool inpaint, KernelShape shape) {
+  morphologicalFilter<MinOfFinites>(map, layerIn, layerOut, applyMask(map, layerIn, mask), kernelSize, inpaint, shape);
+}
+
+void dilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+            int kernelSize, bool inpaint, KernelShape shape) {
+  map.add(layerOut, morphologicalFilter<MaxOfFinites>(map.get(layerIn), validity, kernelSize, inpaint, shape));
+}
+
+void erode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+           int kernelSize, bool inpaint, KernelShape shape) {
+  map.add(layerOut, morphologicalFilter<MinOfFinites>(map.get(layerIn), validity, kernelSize, inpaint, shape));
+}
+
+grid_map::Matrix dilate(const grid_map::Matrix& data, int kernelSize, bool inpaint, KernelShape shape) {
+  return morphologicalFilter<MaxOfFinites>(data, data, kernelSize, inpaint, shape);
+}
+
+grid_map::Matrix erode(const grid_map::Matrix& data, int kernelSize, bool inpaint, KernelShape shape) {
+  return morphologicalFilter<MinOfFinites>(data, data, kernelSize, inpaint, shape);
+}
+
+grid_map::Matrix coneDilate(const grid_map::Matrix& data, float slope, int kernelSize) {
+  return coneDilateMatrix(data, slope, kernelSize);
+}
+
+grid_map::Matrix coneErode(const grid_map::Matrix& data, float slope, int kernelSize) {
+  return -coneDilateMatrix(-data, slope, kernelSize);
+}
+
+void coneDilate(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, float slope, int kernelSize) {
+  map.add(layerOut, coneDilateMatrix(map.get(layerIn), slope, kernelSize));
+}
+
+void coneErode(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, float slope, int kernelSize) {
+  map.add(layerOut, -coneDilateMatrix(-map.get(layerIn), slope, kernelSize));
+}
+
+void outline(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut) {
+  outline(map, layerIn, layerOut, mask::ValidityMask::fromLayer(map, layerIn));
+}
+
+void outline(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity) {
+  // Valid cells with an invalid cell in their window.
+  constexpr auto kernelSize = 3;
+  const mask::ValidityMask isOutline = validity & (~validity).dilated(kernelSize);
+  map.add(layerOut, isOutline.applyTo(map.get(layerIn)));
+}
+
+void applyKernelFunction(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize,
+                         std::function<float(const Eigen::Ref<const grid_map::GridMap::Matrix>&)> func) {
+  applyKernelFunction(
+      map, layerIn, layerOut, kernelSize, [&func](const Eigen::Block<const grid_map::Matrix>& data) -> float { return func(data); }, false);
 }
 
 }  // namespace processing
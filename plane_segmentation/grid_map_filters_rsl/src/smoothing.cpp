@@ -7,6 +7,7 @@
  */
 
 // grid map filters rsl.
+#include <grid_map_filters_rsl/parallel.hpp>
 #include <grid_map_filters_rsl/smoothing.hpp>
 
 // open cv.
@@ -17,54 +18,271 @@
 #include <opencv2/photo.hpp>
 #include <opencv2/xphoto/bm3d_image_denoising.hpp>
 
+// stl.
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
 namespace grid_map {
 namespace smoothing {
 
-void median(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize, int deltaKernelSize,
-            int numberOfRepeats) {
-  // Create new layer if missing.
-  if (!map.exists(layerOut)) {
-    map.add(layerOut);
+namespace {
+
+/// Value and index of its cell. Ordered by value and then by index, such that all values in a region have a unique rank.
+struct RankedValue {
+  float value;
+  int index;
+};
+
+bool operator<(const RankedValue& lhs, const RankedValue& rhs) {
+  return lhs.value < rhs.value || (lhs.value == rhs.value && lhs.index < rhs.index);
+}
+
+/**
+ * Set of ranks stored as bitset. Tracks the median while ranks are inserted and erased: numBelow_ counts the ranks below pointer_, such
+ * that the median only has to be moved by the number of changed ranks.
+ */
+class RankWindow {
+ public:
+  void reset(int numRanks) {
+    words_.assign((numRanks + 63) / 64, 0);
+    count_ = 0;
+    pointer_ = -1;
+    numBelow_ = 0;
   }
 
-  if (kernelSize + deltaKernelSize * (numberOfRepeats - 1) <= 5) {
-    // Convert to image.
-    cv::Mat elevationImage;
-    cv::eigen2cv(map.get(layerIn), elevationImage);
+  void insert(int rank) {
+    words_[rank / 64] |= bit(rank);
+    ++count_;
+    if (rank < pointer_) {
+      ++numBelow_;
+    }
+  }
 
-    for (auto iter = 0; iter < numberOfRepeats; ++iter) {
-      cv::medianBlur(elevationImage, elevationImage, kernelSize);
-      kernelSize += deltaKernelSize;
+  void erase(int rank) {
+    words_[rank / 64] &= ~bit(rank);
+    --count_;
+    if (rank < pointer_) {
+      --numBelow_;
     }
+  }
+
+  int count() const { return count_; }
 
-    // Set output layer.
-    cv::cv2eigen(elevationImage, map.get(layerOut));
+  /// Ranks of the lower and upper median, which are equal for an odd count. Requires count() > 0.
+  std::pair<int, int> medianRanks() {
+    if (pointer_ < 0 || (words_[pointer_ / 64] & bit(pointer_)) == 0) {
+      const int next = findNext(std::max(pointer_, 0));
+      if (next >= 0) {
+        pointer_ = next;
+      } else {
+        pointer_ = findPrevious(pointer_);
+        --numBelow_;
+      }
+    }
+    const int medianId = (count_ - 1) / 2;
+    while (numBelow_ < medianId) {
+      pointer_ = findNext(pointer_ + 1);
+      ++numBelow_;
+    }
+    while (numBelow_ > medianId) {
+      pointer_ = findPrevious(pointer_ - 1);
+      --numBelow_;
+    }
+    return {pointer_, (count_ % 2 == 1) ? pointer_ : findNext(pointer_ + 1)};
   }
 
-  // Larger kernel sizes require a specific format.
-  else {
-    // Reference to in map.
-    const grid_map::Matrix& H_in = map.get(layerIn);
+ private:
+  static uint64_t bit(int rank) { return uint64_t{1} << (rank % 64); }
 
-    // Convert grid map to image.
+  /// Smallest rank >= rank in the set, -1 if there is none.
+  int findNext(int rank) const {
+    int wordId = rank / 64;
+    if (wordId >= static_cast<int>(words_.size())) {
+      return -1;
+    }
+    uint64_t word = words_[wordId] & (~uint64_t{0} << (rank % 64));
+    while (word == 0) {
+      if (++wordId == static_cast<int>(words_.size())) {
+        return -1;
+      }
+      word = words_[wordId];
+    }
+    return 64 * wordId + __builtin_ctzll(word);
+  }
+
+  /// Largest rank <= rank in the set, -1 if there is none.
+  int findPrevious(int rank) const {
+    if (rank < 0) {
+      return -1;
+    }
+    int wordId = rank / 64;
+    uint64_t word = words_[wordId] & (~uint64_t{0} >> (63 - rank % 64));
+    while (word == 0) {
+      if (--wordId < 0) {
+        return -1;
+      }
+      word = words_[wordId];
+    }
+    return 64 * wordId + 63 - __builtin_clzll(word);
+  }
+
+  std::vector<uint64_t> words_;
+  int count_ = 0;
+  int pointer_ = -1;
+  int numBelow_ = 0;
+};
+
+/**
+ * Exact median of the valid values in the kernelSize x kernelSize window around each cell, clipped at the border. Invalid cells are nan.
+ * The valid values are collected from the words of the mask, such that words without valid cells are skipped. For each column, the valid
+ * values of the columns in its window are sorted once, which is updated incrementally from one column to the next. The window then slides
+ * down the column as set of ranks, in the spirit of Huang's running median, such that each step only changes 2 * kernelSize ranks. Ranges
+ * of columns are processed in parallel.
+ */
+grid_map::Matrix medianOfValid(const grid_map::Matrix& H_in, const mask::ValidityMask& validity, int kernelSize) {
+  const int numRows = H_in.rows();
+  const int numCols = H_in.cols();
+  const int maxKernelId = (kernelSize - 1) / 2;
+  grid_map::Matrix H_out(numRows, numCols);
+
+  parallel::forEachRange(0, numCols, [&](int colBegin, int colEnd) {
+    // Rank of each cell in the sorted values of the current window columns, -1 for invalid cells. Only the columns around the range are
+    // stored.
+    const int firstStoredColId = std::max(0, colBegin - maxKernelId);
+    const int lastStoredColId = std::min(numCols - 1, colEnd - 1 + maxKernelId);
+    std::vector<int> ranks((lastStoredColId - firstStoredColId + 1) * numRows, -1);
+    auto storageIndex = [&](int rowId, int colId) { return (colId - firstStoredColId) * numRows + rowId; };
+
+    std::vector<RankedValue> sortedValues;
+    std::vector<RankedValue> columnValues;
+    std::vector<RankedValue> mergedValues;
+    auto sortedColumn = [&](int colId) -> const std::vector<RankedValue>& {
+      columnValues.clear();
+      for (int wordId = 0; wordId < validity.wordsPerCol(); ++wordId) {
+        for (auto bits = validity.word(wordId, colId); bits != 0; bits &= bits - 1) {
+          const int rowId = wordId * mask::ValidityMask::bitsPerWord + __builtin_ctzll(bits);
+          columnValues.push_back({H_in(rowId, colId), storageIndex(rowId, colId)});
+        }
+      }
+      std::sort(columnValues.begin(), columnValues.end());
+      return columnValues;
+    };
+
+    RankWindow window;
+    for (int colId = colBegin; colId < colEnd; ++colId) {
+      const int windowColBegin = std::max(0, colId - maxKernelId);
+      const int windowColEnd = std::min(numCols, colId + maxKernelId + 1);
+
+      // Update the sorted values of the window columns.
+      if (colId == colBegin) {
+        sortedValues.clear();
+        for (int windowColId = windowColBegin; windowColId < windowColEnd; ++windowColId) {
+          const auto& column = sortedColumn(windowColId);
+          sortedValues.insert(sortedValues.end(), column.begin(), column.end());
+        }
+        std::sort(sortedValues.begin(), sortedValues.end());
+      } else {
+        if (colId - maxKernelId - 1 >= 0) {
+          const int removedIndexBegin = storageIndex(0, colId - maxKernelId - 1);
+          sortedValues.erase(std::remove_if(sortedValues.begin(), sortedValues.end(),
+                                            [&](const RankedValue& value) {
+                                              return value.index >= removedIndexBegin && value.index < removedIndexBegin + numRows;
+                                            }),
+                             sortedValues.end());
+        }
+        if (colId + maxKernelId < numCols) {
+          const auto& column = sortedColumn(colId + maxKernelId);
+          mergedValues.resize(sortedValues.size() + column.size());
+          std::merge(sortedValues.begin(), sortedValues.end(), column.begin(), column.end(), mergedValues.begin());
+          std::swap(sortedValues, mergedValues);
+        }
+      }
+      for (int valueId = 0; valueId < static_cast<int>(sortedValues.size()); ++valueId) {
+        ranks[sortedValues[valueId].index] = valueId;
+      }
+
+      // Slide the window down the column.
+      window.reset(sortedValues.size());
+      auto updateRow = [&](int rowId, bool isInsert) {
+        for (int windowColId = windowColBegin; windowColId < windowColEnd; ++windowColId) {
+          const int cellRank = ranks[storageIndex(rowId, windowColId)];
+          if (cellRank >= 0) {
+            isInsert ? window.insert(cellRank) : window.erase(cellRank);
+          }
+        }
+      };
+      for (int rowId = 0; rowId < std::min(maxKernelId, numRows); ++rowId) {
+        updateRow(rowId, true);
+      }
+      for (int rowId = 0; rowId < numRows; ++rowId) {
+        if (rowId - maxKernelId - 1 >= 0) {
+          updateRow(rowId - maxKernelId - 1, false);
+        }
+        if (rowId + maxKernelId < numRows) {
+          updateRow(rowId + maxKernelId, true);
+        }
+        if (validity.isValid(rowId, colId)) {
+          const auto medianRanks = window.medianRanks();
+          const float lowerMedian = sortedValues[medianRanks.first].value;
+          const float upperMedian = sortedValues[medianRanks.second].value;
+          H_out(rowId, colId) = (medianRanks.first == medianRanks.second) ? lowerMedian : 0.5F * (lowerMedian + upperMedian);
+        } else {
+          H_out(rowId, colId) = NAN;
+        }
+      }
+    }
+  });
+  return H_out;
+}
+
+}  // namespace
+
+grid_map::Matrix median(const grid_map::Matrix& data, int kernelSize, int deltaKernelSize, int numberOfRepeats) {
+  if (kernelSize + deltaKernelSize * (numberOfRepeats - 1) <= 5) {
+    // Convert to image.
     cv::Mat elevationImage;
-    const float minValue = H_in.minCoeffOfFinites();
-    const float maxValue = H_in.maxCoeffOfFinites();
-    grid_map::GridMapCvConverter::toImage<unsigned char, 1>(map, layerIn, CV_8UC1, minValue, maxValue, elevationImage);
+    cv::eigen2cv(data, elevationImage);
 
     for (auto iter = 0; iter < numberOfRepeats; ++iter) {
       cv::medianBlur(elevationImage, elevationImage, kernelSize);
       kernelSize += deltaKernelSize;
     }
 
-    // Get image as float.
-    cv::Mat elevationImageFloat;
-    constexpr float maxUCharValue = 255.F;
-    elevationImage.convertTo(elevationImageFloat, CV_32F, (maxValue - minValue) / maxUCharValue, minValue);
+    grid_map::Matrix H;
+    cv::cv2eigen(elevationImage, H);
+    return H;
+  }
+
+  // Open-cv only supports kernel sizes up to 5 for float images.
+  else {
+    return median(data, mask::ValidityMask::fromFinite(data), kernelSize, deltaKernelSize, numberOfRepeats);
+  }
+}
 
-    // Convert back to grid map.
-    cv::cv2eigen(elevationImageFloat, map.get(layerOut));
+grid_map::Matrix median(const grid_map::Matrix& data, const mask::ValidityMask& validity, int kernelSize, int deltaKernelSize,
+                        int numberOfRepeats) {
+  if (validity.rows() != data.rows() || validity.cols() != data.cols()) {
+    throw std::invalid_argument("smoothing: the size of the validity mask does not match the layer.");
   }
+  // The median of valid values is finite, such that the valid cells do not change between the repeats.
+  grid_map::Matrix H = data;
+  for (auto iter = 0; iter < numberOfRepeats; ++iter) {
+    H = medianOfValid(H, validity, kernelSize);
+    kernelSize += deltaKernelSize;
+  }
+  return H;
+}
+
+void median(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize, int deltaKernelSize,
+            int numberOfRepeats) {
+  map.add(layerOut, median(map.get(layerIn), kernelSize, deltaKernelSize, numberOfRepeats));
+}
+
+void median(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, const mask::ValidityMask& validity,
+            int kernelSize, int deltaKernelSize, int numberOfRepeats) {
+  map.add(layerOut, median(map.get(layerIn), validity, kernelSize, deltaKernelSize, numberOfRepeats));
 }
 
 void boxBlur(grid_map::GridMap& map, const std::string& layerIn, const std::string& layerOut, int kernelSize, int numberOfRepeats) {
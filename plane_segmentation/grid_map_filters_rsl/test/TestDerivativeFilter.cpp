@@ -37,3 +37,94 @@ TEST(TestGridMapDerivative, initialization) {  // NOLINT
 
   EXPECT_TRUE(iterator.isPastEnd());
 }
+
+TEST(TestGridMapDerivative, derivativeLayersMatchEstimates) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(2.0, 1.5), 0.1, Position(0.0, 0.0));
+  map.add("elevation");
+  auto& H = map.get("elevation");
+  for (int colId = 0; colId < H.cols(); ++colId) {
+    for (int rowId = 0; rowId < H.rows(); ++rowId) {
+      H(rowId, colId) = std::sin(0.3 * rowId) * std::cos(0.2 * colId) + 0.01 * rowId * colId;
+    }
+  }
+
+  derivative::GridMapDerivative derivativeFilter;
+  ASSERT_TRUE(derivativeFilter.initialize(map.getResolution()));
+  derivative::GridMapDerivative::DerivativeLayers layers;
+  layers.gradientX = "gradient_x";
+  layers.gradientY = "gradient_y";
+  layers.slope = "slope";
+  layers.curvatureXX = "curvature_xx";
+  layers.curvatureXY = "curvature_xy";
+  layers.curvatureYY = "curvature_yy";
+  derivativeFilter.computeDerivativeLayers(map, "elevation", layers);
+
+  Eigen::Vector2d gradient;
+  Eigen::Matrix2d curvature;
+  constexpr double tolerance = 1.0e-4;
+  for (GridMapIterator iterator(map); !iterator.isPastEnd(); ++iterator) {
+    const Index index = *iterator;
+    derivativeFilter.estimateGradientAndCurvature(map, gradient, curvature, index, H);
+    EXPECT_NEAR(map.at("gradient_x", index), gradient.x(), tolerance);
+    EXPECT_NEAR(map.at("gradient_y", index), gradient.y(), tolerance);
+    EXPECT_NEAR(map.at("slope", index), gradient.norm(), tolerance);
+    EXPECT_NEAR(map.at("curvature_xx", index), curvature(0, 0), tolerance);
+    EXPECT_NEAR(map.at("curvature_xy", index), curvature(0, 1), tolerance);
+    EXPECT_NEAR(map.at("curvature_yy", index), curvature(1, 1), tolerance);
+  }
+}
+
+TEST(TestGridMapDerivative, derivativeLayersAroundNaN) {  // NOLINT
+  // Plane with nan holes, the gradient is exact at all cells with a finite neighbour in both directions.
+  GridMap map;
+  map.setGeometry(Length(1.0, 1.2), 0.1, Position(0.0, 0.0));
+  map.add("elevation");
+  auto& H = map.get("elevation");
+  const Eigen::Vector2d planeGradient(0.5, -0.25);
+  for (int colId = 0; colId < H.cols(); ++colId) {
+    for (int rowId = 0; rowId < H.rows(); ++rowId) {
+      Position position;
+      map.getPosition(Index(rowId, colId), position);
+      H(rowId, colId) = planeGradient.dot(position);
+    }
+  }
+  H(4, 4) = NAN;
+  H.block(6, 0, 2, 3).setConstant(NAN);
+  H(0, 11) = NAN;
+
+  derivative::GridMapDerivative derivativeFilter;
+  ASSERT_TRUE(derivativeFilter.initialize(map.getResolution()));
+  derivative::GridMapDerivative::DerivativeLayers layers;
+  layers.gradientX = "gradient_x";
+  layers.gradientY = "gradient_y";
+  layers.slope = "slope";
+  layers.curvatureXX = "curvature_xx";
+  layers.curvatureYY = "curvature_yy";
+  derivativeFilter.computeDerivativeLayers(map, "elevation", layers);
+  EXPECT_FALSE(map.exists("curvature_xy"));
+
+  constexpr double tolerance = 1.0e-4;
+  for (GridMapIterator iterator(map); !iterator.isPastEnd(); ++iterator) {
+    const Index index = *iterator;
+    if (std::isnan(H(index.x(), index.y()))) {
+      EXPECT_TRUE(std::isnan(map.at("gradient_x", index)));
+      EXPECT_TRUE(std::isnan(map.at("slope", index)));
+      EXPECT_TRUE(std::isnan(map.at("curvature_yy", index)));
+    } else {
+      EXPECT_NEAR(map.at("gradient_x", index), planeGradient.x(), tolerance) << index.transpose();
+      EXPECT_NEAR(map.at("gradient_y", index), planeGradient.y(), tolerance) << index.transpose();
+      EXPECT_NEAR(map.at("slope", index), planeGradient.norm(), tolerance) << index.transpose();
+      if (!std::isnan(map.at("curvature_xx", index))) {
+        EXPECT_NEAR(map.at("curvature_xx", index), 0.0, tolerance) << index.transpose();
+      }
+      if (!std::isnan(map.at("curvature_yy", index))) {
+        EXPECT_NEAR(map.at("curvature_yy", index), 0.0, tolerance) << index.transpose();
+      }
+    }
+  }
+
+  // Cells next to the hole use the short kernel, cells at the border of the hole and the map the one-sided difference.
+  EXPECT_FALSE(std::isnan(map.at("curvature_xx", Index(2, 4))));
+  EXPECT_TRUE(std::isnan(map.at("curvature_yy", Index(0, 10))));
+}
@@ -7,9 +7,227 @@
 #include <gtest/gtest.h>
 
 #include <grid_map_filters_rsl/inpainting.hpp>
+#include <grid_map_filters_rsl/processing.hpp>
+#include <grid_map_filters_rsl/smoothing.hpp>
+
+#include <Eigen/QR>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
 
 using namespace grid_map;
 
+namespace {
+
+/// Fills nan cells with the min of their neighbours until nothing changes, the original implementation of inpainting::minValues.
+Eigen::MatrixXf iterativeMinValues(const Eigen::MatrixXf& H_in) {
+  Eigen::MatrixXf H_out = H_in;
+  bool changedValue = true;
+  while (changedValue) {
+    changedValue = false;
+    for (int colId = 0; colId < H_in.cols(); ++colId) {
+      for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+        if (!std::isnan(H_in(rowId, colId))) {
+          continue;
+        }
+        auto& middleValue = H_out(rowId, colId);
+        auto compareAndStoreMin = [&](float newValue) {
+          if (!std::isnan(newValue) && (newValue < middleValue || std::isnan(middleValue))) {
+            middleValue = newValue;
+            changedValue = true;
+          }
+        };
+        if (colId > 0) compareAndStoreMin(H_out(rowId, colId - 1));
+        if (colId < H_in.cols() - 1) compareAndStoreMin(H_out(rowId, colId + 1));
+        if (rowId > 0) compareAndStoreMin(H_out(rowId - 1, colId));
+        if (rowId < H_in.rows() - 1) compareAndStoreMin(H_out(rowId + 1, colId));
+      }
+    }
+  }
+  return H_out;
+}
+
+/**
+ * Searches the closest valid cell in each direction from every nan cell and fits a bi-linear function through them, the original
+ * implementation of inpainting::biLinearInterpolation.
+ */
+Eigen::MatrixXf searchingBiLinearInterpolation(const Eigen::MatrixXf& H_in) {
+  Eigen::MatrixXf H_out = H_in;
+  std::array<Eigen::Vector2i, 4> indices;
+  std::array<float, 4> values;
+  indices.fill(Eigen::Vector2i::Zero());
+  values.fill(NAN);
+  for (int colId = 0; colId < H_in.cols(); ++colId) {
+    for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+      if (!std::isnan(H_in(rowId, colId))) {
+        continue;
+      }
+      const std::array<Eigen::Vector2i, 4> directions{Eigen::Vector2i(-1, 0), Eigen::Vector2i(0, -1), Eigen::Vector2i(1, 0),
+                                                      Eigen::Vector2i(0, 1)};
+      float minValue = std::numeric_limits<float>::max();
+      for (size_t id = 0; id < 4; ++id) {
+        for (Eigen::Vector2i index = Eigen::Vector2i(rowId, colId) + directions[id];
+             index.x() >= 0 && index.y() >= 0 && index.x() < H_in.rows() && index.y() < H_in.cols(); index += directions[id]) {
+          if (!std::isnan(H_in(index.x(), index.y()))) {
+            indices[id] = index;
+            values[id] = H_in(index.x(), index.y());
+            minValue = std::fmin(minValue, values[id]);
+            break;
+          }
+        }
+      }
+      if (std::any_of(values.begin(), values.end(), [](float value) { return std::isnan(value); })) {
+        H_out(rowId, colId) = minValue;
+        continue;
+      }
+      Eigen::Matrix4f A;
+      Eigen::Vector4f b;
+      A.setOnes();
+      for (size_t id = 0; id < 4; ++id) {
+        A(id, 1) = static_cast<float>(indices[id].x());
+        A(id, 2) = static_cast<float>(indices[id].y());
+        A(id, 3) = static_cast<float>(indices[id].x() * indices[id].y());
+        b(id) = values[id];
+      }
+      const Eigen::Vector4f weights = A.colPivHouseholderQr().solve(b);
+      H_out(rowId, colId) =
+          weights.dot(Eigen::Vector4f(1.0, static_cast<float>(rowId), static_cast<float>(colId), static_cast<float>(rowId * colId)));
+    }
+  }
+  return H_out;
+}
+
+/// Random terrain with scattered nan cells and large nan-patches (disks and stripes) touching the map border.
+Eigen::MatrixXf createMapWithHoles(int rows, int cols, unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> heights(-1.0F, 1.0F);
+  std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+  Eigen::MatrixXf H(rows, cols);
+  for (int colId = 0; colId < cols; ++colId) {
+    for (int rowId = 0; rowId < rows; ++rowId) {
+      H(rowId, colId) = (unit(generator) < 0.2F) ? NAN : heights(generator);
+    }
+  }
+  for (int hole = 0; hole < 5; ++hole) {
+    const float centerRow = unit(generator) * rows;
+    const float centerCol = unit(generator) * cols;
+    const float radius = 0.05F * rows + unit(generator) * 0.2F * rows;
+    for (int colId = 0; colId < cols; ++colId) {
+      for (int rowId = 0; rowId < rows; ++rowId) {
+        if (std::hypot(rowId - centerRow, colId - centerCol) < radius) {
+          H(rowId, colId) = NAN;
+        }
+      }
+    }
+  }
+  H.col(cols / 3).setConstant(NAN);
+  H.topRows(2).setConstant(NAN);
+  return H;
+}
+
+/**
+ * Dilation or erosion by searching every kernel window, the original implementation of processing::dilate / processing::erode for the
+ * square kernel. The disk is clipped at the map border.
+ */
+Eigen::MatrixXf searchingMorphologicalFilter(const Eigen::MatrixXf& H_in, const Eigen::MatrixXf& mask, int kernelSize, bool inpaint,
+                                             bool isDilation, processing::KernelShape shape) {
+  const Eigen::MatrixXf H_in_masked = (mask.size() == 0) ? H_in : Eigen::MatrixXf(H_in.cwiseProduct(mask));
+  const int maxKernelId = (kernelSize - 1) / 2;
+  Eigen::MatrixXf H_out(H_in.rows(), H_in.cols());
+  for (int colId = 0; colId < H_in.cols(); ++colId) {
+    for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+      float valueInKernel = NAN;
+      if (shape == processing::KernelShape::Square) {
+        const int cornerColId = std::min(std::max(colId - maxKernelId, 0), static_cast<int>(H_in.cols()) - kernelSize);
+        const int cornerRowId = std::min(std::max(rowId - maxKernelId, 0), static_cast<int>(H_in.rows()) - kernelSize);
+        const auto block = H_in_masked.block(cornerRowId, cornerColId, kernelSize, kernelSize);
+        valueInKernel = isDilation ? block.maxCoeffOfFinites() : block.minCoeffOfFinites();
+      } else {
+        for (int dCol = -maxKernelId; dCol <= maxKernelId; ++dCol) {
+          for (int dRow = -maxKernelId; dRow <= maxKernelId; ++dRow) {
+            const int neighbourRowId = rowId + dRow;
+            const int neighbourColId = colId + dCol;
+            if (dRow * dRow + dCol * dCol > maxKernelId * maxKernelId || neighbourRowId < 0 || neighbourColId < 0 ||
+                neighbourRowId >= H_in.rows() || neighbourColId >= H_in.cols()) {
+              continue;
+            }
+            const float value = H_in_masked(neighbourRowId, neighbourColId);
+            if (std::isfinite(value) && (std::isnan(valueInKernel) || (isDilation ? value > valueInKernel : value < valueInKernel))) {
+              valueInKernel = value;
+            }
+          }
+        }
+      }
+      if (inpaint || !std::isnan(H_in(rowId, colId))) {
+        H_out(rowId, colId) = std::isnan(valueInKernel) ? H_in(rowId, colId) : valueInKernel;
+      } else {
+        H_out(rowId, colId) = NAN;
+      }
+    }
+  }
+  return H_out;
+}
+
+/// Median of the finite values in the window around each cell, clipped at the border, by sorting the window of every cell.
+Eigen::MatrixXf sortingMedian(const Eigen::MatrixXf& H_in, int kernelSize) {
+  const int maxKernelId = (kernelSize - 1) / 2;
+  Eigen::MatrixXf H_out = Eigen::MatrixXf::Constant(H_in.rows(), H_in.cols(), NAN);
+  std::vector<float> values;
+  for (int colId = 0; colId < H_in.cols(); ++colId) {
+    for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+      if (std::isnan(H_in(rowId, colId))) {
+        continue;
+      }
+      values.clear();
+      for (int windowColId = std::max(0, colId - maxKernelId); windowColId <= std::min<int>(H_in.cols() - 1, colId + maxKernelId);
+           ++windowColId) {
+        for (int windowRowId = std::max(0, rowId - maxKernelId); windowRowId <= std::min<int>(H_in.rows() - 1, rowId + maxKernelId);
+             ++windowRowId) {
+          if (std::isfinite(H_in(windowRowId, windowColId))) {
+            values.push_back(H_in(windowRowId, windowColId));
+          }
+        }
+      }
+      std::sort(values.begin(), values.end());
+      const size_t medianId = (values.size() - 1) / 2;
+      H_out(rowId, colId) = (values.size() % 2 == 1) ? values[medianId] : 0.5F * (values[medianId] + values[medianId + 1]);
+    }
+  }
+  return H_out;
+}
+
+/// Random mask with entries 1, 0 and nan.
+Eigen::MatrixXf createRandomMask(int rows, int cols, unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+  Eigen::MatrixXf mask(rows, cols);
+  for (int i = 0; i < mask.size(); ++i) {
+    const float sample = unit(generator);
+    mask(i) = (sample < 0.8F) ? 1.0F : ((sample < 0.9F) ? 0.0F : NAN);
+  }
+  return mask;
+}
+
+/// Expects equal values, where nan equals nan.
+void expectEqualWithNaN(const Eigen::MatrixXf& expected, const Eigen::MatrixXf& actual, const std::string& description) {
+  ASSERT_EQ(expected.rows(), actual.rows());
+  ASSERT_EQ(expected.cols(), actual.cols());
+  for (Eigen::Index i = 0; i < expected.size(); ++i) {
+    if (std::isnan(expected(i))) {
+      ASSERT_TRUE(std::isnan(actual(i))) << description << ", cell: " << i;
+    } else {
+      ASSERT_EQ(expected(i), actual(i)) << description << ", cell: " << i;
+    }
+  }
+}
+
+}  // namespace
+
 TEST(TestInpainting, initialization) {  // NOLINT
   // Grid map with constant gradient.
   GridMap map;
@@ -76,6 +294,327 @@ TEST(TestInpainting, minValuesOnlyNaN) {  // NOLINT
   EXPECT_DOUBLE_EQ(map.get("filled_min_nonan").minCoeff(), 1.0);
 }
 
+TEST(TestInpainting, minValuesMatchesIterativeFill) {  // NOLINT
+  for (unsigned int seed = 0; seed < 10; ++seed) {
+    GridMap map;
+    map.setGeometry(Length(6.0, 4.0), 0.05, Position(0.0, 0.0));
+    map.add("input", createMapWithHoles(map.getSize()(0), map.getSize()(1), seed));
+
+    inpainting::minValues(map, "input", "filled_min");
+
+    const Eigen::MatrixXf H_expected = iterativeMinValues(map.get("input"));
+    const Eigen::MatrixXf& H_out = map.get("filled_min");
+    ASSERT_FALSE(H_out.hasNaN());
+    for (Eigen::Index i = 0; i < H_out.size(); ++i) {
+      ASSERT_EQ(H_out(i), H_expected(i)) << "seed: " << seed << ", cell: " << i;
+    }
+  }
+}
+
+TEST(TestInpainting, biLinearInterpolationMatchesSearch) {  // NOLINT
+  for (unsigned int seed = 0; seed < 10; ++seed) {
+    GridMap map;
+    map.setGeometry(Length(6.0, 4.0), 0.05, Position(0.0, 0.0));
+    map.add("input", createMapWithHoles(map.getSize()(0), map.getSize()(1), seed));
+
+    inpainting::biLinearInterpolation(map, "input", "filled_bilinear");
+
+    const Eigen::MatrixXf H_expected = searchingBiLinearInterpolation(map.get("input"));
+    const Eigen::MatrixXf& H_out = map.get("filled_bilinear");
+    ASSERT_FALSE(H_out.hasNaN());
+    for (Eigen::Index i = 0; i < H_out.size(); ++i) {
+      ASSERT_NEAR(H_out(i), H_expected(i), 1.0e-4) << "seed: " << seed << ", cell: " << i;
+    }
+  }
+}
+
+TEST(TestInpainting, biLinearInterpolationOfPlane) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(4.0, 3.0), 0.05, Position(0.0, 0.0));
+  map.add("input");
+  Eigen::MatrixXf& H_in = map.get("input");
+  for (int colId = 0; colId < H_in.cols(); ++colId) {
+    for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+      H_in(rowId, colId) = 0.3F + 0.02F * rowId - 0.01F * colId;
+    }
+  }
+  const Eigen::MatrixXf H0 = H_in;
+
+  // Holes of different sizes that do not touch the border.
+  H_in.block(10, 10, 30, 20).setConstant(NAN);
+  H_in.block(50, 5, 5, 40).setConstant(NAN);
+  H_in.block(20, 45, 1, 1).setConstant(NAN);
+
+  inpainting::biLinearInterpolation(map, "input", "filled_bilinear");
+  EXPECT_TRUE(map.get("filled_bilinear").isApprox(H0, 1.0e-5));
+}
+
+TEST(TestInpainting, harmonicInterpolationOfHarmonicSurfaces) {  // NOLINT
+  // Planes and saddles solve the Laplace equation, such that the holes are filled exactly.
+  const std::vector<std::function<float(float, float)>> surfaces{[](float x, float y) { return 0.3F + 0.5F * x - 0.2F * y; },
+                                                                 [](float x, float y) { return x * x - y * y; },
+                                                                 [](float x, float y) { return 0.5F * x * y - 0.1F * x; }};
+  for (const auto& surface : surfaces) {
+    GridMap map;
+    map.setGeometry(Length(6.0, 4.0), 0.05, Position(0.0, 0.0));
+    map.add("input");
+    Eigen::MatrixXf& H_in = map.get("input");
+    for (int colId = 0; colId < H_in.cols(); ++colId) {
+      for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+        Position position;
+        map.getPosition(Index(rowId, colId), position);
+        H_in(rowId, colId) = surface(position.x(), position.y());
+      }
+    }
+    const Eigen::MatrixXf H0 = H_in;
+
+    // Large disk, thin stripe and single cells, none touching the border.
+    for (int colId = 0; colId < H_in.cols(); ++colId) {
+      for (int rowId = 0; rowId < H_in.rows(); ++rowId) {
+        if (std::hypot(rowId - 50, colId - 40) < 30.0) {
+          H_in(rowId, colId) = NAN;
+        }
+      }
+    }
+    H_in.block(95, 5, 2, 70).setConstant(NAN);
+    H_in(110, 70) = NAN;
+
+    inpainting::harmonicInterpolation(map, "input", "filled_harmonic");
+    const Eigen::MatrixXf& H_out = map.get("filled_harmonic");
+    ASSERT_FALSE(H_out.hasNaN());
+    const float heightRange = H0.maxCoeff() - H0.minCoeff();
+    EXPECT_LT((H_out - H0).cwiseAbs().maxCoeff(), 1.0e-4 * std::max(1.0F, heightRange));
+  }
+}
+
+TEST(TestInpainting, harmonicInterpolationMaxFillDistance) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(4.0, 4.0), 0.05, Position(0.0, 0.0));
+  map.add("input", 1.0);
+  Eigen::MatrixXf& H_in = map.get("input");
+  H_in.block(10, 10, 60, 60).setConstant(NAN);
+  H_in.bottomRows(5).setConstant(NAN);  // touching the border
+  const Eigen::MatrixXf H0 = H_in;
+
+  const double maxFillDistance = 0.5;  // 10 cells
+  inpainting::harmonicInterpolation(map, "input", "input", maxFillDistance);
+  const Eigen::MatrixXf& H_out = map.get("input");
+  for (int colId = 0; colId < H_out.cols(); ++colId) {
+    for (int rowId = 0; rowId < H_out.rows(); ++rowId) {
+      if (!std::isnan(H0(rowId, colId))) {
+        ASSERT_EQ(H_out(rowId, colId), H0(rowId, colId));
+        continue;
+      }
+      // Distance to the valid frame around the square, or to the valid rows above the border stripe.
+      const bool isInSquare = rowId >= 10 && rowId < 70 && colId >= 10 && colId < 70;
+      const int distanceInCells =
+          isInSquare ? std::min({rowId - 9, 70 - rowId, colId - 9, 70 - colId}) : rowId - (static_cast<int>(H_out.rows()) - 6);
+      if (distanceInCells <= 9) {
+        ASSERT_NEAR(H_out(rowId, colId), 1.0, 1.0e-4) << rowId << ", " << colId;
+      } else if (distanceInCells > 11) {
+        ASSERT_TRUE(std::isnan(H_out(rowId, colId))) << rowId << ", " << colId;
+      }
+    }
+  }
+
+  // Without limit, everything is filled.
+  map.add("input", H0);
+  inpainting::harmonicInterpolation(map, "input", "filled_harmonic");
+  EXPECT_TRUE(map.get("filled_harmonic").isApprox(Eigen::MatrixXf::Ones(H0.rows(), H0.cols()), 1.0e-4));
+}
+
+TEST(TestInpainting, harmonicInterpolationInfiniteCells) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(3.0, 2.0), 0.05, Position(0.0, 0.0));
+  map.add("input_nan", createMapWithHoles(map.getSize()(0), map.getSize()(1), 3));
+  map.add("input_inf", map.get("input_nan"));
+  Eigen::MatrixXf& H_inf = map.get("input_inf");
+  H_inf = H_inf.array().isNaN().select(std::numeric_limits<float>::infinity(), H_inf);
+  H_inf(0, 0) = -std::numeric_limits<float>::infinity();
+  map.get("input_nan")(0, 0) = NAN;
+
+  // Infinite cells are filled like nan cells, and do not act as seeds.
+  inpainting::harmonicInterpolation(map, "input_nan", "filled_nan");
+  inpainting::harmonicInterpolation(map, "input_inf", "filled_inf");
+  ASSERT_TRUE(map.get("filled_inf").allFinite());
+  EXPECT_TRUE(map.get("filled_inf").isApprox(map.get("filled_nan")));
+}
+
+TEST(TestInpainting, harmonicInterpolationOnlyNaN) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(3.0, 3.0), 1.0, Position(0.0, 0.0));
+  map.add("input_nan", NAN);
+  inpainting::harmonicInterpolation(map, "input_nan", "filled_harmonic");
+  EXPECT_TRUE(map.get("filled_harmonic").array().isNaN().all());
+}
+
+TEST(TestProcessing, morphologicalFiltersMatchSearch) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(6.0, 4.0), 0.05, Position(0.0, 0.0));
+  const int rows = map.getSize()(0);
+  const int cols = map.getSize()(1);
+  map.add("input", createMapWithHoles(rows, cols, 0));
+  map.get("input")(5, 7) = std::numeric_limits<float>::infinity();
+  const Eigen::MatrixXf mask = createRandomMask(rows, cols, 1);
+
+  for (const auto shape : {processing::KernelShape::Square, processing::KernelShape::Disk}) {
+    for (const int kernelSize : {1, 3, 4, 5, 9, 15, 31}) {
+      for (const bool inpaint : {true, false}) {
+        for (const bool useMask : {false, true}) {
+          const Eigen::MatrixXf maskIn = useMask ? mask : Eigen::MatrixXf();
+          const std::string description = "shape: " + std::to_string(static_cast<int>(shape)) + ", kernel: " + std::to_string(kernelSize) +
+                                          ", inpaint: " + std::to_string(inpaint) + ", mask: " + std::to_string(useMask);
+          processing::dilate(map, "input", "dilated", maskIn, kernelSize, inpaint, shape);
+          expectEqualWithNaN(searchingMorphologicalFilter(map.get("input"), maskIn, kernelSize, inpaint, true, shape), map.get("dilated"),
+                             "dilate, " + description);
+          processing::erode(map, "input", "eroded", maskIn, kernelSize, inpaint, shape);
+          expectEqualWithNaN(searchingMorphologicalFilter(map.get("input"), maskIn, kernelSize, inpaint, false, shape), map.get("eroded"),
+                             "erode, " + description);
+        }
+      }
+    }
+  }
+}
+
+TEST(TestProcessing, morphologicalFiltersInPlace) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(3.0, 3.0), 0.05, Position(0.0, 0.0));
+  map.add("input", createMapWithHoles(map.getSize()(0), map.getSize()(1), 2));
+  map.add("in_place", map.get("input"));
+
+  processing::dilate(map, "input", "dilated", Eigen::MatrixXf(), 5);
+  processing::dilate(map, "in_place", "in_place", Eigen::MatrixXf(), 5);
+  expectEqualWithNaN(map.get("dilated"), map.get("in_place"), "dilate");
+
+  processing::erode(map, "dilated", "closed", Eigen::MatrixXf(), 5, false, processing::KernelShape::Disk);
+  processing::erode(map, "in_place", "in_place", Eigen::MatrixXf(), 5, false, processing::KernelShape::Disk);
+  expectEqualWithNaN(map.get("closed"), map.get("in_place"), "erode");
+}
+
+TEST(TestProcessing, applyKernelFunction) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(3.0, 2.0), 0.05, Position(0.0, 0.0));
+  const int rows = map.getSize()(0);
+  const int cols = map.getSize()(1);
+  map.add("input", createMapWithHoles(rows, cols, 3));
+  const int kernelSize = 7;
+  const Eigen::MatrixXf weights = Eigen::MatrixXf::Random(kernelSize, kernelSize);
+  auto weightedSum = [&](const Eigen::Ref<const grid_map::GridMap::Matrix>& data) -> float {
+    return data.cwiseProduct(weights).unaryExpr([](float value) { return std::isnan(value) ? 0.0F : value; }).sum();
+  };
+
+  // Expected: the window at the border is shifted to stay inside the map.
+  const Eigen::MatrixXf H_in = map.get("input");
+  Eigen::MatrixXf H_expected(rows, cols);
+  for (int colId = 0; colId < cols; ++colId) {
+    for (int rowId = 0; rowId < rows; ++rowId) {
+      const int cornerRowId = std::min(std::max(rowId - kernelSize / 2, 0), rows - kernelSize);
+      const int cornerColId = std::min(std::max(colId - kernelSize / 2, 0), cols - kernelSize);
+      H_expected(rowId, colId) = weightedSum(Eigen::MatrixXf(H_in.block(cornerRowId, cornerColId, kernelSize, kernelSize)));
+    }
+  }
+
+  processing::applyKernelFunction(map, "input", "templated", kernelSize, weightedSum);
+  expectEqualWithNaN(H_expected, map.get("templated"), "templated");
+
+  processing::applyKernelFunction(map, "input", "parallel", kernelSize, weightedSum, true);
+  expectEqualWithNaN(H_expected, map.get("parallel"), "parallel");
+
+  // The std::function may have state, it is called serially from the calling thread.
+  std::vector<std::thread::id> callingThreads;
+  const std::function<float(const Eigen::Ref<const grid_map::GridMap::Matrix>&)> function =
+      [&](const Eigen::Ref<const grid_map::GridMap::Matrix>& data) {
+        callingThreads.push_back(std::this_thread::get_id());
+        return weightedSum(data);
+      };
+  processing::applyKernelFunction(map, "input", "function", kernelSize, function);
+  expectEqualWithNaN(H_expected, map.get("function"), "std::function");
+  ASSERT_EQ(callingThreads.size(), static_cast<size_t>(rows * cols));
+  const auto isCallingThread = [](std::thread::id id) { return id == std::this_thread::get_id(); };
+  EXPECT_TRUE(std::all_of(callingThreads.begin(), callingThreads.end(), isCallingThread));
+
+  map.add("in_place", map.get("input"));
+  processing::applyKernelFunction(map, "in_place", "in_place", kernelSize, weightedSum);
+  expectEqualWithNaN(H_expected, map.get("in_place"), "in-place");
+}
+
+TEST(TestProcessing, coneDilateMatchesSearch) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(4.0, 3.0), 0.05, Position(0.0, 0.0));
+  const int rows = map.getSize()(0);
+  const int cols = map.getSize()(1);
+  map.add("input", createMapWithHoles(rows, cols, 4));
+  map.get("input")(40, 20) = 10.0;
+  const Eigen::MatrixXf H_in = map.get("input");
+  const float slope = 0.05;
+
+  for (const int kernelSize : {1, 3, 5, 11, 21, 45, 101}) {
+    const int maxKernelId = (kernelSize - 1) / 2;
+    processing::coneDilate(map, "input", "dilated", slope, kernelSize);
+    processing::coneErode(map, "input", "eroded", slope, kernelSize);
+
+    // Expected: search the window, clipped at the border.
+    Eigen::MatrixXf H_dilated = Eigen::MatrixXf::Constant(rows, cols, NAN);
+    Eigen::MatrixXf H_eroded = Eigen::MatrixXf::Constant(rows, cols, NAN);
+    for (int colId = 0; colId < cols; ++colId) {
+      for (int rowId = 0; rowId < rows; ++rowId) {
+        for (int dCol = -maxKernelId; dCol <= maxKernelId; ++dCol) {
+          for (int dRow = -maxKernelId; dRow <= maxKernelId; ++dRow) {
+            if (rowId + dRow < 0 || rowId + dRow >= rows || colId + dCol < 0 || colId + dCol >= cols) {
+              continue;
+            }
+            const float value = H_in(rowId + dRow, colId + dCol);
+            const float offset = slope * std::sqrt(dRow * dRow + dCol * dCol);
+            if (std::isfinite(value)) {
+              H_dilated(rowId, colId) = std::fmax(H_dilated(rowId, colId), value - offset);
+              H_eroded(rowId, colId) = std::fmin(H_eroded(rowId, colId), value + offset);
+            }
+          }
+        }
+      }
+    }
+    expectEqualWithNaN(H_dilated, map.get("dilated"), "dilate, kernel: " + std::to_string(kernelSize));
+    expectEqualWithNaN(H_eroded, map.get("eroded"), "erode, kernel: " + std::to_string(kernelSize));
+
+    // Away from the border, the same as with applyKernelFunction.
+    if (kernelSize > std::min(rows, cols)) {
+      continue;
+    }
+    Eigen::MatrixXf offsets(kernelSize, kernelSize);
+    for (int i = 0; i < kernelSize; ++i) {
+      for (int j = 0; j < kernelSize; ++j) {
+        offsets(i, j) = slope * std::sqrt((i - maxKernelId) * (i - maxKernelId) + (j - maxKernelId) * (j - maxKernelId));
+      }
+    }
+    processing::applyKernelFunction(map, "input", "kernel_function", kernelSize,
+                                    [&](const Eigen::Block<const Matrix>& data) { return (data - offsets).maxCoeffOfFinites(); });
+    const auto interior = [&](const Eigen::MatrixXf& H) {
+      return Eigen::MatrixXf(H.block(maxKernelId, maxKernelId, rows - 2 * maxKernelId, cols - 2 * maxKernelId));
+    };
+    expectEqualWithNaN(interior(map.get("kernel_function")), interior(map.get("dilated")), "kernel: " + std::to_string(kernelSize));
+  }
+}
+
+TEST(TestSmoothing, medianMatchesSorting) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(4.0, 3.0), 0.05, Position(0.0, 0.0));
+  Eigen::MatrixXf H_in = createMapWithHoles(map.getSize()(0), map.getSize()(1), 5);
+  // Repeated values and a large height range, which would be quantized by an 8-bit image.
+  H_in.block(10, 10, 20, 20).setConstant(0.25F);
+  H_in(50, 50) = 100.0F;
+  map.add("input", H_in);
+
+  for (const int kernelSize : {7, 9, 15, 31}) {
+    smoothing::median(map, "input", "median", kernelSize);
+    expectEqualWithNaN(sortingMedian(H_in, kernelSize), map.get("median"), "kernel: " + std::to_string(kernelSize));
+  }
+
+  // Repeated application with increasing kernel size, in-place.
+  map.add("in_place", H_in);
+  smoothing::median(map, "in_place", "in_place", 3, 4, 2);
+  expectEqualWithNaN(sortingMedian(sortingMedian(H_in, 3), 7), map.get("in_place"), "repeated");
+}
+
 TEST(TestResampling, resampleSameSize) {  // NOLINT
   const std::string layerName = "layer";
 
@@ -141,4 +680,95 @@ TEST(TestResampling, resampleDownsample) {  // NOLINT
   EXPECT_TRUE(newTrueSize.isApprox(oldTrueSize));
   EXPECT_TRUE(resampleMap.getPosition().isApprox(map.getPosition()));
   EXPECT_DOUBLE_EQ(resampleMap.getResolution(), newRes);
-}
\ No newline at end of file
+}
+
+TEST(TestResampling, resampleDownsampleAveragesArea) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(2.0, 3.0), 0.5, Position(0.1, 0.2));
+  map.add("layer");
+  auto& H = map.get("layer");
+  H.setRandom();
+  H(0, 0) = NAN;
+  H.block(0, 4, 2, 2).setConstant(NAN);
+  const Eigen::MatrixXf H_old = H;
+
+  inpainting::resample(map, "layer", 1.0);
+  ASSERT_EQ(map.getSize().x(), 2);
+  ASSERT_EQ(map.getSize().y(), 3);
+
+  // Each new cell is the average of the finite values in its 2 x 2 block.
+  const auto& H_new = map.get("layer");
+  for (int colId = 0; colId < 3; ++colId) {
+    for (int rowId = 0; rowId < 2; ++rowId) {
+      const Eigen::MatrixXf block = H_old.block(2 * rowId, 2 * colId, 2, 2);
+      const int numFinite = block.array().isFinite().count();
+      if (numFinite == 0) {
+        EXPECT_TRUE(std::isnan(H_new(rowId, colId)));
+      } else {
+        const float expected = block.array().isFinite().select(block.array(), 0.0F).sum() / numFinite;
+        EXPECT_NEAR(H_new(rowId, colId), expected, 1e-6);
+      }
+    }
+  }
+}
+
+TEST(TestResampling, resampleUpsampleIgnoresNaN) {  // NOLINT
+  const float value = 1.5F;
+  GridMap map;
+  map.setGeometry(Length(5.0, 5.0), 1.0, Position(0.1, 0.2));
+  map.add("layer", value);
+  map.get("layer")(2, 2) = NAN;
+
+  inpainting::resample(map, "layer", 0.5);
+  ASSERT_EQ(map.getSize().x(), 10);
+  ASSERT_EQ(map.getSize().y(), 10);
+
+  // The nan-cell is surrounded by finite cells, it does not spread.
+  const auto& H_new = map.get("layer");
+  for (int i = 0; i < H_new.size(); ++i) {
+    ASSERT_FLOAT_EQ(H_new(i), value);
+  }
+}
+
+TEST(TestResampling, resampleUpsampleInterpolatesPlane) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(4.0, 6.0), 1.0, Position(0.0, 0.0));
+  map.add("layer");
+  auto& H = map.get("layer");
+  auto plane = [](double rowId, double colId) { return static_cast<float>(0.3 * rowId - 0.7 * colId + 2.0); };
+  for (int colId = 0; colId < H.cols(); ++colId) {
+    for (int rowId = 0; rowId < H.rows(); ++rowId) {
+      H(rowId, colId) = plane(rowId, colId);
+    }
+  }
+
+  inpainting::resample(map, "layer", 0.25);
+
+  // Away from the border, the new cell centers are interpolated exactly.
+  const auto& H_new = map.get("layer");
+  for (int colId = 2; colId < H_new.cols() - 2; ++colId) {
+    for (int rowId = 2; rowId < H_new.rows() - 2; ++rowId) {
+      EXPECT_NEAR(H_new(rowId, colId), plane((rowId + 0.5) / 4.0 - 0.5, (colId + 0.5) / 4.0 - 0.5), 1e-5);
+    }
+  }
+}
+
+TEST(TestResampling, resampleAllLayers) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(3.0, 2.0), 0.1, Position(0.1, 0.2));
+  map.add("a");
+  map.add("b");
+  map.get("a").setRandom();
+  map.get("b").setRandom();
+  map.get("b").block(3, 4, 7, 5).setConstant(NAN);
+
+  GridMap mapA = map;
+  GridMap mapB = map;
+  inpainting::resample(map, "all", 0.3);
+  inpainting::resample(mapA, "a", 0.3);
+  inpainting::resample(mapB, "b", 0.3);
+
+  EXPECT_TRUE((map.getSize() == mapA.getSize()).all());
+  EXPECT_TRUE(map.get("a").isApprox(mapA.get("a")));
+  expectEqualWithNaN(mapB.get("b"), map.get("b"), "resampled layer b");
+}
@@ -8,8 +8,46 @@
 
 #include <grid_map_filters_rsl/lookup.hpp>
 
+#include <random>
+
 using namespace grid_map;
 
+namespace {
+
+/// Random map with holes and a few peaks, such that the maximum along a line varies.
+GridMap createRandomMap(std::mt19937& generator) {
+  GridMap map;
+  map.setGeometry(Length(7.3, 5.1), 0.05, Position(0.4, -0.2));
+  map.add("elevation", 0.0);
+  auto& data = map.get("elevation");
+  std::uniform_real_distribution<float> height(-0.1, 0.1);
+  std::bernoulli_distribution isHole(0.05);
+  std::bernoulli_distribution isPeak(0.002);
+  for (int col = 0; col < data.cols(); ++col) {
+    for (int row = 0; row < data.rows(); ++row) {
+      data(row, col) = isHole(generator) ? NAN : height(generator) + (isPeak(generator) ? 1.0F : 0.0F);
+    }
+  }
+  data.block(40, 30, 20, 20).setConstant(NAN);
+  return map;
+}
+
+std::vector<lookup::LookupSegment> createRandomSegments(int numSegments, std::mt19937& generator) {
+  std::uniform_real_distribution<double> coordinate(-5.0, 5.0);
+  std::vector<lookup::LookupSegment> segments(numSegments);
+  for (auto& segment : segments) {
+    segment.start = Position(coordinate(generator), coordinate(generator));
+    segment.end = Position(coordinate(generator), coordinate(generator));
+  }
+  // Degenerate and axis aligned lines.
+  segments[0].end = segments[0].start;
+  segments[1].end = Position(segments[1].start.x(), -segments[1].start.y());
+  segments[2].end = Position(-segments[2].start.x(), segments[2].start.y());
+  return segments;
+}
+
+}  // namespace
+
 TEST(TestLookup, maxValue_constant_map) {  // NOLINT
   // Grid map with constant value.
   GridMap map;
@@ -67,6 +105,33 @@ TEST(TestLookup, maxValue_in_middle_map) {  // NOLINT
   EXPECT_DOUBLE_EQ(result.value, checkMaxValue);
 }
 
+TEST(TestLookup, maxValue_position) {  // NOLINT
+  GridMap map;
+  map.setGeometry(Length(1.0, 2.0), 0.1, Position(0.1, 0.2));
+  map.add("elevation", 0.0);
+  auto& data = map.get("elevation");
+  const Index peakIndex(5, 10);
+  data(peakIndex(0), peakIndex(1)) = 1.0;
+  Position peakPosition;
+  map.getPosition(peakIndex, peakPosition);
+
+  // The peak is the location, not the last cell of the line.
+  const Position position1(peakPosition.x(), -0.7);
+  const Position position2(peakPosition.x(), 1.1);
+  const auto result = lookup::maxValueBetweenLocations(position1, position2, map, data);
+  ASSERT_TRUE(result.isValid);
+  EXPECT_DOUBLE_EQ(result.value, 1.0);
+  EXPECT_TRUE(result.position.isApprox(peakPosition));
+
+  // Of equal values, the one closest to position1.
+  Index firstIndex;
+  ASSERT_TRUE(map.getIndex(position1, firstIndex));
+  Position firstPosition;
+  map.getPosition(firstIndex, firstPosition);
+  const auto flatResult = lookup::maxValueBetweenLocations(position1, position2, map, Matrix(Matrix::Zero(data.rows(), data.cols())));
+  EXPECT_TRUE(flatResult.position.isApprox(firstPosition));
+}
+
 TEST(TestLookup, maxValue_onlyNaN) {  // NOLINT
   // Grid map with constant value.
   GridMap map;
@@ -80,3 +145,76 @@ TEST(TestLookup, maxValue_onlyNaN) {  // NOLINT
   const auto result = lookup::maxValueBetweenLocations(position1, position2, map, data);
   ASSERT_FALSE(result.isValid);
 }
+
+TEST(TestLookup, maxPyramid_boxBound) {  // NOLINT
+  std::mt19937 generator(0);
+  const GridMap map = createRandomMap(generator);
+  const auto& data = map.get("elevation");
+  const lookup::MaxPyramid pyramid(map, data);
+  EXPECT_EQ(pyramid.level(pyramid.numLevels() - 1).size(), 1);
+
+  std::uniform_int_distribution<int> row(0, data.rows() - 1);
+  std::uniform_int_distribution<int> col(0, data.cols() - 1);
+  for (int i = 0; i < 1000; ++i) {
+    const Index corner1(row(generator), col(generator));
+    const Index corner2 = (i % 2 == 0) ? corner1 : Index(row(generator), col(generator));
+    const Index minIndex = corner1.min(corner2);
+    const Index size = (corner1 - corner2).abs() + 1;
+    const Matrix box = data.block(minIndex.x(), minIndex.y(), size.x(), size.y());
+    const float boxMax =
+        box.unaryExpr([](float value) { return std::isfinite(value) ? value : std::numeric_limits<float>::lowest(); }).maxCoeff();
+    if (corner1.isApprox(corner2)) {
+      ASSERT_EQ(pyramid.upperBoundInBox(corner1, corner2), boxMax);
+    } else {
+      ASSERT_GE(pyramid.upperBoundInBox(corner1, corner2), boxMax);
+    }
+  }
+}
+
+TEST(TestLookup, maxPyramid_matchesLineIteration) {  // NOLINT
+  std::mt19937 generator(1);
+  const GridMap map = createRandomMap(generator);
+  const auto& data = map.get("elevation");
+  const lookup::MaxPyramid pyramid(map, data);
+  const auto segments = createRandomSegments(500, generator);
+
+  std::vector<lookup::LookupResult> results;
+  lookup::maxValuesBetweenLocations(segments, map, pyramid, results);
+  ASSERT_EQ(results.size(), segments.size());
+
+  std::vector<Position3> lineValues;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const auto expected = lookup::maxValueBetweenLocations(segments[i].start, segments[i].end, map, data);
+    const auto result = lookup::maxValueBetweenLocations(segments[i].start, segments[i].end, map, pyramid);
+    ASSERT_EQ(result.isValid, expected.isValid) << "segment " << i;
+    if (expected.isValid) {
+      ASSERT_EQ(result.value, expected.value) << "segment " << i;
+      ASSERT_TRUE(result.position.isApprox(expected.position)) << "segment " << i;
+    }
+    ASSERT_EQ(results[i].isValid, result.isValid) << "segment " << i;
+    ASSERT_EQ(results[i].value, result.value) << "segment " << i;
+
+    lookup::valuesBetweenLocations(segments[i].start, segments[i].end, map, data, lineValues);
+    ASSERT_EQ(lineValues, lookup::valuesBetweenLocations(segments[i].start, segments[i].end, map, data)) << "segment " << i;
+  }
+}
+
+TEST(TestLookup, maxPyramid_threshold) {  // NOLINT
+  std::mt19937 generator(2);
+  const GridMap map = createRandomMap(generator);
+  const auto& data = map.get("elevation");
+  const lookup::MaxPyramid pyramid(map, data);
+  const auto segments = createRandomSegments(500, generator);
+
+  for (const float threshold : {-0.2F, 0.05F, 0.5F, 2.0F}) {
+    std::vector<uint8_t> isBelow;
+    lookup::areMaxValuesBelow(segments, map, pyramid, threshold, isBelow);
+    ASSERT_EQ(isBelow.size(), segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const auto expected = lookup::maxValueBetweenLocations(segments[i].start, segments[i].end, map, data);
+      const bool expectedIsBelow = !expected.isValid || expected.value < threshold;
+      ASSERT_EQ(lookup::isMaxValueBelow(segments[i].start, segments[i].end, map, pyramid, threshold), expectedIsBelow) << "segment " << i;
+      ASSERT_EQ(isBelow[i], expectedIsBelow ? 1 : 0) << "segment " << i;
+    }
+  }
+}
@@ -0,0 +1,280 @@
+/**
+ * @brief       Tests for the shared thread pool.
+ */
+
+#include <gtest/gtest.h>
+
+#include <grid_map_filters_rsl/ThreadPool.hpp>
+#include <grid_map_filters_rsl/parallel.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace grid_map;
+
+TEST(TestThreadPool, coversEachIndexOnce) {  // NOLINT
+  for (int numThreads : {1, 2, 3, 8}) {
+    parallel::ThreadPoolSettings settings;
+    settings.numThreads = numThreads;
+    parallel::ThreadPool pool(settings);
+    ASSERT_EQ(pool.numThreads(), numThreads);
+
+    for (int numIndices : {0, 1, 7, 100, 1001}) {
+      std::vector<std::atomic<int>> counts(numIndices);
+      for (auto& count : counts) {
+        count = 0;
+      }
+      pool.parallelFor(5, 5 + numIndices, [&](int rangeBegin, int rangeEnd) {
+        EXPECT_LT(rangeBegin, rangeEnd);
+        for (int index = rangeBegin; index < rangeEnd; ++index) {
+          ++counts[index - 5];
+        }
+      });
+      for (const auto& count : counts) {
+        EXPECT_EQ(count, 1);
+      }
+    }
+  }
+}
+
+TEST(TestThreadPool, unevenWorkIsStolen) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 4;
+  parallel::ThreadPool pool(settings);
+
+  // All work is in the chunks of the calling thread, such that the workers can only help by stealing.
+  std::mutex mutex;
+  std::set<std::thread::id> threadIds;
+  pool.parallelFor(0, 64, [&](int rangeBegin, int /*rangeEnd*/) {
+    if (rangeBegin < 16) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    threadIds.insert(std::this_thread::get_id());
+  });
+  const auto statistics = pool.statistics();
+  EXPECT_EQ(statistics.numLoops, 1U);
+  EXPECT_EQ(statistics.numChunks, 16U);
+  EXPECT_GT(statistics.numStolenChunks, 0U);
+  EXPECT_GT(threadIds.size(), 1U);
+}
+
+TEST(TestThreadPool, deterministicModeRunsOneRangeOnTheCallingThread) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 4;
+  settings.deterministic = true;
+  parallel::ThreadPool pool(settings);
+  EXPECT_EQ(pool.numThreads(), 1);
+
+  int numCalls = 0;
+  const auto callingThreadId = std::this_thread::get_id();
+  pool.parallelFor(0, 1000, [&](int rangeBegin, int rangeEnd) {
+    EXPECT_EQ(std::this_thread::get_id(), callingThreadId);
+    EXPECT_EQ(rangeBegin, 0);
+    EXPECT_EQ(rangeEnd, 1000);
+    ++numCalls;
+  });
+  EXPECT_EQ(numCalls, 1);
+}
+
+TEST(TestThreadPool, nestedLoopsRunOnTheCallingThread) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 4;
+  parallel::ThreadPool pool(settings);
+
+  std::atomic<int> numInnerCalls{0};
+  std::atomic<int> sum{0};
+  pool.parallelFor(0, 8, [&](int rangeBegin, int rangeEnd) {
+    EXPECT_TRUE(parallel::ThreadPool::isInParallelFor());
+    const auto outerThreadId = std::this_thread::get_id();
+    for (int index = rangeBegin; index < rangeEnd; ++index) {
+      pool.parallelFor(0, 100, [&](int innerBegin, int innerEnd) {
+        EXPECT_EQ(std::this_thread::get_id(), outerThreadId);
+        ++numInnerCalls;
+        sum += innerEnd - innerBegin;
+      });
+    }
+  });
+  EXPECT_FALSE(parallel::ThreadPool::isInParallelFor());
+  EXPECT_EQ(numInnerCalls, 8);
+  EXPECT_EQ(sum, 800);
+}
+
+TEST(TestThreadPool, concurrentCallers) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  parallel::ThreadPool pool(settings);
+
+  std::atomic<int> sum{0};
+  std::vector<std::thread> callers;
+  for (int callerId = 0; callerId < 4; ++callerId) {
+    callers.emplace_back([&]() {
+      for (int loop = 0; loop < 20; ++loop) {
+        pool.parallelFor(0, 100, [&](int rangeBegin, int rangeEnd) { sum += rangeEnd - rangeBegin; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(sum, 4 * 20 * 100);
+  EXPECT_EQ(pool.statistics().numLoops, 80U);
+}
+
+TEST(TestThreadPool, tilesCoverTheMatrix) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  parallel::ThreadPool pool(settings);
+
+  const int numRows = 37;
+  const int numCols = 20;
+  std::vector<std::atomic<int>> counts(numRows * numCols);
+  for (auto& count : counts) {
+    count = 0;
+  }
+  pool.parallelForTiles(numRows, numCols, 8, [&](int rowBegin, int rowEnd, int colBegin, int colEnd) {
+    EXPECT_LE(rowEnd - rowBegin, 8);
+    EXPECT_LE(colEnd - colBegin, 8);
+    for (int col = colBegin; col < colEnd; ++col) {
+      for (int row = rowBegin; row < rowEnd; ++row) {
+        ++counts[col * numRows + row];
+      }
+    }
+  });
+  for (const auto& count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(TestThreadPool, exceptionsAreRethrown) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  parallel::ThreadPool pool(settings);
+
+  std::atomic<int> numProcessed{0};
+  EXPECT_THROW(pool.parallelFor(0, 100,
+                                [&](int rangeBegin, int rangeEnd) {
+                                  numProcessed += rangeEnd - rangeBegin;
+                                  if (rangeBegin == 0) {
+                                    throw std::runtime_error("first range");
+                                  }
+                                }),
+               std::runtime_error);
+  EXPECT_EQ(numProcessed, 100);
+  EXPECT_FALSE(parallel::ThreadPool::isInParallelFor());
+
+  // The pool is still usable.
+  std::atomic<int> sum{0};
+  pool.parallelFor(0, 100, [&](int rangeBegin, int rangeEnd) { sum += rangeEnd - rangeBegin; });
+  EXPECT_EQ(sum, 100);
+}
+
+TEST(TestThreadPool, configureAndStatistics) {  // NOLINT
+  parallel::ThreadPool pool;
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 2;
+  pool.configure(settings);
+  EXPECT_EQ(pool.numThreads(), 2);
+  EXPECT_EQ(pool.statistics().numLoops, 0U);
+
+  pool.parallelFor(0, 10, [](int /*rangeBegin*/, int /*rangeEnd*/) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+  pool.parallelFor(0, 10, [](int /*rangeBegin*/, int /*rangeEnd*/) {}, 100);
+  const auto statistics = pool.statistics();
+  EXPECT_EQ(statistics.numThreads, 2);
+  EXPECT_EQ(statistics.numLoops, 2U);
+  EXPECT_EQ(statistics.numChunks, 9U);
+  EXPECT_GT(statistics.busySeconds, 0.0);
+  EXPECT_GT(statistics.utilization, 0.0);
+  EXPECT_LE(statistics.utilization, 1.0);
+
+  pool.resetStatistics();
+  EXPECT_EQ(pool.statistics().numLoops, 0U);
+  EXPECT_EQ(pool.statistics().busySeconds, 0.0);
+
+  settings.numThreads = -1;
+  EXPECT_THROW(pool.configure(settings), std::invalid_argument);
+  EXPECT_THROW(pool.parallelFor(0, 2, [&](int, int) { pool.configure(parallel::ThreadPoolSettings()); }), std::runtime_error);
+}
+
+TEST(TestThreadPool, reconfigureAfterLoops) {  // NOLINT
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  parallel::ThreadPool pool(settings);
+
+  for (int configuration = 0; configuration < 20; ++configuration) {
+    // Loops before the reconfiguration advance the loop id, the new workers must not start without a new loop.
+    std::atomic<int> sum{0};
+    pool.parallelFor(0, 100, [&](int rangeBegin, int rangeEnd) { sum += rangeEnd - rangeBegin; });
+    EXPECT_EQ(sum, 100);
+
+    settings.numThreads = 2 + configuration % 3;
+    pool.configure(settings);
+    std::atomic<int> numActiveCallbacks{0};
+    for (int loop = 0; loop < 50; ++loop) {
+      std::vector<std::atomic<int>> counts(64);
+      for (auto& count : counts) {
+        count = 0;
+      }
+      pool.parallelFor(0, 64, [&](int rangeBegin, int rangeEnd) {
+        ++numActiveCallbacks;
+        for (int index = rangeBegin; index < rangeEnd; ++index) {
+          ++counts[index];
+        }
+        std::this_thread::yield();
+        --numActiveCallbacks;
+      });
+      // No worker may still be inside the callback once the loop returned.
+      ASSERT_EQ(numActiveCallbacks, 0);
+      for (const auto& count : counts) {
+        ASSERT_EQ(count, 1);
+      }
+    }
+    EXPECT_EQ(pool.statistics().numLoops, 50U);
+  }
+}
+
+TEST(TestThreadPool, forEachRangeUsesTheGlobalPool) {  // NOLINT
+  auto& pool = parallel::ThreadPool::global();
+  const auto previousSettings = pool.settings();
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  pool.configure(settings);
+
+  std::atomic<int> sum{0};
+  parallel::forEachRange(0, 1000, [&](int rangeBegin, int rangeEnd) { sum += rangeEnd - rangeBegin; });
+  EXPECT_EQ(sum, 1000);
+  EXPECT_EQ(pool.statistics().numLoops, 1U);
+  EXPECT_EQ(pool.statistics().numChunks, 12U);
+
+  pool.configure(previousSettings);
+}
+
+#ifdef __linux__
+TEST(TestThreadPool, cpuAffinity) {  // NOLINT
+  cpu_set_t allowedCpus;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &allowedCpus), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &allowedCpus)) {
+    ++cpu;
+  }
+
+  parallel::ThreadPoolSettings settings;
+  settings.numThreads = 3;
+  settings.cpuAffinity = {cpu};
+  parallel::ThreadPool pool(settings);
+  const auto callingThreadId = std::this_thread::get_id();
+  pool.parallelFor(0, 12, [&](int /*rangeBegin*/, int /*rangeEnd*/) {
+    if (std::this_thread::get_id() != callingThreadId) {
+      EXPECT_EQ(sched_getcpu(), cpu);
+    }
+  });
+}
+#endif
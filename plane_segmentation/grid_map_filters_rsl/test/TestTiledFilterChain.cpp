@@ -0,0 +1,138 @@
+/**
+ * @brief       Tests for the tiled filter chain.
+ */
+
+#include <gtest/gtest.h>
+
+#include <grid_map_filters_rsl/TiledFilterChain.hpp>
+#include <grid_map_filters_rsl/processing.hpp>
+#include <grid_map_filters_rsl/smoothing.hpp>
+
+#include <cmath>
+#include <random>
+
+using namespace grid_map;
+
+namespace {
+
+Eigen::MatrixXf createRandomData(int numRows, int numCols, double nanProbability) {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> heightDistribution(-1.0F, 1.0F);
+  std::bernoulli_distribution nanDistribution(nanProbability);
+  Eigen::MatrixXf data(numRows, numCols);
+  for (int colId = 0; colId < numCols; ++colId) {
+    for (int rowId = 0; rowId < numRows; ++rowId) {
+      data(rowId, colId) = nanDistribution(generator) ? NAN : heightDistribution(generator);
+    }
+  }
+  return data;
+}
+
+void expectIdentical(const Eigen::MatrixXf& expected, const Eigen::MatrixXf& actual) {
+  ASSERT_EQ(expected.rows(), actual.rows());
+  ASSERT_EQ(expected.cols(), actual.cols());
+  for (int colId = 0; colId < expected.cols(); ++colId) {
+    for (int rowId = 0; rowId < expected.rows(); ++rowId) {
+      if (std::isnan(expected(rowId, colId))) {
+        EXPECT_TRUE(std::isnan(actual(rowId, colId))) << "at (" << rowId << ", " << colId << ")";
+      } else {
+        EXPECT_EQ(expected(rowId, colId), actual(rowId, colId)) << "at (" << rowId << ", " << colId << ")";
+      }
+    }
+  }
+}
+
+float meanOfFinites(const Eigen::Block<const grid_map::Matrix>& window) {
+  float sum = 0.0F;
+  int numFinites = 0;
+  for (int colId = 0; colId < window.cols(); ++colId) {
+    for (int rowId = 0; rowId < window.rows(); ++rowId) {
+      if (std::isfinite(window(rowId, colId))) {
+        sum += window(rowId, colId);
+        ++numFinites;
+      }
+    }
+  }
+  return numFinites > 0 ? sum / numFinites : NAN;
+}
+
+}  // namespace
+
+TEST(TestTiledFilterChain, matchesSequentialFilters) {  // NOLINT
+  const Eigen::MatrixXf data = createRandomData(53, 41, 0.2);
+
+  Eigen::MatrixXf expected = processing::dilate(data, 3, true, processing::KernelShape::Square);
+  expected = smoothing::median(expected, 7, 2, 2);
+  expected = processing::erode(expected, 5, false, processing::KernelShape::Disk);
+  expected = processing::coneDilate(expected, 0.1F, 9);
+  expected = processing::coneErode(expected, 0.2F, 5);
+  expected = expected.unaryExpr([](float value) { return 2.0F * value + 1.0F; });
+  expected = processing::applyKernelFunction(expected, 3, meanOfFinites);
+
+  // Tiles smaller than the kernels, not dividing the map, and larger than the map.
+  for (int tileSize : {1, 4, 7, 16, 64}) {
+    processing::TiledFilterChain chain(tileSize);
+    chain.addDilation(3, true, processing::KernelShape::Square)
+        .addMedian(7, 2, 2)
+        .addErosion(5, false, processing::KernelShape::Disk)
+        .addConeDilation(0.1F, 9)
+        .addConeErosion(0.2F, 5)
+        .addCellFunction([](float value) { return 2.0F * value + 1.0F; })
+        .addKernelFunction(3, meanOfFinites);
+    ASSERT_EQ(chain.numFilters(), 7);
+    SCOPED_TRACE("tileSize = " + std::to_string(tileSize));
+    expectIdentical(expected, chain.apply(data));
+  }
+}
+
+TEST(TestTiledFilterChain, evenKernelsAndSmallMaps) {  // NOLINT
+  for (int numRows : {4, 6, 19}) {
+    const Eigen::MatrixXf data = createRandomData(numRows, 23, 0.1);
+    Eigen::MatrixXf expected = processing::applyKernelFunction(data, 2, meanOfFinites);
+    expected = processing::dilate(expected, 1, true);
+    expected = processing::applyKernelFunction(expected, 4, meanOfFinites);
+
+    processing::TiledFilterChain chain(5);
+    chain.addKernelFunction(2, meanOfFinites).addDilation(1).addKernelFunction(4, meanOfFinites);
+    SCOPED_TRACE("numRows = " + std::to_string(numRows));
+    expectIdentical(expected, chain.apply(data));
+  }
+}
+
+TEST(TestTiledFilterChain, tileRegions) {  // NOLINT
+  const Eigen::MatrixXf data = createRandomData(20, 30, 0.0);
+
+  // The region of the last filter is the tile itself, the first filter sees the tile and its halo.
+  processing::TiledFilterChain chain(8);
+  chain
+      .addFilter(5,
+                 [&](const grid_map::Matrix& tile, const processing::TileRegion& region) -> grid_map::Matrix {
+                   EXPECT_EQ(tile.rows(), region.size.x());
+                   EXPECT_EQ(tile.cols(), region.size.y());
+                   EXPECT_TRUE(tile.isApprox(data.block(region.topLeftIndex.x(), region.topLeftIndex.y(), tile.rows(), tile.cols())));
+                   return tile;
+                 })
+      .addFilter(1, [](const grid_map::Matrix& tile, const processing::TileRegion& region) -> grid_map::Matrix {
+        EXPECT_EQ(region.topLeftIndex.x() % 8, 0);
+        EXPECT_EQ(region.topLeftIndex.y() % 8, 0);
+        EXPECT_LE(tile.rows(), 8);
+        EXPECT_LE(tile.cols(), 8);
+        return grid_map::Matrix::Constant(tile.rows(), tile.cols(), static_cast<float>(region.topLeftIndex.sum()));
+      });
+
+  const Eigen::MatrixXf result = chain.apply(data);
+  for (int colId = 0; colId < data.cols(); ++colId) {
+    for (int rowId = 0; rowId < data.rows(); ++rowId) {
+      EXPECT_EQ(result(rowId, colId), static_cast<float>(rowId / 8 * 8 + colId / 8 * 8));
+    }
+  }
+}
+
+TEST(TestTiledFilterChain, emptyChainAndInvalidArguments) {  // NOLINT
+  const Eigen::MatrixXf data = createRandomData(10, 12, 0.3);
+  expectIdentical(data, processing::TiledFilterChain().apply(data));
+
+  EXPECT_THROW(processing::TiledFilterChain(0), std::invalid_argument);
+  processing::TiledFilterChain chain;
+  EXPECT_THROW(chain.addDilation(0), std::invalid_argument);
+}
@@ -0,0 +1,270 @@
+/**
+ * @brief       Tests for the bit-packed validity mask.
+ */
+
+#include <gtest/gtest.h>
+
+#include <grid_map_filters_rsl/ValidityMask.hpp>
+#include <grid_map_filters_rsl/processing.hpp>
+#include <grid_map_filters_rsl/smoothing.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace grid_map;
+using mask::ValidityMask;
+
+namespace {
+
+ValidityMask createRandomMask(int rows, int cols, double validProbability, std::mt19937& generator) {
+  std::bernoulli_distribution isValid(validProbability);
+  ValidityMask result(rows, cols);
+  for (int col = 0; col < cols; ++col) {
+    for (int row = 0; row < rows; ++row) {
+      result.setValid(row, col, isValid(generator));
+    }
+  }
+  return result;
+}
+
+/// Start of the window of cell id, shifted at the border to stay inside the map.
+int windowStart(int id, int kernelSize, int size) {
+  return std::min(std::max(id - (kernelSize - 1) / 2, 0), size - kernelSize);
+}
+
+/// Number of valid cells in the window of each cell, by searching the window.
+Eigen::MatrixXi searchingWindowCounts(const ValidityMask& mask, int kernelSize) {
+  const int kernelRows = std::min(kernelSize, mask.rows());
+  const int kernelCols = std::min(kernelSize, mask.cols());
+  Eigen::MatrixXi counts(mask.rows(), mask.cols());
+  for (int col = 0; col < mask.cols(); ++col) {
+    for (int row = 0; row < mask.rows(); ++row) {
+      const int startRow = windowStart(row, kernelRows, mask.rows());
+      const int startCol = windowStart(col, kernelCols, mask.cols());
+      int count = 0;
+      for (int j = startCol; j < startCol + kernelCols; ++j) {
+        for (int i = startRow; i < startRow + kernelRows; ++i) {
+          count += mask.isValid(i, j) ? 1 : 0;
+        }
+      }
+      counts(row, col) = count;
+    }
+  }
+  return counts;
+}
+
+void expectEqualMasks(const ValidityMask& expected, const ValidityMask& actual, const std::string& description) {
+  ASSERT_EQ(expected.rows(), actual.rows()) << description;
+  ASSERT_EQ(expected.cols(), actual.cols()) << description;
+  for (int col = 0; col < expected.cols(); ++col) {
+    for (int row = 0; row < expected.rows(); ++row) {
+      ASSERT_EQ(expected.isValid(row, col), actual.isValid(row, col)) << description << " at (" << row << ", " << col << ")";
+    }
+  }
+}
+
+}  // namespace
+
+TEST(TestValidityMask, conversions) {  // NOLINT
+  Eigen::MatrixXf data = Eigen::MatrixXf::Random(130, 7);
+  data(0, 0) = NAN;
+  data(64, 3) = NAN;
+  data(129, 6) = std::numeric_limits<float>::infinity();
+  data.col(5).setConstant(NAN);
+
+  const ValidityMask mask = ValidityMask::fromFinite(data);
+  EXPECT_EQ(mask.wordsPerCol(), 3);
+  EXPECT_EQ(mask.count(), 130 * 7 - 3 - 130);
+  for (int col = 0; col < data.cols(); ++col) {
+    for (int row = 0; row < data.rows(); ++row) {
+      EXPECT_EQ(mask.isValid(row, col), std::isfinite(data(row, col)));
+    }
+  }
+  for (int wordId = 0; wordId < mask.wordsPerCol(); ++wordId) {
+    EXPECT_EQ(mask.word(wordId, 5), 0U);
+    EXPECT_EQ((~mask).word(wordId, 5), mask.fullWord(wordId));
+  }
+
+  const Eigen::MatrixXf masked = mask.applyTo(data);
+  const Eigen::MatrixXf ones = mask.toMatrix();
+  for (int col = 0; col < data.cols(); ++col) {
+    for (int row = 0; row < data.rows(); ++row) {
+      if (mask.isValid(row, col)) {
+        EXPECT_EQ(masked(row, col), data(row, col));
+        EXPECT_EQ(ones(row, col), 1.0F);
+      } else {
+        EXPECT_TRUE(std::isnan(masked(row, col)));
+        EXPECT_TRUE(std::isnan(ones(row, col)));
+      }
+    }
+  }
+}
+
+TEST(TestValidityMask, logicalOperations) {  // NOLINT
+  std::mt19937 generator(42);
+  const ValidityMask a = createRandomMask(100, 9, 0.5, generator);
+  const ValidityMask b = createRandomMask(100, 9, 0.5, generator);
+  const ValidityMask both = a & b;
+  const ValidityMask either = a | b;
+  const ValidityMask notA = ~a;
+  for (int col = 0; col < a.cols(); ++col) {
+    for (int row = 0; row < a.rows(); ++row) {
+      EXPECT_EQ(both.isValid(row, col), a.isValid(row, col) && b.isValid(row, col));
+      EXPECT_EQ(either.isValid(row, col), a.isValid(row, col) || b.isValid(row, col));
+      EXPECT_EQ(notA.isValid(row, col), !a.isValid(row, col));
+    }
+  }
+  EXPECT_EQ(a.count() + notA.count(), 100 * 9);
+  EXPECT_THROW(a & ValidityMask(99, 9), std::invalid_argument);
+}
+
+TEST(TestValidityMask, rangeCount) {  // NOLINT
+  std::mt19937 generator(1);
+  const ValidityMask mask = createRandomMask(200, 2, 0.5, generator);
+  for (int rowBegin = 0; rowBegin <= mask.rows(); rowBegin += 7) {
+    for (int rowEnd = rowBegin; rowEnd <= mask.rows(); rowEnd += 5) {
+      int expected = 0;
+      for (int row = rowBegin; row < rowEnd; ++row) {
+        expected += mask.isValid(row, 1) ? 1 : 0;
+      }
+      ASSERT_EQ(mask.count(1, rowBegin, rowEnd), expected) << "rows [" << rowBegin << ", " << rowEnd << ")";
+    }
+  }
+}
+
+TEST(TestValidityMask, windowOperationsMatchSearch) {  // NOLINT
+  std::mt19937 generator(7);
+  const std::vector<std::pair<int, int>> sizes{{1, 1}, {2, 3}, {13, 17}, {64, 5}, {65, 4}, {130, 11}, {200, 3}};
+  for (const auto& size : sizes) {
+    for (const double validProbability : {0.02, 0.5, 0.98}) {
+      const ValidityMask mask = createRandomMask(size.first, size.second, validProbability, generator);
+      for (const int kernelSize : {1, 3, 5, 9, 15, 69, 131}) {
+        const std::string description = "size " + std::to_string(size.first) + " x " + std::to_string(size.second) + ", kernel " +
+                                        std::to_string(kernelSize) + ", p " + std::to_string(validProbability);
+        const Eigen::MatrixXi expectedCounts = searchingWindowCounts(mask, kernelSize);
+        const Eigen::MatrixXi counts = mask.windowCounts(kernelSize);
+        ASSERT_EQ(counts, expectedCounts) << description;
+
+        const int kernelArea = std::min(kernelSize, mask.rows()) * std::min(kernelSize, mask.cols());
+        ValidityMask expectedDilated(mask.rows(), mask.cols());
+        ValidityMask expectedEroded(mask.rows(), mask.cols());
+        for (int col = 0; col < mask.cols(); ++col) {
+          for (int row = 0; row < mask.rows(); ++row) {
+            expectedDilated.setValid(row, col, expectedCounts(row, col) > 0);
+            expectedEroded.setValid(row, col, expectedCounts(row, col) == kernelArea);
+          }
+        }
+        expectEqualMasks(expectedDilated, mask.dilated(kernelSize), "dilated, " + description);
+        expectEqualMasks(expectedEroded, mask.eroded(kernelSize), "eroded, " + description);
+      }
+    }
+  }
+}
+
+/// Mask with random cells, a block of invalid cells and a block of valid cells, such that there are words of each kind.
+ValidityMask createBlockMask(int rows, int cols, std::mt19937& generator) {
+  ValidityMask result = createRandomMask(rows, cols, 0.7, generator);
+  for (int col = 0; col < cols / 3; ++col) {
+    for (int row = 0; row < rows; ++row) {
+      result.setValid(row, col, false);
+    }
+  }
+  for (int col = cols / 3; col < 2 * cols / 3; ++col) {
+    for (int row = 0; row < rows / 2; ++row) {
+      result.setValid(row, col, true);
+    }
+  }
+  return result;
+}
+
+void expectEqualWithNaN(const Eigen::MatrixXf& expected, const Eigen::MatrixXf& actual, const std::string& description) {
+  ASSERT_EQ(expected.rows(), actual.rows()) << description;
+  ASSERT_EQ(expected.cols(), actual.cols()) << description;
+  for (int i = 0; i < expected.size(); ++i) {
+    if (std::isnan(expected(i))) {
+      ASSERT_TRUE(std::isnan(actual(i))) << description << " at " << i;
+    } else {
+      ASSERT_EQ(expected(i), actual(i)) << description << " at " << i;
+    }
+  }
+}
+
+TEST(TestValidityMask, morphologicalFiltersMatchFloatMask) {  // NOLINT
+  std::mt19937 generator(3);
+  GridMap map;
+  map.setGeometry(Length(13.0, 7.0), 0.1, Position(0.0, 0.0));
+  const int rows = map.getSize().x();
+  const int cols = map.getSize().y();
+  map.add("input", createBlockMask(rows, cols, generator).applyTo(Eigen::MatrixXf::Random(rows, cols)));
+  const ValidityMask mask = createBlockMask(rows, cols, generator);
+  const ValidityMask validity = ValidityMask::fromLayer(map, "input") & mask;
+
+  for (const int kernelSize : {3, 5, 11}) {
+    for (const bool inpaint : {true, false}) {
+      for (const auto shape : {processing::KernelShape::Square, processing::KernelShape::Disk}) {
+        const std::string description = "kernel: " + std::to_string(kernelSize) + ", inpaint: " + std::to_string(inpaint) +
+                                        ", disk: " + std::to_string(shape == processing::KernelShape::Disk);
+        processing::dilate(map, "input", "dilatedFloat", mask.toMatrix(), kernelSize, inpaint, shape);
+        processing::dilate(map, "input", "dilatedBits", validity, kernelSize, inpaint, shape);
+        expectEqualWithNaN(map.get("dilatedFloat"), map.get("dilatedBits"), "dilate, " + description);
+        processing::erode(map, "input", "erodedFloat", mask.toMatrix(), kernelSize, inpaint, shape);
+        processing::erode(map, "input", "erodedBits", validity, kernelSize, inpaint, shape);
+        expectEqualWithNaN(map.get("erodedFloat"), map.get("erodedBits"), "erode, " + description);
+      }
+    }
+  }
+
+  EXPECT_THROW(processing::dilate(map, "input", "dilatedBits", ValidityMask(rows, cols + 1), 3), std::invalid_argument);
+}
+
+TEST(TestValidityMask, medianMatchesNanMask) {  // NOLINT
+  std::mt19937 generator(4);
+  GridMap map;
+  map.setGeometry(Length(13.0, 7.0), 0.1, Position(0.0, 0.0));
+  const int rows = map.getSize().x();
+  const int cols = map.getSize().y();
+  map.add("input", createBlockMask(rows, cols, generator).applyTo(Eigen::MatrixXf::Random(rows, cols)));
+  const ValidityMask validity = ValidityMask::fromLayer(map, "input") & createBlockMask(rows, cols, generator);
+
+  // The median without mask computes the exact median of the finite values for these kernel sizes.
+  for (const int kernelSize : {7, 9}) {
+    const std::string description = "kernel: " + std::to_string(kernelSize);
+    smoothing::median(map, "input", "medianBits", validity, kernelSize, 2, 2);
+    expectEqualWithNaN(smoothing::median(validity.applyTo(map.get("input")), kernelSize, 2, 2), map.get("medianBits"), description);
+  }
+
+  EXPECT_THROW(smoothing::median(map, "input", "medianBits", ValidityMask(rows + 1, cols), 7), std::invalid_argument);
+}
+
+TEST(TestValidityMask, outline) {  // NOLINT
+  std::mt19937 generator(5);
+  GridMap map;
+  map.setGeometry(Length(9.0, 7.0), 0.1, Position(0.0, 0.0));
+  map.add("input", Eigen::MatrixXf::Random(map.getSize().x(), map.getSize().y()));
+  const ValidityMask validity = createRandomMask(map.getSize().x(), map.getSize().y(), 0.9, generator);
+  map.get("input") = validity.applyTo(map.get("input"));
+
+  processing::outline(map, "input", "outline");
+  processing::outline(map, "input", "outlineWithMask", validity);
+  map.add("inPlace", map.get("input"));
+  processing::outline(map, "inPlace", "inPlace");
+
+  // Finite values that touch a nan value in their 3x3 window, shifted at the border.
+  const Eigen::MatrixXf& H_in = map.get("input");
+  for (const std::string layer : {"outline", "outlineWithMask", "inPlace"}) {
+    const Eigen::MatrixXf& H_out = map.get(layer);
+    for (int col = 0; col < H_in.cols(); ++col) {
+      for (int row = 0; row < H_in.rows(); ++row) {
+        const int startRow = windowStart(row, 3, H_in.rows());
+        const int startCol = windowStart(col, 3, H_in.cols());
+        if (H_in.block(startRow, startCol, 3, 3).hasNaN() && std::isfinite(H_in(row, col))) {
+          ASSERT_EQ(H_out(row, col), H_in(row, col)) << layer << " at (" << row << ", " << col << ")";
+        } else {
+          ASSERT_TRUE(std::isnan(H_out(row, col))) << layer << " at (" << row << ", " << col << ")";
+        }
+      }
+    }
+  }
+}